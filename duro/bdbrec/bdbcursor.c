@@ -10,7 +10,15 @@
 #include <rec/indeximpl.h>
 #include <treerec/field.h>
 #include <obj/excontext.h>
+#include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+
+/*
+ * Size of the buffer for bulk reads. Must be a multiple of 1024
+ * and at least as large as the page size.
+ */
+#define BULK_BUFSIZE (64 * 1024)
 
 /*
  * Allocate and initialize a RDB_cursor structure.
@@ -30,6 +38,9 @@ new_bdb_cursor(RDB_recmap *rmp, RDB_rec_transaction *rtxp, RDB_index *idxp,
     curp->cur.bdb.current_key.flags = DB_DBT_REALLOC;
     memset(&curp->cur.bdb.current_data, 0, sizeof(DBT));
     curp->cur.bdb.current_data.flags = DB_DBT_REALLOC;
+    curp->cur.bdb.bulk_read = RDB_FALSE;
+    memset(&curp->cur.bdb.bulk, 0, sizeof(DBT));
+    curp->cur.bdb.bulkp = NULL;
 
     curp->destroy_fn = &RDB_destroy_bdb_cursor;
     curp->get_fn = &RDB_bdb_cursor_get;
@@ -48,8 +59,10 @@ RDB_bdb_recmap_cursor(RDB_recmap *rmp, RDB_bool wr,
         RDB_rec_transaction *rtxp, RDB_exec_context *ecp)
 {
     /*
-     * The wr agument is ignored, because setting DB_WRITECURSOR only
+     * Setting DB_WRITECURSOR is not used, because it only
      * works for multiple reader/single writer access.
+     * Records are read in bulk if the cursor is not used for writing,
+     * because records read in advance would not reflect modifications.
      */
 
     int ret;
@@ -65,6 +78,7 @@ RDB_bdb_recmap_cursor(RDB_recmap *rmp, RDB_bool wr,
         return NULL;
     }
     curp->secondary = RDB_FALSE;
+    curp->cur.bdb.bulk_read = (RDB_bool) !wr;
     return curp;
 }
 
@@ -95,6 +109,7 @@ RDB_destroy_bdb_cursor(RDB_cursor *curp, RDB_exec_context *ecp)
 
     free(curp->cur.bdb.current_key.data);
     free(curp->cur.bdb.current_data.data);
+    free(curp->cur.bdb.bulk.data);
 
     ret = curp->cur.bdb.cursorp->close(curp->cur.bdb.cursorp);
     RDB_free(curp);
@@ -105,6 +120,86 @@ RDB_destroy_bdb_cursor(RDB_cursor *curp, RDB_exec_context *ecp)
     return RDB_OK;
 }
 
+/*
+ * Copy len bytes at datap to *dbtp, which must have the flag DB_DBT_REALLOC.
+ */
+static int
+copy_to_dbt(DBT *dbtp, const void *datap, u_int32_t len)
+{
+    if (len > 0) {
+        void *p = realloc(dbtp->data, len);
+        if (p == NULL)
+            return ENOMEM;
+        memcpy(p, datap, len);
+        dbtp->data = p;
+    }
+    dbtp->size = len;
+    return 0;
+}
+
+/*
+ * Make the next record in the bulk buffer the current record.
+ * If there are no more records in the buffer, read the next records
+ * into the buffer using DB_MULTIPLE_KEY.
+ */
+static int
+bulk_next(RDB_cursor *curp)
+{
+    int ret;
+    DBT key;
+    void *keyp, *datap;
+    u_int32_t keylen, datalen;
+
+    for (;;) {
+        if (curp->cur.bdb.bulkp != NULL) {
+            DB_MULTIPLE_KEY_NEXT(curp->cur.bdb.bulkp, &curp->cur.bdb.bulk,
+                    keyp, keylen, datap, datalen);
+            if (curp->cur.bdb.bulkp != NULL) {
+                ret = copy_to_dbt(&curp->cur.bdb.current_key, keyp, keylen);
+                if (ret != 0)
+                    return ret;
+                return copy_to_dbt(&curp->cur.bdb.current_data, datap, datalen);
+            }
+        }
+
+        if (curp->cur.bdb.bulk.data == NULL) {
+            curp->cur.bdb.bulk.data = malloc(BULK_BUFSIZE);
+            if (curp->cur.bdb.bulk.data == NULL)
+                return ENOMEM;
+            curp->cur.bdb.bulk.ulen = BULK_BUFSIZE;
+            curp->cur.bdb.bulk.flags = DB_DBT_USERMEM;
+        }
+
+        memset(&key, 0, sizeof key);
+        ret = curp->cur.bdb.cursorp->get(curp->cur.bdb.cursorp,
+                &key, &curp->cur.bdb.bulk, DB_NEXT | DB_MULTIPLE_KEY);
+        if (ret == DB_BUFFER_SMALL) {
+            /* The record does not fit into the buffer, so read it alone */
+            return curp->cur.bdb.cursorp->get(curp->cur.bdb.cursorp,
+                    &curp->cur.bdb.current_key, &curp->cur.bdb.current_data,
+                    DB_NEXT);
+        }
+        if (ret != 0)
+            return ret;
+        DB_MULTIPLE_INIT(curp->cur.bdb.bulkp, &curp->cur.bdb.bulk);
+    }
+}
+
+/*
+ * If records have been read in advance, discard them and move
+ * the Berkeley DB cursor back to the current record.
+ */
+static int
+end_bulk(RDB_cursor *curp)
+{
+    if (curp->cur.bdb.bulkp == NULL)
+        return 0;
+    curp->cur.bdb.bulkp = NULL;
+    return curp->cur.bdb.cursorp->get(curp->cur.bdb.cursorp,
+            &curp->cur.bdb.current_key, &curp->cur.bdb.current_data,
+            DB_GET_BOTH);
+}
+
 int
 RDB_bdb_cursor_get(RDB_cursor *curp, int fno, void **datapp, size_t *lenp,
         RDB_exec_context *ecp)
@@ -173,6 +268,12 @@ RDB_bdb_cursor_set(RDB_cursor *curp, int fieldc, RDB_field fields[],
     if (curp->secondary)
         return RDB_bdb_cursor_update(curp, fieldc, fields, ecp);
 
+    ret = end_bulk(curp);
+    if (ret != 0) {
+        RDB_errcode_to_error(ret, ecp);
+        return RDB_ERROR;
+    }
+
     for (i = 0; i < fieldc; i++) {
         if (fields[i].no < curp->recmapp->keyfieldcount) {
             RDB_raise_invalid_argument("Modifying the key is not supported", ecp);
@@ -201,7 +302,9 @@ RDB_bdb_cursor_set(RDB_cursor *curp, int fieldc, RDB_field fields[],
 int
 RDB_bdb_cursor_delete(RDB_cursor *curp, RDB_exec_context *ecp)
 {
-    int ret = curp->cur.bdb.cursorp->del(curp->cur.bdb.cursorp, 0);
+    int ret = end_bulk(curp);
+    if (ret == 0)
+        ret = curp->cur.bdb.cursorp->del(curp->cur.bdb.cursorp, 0);
     if (ret != 0) {
         RDB_errcode_to_error(ret, ecp);
         return RDB_ERROR;
@@ -217,6 +320,8 @@ int
 RDB_bdb_cursor_first(RDB_cursor *curp, RDB_exec_context *ecp)
 {
     int ret;
+
+    curp->cur.bdb.bulkp = NULL;
     if (curp->idxp == NULL) {
         ret = curp->cur.bdb.cursorp->get(curp->cur.bdb.cursorp,
                 &curp->cur.bdb.current_key, &curp->cur.bdb.current_data, DB_FIRST);
@@ -240,10 +345,15 @@ RDB_bdb_cursor_next(RDB_cursor *curp, int flags, RDB_exec_context *ecp)
     DBT key;
     int ret;
 
-    if (curp->idxp == NULL) {
-        ret = curp->cur.bdb.cursorp->get(curp->cur.bdb.cursorp,
-                &curp->cur.bdb.current_key, &curp->cur.bdb.current_data,
-                flags == RDB_REC_DUP ? DB_NEXT_DUP : DB_NEXT);
+    if (curp->cur.bdb.bulk_read && flags != RDB_REC_DUP) {
+        ret = bulk_next(curp);
+    } else if (curp->idxp == NULL) {
+        ret = end_bulk(curp);
+        if (ret == 0) {
+            ret = curp->cur.bdb.cursorp->get(curp->cur.bdb.cursorp,
+                    &curp->cur.bdb.current_key, &curp->cur.bdb.current_data,
+                    flags == RDB_REC_DUP ? DB_NEXT_DUP : DB_NEXT);
+        }
     } else {
         memset(&key, 0, sizeof key);
         ret = curp->cur.bdb.cursorp->pget(curp->cur.bdb.cursorp,
@@ -264,8 +374,12 @@ RDB_bdb_cursor_prev(RDB_cursor *curp, RDB_exec_context *ecp)
     int ret;
 
     if (curp->idxp == NULL) {
-        ret = curp->cur.bdb.cursorp->get(curp->cur.bdb.cursorp,
-                &curp->cur.bdb.current_key, &curp->cur.bdb.current_data, DB_PREV);
+        ret = end_bulk(curp);
+        if (ret == 0) {
+            ret = curp->cur.bdb.cursorp->get(curp->cur.bdb.cursorp,
+                    &curp->cur.bdb.current_key, &curp->cur.bdb.current_data,
+                    DB_PREV);
+        }
     } else {
         memset(&key, 0, sizeof key);
         ret = curp->cur.bdb.cursorp->pget(curp->cur.bdb.cursorp,
@@ -289,6 +403,7 @@ RDB_bdb_cursor_seek(RDB_cursor *curp, int fieldc, RDB_field keyv[], int flags,
     int i;
     DBT key;
 
+    curp->cur.bdb.bulkp = NULL;
     if (curp->idxp == NULL) {
         for (i = 0; i < curp->recmapp->keyfieldcount; i++)
             keyv[i].no = i;
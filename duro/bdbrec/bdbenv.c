@@ -15,6 +15,12 @@
 #include <stdlib.h>
 #include <errno.h>
 
+/*
+ * Cache size used if none is specified.
+ * The Berkeley DB default of 256 KB is too small for most databases.
+ */
+#define DEFAULT_CACHE_SIZE (16 * 1024 * 1024)
+
 static void
 bdb_set_errfile(RDB_environment *envp, FILE *file)
 {
@@ -29,8 +35,67 @@ bdb_get_errfile(const RDB_environment *envp)
     return file;
 }
 
+/*
+ * Apply the settings which must be made before the environment is opened.
+ */
 static int
-open_env(const char *path, RDB_environment **envpp, int bdb_flags)
+configure_env(DB_ENV *dbenvp, const RDB_env_config *configp)
+{
+    int ret;
+    size_t cache_size = configp != NULL && configp->cache_size != 0 ?
+            configp->cache_size : DEFAULT_CACHE_SIZE;
+
+    ret = dbenvp->set_cachesize(dbenvp,
+            (u_int32_t) (cache_size / (1024 * 1024 * 1024)),
+            (u_int32_t) (cache_size % (1024 * 1024 * 1024)), 1);
+    if (ret != 0)
+        return ret;
+
+    if (configp == NULL)
+        return 0;
+
+    if (configp->log_buf_size != 0) {
+        ret = dbenvp->set_lg_bsize(dbenvp, configp->log_buf_size);
+        if (ret != 0)
+            return ret;
+    }
+    if (configp->max_locks != 0) {
+        ret = dbenvp->set_lk_max_locks(dbenvp, configp->max_locks);
+        if (ret != 0)
+            return ret;
+    }
+    if (configp->max_lockers != 0) {
+        ret = dbenvp->set_lk_max_lockers(dbenvp, configp->max_lockers);
+        if (ret != 0)
+            return ret;
+    }
+    if (configp->max_lock_objects != 0) {
+        ret = dbenvp->set_lk_max_objects(dbenvp, configp->max_lock_objects);
+        if (ret != 0)
+            return ret;
+    }
+    if (configp->max_txns != 0) {
+        ret = dbenvp->set_tx_max(dbenvp, configp->max_txns);
+        if (ret != 0)
+            return ret;
+    }
+    switch (configp->durability) {
+        case RDB_DURABILITY_DEFAULT:
+        case RDB_DURABILITY_SYNC:
+            break;
+        case RDB_DURABILITY_WRITE_NOSYNC:
+            ret = dbenvp->set_flags(dbenvp, DB_TXN_WRITE_NOSYNC, 1);
+            break;
+        case RDB_DURABILITY_NOSYNC:
+            ret = dbenvp->set_flags(dbenvp, DB_TXN_NOSYNC, 1);
+            break;
+    }
+    return ret;
+}
+
+static int
+open_env(const char *path, RDB_environment **envpp, int bdb_flags,
+        const RDB_env_config *configp)
 {
     RDB_environment *envp;
     int ret;
@@ -55,6 +120,17 @@ open_env(const char *path, RDB_environment **envpp, int bdb_flags)
     envp->xdata = NULL;
     envp->trace = 0;
     envp->queries = RDB_FALSE;
+    envp->hash_mem = 0;
+    envp->sort_mem = 0;
+    envp->fetch_rows = 0;
+    envp->page_size = configp != NULL ? configp->page_size : 0;
+    envp->hash_ffactor = configp != NULL ? configp->hash_ffactor : 0;
+
+    /* Group commit only makes sense if the log is flushed on commit */
+    envp->group_commit_delay = configp != NULL
+            && (configp->durability == RDB_DURABILITY_DEFAULT
+                    || configp->durability == RDB_DURABILITY_SYNC) ?
+            configp->group_commit_delay : 0;
 
     /* create environment handle */
     *envpp = envp;
@@ -81,6 +157,13 @@ open_env(const char *path, RDB_environment **envpp, int bdb_flags)
     if (envp->trace == 0)
         envp->env.envp->set_errfile(envp->env.envp, NULL);
 
+    ret = configure_env(envp->env.envp, configp);
+    if (ret != 0) {
+        envp->env.envp->close(envp->env.envp, 0);
+        free(envp);
+        return ret;
+    }
+
     /* Open DB environment */
     ret = envp->env.envp->open(envp->env.envp, path, bdb_flags, 0);
     if (ret != 0) {
@@ -103,10 +186,12 @@ open_env(const char *path, RDB_environment **envpp, int bdb_flags)
 }
 
 int
-RDB_bdb_open_env(const char *path, RDB_environment **envpp, int flags)
+RDB_bdb_open_env(const char *path, RDB_environment **envpp, int flags,
+        const RDB_env_config *configp)
 {
     return open_env(path, envpp, DB_INIT_LOCK | DB_INIT_LOG | DB_INIT_MPOOL | DB_INIT_TXN
-            | (flags & RDB_RECOVER ? DB_CREATE | DB_RECOVER : DB_CREATE));
+            | (flags & RDB_RECOVER ? DB_CREATE | DB_RECOVER : DB_CREATE),
+            configp);
 }
 
 /**
@@ -114,6 +199,7 @@ RDB_bdb_open_env(const char *path, RDB_environment **envpp, int flags)
  *
  * @param path  pathname of the direcory where the data is stored.
  * @param envpp   location where the pointer to the environment is stored.
+ * @param configp   the environment settings, NULL for the defaults.
  *
  * @return On success, RDB_OK is returned. On failure, an error code is returned.
  *
@@ -121,10 +207,12 @@ RDB_bdb_open_env(const char *path, RDB_environment **envpp, int flags)
  * See the documentation of the Berkeley DB function DB_ENV->open for details.
  */
 int
-RDB_bdb_create_env(const char *path, RDB_environment **envpp)
+RDB_bdb_create_env(const char *path, RDB_environment **envpp,
+        const RDB_env_config *configp)
 {
     return open_env(path, envpp,
-            DB_INIT_LOCK | DB_INIT_LOG | DB_INIT_MPOOL | DB_INIT_TXN | DB_CREATE);
+            DB_INIT_LOCK | DB_INIT_LOG | DB_INIT_MPOOL | DB_INIT_TXN | DB_CREATE,
+            configp);
 }
 
 /**
@@ -10,12 +10,15 @@
 
 typedef struct RDB_environment RDB_environment;
 typedef struct RDB_exec_context RDB_exec_context;
+typedef struct RDB_env_config RDB_env_config;
 
 int
-RDB_bdb_open_env(const char *, RDB_environment **, int);
+RDB_bdb_open_env(const char *, RDB_environment **, int,
+        const RDB_env_config *);
 
 int
-RDB_bdb_create_env(const char *, RDB_environment **);
+RDB_bdb_create_env(const char *, RDB_environment **,
+        const RDB_env_config *);
 
 int
 RDB_bdb_close_env(RDB_environment *, RDB_exec_context *);
@@ -160,6 +160,22 @@ RDB_create_bdb_recmap(const char *name,
         }
     }
 
+    /*
+     * Set page size and fill factor.
+     * The page size only takes effect if the data file is created,
+     * because all databases in a file have the same page size.
+     */
+    if (envp != NULL && envp->page_size != 0) {
+        ret = rmp->impl.dbp->set_pagesize(rmp->impl.dbp, envp->page_size);
+        if (ret != 0)
+            goto error;
+    }
+    if (envp != NULL && envp->hash_ffactor != 0 && !(RDB_ORDERED & flags)) {
+        ret = rmp->impl.dbp->set_h_ffactor(rmp->impl.dbp, envp->hash_ffactor);
+        if (ret != 0)
+            goto error;
+    }
+
     /* Suppress error output */
     rmp->impl.dbp->set_errfile(rmp->impl.dbp, NULL);
 
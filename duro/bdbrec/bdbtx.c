@@ -11,6 +11,156 @@
 
 #include <db.h>
 
+#ifndef _WIN32
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Group commit state of a Berkeley DB environment.
+ * It is shared by all handles of the environment in the process,
+ * because concurrent transactions use different handles.
+ */
+typedef struct commit_group {
+    /* Home directory of the environment */
+    char *home;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    /* Number of commits whose log records have been written */
+    unsigned long written;
+
+    /* Number of commits whose log records are known to be flushed */
+    unsigned long flushed;
+
+    /* RDB_TRUE if a thread is about to flush the log */
+    RDB_bool flushing;
+
+    struct commit_group *nextp;
+} commit_group;
+
+/*
+ * Group commit states, one per environment.
+ * They are never freed because other threads may be using them.
+ */
+static commit_group *commit_groups = NULL;
+static pthread_mutex_t commit_groups_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Get the group commit state of the environment, creating it
+ * if it does not exist.
+ * Return NULL if no memory is available.
+ */
+static commit_group *
+get_commit_group(DB_ENV *dbenvp)
+{
+    const char *home;
+    commit_group *groupp;
+
+    if (dbenvp->get_home(dbenvp, &home) != 0 || home == NULL)
+        home = "";
+
+    pthread_mutex_lock(&commit_groups_mutex);
+    groupp = commit_groups;
+    while (groupp != NULL && strcmp(groupp->home, home) != 0)
+        groupp = groupp->nextp;
+    if (groupp == NULL) {
+        groupp = malloc(sizeof(commit_group));
+        if (groupp != NULL) {
+            groupp->home = malloc(strlen(home) + 1);
+            if (groupp->home == NULL) {
+                free(groupp);
+                groupp = NULL;
+            } else {
+                strcpy(groupp->home, home);
+                pthread_mutex_init(&groupp->mutex, NULL);
+                pthread_cond_init(&groupp->cond, NULL);
+                groupp->written = 0;
+                groupp->flushed = 0;
+                groupp->flushing = RDB_FALSE;
+                groupp->nextp = commit_groups;
+                commit_groups = groupp;
+            }
+        }
+    }
+    pthread_mutex_unlock(&commit_groups_mutex);
+    return groupp;
+}
+
+/*
+ * Flush the log after the log records of a commit have been written.
+ * The first thread which arrives waits for the group commit delay,
+ * then flushes the log for all commits which have been written so far.
+ * The other threads wait until the log has been flushed for them.
+ */
+static int
+group_flush(RDB_environment *envp)
+{
+    int ret = 0;
+    unsigned long ticket;
+    unsigned long target;
+    struct timespec delay;
+    DB_ENV *dbenvp = envp->env.envp;
+    commit_group *groupp = get_commit_group(dbenvp);
+
+    if (groupp == NULL)
+        return dbenvp->log_flush(dbenvp, NULL);
+
+    pthread_mutex_lock(&groupp->mutex);
+    ticket = ++groupp->written;
+    while (groupp->flushed < ticket) {
+        if (groupp->flushing) {
+            pthread_cond_wait(&groupp->cond, &groupp->mutex);
+            continue;
+        }
+
+        /* Become the thread which flushes the log */
+        groupp->flushing = RDB_TRUE;
+        pthread_mutex_unlock(&groupp->mutex);
+
+        delay.tv_sec = envp->group_commit_delay / 1000000;
+        delay.tv_nsec = (long) (envp->group_commit_delay % 1000000) * 1000;
+        nanosleep(&delay, NULL);
+
+        /* Commits written until now will be flushed */
+        pthread_mutex_lock(&groupp->mutex);
+        target = groupp->written;
+        pthread_mutex_unlock(&groupp->mutex);
+
+        ret = dbenvp->log_flush(dbenvp, NULL);
+
+        pthread_mutex_lock(&groupp->mutex);
+        groupp->flushing = RDB_FALSE;
+        if (ret == 0 && target > groupp->flushed)
+            groupp->flushed = target;
+        pthread_cond_broadcast(&groupp->cond);
+        if (ret != 0)
+            break;
+    }
+    pthread_mutex_unlock(&groupp->mutex);
+    return ret;
+}
+
+/*
+ * Return RDB_TRUE if the log is flushed on commit by default,
+ * i.e. neither DB_TXN_NOSYNC nor DB_TXN_WRITE_NOSYNC is set
+ * for the environment, which may also be done in DB_CONFIG.
+ */
+static RDB_bool
+env_syncs_on_commit(RDB_environment *envp)
+{
+    u_int32_t envflags;
+    DB_ENV *dbenvp = envp->env.envp;
+
+    if (dbenvp->get_flags(dbenvp, &envflags) != 0)
+        return RDB_FALSE;
+    return (RDB_bool) ((envflags & (DB_TXN_NOSYNC | DB_TXN_WRITE_NOSYNC)) == 0);
+}
+#endif
+
 RDB_rec_transaction *
 RDB_bdb_begin_tx(RDB_environment *envp,
         RDB_rec_transaction *parent_rtxp, RDB_exec_context *ecp)
@@ -25,14 +175,70 @@ RDB_bdb_begin_tx(RDB_environment *envp,
     return (RDB_rec_transaction *)txp;
 }
 
+/*
+ * Commit the transaction.
+ * If group commit is enabled and the log is to be flushed,
+ * the log records are written without flushing and the log is flushed
+ * together with the log records of concurrent commits.
+ * With the default durability, this is only done if the environment
+ * flushes the log on commit.
+ * If flushing the log fails, a system error is raised. In this case
+ * the transaction has been committed but is not durable, and it will be
+ * lost if the system crashes before the log is flushed successfully.
+ */
 int
-RDB_bdb_commit(RDB_rec_transaction *rtxp, RDB_exec_context *ecp)
+RDB_bdb_commit(RDB_rec_transaction *rtxp, RDB_environment *envp,
+        RDB_durability durability, RDB_exec_context *ecp)
 {
-    int ret = ((DB_TXN *) rtxp)->commit((DB_TXN *) rtxp, 0);
+    int ret;
+    u_int32_t flags = 0;
+    RDB_bool group = RDB_FALSE;
+
+    /* The durability of nested transactions is that of the parent */
+    if (((DB_TXN *) rtxp)->parent == NULL) {
+        switch (durability) {
+            case RDB_DURABILITY_DEFAULT:
+                break;
+            case RDB_DURABILITY_SYNC:
+                flags = DB_TXN_SYNC;
+                break;
+            case RDB_DURABILITY_WRITE_NOSYNC:
+                flags = DB_TXN_WRITE_NOSYNC;
+                break;
+            case RDB_DURABILITY_NOSYNC:
+                flags = DB_TXN_NOSYNC;
+                break;
+        }
+#ifndef _WIN32
+        if (envp->group_commit_delay > 0
+                && (durability == RDB_DURABILITY_SYNC
+                        || (durability == RDB_DURABILITY_DEFAULT
+                                && env_syncs_on_commit(envp)))) {
+            flags = DB_TXN_WRITE_NOSYNC;
+            group = RDB_TRUE;
+        }
+#endif
+    }
+
+    ret = ((DB_TXN *) rtxp)->commit((DB_TXN *) rtxp, flags);
     if (ret != 0) {
         RDB_errcode_to_error(ret, ecp);
         return RDB_ERROR;
     }
+#ifndef _WIN32
+    if (group) {
+        ret = group_flush(envp);
+        if (ret != 0) {
+            char msg[256];
+
+            snprintf(msg, sizeof(msg),
+                    "transaction committed, but flushing the log failed: %s",
+                    db_strerror(ret));
+            RDB_raise_system(msg, ecp);
+            return RDB_ERROR;
+        }
+    }
+#endif
     return RDB_OK;
 }
 
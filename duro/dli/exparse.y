@@ -174,6 +174,7 @@ yyerror(const char *);
 %token TOK_MAP "MAP"
 %token TOK_PACKAGE "PACKAGE"
 %token TOK_LIMIT "LIMIT"
+%token TOK_ANALYZE "ANALYZE"
 %token TOK_INVALID "invalid"
 
 %left TOK_FROM TOK_ELSE ','
@@ -948,6 +949,18 @@ statement: assignment ';' {
         RDB_parse_add_child($$, $3);
         RDB_parse_add_child($$, $4);
     }
+    | TOK_ANALYZE TOK_ID ';' {
+        $$ = new_parse_inner();
+        if ($$ == NULL) {
+            RDB_parse_del_node($1, RDB_parse_ecp);
+            RDB_parse_del_node($2, RDB_parse_ecp);
+            RDB_parse_del_node($3, RDB_parse_ecp);
+            YYABORT;
+        }
+        RDB_parse_add_child($$, $1);
+        RDB_parse_add_child($$, $2);
+        RDB_parse_add_child($$, $3);
+    }
     | map_def
     | TOK_EXPLAIN expression TOK_ORDER '(' order_item_commalist ')' ';' {
         $$ = new_parse_inner();
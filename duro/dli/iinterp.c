@@ -27,6 +27,13 @@ typedef struct yy_buffer_state *YY_BUFFER_STATE;
 YY_BUFFER_STATE yy_scan_string(const char *txt);
 void yy_delete_buffer(YY_BUFFER_STATE);
 
+extern int yylineno;
+
+enum {
+    /* Maximum number of statement strings in the statement cache */
+    STMT_CACHE_SIZE = 64
+};
+
 /** @page update-ops Built-in system and connection operators
 
 OPERATOR connect(envname string) UPDATES {};
@@ -39,6 +46,17 @@ OPERATOR connect(envname string, recover boolean) UPDATES {};
 Connects to the database environment \a envname.
 If \a recover is true, connect with the Berkeley DB DB_RECOVER flag.
 
+OPERATOR connect(envname string, recover boolean, config string) UPDATES {};
+
+Connects to the database environment \a envname using the settings
+given by \a config.
+\a config is a list of settings of the form <code>name=value</code>,
+separated by whitespace or commas, e.g.
+<code>'cache_size=64M durability=write_nosync'</code>.
+See RDB_parse_env_config() for the supported settings.
+With Berkeley DB, the settings take effect when the environment is created,
+so \a recover should be true.
+
 OPERATOR disconnect() UPDATES {};
 
 Closes the database connection and sets current_db to the empty string.
@@ -137,6 +155,37 @@ connect_recover_op(int argc, RDB_object *argv[], RDB_operator *op,
     return RDB_OK;
 }
 
+static int
+connect_config_op(int argc, RDB_object *argv[], RDB_operator *op,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int ret;
+    RDB_env_config config;
+    Duro_interp *interp = RDB_ec_property(ecp, "INTERP");
+
+    RDB_init_env_config(&config);
+    if (RDB_parse_env_config(RDB_obj_string(argv[2]), &config, ecp) != RDB_OK)
+        return RDB_ERROR;
+
+    if (interp->txnp != NULL) {
+        ret = Duro_rollback_all(interp, ecp);
+        if (ret == RDB_OK && RDB_parse_get_interactive())
+            printf("Transaction rolled back.\n");
+    }
+
+    if (interp->envp != NULL) {
+        RDB_close_env(interp->envp, ecp);
+    }
+
+    interp->envp = RDB_open_env_config(RDB_obj_string(argv[0]),
+            RDB_obj_bool(argv[1]) ? RDB_RECOVER : 0, &config, ecp);
+    if (interp->envp == NULL) {
+        RDB_handle_err(ecp, txp);
+        return RDB_ERROR;
+    }
+    return RDB_OK;
+}
+
 static int
 disconnect_op(int argc, RDB_object *argv[], RDB_operator *op,
         RDB_exec_context *ecp, RDB_transaction *txp)
@@ -163,6 +212,9 @@ disconnect_op(int argc, RDB_object *argv[], RDB_operator *op,
             printf("Transaction rolled back.\n");
     }
 
+    /* Statements cannot be reused with another environment */
+    Duro_clear_qcache(&interp->stmt_cache, ecp);
+
     /* Close DB environment */
     ret = RDB_close_env(interp->envp, ecp);
     interp->envp = NULL;
@@ -291,6 +343,7 @@ Duro_init_interp(Duro_interp *interp, RDB_exec_context *ecp,
 {
     static RDB_parameter connect_params[1];
     static RDB_parameter connect_create_params[2];
+    static RDB_parameter connect_config_params[3];
     static RDB_parameter create_db_params[1];
     static RDB_parameter create_env_params[1];
     static RDB_parameter trace_params[2];
@@ -301,6 +354,12 @@ Duro_init_interp(Duro_interp *interp, RDB_exec_context *ecp,
     connect_create_params[0].update = RDB_FALSE;
     connect_create_params[1].typ = &RDB_BOOLEAN;
     connect_create_params[1].update = RDB_FALSE;
+    connect_config_params[0].typ = &RDB_STRING;
+    connect_config_params[0].update = RDB_FALSE;
+    connect_config_params[1].typ = &RDB_BOOLEAN;
+    connect_config_params[1].update = RDB_FALSE;
+    connect_config_params[2].typ = &RDB_STRING;
+    connect_config_params[2].update = RDB_FALSE;
     create_db_params[0].typ = &RDB_STRING;
     create_db_params[0].update = RDB_FALSE;
     create_env_params[0].typ = &RDB_STRING;
@@ -324,6 +383,10 @@ Duro_init_interp(Duro_interp *interp, RDB_exec_context *ecp,
 
     RDB_init_hashmap(&interp->uop_info_map, 5);
 
+    RDB_init_arena(&interp->stmt_arena);
+
+    Duro_init_qcache(&interp->stmt_cache, STMT_CACHE_SIZE);
+
     RDB_init_obj(&interp->pkg_name);
 
     interp->current_db_objp = RDB_alloc(sizeof (RDB_object), ecp);
@@ -342,12 +405,20 @@ Duro_init_interp(Duro_interp *interp, RDB_exec_context *ecp,
         goto error;
     RDB_init_obj(interp->implicit_tx_objp);
 
+    interp->tx_durability_objp = RDB_alloc(sizeof (RDB_object), ecp);
+    if (interp->tx_durability_objp == NULL)
+        goto error;
+    RDB_init_obj(interp->tx_durability_objp);
+
     if (RDB_put_upd_op(&interp->sys_upd_op_map, "connect", 1, connect_params, &connect_op,
             ecp) != RDB_OK)
         goto error;
     if (RDB_put_upd_op(&interp->sys_upd_op_map, "connect", 2, connect_create_params,
             &connect_recover_op, ecp) != RDB_OK)
         goto error;
+    if (RDB_put_upd_op(&interp->sys_upd_op_map, "connect", 3, connect_config_params,
+            &connect_config_op, ecp) != RDB_OK)
+        goto error;
     if (RDB_put_upd_op(&interp->sys_upd_op_map, "disconnect", 0, NULL, &disconnect_op,
             ecp) != RDB_OK)
         goto error;
@@ -365,9 +436,11 @@ Duro_init_interp(Duro_interp *interp, RDB_exec_context *ecp,
         goto error;
     }
 
-    /* Create current_db and implicit_tx in system package */
+    /* Create current_db, implicit_tx, and tx_durability in system package */
 
     RDB_bool_to_obj(interp->implicit_tx_objp, RDB_FALSE);
+    if (RDB_string_to_obj(interp->tx_durability_objp, "", ecp) != RDB_OK)
+        goto error;
 
     if (Duro_varmap_put(&interp->root_varmap, "current_db",
             interp->current_db_objp, DURO_VAR_FREE, ecp) != RDB_OK) {
@@ -379,6 +452,11 @@ Duro_init_interp(Duro_interp *interp, RDB_exec_context *ecp,
         goto error;
     }
 
+    if (Duro_varmap_put(&interp->root_varmap, "tx_durability",
+            interp->tx_durability_objp, DURO_VAR_FREE, ecp) != RDB_OK) {
+        goto error;
+    }
+
     if (add_io(interp, ecp) != RDB_OK) {
         goto error;
     }
@@ -394,6 +472,7 @@ error:
     RDB_destroy_op_map(&interp->sys_upd_op_map);
     RDB_destroy_obj(&interp->pkg_name, ecp);
     RDB_destroy_hashmap(&interp->uop_info_map);
+    Duro_destroy_qcache(&interp->stmt_cache, ecp);
     return RDB_ERROR;
 }
 
@@ -426,6 +505,10 @@ Duro_destroy_interp(Duro_interp *interp)
 
     RDB_destroy_hashmap(&interp->uop_info_map);
 
+    RDB_destroy_arena(&interp->stmt_arena);
+
+    Duro_destroy_qcache(&interp->stmt_cache, &ec);
+
     RDB_destroy_obj(&interp->pkg_name, &ec);
 
     if (interp->envp != NULL)
@@ -593,14 +676,53 @@ error:
     return RDB_ERROR;
 }
 
+/*
+ * Execute the statements of a cache entry.
+ */
+static int
+exec_cached_stmts(Duro_qentry *entryp, Duro_interp *interp,
+        RDB_exec_context *ecp)
+{
+    RDB_parse_node *stmtp;
+
+    for (stmtp = entryp->stmtp; stmtp != NULL; stmtp = stmtp->nextp) {
+        if (Duro_exec_parsed_stmt(stmtp, interp, ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
+    return RDB_OK;
+}
+
+/*
+ * Return the statements of a cache entry to the statement cache.
+ * Failing to cache the statements is not an error because they
+ * have already been executed.
+ */
+static void
+put_cached_stmts(Duro_qentry *entryp, Duro_interp *interp,
+        RDB_exec_context *ecp)
+{
+    if (Duro_qcache_put(&interp->stmt_cache, entryp, interp->envp, ecp)
+            != RDB_OK) {
+        RDB_clear_err(ecp);
+    }
+}
+
 /**
  * Read statements from string instr and execute them.
+ *
+ * The parsed statements are kept in a cache, so if the same string
+ * is executed again, the statements are not parsed again.
+ * Cached statements are discarded when the catalog changes.
  */
 int
 Duro_dt_execute_str(const char *instr, Duro_interp *interp,
         RDB_exec_context *ecp)
 {
     YY_BUFFER_STATE buf;
+    Duro_qentry *entryp;
+    RDB_parse_node *stmtp;
+    RDB_parse_node *laststmtp = NULL;
+
     interp->interrupted = 0;
 
     /* Initialize error line and operator */
@@ -613,24 +735,62 @@ Duro_dt_execute_str(const char *instr, Duro_interp *interp,
     if (RDB_ec_set_property(ecp, "INTERP", interp) != RDB_OK)
         return RDB_ERROR;
 
+    entryp = Duro_qcache_get(&interp->stmt_cache, instr, interp->envp, ecp);
+    if (entryp != NULL) {
+        if (exec_cached_stmts(entryp, interp, ecp) != RDB_OK) {
+            Duro_del_qentry(entryp, ecp);
+            return RDB_ERROR;
+        }
+        put_cached_stmts(entryp, interp, ecp);
+        return RDB_OK;
+    }
+
+    /*
+     * Create the entry before parsing so it is discarded if the catalog
+     * changes while the statements are parsed or executed
+     */
+    entryp = Duro_new_qentry(instr, interp->envp, ecp);
+    if (entryp == NULL)
+        return RDB_ERROR;
+
     buf = yy_scan_string(instr);
     if (buf == NULL) {
         RDB_raise_internal("yy_scan_string() failed", ecp);
-        goto error;
+        Duro_del_qentry(entryp, ecp);
+        return RDB_ERROR;
     }
 
-    while (Duro_process_stmt(interp, ecp) == RDB_OK);
+    for (;;) {
+        stmtp = RDB_parse_stmt(ecp);
+        if (stmtp == NULL) {
+            if (RDB_get_err(ecp) != NULL) {
+                interp->err_line = yylineno;
+                goto error;
+            }
+            /* EOF */
+            break;
+        }
+        RDB_clear_err(ecp);
 
-    if (RDB_get_err(ecp) != NULL) {
-        goto error;
-    } else {
-        /* Exit on EOF  */
-        yy_delete_buffer(buf);
-        return RDB_OK;
+        /* Append statement to the entry, which takes ownership of it */
+        stmtp->nextp = NULL;
+        if (laststmtp == NULL)
+            entryp->stmtp = stmtp;
+        else
+            laststmtp->nextp = stmtp;
+        laststmtp = stmtp;
+
+        if (Duro_exec_parsed_stmt(stmtp, interp, ecp) != RDB_OK)
+            goto error;
     }
+    yy_delete_buffer(buf);
+
+    put_cached_stmts(entryp, interp, ecp);
+    return RDB_OK;
 
 error:
     yy_delete_buffer(buf);
+    Duro_del_qentry(entryp, ecp);
     return RDB_ERROR;
 }
 
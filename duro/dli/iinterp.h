@@ -3,8 +3,10 @@
 
 #include <rel/rdb.h>
 #include <obj/opmap.h>
+#include <gen/arena.h>
 #include "parse.h"
 #include "varmap.h"
+#include "qcache.h"
 
 #include <signal.h>
 #include <stdio.h>
@@ -70,10 +72,23 @@ typedef struct Duro_interp {
 
     RDB_object *current_db_objp;
     RDB_object *implicit_tx_objp;
+    RDB_object *tx_durability_objp;
 
     /* Data needed for user-defined operators */
     RDB_hashmap uop_info_map;
 
+    /*
+     * Temporary memory which is released when the statement
+     * that allocated it has been executed
+     */
+    RDB_arena stmt_arena;
+
+    /*
+     * Statements parsed by Duro_dt_execute_str(), so statements which are
+     * executed repeatedly need not be parsed again
+     */
+    Duro_qcache stmt_cache;
+
     void *user_data;
 
     RDB_bool retryable;
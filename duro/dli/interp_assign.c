@@ -1191,8 +1191,10 @@ Duro_exec_load(RDB_parse_node *nodep, Duro_interp *interp, RDB_exec_context *ecp
     seqitnodep = nodep->nextp->nextp->nextp->nextp->nextp;
     seqitc = (RDB_parse_nodelist_length(seqitnodep) + 1) / 2;
     if (seqitc > 0) {
-        seqitv = RDB_alloc(sizeof(RDB_seq_item) * seqitc, ecp);
+        seqitv = RDB_arena_alloc(&interp->stmt_arena,
+                sizeof(RDB_seq_item) * seqitc);
         if (seqitv == NULL) {
+            RDB_raise_no_memory(ecp);
             ret = RDB_ERROR;
             goto cleanup;
         }
@@ -1232,8 +1234,6 @@ Duro_exec_load(RDB_parse_node *nodep, Duro_interp *interp, RDB_exec_context *ecp
     }
 
 cleanup:
-    if (seqitv != NULL)
-        RDB_free(seqitv);
     RDB_destroy_obj(&srctb, ecp);
     return ret;
 }
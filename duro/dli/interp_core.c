@@ -282,9 +282,22 @@ Duro_exec_rename(const RDB_parse_node *nodep, Duro_interp *interp,
 static const char *
 var_of_type(Duro_varmap *mapp, RDB_type *typ)
 {
+    int i;
     RDB_hashtable_iter it;
     Duro_var_entry *entryp;
 
+    if (mapp->slottabp != NULL) {
+        for (i = 0; i < mapp->slottabp->slotc; i++) {
+            entryp = &mapp->slotv[i];
+            if (entryp->varp != NULL) {
+                RDB_type *vtyp = RDB_obj_type(entryp->varp);
+
+                if (vtyp != NULL && RDB_type_depends_type(vtyp, typ))
+                    return entryp->name;
+            }
+        }
+    }
+
     RDB_init_hashtable_iter(&it, &mapp->hashtab);
     for(;;) {
         entryp = RDB_hashtable_next(&it);
@@ -17,7 +17,10 @@
 
 enum {
     DURO_MAX_LLEN = 64,
-    DEFAULT_VARMAP_SIZE = 128
+    DEFAULT_VARMAP_SIZE = 128,
+
+    /* Number of operator frame slots which are allocated on the stack */
+    DURO_FRAME_SLOTS = 16
 };
 
 typedef struct Duro_return_info {
@@ -30,6 +33,9 @@ typedef struct {
     RDB_parse_node *stmtlistp;
     int argnamec;
     char **argnamev;
+
+    /* Slots of the parameters and of the variables of the operator body */
+    Duro_slot_table slottab;
 } Duro_op_data;
 
 int
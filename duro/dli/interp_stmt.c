@@ -5,6 +5,7 @@
  * See the file COPYING for redistribution information.
  */
 
+#include "interp_stmt.h"
 #include "interp_core.h"
 #include "interp_vardef.h"
 #include "interp_assign.h"
@@ -351,9 +352,12 @@ exec_foreach(const RDB_parse_node *nodep, const RDB_parse_node *labelp,
     seqitnodep = nodep->nextp->nextp->nextp->nextp->nextp;
     seqitc = (RDB_parse_nodelist_length(seqitnodep) + 1) / 2;
     if (seqitc > 0) {
-        seqitv = RDB_alloc(sizeof(RDB_seq_item) * seqitc, ecp);
-        if (seqitv == NULL)
+        seqitv = RDB_arena_alloc(&interp->stmt_arena,
+                sizeof(RDB_seq_item) * seqitc);
+        if (seqitv == NULL) {
+            RDB_raise_no_memory(ecp);
             goto error;
+        }
     }
     seqitnodep = nodep->nextp->nextp->nextp->nextp->nextp;
     if (Duro_nodes_to_seqitv(seqitv, seqitnodep->val.children.firstp, interp, ecp)
@@ -414,7 +418,6 @@ exec_foreach(const RDB_parse_node *nodep, const RDB_parse_node *labelp,
     /* Set to previous FOREACH iterator (or NULL) */
     interp->current_foreachp = it.prevp;
 
-    RDB_free(seqitv);
     if (RDB_del_table_iterator(it.qrp, ecp, txp) != RDB_OK) {
         RDB_destroy_obj(&tb, ecp);
         return RDB_ERROR;
@@ -436,7 +439,6 @@ error:
         interp->current_foreachp = it.prevp;
     }
     RDB_destroy_obj(&tb, ecp);
-    RDB_free(seqitv);
     return RDB_ERROR;
 }
 
@@ -494,11 +496,37 @@ exec_begin_tx(Duro_interp *interp, RDB_exec_context *ecp)
     return RDB_OK;
 }
 
+/*
+ * Get the durability from the variable tx_durability.
+ * The empty string means the setting of the environment.
+ */
+static int
+tx_durability(Duro_interp *interp, RDB_durability *durabilityp,
+        RDB_exec_context *ecp)
+{
+    const char *str = RDB_obj_string(interp->tx_durability_objp);
+
+    if (str[0] == '\0') {
+        *durabilityp = RDB_DURABILITY_DEFAULT;
+    } else if (strcmp(str, "sync") == 0) {
+        *durabilityp = RDB_DURABILITY_SYNC;
+    } else if (strcmp(str, "write_nosync") == 0) {
+        *durabilityp = RDB_DURABILITY_WRITE_NOSYNC;
+    } else if (strcmp(str, "nosync") == 0) {
+        *durabilityp = RDB_DURABILITY_NOSYNC;
+    } else {
+        RDB_raise_invalid_argument("invalid value of tx_durability", ecp);
+        return RDB_ERROR;
+    }
+    return RDB_OK;
+}
+
 int
 Duro_commit(Duro_interp *interp, RDB_exec_context *ecp)
 {
     tx_node *ptxnp;
     int ret;
+    RDB_durability durability;
 
     if (interp->txnp == NULL) {
         RDB_raise_no_running_tx(ecp);
@@ -510,6 +538,12 @@ Duro_commit(Duro_interp *interp, RDB_exec_context *ecp)
         return RDB_ERROR;
     }
 
+    if (interp->txnp->parentp == NULL) {
+        if (tx_durability(interp, &durability, ecp) != RDB_OK)
+            return RDB_ERROR;
+        RDB_tx_set_durability(&interp->txnp->tx, durability);
+    }
+
     ret = RDB_commit(ecp, &interp->txnp->tx);
 
     /*
@@ -1441,6 +1475,9 @@ free_opdata(RDB_operator *op)
     /* Initialize temporary execution context */
     RDB_init_exec_context(&ec);
 
+    /* The slot table refers to names in the code, so it's deleted first */
+    Duro_destroy_slot_table(&opdatap->slottab);
+
     /* Delete code */
     RDB_parse_del_node(opdatap->rootp, &ec);
 
@@ -1450,6 +1487,82 @@ free_opdata(RDB_operator *op)
     RDB_free(opdatap);
 }
 
+/*
+ * Assign slots to the variables and constants defined by the statements
+ * which are executed in the operator frame, i.e. not in a nested block.
+ * Real, virtual and public tables are not stored in the frame.
+ */
+static int
+compile_stmts(const RDB_parse_node *stmtp, Duro_slot_table *slottabp,
+        RDB_exec_context *ecp)
+{
+    const RDB_parse_node *firstchildp;
+
+    for (; stmtp != NULL; stmtp = stmtp->nextp) {
+        if (stmtp->kind != RDB_NODE_INNER)
+            continue;
+        firstchildp = stmtp->val.children.firstp;
+        if (firstchildp == NULL || firstchildp->kind != RDB_NODE_TOK)
+            continue;
+        switch (firstchildp->val.token) {
+        case TOK_VAR:
+            if (firstchildp->nextp->nextp->kind == RDB_NODE_TOK) {
+                int tok = firstchildp->nextp->nextp->val.token;
+                if (tok == TOK_REAL || tok == TOK_VIRTUAL || tok == TOK_PUBLIC)
+                    break;
+            }
+            /* Fall through */
+        case TOK_CONST:
+            if (firstchildp->nextp->kind == RDB_NODE_EXPR
+                    && Duro_slot_table_add(slottabp,
+                            RDB_expr_var_name(firstchildp->nextp->exp),
+                            ecp) != RDB_OK) {
+                return RDB_ERROR;
+            }
+            break;
+        case TOK_BEGIN:
+            /* BEGIN ... END does not create a block */
+            if (firstchildp->nextp->kind == RDB_NODE_INNER) {
+                if (compile_stmts(firstchildp->nextp->val.children.firstp,
+                        slottabp, ecp) != RDB_OK) {
+                    return RDB_ERROR;
+                }
+            }
+            break;
+        }
+    }
+    return RDB_OK;
+}
+
+/*
+ * Resolve the names of the parameters and of the local variables
+ * of the operator to slots, so the operator frame can store them
+ * in an array instead of allocating a hashtable entry per variable
+ * on every invocation.
+ * Variables of nested blocks are still stored in the varmaps of the blocks,
+ * and variables not found in the slot table in the hashtable of the frame.
+ */
+static int
+compile_op(Duro_op_data *opdatap, RDB_exec_context *ecp)
+{
+    int i;
+
+    Duro_init_slot_table(&opdatap->slottab);
+    for (i = 0; i < opdatap->argnamec; i++) {
+        if (Duro_slot_table_add(&opdatap->slottab, opdatap->argnamev[i],
+                ecp) != RDB_OK) {
+            goto error;
+        }
+    }
+    if (compile_stmts(opdatap->stmtlistp, &opdatap->slottab, ecp) != RDB_OK)
+        goto error;
+    return RDB_OK;
+
+error:
+    Duro_destroy_slot_table(&opdatap->slottab);
+    return RDB_ERROR;
+}
+
 int
 Duro_dt_invoke_ro_op(int argc, RDB_object *argv[], RDB_operator *op,
         RDB_exec_context *ecp, RDB_transaction *txp,
@@ -1458,6 +1571,8 @@ Duro_dt_invoke_ro_op(int argc, RDB_object *argv[], RDB_operator *op,
     int i;
     int ret;
     varmap_node vars;
+    Duro_var_entry slotbuf[DURO_FRAME_SLOTS];
+    Duro_var_entry *slotv = slotbuf;
     RDB_parse_node *codestmtp, *attrnodep;
     Duro_op_data *opdatap;
     Duro_return_info retinfo;
@@ -1510,12 +1625,23 @@ Duro_dt_invoke_ro_op(int argc, RDB_object *argv[], RDB_operator *op,
                 ->nextp->nextp->nextp->nextp->nextp->val.children.firstp;
         opdatap->argnamec = argc;
         opdatap->argnamev = argnamev;
+        if (compile_op(opdatap, ecp) != RDB_OK) {
+            RDB_parse_del_node(codestmtp, ecp);
+            RDB_free(argnamev);
+            RDB_free(opdatap);
+            return RDB_ERROR;
+        }
 
         RDB_set_operator_u_data(op, opdatap);
         RDB_set_op_cleanup_fn(op, &free_opdata);
     }
 
-    Duro_init_varmap(&vars.map, 256);
+    if (opdatap->slottab.slotc > DURO_FRAME_SLOTS) {
+        slotv = RDB_alloc(opdatap->slottab.slotc * sizeof(Duro_var_entry), ecp);
+        if (slotv == NULL)
+            return RDB_ERROR;
+    }
+    Duro_init_frame_varmap(&vars.map, &opdatap->slottab, slotv);
     vars.parentp = NULL;
     ovarmapp = Duro_set_current_varmap(interp, &vars);
 
@@ -1594,6 +1720,8 @@ Duro_dt_invoke_ro_op(int argc, RDB_object *argv[], RDB_operator *op,
 
     Duro_set_current_varmap(interp, ovarmapp);
     Duro_destroy_varmap(&vars.map);
+    if (slotv != slotbuf)
+        RDB_free(slotv);
 
     switch (ret) {
     case RDB_OK:
@@ -1627,6 +1755,8 @@ Duro_dt_invoke_update_op(int argc, RDB_object *argv[], RDB_operator *op,
     int ret;
     int i;
     varmap_node vars;
+    Duro_var_entry slotbuf[DURO_FRAME_SLOTS];
+    Duro_var_entry *slotv = slotbuf;
     RDB_parse_node *codestmtp;
     RDB_parse_node *attrnodep;
     varmap_node *ovarmapp;
@@ -1678,12 +1808,23 @@ Duro_dt_invoke_update_op(int argc, RDB_object *argv[], RDB_operator *op,
                     ->nextp->nextp->nextp->nextp->nextp->nextp->nextp->val.children.firstp;
         opdatap->argnamec = argc;
         opdatap->argnamev = argnamev;
+        if (compile_op(opdatap, ecp) != RDB_OK) {
+            RDB_parse_del_node(codestmtp, ecp);
+            RDB_free(argnamev);
+            RDB_free(opdatap);
+            return RDB_ERROR;
+        }
 
         RDB_set_operator_u_data(op, opdatap);
         RDB_set_op_cleanup_fn(op, &free_opdata);
     }
 
-    Duro_init_varmap(&vars.map, 256);
+    if (opdatap->slottab.slotc > DURO_FRAME_SLOTS) {
+        slotv = RDB_alloc(opdatap->slottab.slotc * sizeof(Duro_var_entry), ecp);
+        if (slotv == NULL)
+            return RDB_ERROR;
+    }
+    Duro_init_frame_varmap(&vars.map, &opdatap->slottab, slotv);
     vars.parentp = NULL;
     ovarmapp = Duro_set_current_varmap(interp, &vars);
 
@@ -1742,6 +1883,8 @@ Duro_dt_invoke_update_op(int argc, RDB_object *argv[], RDB_operator *op,
 
     Duro_set_current_varmap(interp, ovarmapp);
     Duro_destroy_varmap(&vars.map);
+    if (slotv != slotbuf)
+        RDB_free(slotv);
 
     /* Catch LEAVE */
     if (ret == DURO_LEAVE) {
@@ -2020,6 +2163,30 @@ exec_indexdef(RDB_parse_node *nodep, Duro_interp *interp,
     return ret;
 }
 
+static int
+exec_analyze(RDB_parse_node *nodep, Duro_interp *interp,
+        RDB_exec_context *ecp)
+{
+    RDB_object *tbp;
+    const char *tbname = RDB_expr_var_name(nodep->exp);
+
+    if (interp->txnp == NULL) {
+        RDB_raise_no_running_tx(ecp);
+        return RDB_ERROR;
+    }
+
+    tbp = RDB_get_table(tbname, ecp, &interp->txnp->tx);
+    if (tbp == NULL) {
+        return RDB_ERROR;
+    }
+
+    if (RDB_analyze_table(tbp, ecp, &interp->txnp->tx) != RDB_OK)
+        return RDB_ERROR;
+    if (RDB_parse_get_interactive())
+        printf("Table %s analyzed.\n", tbname);
+    return RDB_OK;
+}
+
 static int
 exec_constrdrop(RDB_parse_node *nodep, Duro_interp *interp,
         RDB_exec_context *ecp)
@@ -2502,8 +2669,10 @@ exec_explain(RDB_parse_node *nodep, Duro_interp *interp, RDB_exec_context *ecp)
 
     seqitc = RDB_parse_nodelist_length(nodep->nextp->nextp->nextp);
     if (seqitc > 0) {
-        seqitv = RDB_alloc(sizeof(RDB_seq_item) * seqitc, ecp);
+        seqitv = RDB_arena_alloc(&interp->stmt_arena,
+                sizeof(RDB_seq_item) * seqitc);
         if (seqitv == NULL) {
+            RDB_raise_no_memory(ecp);
             ret = RDB_ERROR;
             goto cleanup;
         }
@@ -2546,8 +2715,6 @@ exec_explain(RDB_parse_node *nodep, Duro_interp *interp, RDB_exec_context *ecp)
     fflush(stdout);
 
 cleanup:
-    if (seqitv != NULL)
-        RDB_free(seqitv);
     if (optexp != NULL) {
         RDB_del_expr(optexp, ecp);
     }
@@ -2559,7 +2726,7 @@ cleanup:
 }
 
 static int
-Duro_exec_stmt(RDB_parse_node *stmtp, Duro_interp *interp,
+exec_stmt(RDB_parse_node *stmtp, Duro_interp *interp,
         RDB_exec_context *ecp, Duro_return_info *retinfop)
 {
     int ret = RDB_OK;
@@ -2682,6 +2849,9 @@ Duro_exec_stmt(RDB_parse_node *stmtp, Duro_interp *interp,
             case TOK_INDEX:
                 ret = exec_indexdef(firstchildp->nextp, interp, ecp);
                 break;
+            case TOK_ANALYZE:
+                ret = exec_analyze(firstchildp->nextp, interp, ecp);
+                break;
             case TOK_EXPLAIN:
                 if (firstchildp->nextp->nextp->nextp == NULL) {
                     ret = Duro_exec_explain_assign(firstchildp->nextp, interp, ecp);
@@ -2770,6 +2940,23 @@ Duro_exec_stmt(RDB_parse_node *stmtp, Duro_interp *interp,
     return ret;
 }
 
+/*
+ * Execute a statement. Memory the statement allocates from the
+ * statement arena is released when the statement has been executed.
+ */
+static int
+Duro_exec_stmt(RDB_parse_node *stmtp, Duro_interp *interp,
+        RDB_exec_context *ecp, Duro_return_info *retinfop)
+{
+    int ret;
+    RDB_arena_mark mark;
+
+    RDB_arena_get_mark(&interp->stmt_arena, &mark);
+    ret = exec_stmt(stmtp, interp, ecp, retinfop);
+    RDB_arena_release(&interp->stmt_arena, &mark);
+    return ret;
+}
+
 static int
 Duro_exec_stmt_impl_tx(RDB_parse_node *stmtp, Duro_interp *interp,
         RDB_exec_context *ecp)
@@ -2866,25 +3053,40 @@ Duro_process_stmt(Duro_interp *interp, RDB_exec_context *ecp)
         return RDB_ERROR;
     }
     RDB_clear_err(ecp);
-    ret = Duro_exec_stmt_impl_tx(stmtp, interp, ecp);
+    ret = Duro_exec_parsed_stmt(stmtp, interp, ecp);
+    if (ret != RDB_OK) {
+        RDB_parse_del_node(stmtp, ecp);
+        return RDB_ERROR;
+    }
+
+    return RDB_parse_del_node(stmtp, ecp);
+}
+
+/*
+ * Execute a top-level statement which has already been parsed.
+ * The statement is not deleted, so it can be executed again.
+ */
+int
+Duro_exec_parsed_stmt(RDB_parse_node *stmtp, Duro_interp *interp,
+        RDB_exec_context *ecp)
+{
+    int ret = Duro_exec_stmt_impl_tx(stmtp, interp, ecp);
 
     if (ret != RDB_OK) {
         if (ret == DURO_RETURN) {
             RDB_raise_syntax("invalid RETURN", ecp);
-            interp->err_line = yylineno;
+            interp->err_line = stmtp->lineno;
             return RDB_ERROR;
         }
         if (ret == DURO_LEAVE) {
             RDB_raise_syntax("unmatched LEAVE", ecp);
-            interp->err_line = yylineno;
+            interp->err_line = stmtp->lineno;
             return RDB_ERROR;
         }
-        RDB_parse_del_node(stmtp, ecp);
         if (RDB_get_err(ecp) == NULL) {
             RDB_raise_internal("statement execution failed, no error available", ecp);
         }
         return RDB_ERROR;
     }
-
-    return RDB_parse_del_node(stmtp, ecp);
+    return RDB_OK;
 }
@@ -11,8 +11,12 @@
 typedef struct Duro_interp Duro_interp;
 
 typedef struct RDB_exec_context RDB_exec_context;
+struct RDB_parse_node;
 
 int
 Duro_process_stmt(Duro_interp *, RDB_exec_context *);
 
+int
+Duro_exec_parsed_stmt(struct RDB_parse_node *, Duro_interp *, RDB_exec_context *);
+
 #endif /* INTERP_STMT_H_ */
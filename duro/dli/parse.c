@@ -16,6 +16,12 @@
 #include <string.h>
 #include <locale.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
 int yyparse(void);
 
 typedef struct yy_buffer_state *YY_BUFFER_STATE;
@@ -32,9 +38,39 @@ extern int yylineno;
 RDB_parse_node *RDB_parse_resultp;
 RDB_exec_context *RDB_parse_ecp;
 
+/*
+ * The parser and the LC_NUMERIC locale are global,
+ * so parsing is serialized if there are several threads
+ */
+#ifdef _WIN32
+static SRWLOCK parse_lock = SRWLOCK_INIT;
+#else
+static pthread_mutex_t parse_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void
+lock_parser(void)
+{
+#ifdef _WIN32
+    AcquireSRWLockExclusive(&parse_lock);
+#else
+    pthread_mutex_lock(&parse_mutex);
+#endif
+}
+
+static void
+unlock_parser(void)
+{
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(&parse_lock);
+#else
+    pthread_mutex_unlock(&parse_mutex);
+#endif
+}
+
 /* Array of tokens in alphabetical order for keyword completion */
 int RDB_parse_tokens[] = {
-    TOK_AND, TOK_ALL, TOK_ANY, TOK_AVG, TOK_ARRAY, TOK_AS, TOK_ASC,
+    TOK_ANALYZE, TOK_AND, TOK_ALL, TOK_ANY, TOK_AVG, TOK_ARRAY, TOK_AS, TOK_ASC,
     TOK_BEGIN, TOK_BUT, TOK_CALL, TOK_CASE, TOK_CATCH, TOK_COUNT, TOK_COMMIT,
     TOK_CONST, TOK_CONSTRAINT, TOK_DEFAULT, TOK_DELETE, TOK_DESC,
     TOK_DIVIDEBY, TOK_DROP, TOK_D_INSERT, TOK_D_UNION,
@@ -1371,25 +1407,8 @@ RDB_parse_node_expr(RDB_parse_node *nodep, RDB_exec_context *ecp,
     return NULL;
 }
 
-/**
- * Parse the <a href="../../expressions.html">expression</a>
-specified by <var>txt</var>.
-
-@returns A pointer to the RDB_parse_node representing the expression,
-or NULL if the parsing failed.
-
-@par Errors:
-<dl>
-<dt>SYNTAX_ERROR
-<dd>A syntax error occurred during parsing.
-</dl>
-
-The call may also fail for a @ref system-errors "system error".
-
-@warning The parser is not reentrant.
- */
-RDB_parse_node *
-RDB_parse_expr(const char *txt, RDB_exec_context *ecp)
+static RDB_parse_node *
+parse_expr(const char *txt, RDB_exec_context *ecp)
 {
     int pret;
     YY_BUFFER_STATE buf;
@@ -1439,6 +1458,34 @@ error:
     return NULL;
 }
 
+/**
+ * Parse the <a href="../../expressions.html">expression</a>
+specified by <var>txt</var>.
+
+@returns A pointer to the RDB_parse_node representing the expression,
+or NULL if the parsing failed.
+
+@par Errors:
+<dl>
+<dt>SYNTAX_ERROR
+<dd>A syntax error occurred during parsing.
+</dl>
+
+The call may also fail for a @ref system-errors "system error".
+
+Calls from different threads are serialized.
+ */
+RDB_parse_node *
+RDB_parse_expr(const char *txt, RDB_exec_context *ecp)
+{
+    RDB_parse_node *nodep;
+
+    lock_parser();
+    nodep = parse_expr(txt, ecp);
+    unlock_parser();
+    return nodep;
+}
+
 /*@}*/
 
 static RDB_type *
@@ -1618,8 +1665,8 @@ RDB_parse_node_to_type(RDB_parse_node *nodep, RDB_gettypefn *getfnp, void *getar
     return NULL;
 }
 
-RDB_parse_node *
-RDB_parse_stmt(RDB_exec_context *ecp)
+static RDB_parse_node *
+parse_stmt(RDB_exec_context *ecp)
 {
     int pret;
     RDB_object oldlocaleobj;
@@ -1672,7 +1719,18 @@ error:
 }
 
 RDB_parse_node *
-RDB_parse_stmt_string(const char *txt, RDB_exec_context *ecp)
+RDB_parse_stmt(RDB_exec_context *ecp)
+{
+    RDB_parse_node *nodep;
+
+    lock_parser();
+    nodep = parse_stmt(ecp);
+    unlock_parser();
+    return nodep;
+}
+
+static RDB_parse_node *
+parse_stmt_string(const char *txt, RDB_exec_context *ecp)
 {
     int pret;
     RDB_object oldlocaleobj;
@@ -1742,3 +1800,14 @@ error:
     yylineno = lineno;
     return NULL;
 }
+
+RDB_parse_node *
+RDB_parse_stmt_string(const char *txt, RDB_exec_context *ecp)
+{
+    RDB_parse_node *nodep;
+
+    lock_parser();
+    nodep = parse_stmt_string(txt, ecp);
+    unlock_parser();
+    return nodep;
+}
@@ -435,6 +435,8 @@ RDB_token_name(int tok)
         return "PACKAGE";
     case TOK_EXPLAIN:
         return "EXPLAIN";
+    case TOK_ANALYZE:
+        return "ANALYZE";
     }
     chtok[0] = (char) tok;
     chtok[1] = '\0';
@@ -0,0 +1,226 @@
+/*
+ * Cache for parsed and optimized queries and statements
+ *
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include "qcache.h"
+#include <gen/strfns.h>
+
+#include <string.h>
+
+enum {
+    QCACHE_CAPACITY = 64
+};
+
+static unsigned
+hash_entry(const void *entryp, void *arg)
+{
+    return ((const Duro_qentry *) entryp)->hash;
+}
+
+static RDB_bool
+entry_equals(const void *e1p, const void *e2p, void *arg)
+{
+    const Duro_qentry *entry1p = e1p;
+    const Duro_qentry *entry2p = e2p;
+
+    return (RDB_bool) (entry1p->hash == entry2p->hash
+            && strcmp(entry1p->key, entry2p->key) == 0);
+}
+
+static unsigned long
+catalog_version(RDB_environment *envp)
+{
+    return envp != NULL ? RDB_catalog_version(envp) : 0;
+}
+
+void
+Duro_init_qcache(Duro_qcache *qcp, int maxc)
+{
+    RDB_init_hashtable(&qcp->tab, QCACHE_CAPACITY, &hash_entry,
+            &entry_equals);
+    qcp->maxc = maxc;
+    qcp->envp = NULL;
+    qcp->firstp = NULL;
+    qcp->lastp = NULL;
+}
+
+/*
+ * Create an entry for the key given by key. The entry is marked
+ * with the current catalog version of *envp, so it must be created
+ * before the query or the statements are parsed.
+ * envp may be NULL if no environment is available.
+ */
+Duro_qentry *
+Duro_new_qentry(const char *key, RDB_environment *envp,
+        RDB_exec_context *ecp)
+{
+    Duro_qentry *entryp = RDB_alloc(sizeof(Duro_qentry), ecp);
+    if (entryp == NULL)
+        return NULL;
+    entryp->key = RDB_dup_str(key);
+    if (entryp->key == NULL) {
+        RDB_free(entryp);
+        RDB_raise_no_memory(ecp);
+        return NULL;
+    }
+    entryp->hash = RDB_hash_str(key);
+    entryp->envp = envp;
+    entryp->cat_version = catalog_version(envp);
+    entryp->tbp = NULL;
+    entryp->drop = RDB_FALSE;
+    entryp->texp = NULL;
+    entryp->exp = NULL;
+    entryp->stmtp = NULL;
+    entryp->prevp = NULL;
+    entryp->nextp = NULL;
+    return entryp;
+}
+
+void
+Duro_del_qentry(Duro_qentry *entryp, RDB_exec_context *ecp)
+{
+    if (entryp->texp != NULL)
+        RDB_del_expr(entryp->texp, ecp);
+    if (entryp->drop)
+        RDB_drop_table(entryp->tbp, ecp, NULL);
+    if (entryp->exp != NULL)
+        RDB_del_expr(entryp->exp, ecp);
+    if (entryp->stmtp != NULL)
+        RDB_parse_del_nodelist(entryp->stmtp, ecp);
+    RDB_free(entryp->key);
+    RDB_free(entryp);
+}
+
+static void
+unlink_entry(Duro_qcache *qcp, Duro_qentry *entryp)
+{
+    if (entryp->prevp != NULL)
+        entryp->prevp->nextp = entryp->nextp;
+    else
+        qcp->firstp = entryp->nextp;
+    if (entryp->nextp != NULL)
+        entryp->nextp->prevp = entryp->prevp;
+    else
+        qcp->lastp = entryp->prevp;
+    RDB_hashtable_del(&qcp->tab, entryp, NULL);
+}
+
+static void
+link_first(Duro_qcache *qcp, Duro_qentry *entryp)
+{
+    entryp->prevp = NULL;
+    entryp->nextp = qcp->firstp;
+    if (qcp->firstp != NULL)
+        qcp->firstp->prevp = entryp;
+    else
+        qcp->lastp = entryp;
+    qcp->firstp = entryp;
+}
+
+/*
+ * Remove all entries.
+ */
+void
+Duro_clear_qcache(Duro_qcache *qcp, RDB_exec_context *ecp)
+{
+    Duro_qentry *entryp = qcp->firstp;
+
+    while (entryp != NULL) {
+        Duro_qentry *nextp = entryp->nextp;
+        Duro_del_qentry(entryp, ecp);
+        entryp = nextp;
+    }
+    RDB_clear_hashtable(&qcp->tab);
+    qcp->firstp = NULL;
+    qcp->lastp = NULL;
+}
+
+void
+Duro_destroy_qcache(Duro_qcache *qcp, RDB_exec_context *ecp)
+{
+    Duro_clear_qcache(qcp, ecp);
+    RDB_destroy_hashtable(&qcp->tab);
+}
+
+/*
+ * Return the entry for the key given by key, or NULL if there is none.
+ * The entry is removed from the cache, so it cannot be removed
+ * by a nested call while it is used. The caller must either return it
+ * using Duro_qcache_put() or delete it.
+ * Entries which have been created with another environment handle or
+ * with a different catalog version are deleted.
+ */
+Duro_qentry *
+Duro_qcache_get(Duro_qcache *qcp, const char *key, RDB_environment *envp,
+        RDB_exec_context *ecp)
+{
+    Duro_qentry sentry;
+    Duro_qentry *entryp;
+
+    if (envp != qcp->envp) {
+        Duro_clear_qcache(qcp, ecp);
+        qcp->envp = envp;
+        return NULL;
+    }
+
+    sentry.key = (char *) key;
+    sentry.hash = RDB_hash_str(key);
+    entryp = RDB_hashtable_get(&qcp->tab, &sentry, NULL);
+    if (entryp == NULL)
+        return NULL;
+
+    unlink_entry(qcp, entryp);
+    if (entryp->cat_version != catalog_version(envp)) {
+        Duro_del_qentry(entryp, ecp);
+        return NULL;
+    }
+    return entryp;
+}
+
+/*
+ * Insert *entryp into the cache as the most recently used entry,
+ * removing the least recently used entry if the cache is full.
+ * If the environment handle or the catalog version has changed since
+ * *entryp has been created, or if the cache already contains an entry with the same key,
+ * *entryp is deleted instead.
+ * If the call fails, *entryp is deleted.
+ */
+int
+Duro_qcache_put(Duro_qcache *qcp, Duro_qentry *entryp, RDB_environment *envp,
+        RDB_exec_context *ecp)
+{
+    if (envp != qcp->envp) {
+        Duro_clear_qcache(qcp, ecp);
+        qcp->envp = envp;
+    }
+
+    if (entryp->envp != envp
+            || entryp->cat_version != catalog_version(envp)
+            || RDB_hashtable_get(&qcp->tab, entryp, NULL) != NULL) {
+        Duro_del_qentry(entryp, ecp);
+        return RDB_OK;
+    }
+
+    if (RDB_hashtable_size(&qcp->tab) >= qcp->maxc) {
+        Duro_qentry *lastp = qcp->lastp;
+
+        if (lastp == NULL) {
+            /* The cache is disabled */
+            Duro_del_qentry(entryp, ecp);
+            return RDB_OK;
+        }
+        unlink_entry(qcp, lastp);
+        Duro_del_qentry(lastp, ecp);
+    }
+
+    if (RDB_hashtable_put(&qcp->tab, entryp, NULL) != RDB_OK) {
+        Duro_del_qentry(entryp, ecp);
+        RDB_raise_no_memory(ecp);
+        return RDB_ERROR;
+    }
+    link_first(qcp, entryp);
+    return RDB_OK;
+}
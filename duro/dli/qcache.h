@@ -0,0 +1,84 @@
+#ifndef DURO_QCACHE_H
+#define DURO_QCACHE_H
+
+/*
+ * Cache for parsed and optimized queries and statements
+ *
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include <rel/rdb.h>
+#include <gen/hashtable.h>
+#include "parsenode.h"
+
+typedef struct Duro_qentry {
+    /* Identifies the query or the statements, e.g. the source text */
+    char *key;
+    unsigned hash;
+
+    /*
+     * Environment handle and catalog version at the time the entry
+     * was created. The entry is discarded if the catalog version has changed.
+     */
+    RDB_environment *envp;
+    unsigned long cat_version;
+
+    /* Table if the query is relation-valued, otherwise NULL */
+    RDB_object *tbp;
+
+    /* RDB_TRUE if *tbp has been created from the query */
+    RDB_bool drop;
+
+    /* Optimized expression of *tbp */
+    RDB_expression *texp;
+
+    /* Expression if the query is not relation-valued, otherwise NULL */
+    RDB_expression *exp;
+
+    /* Parsed statements, linked by nextp */
+    RDB_parse_node *stmtp;
+
+    /* Doubly linked list, from most recently to least recently used */
+    struct Duro_qentry *prevp;
+    struct Duro_qentry *nextp;
+} Duro_qentry;
+
+/*
+ * Maps keys to entries. If the maximum number of entries is reached,
+ * the least recently used entry is removed.
+ * Entries are only valid for the environment handle they have been
+ * created with and as long as the catalog version has not changed.
+ */
+typedef struct {
+    RDB_hashtable tab;
+    int maxc;
+    RDB_environment *envp;
+    Duro_qentry *firstp;
+    Duro_qentry *lastp;
+} Duro_qcache;
+
+void
+Duro_init_qcache(Duro_qcache *, int);
+
+void
+Duro_destroy_qcache(Duro_qcache *, RDB_exec_context *);
+
+void
+Duro_clear_qcache(Duro_qcache *, RDB_exec_context *);
+
+Duro_qentry *
+Duro_qcache_get(Duro_qcache *, const char *, RDB_environment *,
+        RDB_exec_context *);
+
+int
+Duro_qcache_put(Duro_qcache *, Duro_qentry *, RDB_environment *,
+        RDB_exec_context *);
+
+Duro_qentry *
+Duro_new_qentry(const char *, RDB_environment *, RDB_exec_context *);
+
+void
+Duro_del_qentry(Duro_qentry *, RDB_exec_context *);
+
+#endif
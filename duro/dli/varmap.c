@@ -29,15 +29,76 @@ varentry_equals(const void *e1p, const void *e2p, void *arg)
             ((Duro_var_entry *) e2p)->name) == 0);
 }
 
+typedef struct {
+    const char *name;
+    int idx;
+} slot_entry;
+
+static unsigned
+hash_slotentry(const void *entryp, void *arg)
+{
+    return RDB_hash_str(((slot_entry *) entryp)->name);
+}
+
+static RDB_bool
+slotentry_equals(const void *e1p, const void *e2p, void *arg)
+{
+    return (RDB_bool) (strcmp(((slot_entry *) e1p)->name,
+            ((slot_entry *) e2p)->name) == 0);
+}
+
 void
 Duro_init_varmap(Duro_varmap *varmap, int capacity) {
     RDB_init_hashtable(&varmap->hashtab, capacity, &hash_varentry,
             &varentry_equals);
+    varmap->slottabp = NULL;
+    varmap->slotv = NULL;
+}
+
+/*
+ * Initialize a varmap which stores the variables found in *slottabp
+ * in slotv. slotv must have room for slottabp->slotc entries
+ * and must not be freed before the varmap is destroyed.
+ */
+void
+Duro_init_frame_varmap(Duro_varmap *varmap, const Duro_slot_table *slottabp,
+        Duro_var_entry *slotv)
+{
+    int i;
+
+    /* Only variables not known at compile time go to the hashtable */
+    Duro_init_varmap(varmap, 16);
+    varmap->slottabp = slottabp;
+    varmap->slotv = slotv;
+
+    for (i = 0; i < slottabp->slotc; i++) {
+        slotv[i].name = (char *) slottabp->namev[i];
+        slotv[i].varp = NULL;
+        slotv[i].flags = 0;
+    }
+}
+
+static void
+free_entry_var(Duro_var_entry *entryp, RDB_exec_context *ecp)
+{
+    if (entryp->varp != NULL && DURO_VAR_FREE & entryp->flags) {
+        RDB_type *typ = RDB_obj_type(entryp->varp);
+        RDB_bool mustdel = !RDB_type_is_scalar(typ) && !RDB_type_is_relation(typ)
+                && !RDB_type_is_operator(typ);
+
+        RDB_free_obj(entryp->varp, ecp);
+
+        /* Array and tuple types must be destroyed */
+        if (mustdel) {
+            RDB_del_nonscalar_type(typ, ecp);
+        }
+    }
 }
 
 void
 Duro_destroy_varmap(Duro_varmap *varmap)
 {
+    int i;
     Duro_var_entry *entryp;
     RDB_hashtable_iter hiter;
     RDB_exec_context ec;
@@ -46,18 +107,7 @@ Duro_destroy_varmap(Duro_varmap *varmap)
 
     RDB_init_hashtable_iter(&hiter, &varmap->hashtab);
     while ((entryp = RDB_hashtable_next(&hiter)) != NULL) {
-        if (entryp->varp != NULL && DURO_VAR_FREE & entryp->flags) {
-            RDB_type *typ = RDB_obj_type(entryp->varp);
-            RDB_bool mustdel = !RDB_type_is_scalar(typ) && !RDB_type_is_relation(typ)
-                    && !RDB_type_is_operator(typ);
-
-            RDB_free_obj(entryp->varp, &ec);
-
-            /* Array and tuple types must be destroyed */
-            if (mustdel) {
-                RDB_del_nonscalar_type(typ, &ec);
-            }
-        }
+        free_entry_var(entryp, &ec);
         free(entryp->name);
         RDB_free(entryp);
     }
@@ -65,19 +115,47 @@ Duro_destroy_varmap(Duro_varmap *varmap)
 
     RDB_destroy_hashtable(&varmap->hashtab);
 
+    /* The names of the slots belong to the slot table */
+    if (varmap->slottabp != NULL) {
+        for (i = 0; i < varmap->slottabp->slotc; i++) {
+            free_entry_var(&varmap->slotv[i], &ec);
+        }
+    }
+
     RDB_destroy_exec_context(&ec);
 }
 
+/*
+ * Return the slot of the variable if the varmap is an operator frame
+ * and the variable has been assigned a slot, otherwise NULL
+ */
+static Duro_var_entry *
+varmap_slot(const Duro_varmap *varmap, const char *name)
+{
+    slot_entry entry;
+    slot_entry *entryp;
+
+    if (varmap->slottabp == NULL)
+        return NULL;
+    entry.name = name;
+    entryp = RDB_hashtable_get(&varmap->slottabp->hashtab, &entry, NULL);
+    if (entryp == NULL)
+        return NULL;
+    return &varmap->slotv[entryp->idx];
+}
+
 int
 Duro_varmap_put(Duro_varmap *varmap, const char *name,
         RDB_object *varp, int flags, RDB_exec_context *ecp)
 {
     int ret;
     Duro_var_entry entry;
-    Duro_var_entry *entryp;
+    Duro_var_entry *entryp = varmap_slot(varmap, name);
 
-    entry.name = (char *) name;
-    entryp = RDB_hashtable_get(&varmap->hashtab, &entry, NULL);
+    if (entryp == NULL) {
+        entry.name = (char *) name;
+        entryp = RDB_hashtable_get(&varmap->hashtab, &entry, NULL);
+    }
     if (entryp == NULL) {
         entryp = RDB_alloc(sizeof (Duro_var_entry), ecp);
         if (entryp == NULL) {
@@ -106,7 +184,76 @@ Duro_var_entry *
 Duro_varmap_get(const Duro_varmap *varmap, const char *name)
 {
     Duro_var_entry entry;
+    Duro_var_entry *entryp = varmap_slot(varmap, name);
+
+    if (entryp != NULL) {
+        /* Like a hashtable entry, a slot is only found after it was put */
+        return entryp->varp != NULL || entryp->flags != 0 ? entryp : NULL;
+    }
 
     entry.name = (char *) name;
     return RDB_hashtable_get(&varmap->hashtab, &entry, NULL);
 }
+
+void
+Duro_init_slot_table(Duro_slot_table *slottabp)
+{
+    RDB_init_hashtable(&slottabp->hashtab, 16, &hash_slotentry,
+            &slotentry_equals);
+    slottabp->slotc = 0;
+    slottabp->namev = NULL;
+}
+
+void
+Duro_destroy_slot_table(Duro_slot_table *slottabp)
+{
+    slot_entry *entryp;
+    RDB_hashtable_iter hiter;
+
+    RDB_init_hashtable_iter(&hiter, &slottabp->hashtab);
+    while ((entryp = RDB_hashtable_next(&hiter)) != NULL) {
+        RDB_free(entryp);
+    }
+    RDB_destroy_hashtable_iter(&hiter);
+    RDB_destroy_hashtable(&slottabp->hashtab);
+    RDB_free(slottabp->namev);
+}
+
+/*
+ * Assign the next slot to the variable if it does not already have one.
+ * The name is not copied and must not be freed before the slot table
+ * is destroyed.
+ */
+int
+Duro_slot_table_add(Duro_slot_table *slottabp, const char *name,
+        RDB_exec_context *ecp)
+{
+    int ret;
+    slot_entry entry;
+    slot_entry *entryp;
+    const char **namev;
+
+    entry.name = name;
+    if (RDB_hashtable_get(&slottabp->hashtab, &entry, NULL) != NULL)
+        return RDB_OK;
+
+    namev = RDB_realloc(slottabp->namev,
+            (slottabp->slotc + 1) * sizeof(char *), ecp);
+    if (namev == NULL)
+        return RDB_ERROR;
+    slottabp->namev = namev;
+
+    entryp = RDB_alloc(sizeof (slot_entry), ecp);
+    if (entryp == NULL)
+        return RDB_ERROR;
+    entryp->name = name;
+    entryp->idx = slottabp->slotc;
+    ret = RDB_hashtable_put(&slottabp->hashtab, entryp, NULL);
+    if (ret != RDB_OK) {
+        RDB_free(entryp);
+        RDB_errno_to_error(ret, ecp);
+        return RDB_ERROR;
+    }
+    namev[slottabp->slotc++] = name;
+    return RDB_OK;
+}
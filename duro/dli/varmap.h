@@ -19,19 +19,41 @@ enum {
 typedef struct RDB_object RDB_object;
 typedef struct RDB_exec_context RDB_exec_context;
 
-typedef struct {
-    RDB_hashtable hashtab;
-} Duro_varmap;
-
 typedef struct {
     char *name;
     RDB_object *varp;
     RDB_bool flags;
 } Duro_var_entry;
 
+/*
+ * Maps variable names to slot indexes.
+ * Created when an operator is compiled and not modified afterwards.
+ */
+typedef struct {
+    RDB_hashtable hashtab;
+    int slotc;
+    const char **namev;
+} Duro_slot_table;
+
+typedef struct {
+    RDB_hashtable hashtab;
+
+    /*
+     * If the map is the frame of a compiled operator,
+     * variables found in the slot table are stored in slotv,
+     * other variables in the hashtable.
+     */
+    const Duro_slot_table *slottabp;
+    Duro_var_entry *slotv;
+} Duro_varmap;
+
 void
 Duro_init_varmap(Duro_varmap *, int);
 
+void
+Duro_init_frame_varmap(Duro_varmap *, const Duro_slot_table *,
+        Duro_var_entry *);
+
 void
 Duro_destroy_varmap(Duro_varmap *);
 
@@ -42,4 +64,13 @@ Duro_varmap_put(Duro_varmap *, const char *, RDB_object *, int,
 Duro_var_entry *
 Duro_varmap_get(const Duro_varmap *, const char *);
 
+void
+Duro_init_slot_table(Duro_slot_table *);
+
+void
+Duro_destroy_slot_table(Duro_slot_table *);
+
+int
+Duro_slot_table_add(Duro_slot_table *, const char *, RDB_exec_context *);
+
 #endif /* DURO_VARMAP_H_ */
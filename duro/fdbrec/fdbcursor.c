@@ -29,6 +29,7 @@ static RDB_cursor *
 new_fdb_cursor(RDB_recmap *rmp, RDB_rec_transaction *rtxp, RDB_index *idxp,
         RDB_exec_context *ecp)
 {
+    int keylen;
     RDB_cursor *curp = RDB_alloc(sizeof(RDB_cursor), ecp);
     if (curp == NULL)
         return NULL;
@@ -38,8 +39,43 @@ new_fdb_cursor(RDB_recmap *rmp, RDB_rec_transaction *rtxp, RDB_index *idxp,
     curp->tx = rtxp;
 	curp->cur.fdb.key = NULL;
 	curp->cur.fdb.value = NULL;
+    curp->cur.fdb.batchf = NULL;
+    curp->cur.fdb.nextf = NULL;
+    curp->cur.fdb.kvc = 0;
+    curp->cur.fdb.kvi = 0;
+    curp->cur.fdb.iteration = 0;
     curp->secondary = idxp != NULL ? RDB_TRUE : RDB_FALSE;
 
+    if (idxp == NULL) {
+        keylen = RDB_fdb_key_prefix_length(rmp);
+    } else {
+        keylen = RDB_fdb_key_index_prefix_length(idxp);
+    }
+    curp->cur.fdb.prefix_length = keylen;
+
+    /* Allocate and fill buffers for start key and end key */
+    curp->cur.fdb.startkey = RDB_alloc(keylen, ecp);
+    if (curp->cur.fdb.startkey == NULL) {
+        RDB_free(curp);
+        return NULL;
+    }
+    curp->cur.fdb.endkey = RDB_alloc(keylen, ecp);
+    if (curp->cur.fdb.endkey == NULL) {
+        RDB_free(curp->cur.fdb.startkey);
+        RDB_free(curp);
+        return NULL;
+    }
+    if (idxp == NULL) {
+        strcpy((char *)curp->cur.fdb.startkey, "t/");
+        strcat((char *)curp->cur.fdb.startkey, rmp->namp);
+    } else {
+        strcpy((char *)curp->cur.fdb.startkey, "i/");
+        strcat((char *)curp->cur.fdb.startkey, idxp->namp);
+    }
+    strcpy((char *)curp->cur.fdb.endkey, (char *)curp->cur.fdb.startkey);
+    curp->cur.fdb.startkey[keylen - 1] = (uint8_t) '/';
+    curp->cur.fdb.endkey[keylen - 1] = (uint8_t) '/' + 1;
+
     curp->destroy_fn = &RDB_destroy_fdb_cursor;
     curp->get_fn = &RDB_fdb_cursor_get;
     curp->set_fn = &RDB_fdb_cursor_set;
@@ -70,11 +106,33 @@ RDB_fdb_index_cursor(RDB_index *idxp, RDB_bool wr,
     return new_fdb_cursor(idxp->rmp, rtxp, idxp, ecp);
 }
 
+/*
+ * Discard the key/value pairs which have been read in advance.
+ */
+static void
+clear_batch(RDB_cursor *curp)
+{
+    if (curp->cur.fdb.batchf != NULL) {
+        fdb_future_destroy(curp->cur.fdb.batchf);
+        curp->cur.fdb.batchf = NULL;
+    }
+    if (curp->cur.fdb.nextf != NULL) {
+        fdb_future_destroy(curp->cur.fdb.nextf);
+        curp->cur.fdb.nextf = NULL;
+    }
+    curp->cur.fdb.kvc = 0;
+    curp->cur.fdb.kvi = 0;
+    curp->cur.fdb.iteration = 0;
+}
+
 int
 RDB_destroy_fdb_cursor(RDB_cursor *curp, RDB_exec_context *ecp)
 {
+    clear_batch(curp);
 	RDB_free(curp->cur.fdb.key);
 	RDB_free(curp->cur.fdb.value);
+    RDB_free(curp->cur.fdb.startkey);
+    RDB_free(curp->cur.fdb.endkey);
     RDB_free(curp);
 	return RDB_OK;
 }
@@ -186,8 +244,15 @@ RDB_fdb_cursor_set(RDB_cursor *curp, int fieldc, RDB_field fields[],
         return RDB_ERROR;
     }
 
-    if (curp->idxp != NULL)
+    if (curp->idxp != NULL) {
+        /*
+         * The update may move index entries, so the pairs which have been read
+         * in advance cannot be used anymore. The next range read starts
+         * after the current key.
+         */
+        clear_batch(curp);
         return RDB_fdb_cursor_update(curp, fieldc, fields, ecp);
+    }
 
     for (i = 0; i < fieldc; i++) {
         ret = RDB_set_field_mem(curp->recmapp, &data, &data_length, &fields[i],
@@ -348,161 +413,153 @@ fdbkv_to_cursor(RDB_cursor *curp, const FDBKeyValue *fdbkv, RDB_exec_context *ec
 }
 
 /*
- * Move the cursor to the first record.
- * If there is no first record, RDB_NOT_FOUND is raised.
+ * Start reading the key/value pairs from the key given by key and key_length
+ * up to the end of the recmap or index. If after is true, the pair with the
+ * key itself is not read.
+ * The size of the batches returned increases with each read of the same scan.
  */
-int
-RDB_fdb_cursor_first(RDB_cursor *curp, RDB_exec_context *ecp)
+static FDBFuture *
+read_range(RDB_cursor *curp, const uint8_t *key, int key_length,
+        fdb_bool_t after)
 {
-	fdb_error_t err;
-	FDBFuture* f;
-	const FDBKeyValue *out_kv;
-	int out_count;
-	fdb_bool_t out_more;
-	uint8_t *keybuf;
-	uint8_t *endkeybuf;
-	int keylen;
-
-    if (curp->idxp == NULL) {
-        keylen = RDB_fdb_key_prefix_length(curp->recmapp);
-    } else {
-        keylen = RDB_fdb_key_index_prefix_length(curp->idxp);
-    }
+	return fdb_transaction_get_range((FDBTransaction*) curp->tx,
+			key, key_length, after, 1,
+			FDB_KEYSEL_FIRST_GREATER_OR_EQUAL(curp->cur.fdb.endkey,
+			        curp->cur.fdb.prefix_length), 0, 0,
+			FDB_STREAMING_MODE_ITERATOR, ++curp->cur.fdb.iteration, 0, 0);
+}
 
-	/* Allocate and fill buffer for start key and end key */
-	keybuf = RDB_alloc(keylen, ecp);
-	if (keybuf == NULL)
-		return RDB_ERROR;
-	endkeybuf = RDB_alloc(keylen, ecp);
-	if (endkeybuf == NULL) {
-		RDB_free(keybuf);
-		return RDB_ERROR;
-	}
-    if (curp->idxp == NULL) {
-        strcpy((char *)keybuf, "t/");
-        strcat((char *)keybuf, curp->recmapp->namp);
-    } else {
-        strcpy((char *)keybuf, "i/");
-        strcat((char *)keybuf, curp->idxp->namp);
-    }
-	strcpy((char *) endkeybuf, (char *) keybuf);
-	keybuf[keylen - 1] = (uint8_t) '/';
-	endkeybuf[keylen - 1] = (uint8_t) '/' + 1;
-
-	/* Read first key/value pair of recmap */
-	f = fdb_transaction_get_range((FDBTransaction*) curp->tx,
-			FDB_KEYSEL_FIRST_GREATER_OR_EQUAL(keybuf, keylen),
-			FDB_KEYSEL_FIRST_GREATER_OR_EQUAL(endkeybuf, keylen), 1, 0,
-			FDB_STREAMING_MODE_SMALL, 0, 0, 0);
-	err = fdb_future_block_until_ready(f);
-	RDB_free(keybuf);
-	RDB_free(endkeybuf);
-	if (err != 0) {
-		fdb_future_destroy(f);
-        RDB_handle_fdb_errcode(err, ecp, (FDBTransaction*)curp->tx);
-        return RDB_ERROR;
+/*
+ * Wait for the range read *f and make the pairs read the current batch.
+ * If there are more pairs in the range, reading them is started
+ * so the read is performed while the batch is consumed.
+ */
+static int
+receive_batch(RDB_cursor *curp, FDBFuture *f, RDB_exec_context *ecp)
+{
+	fdb_bool_t more;
+	fdb_error_t err = fdb_future_block_until_ready(f);
+	if (err == 0) {
+	    err = fdb_future_get_keyvalue_array(f, &curp->cur.fdb.kvv,
+	            &curp->cur.fdb.kvc, &more);
 	}
-	err = fdb_future_get_keyvalue_array(f, &out_kv, &out_count, &out_more);
 	if (err != 0) {
 		fdb_future_destroy(f);
+		curp->cur.fdb.kvc = 0;
         RDB_handle_fdb_errcode(err, ecp, (FDBTransaction*)curp->tx);
         return RDB_ERROR;
 	}
-	if (out_count == 0) {
-		fdb_future_destroy(f);
-		RDB_raise_not_found("no first record", ecp);
-		return RDB_ERROR;
-	}
-	if (fdbkv_to_cursor(curp, &out_kv[0], ecp) != RDB_OK) {
-		fdb_future_destroy(f);
-		return RDB_ERROR;
+
+	if (curp->cur.fdb.batchf != NULL)
+	    fdb_future_destroy(curp->cur.fdb.batchf);
+	curp->cur.fdb.batchf = f;
+	curp->cur.fdb.kvi = 0;
+	if (more && curp->cur.fdb.kvc > 0) {
+	    const FDBKeyValue *lastkvp = &curp->cur.fdb.kvv[curp->cur.fdb.kvc - 1];
+	    curp->cur.fdb.nextf = read_range(curp, lastkvp->key,
+	            lastkvp->key_length, 1);
 	}
-	fdb_future_destroy(f);
 	return RDB_OK;
 }
 
-int
-RDB_fdb_cursor_next(RDB_cursor *curp, int flags, RDB_exec_context *ecp)
+/*
+ * Get the pair after the current pair, reading the next batch if necessary.
+ * The cursor is not moved.
+ */
+static int
+next_kv(RDB_cursor *curp, const FDBKeyValue **kvpp, RDB_exec_context *ecp)
 {
-	fdb_error_t err;
-	FDBFuture* f;
-	const FDBKeyValue *out_kv;
-	int out_count;
-	fdb_bool_t out_more;
-	uint8_t *endkeybuf;
-	int keylen;
+    FDBFuture *f;
 
-    if (curp->idxp == NULL) {
-        keylen = RDB_fdb_key_prefix_length(curp->recmapp);
-        /* Allocate and fill buffer for end key */
-        endkeybuf = RDB_alloc(keylen, ecp);
-        if (endkeybuf == NULL) {
+    if (curp->cur.fdb.batchf == NULL) {
+        /* Nothing has been read in advance, so start after the current key */
+        clear_batch(curp);
+        f = read_range(curp, curp->cur.fdb.key, curp->cur.fdb.key_length, 1);
+        if (receive_batch(curp, f, ecp) != RDB_OK)
             return RDB_ERROR;
-        }
-        strcpy((char *)endkeybuf, "t/");
-        strcat((char *)endkeybuf, curp->recmapp->namp);
-    } else {
-        keylen = RDB_fdb_key_index_prefix_length(curp->idxp);
-        endkeybuf = RDB_alloc(keylen, ecp);
-        if (endkeybuf == NULL) {
+        curp->cur.fdb.kvi = -1;
+    }
+    while (curp->cur.fdb.kvi + 1 >= curp->cur.fdb.kvc) {
+        if (curp->cur.fdb.nextf == NULL) {
+            RDB_raise_not_found("no next record", ecp);
             return RDB_ERROR;
         }
-        strcpy((char *)endkeybuf, "i/");
-        strcat((char *)endkeybuf, curp->idxp->namp);
+        f = curp->cur.fdb.nextf;
+        curp->cur.fdb.nextf = NULL;
+        if (receive_batch(curp, f, ecp) != RDB_OK)
+            return RDB_ERROR;
+        curp->cur.fdb.kvi = -1;
     }
-	endkeybuf[keylen - 1] = (uint8_t) '/' + 1;
-
-	/* Read next key/value pair */
-	f = fdb_transaction_get_range((FDBTransaction*) curp->tx,
-			FDB_KEYSEL_FIRST_GREATER_THAN(curp->cur.fdb.key, curp->cur.fdb.key_length),
-			FDB_KEYSEL_FIRST_GREATER_OR_EQUAL(endkeybuf, keylen), 1, 0,
-			FDB_STREAMING_MODE_SMALL, 0, 0, 0);
-	err = fdb_future_block_until_ready(f);
-	RDB_free(endkeybuf);
-	if (err != 0) {
-		fdb_future_destroy(f);
-        RDB_handle_fdb_errcode(err, ecp, (FDBTransaction*)curp->tx);
+    *kvpp = &curp->cur.fdb.kvv[curp->cur.fdb.kvi + 1];
+    return RDB_OK;
+}
+
+/*
+ * Read the pairs starting with the given key and move the cursor
+ * to the first pair.
+ * If there is no pair, RDB_NOT_FOUND is raised.
+ */
+static int
+read_first(RDB_cursor *curp, const uint8_t *key, int key_length,
+        RDB_exec_context *ecp)
+{
+    clear_batch(curp);
+    if (receive_batch(curp, read_range(curp, key, key_length, 0), ecp)
+            != RDB_OK) {
         return RDB_ERROR;
-	}
-	err = fdb_future_get_keyvalue_array(f, &out_kv, &out_count, &out_more);
-	if (err != 0) {
-		fdb_future_destroy(f);
-        RDB_handle_fdb_errcode(err, ecp, (FDBTransaction*)curp->tx);
+    }
+    if (curp->cur.fdb.kvc == 0) {
+        clear_batch(curp);
+        RDB_raise_not_found("no record", ecp);
         return RDB_ERROR;
-	}
+    }
+    return RDB_OK;
+}
 
-	if (out_count == 0) {
-		fdb_future_destroy(f);
-		RDB_raise_not_found("no next record", ecp);
-		return RDB_ERROR;
-	}
+/*
+ * Move the cursor to the first record.
+ * If there is no first record, RDB_NOT_FOUND is raised.
+ */
+int
+RDB_fdb_cursor_first(RDB_cursor *curp, RDB_exec_context *ecp)
+{
+    if (read_first(curp, curp->cur.fdb.startkey, curp->cur.fdb.prefix_length,
+            ecp) != RDB_OK) {
+        return RDB_ERROR;
+    }
+    return fdbkv_to_cursor(curp, &curp->cur.fdb.kvv[0], ecp);
+}
+
+int
+RDB_fdb_cursor_next(RDB_cursor *curp, int flags, RDB_exec_context *ecp)
+{
+    const FDBKeyValue *kvp;
+    int keylen = curp->cur.fdb.prefix_length;
+
+    if (next_kv(curp, &kvp, ecp) != RDB_OK)
+        return RDB_ERROR;
 
     if (RDB_REC_DUP & flags) {
         /* If the secondary key has changed, return not_found */
         int skeylen;
         memcpy(&skeylen,
-            (uint8_t *)out_kv[0].key + out_kv[0].key_length - sizeof(int),
+            (uint8_t *)kvp->key + kvp->key_length - sizeof(int),
             sizeof(int));
-        if (out_kv[0].key_length < skeylen + keylen) {
+        if (kvp->key_length < skeylen + keylen) {
             RDB_raise_internal("invalid record length", ecp);
-            fdb_future_destroy(f);
             return RDB_ERROR;
         }
         if (curp->cur.fdb.key_length < skeylen + keylen
-                || memcmp(out_kv[0].key, curp->cur.fdb.key,
+                || memcmp(kvp->key, curp->cur.fdb.key,
                         skeylen + keylen) != 0) {
-            fdb_future_destroy(f);
             RDB_raise_not_found("no record for key", ecp);
             return RDB_ERROR;
         }
     }
 
-    if (fdbkv_to_cursor(curp, &out_kv[0], ecp) != RDB_OK) {
-		fdb_future_destroy(f);
+    if (fdbkv_to_cursor(curp, kvp, ecp) != RDB_OK)
 		return RDB_ERROR;
-	}
-
-	fdb_future_destroy(f);
+    curp->cur.fdb.kvi++;
     return RDB_OK;
 }
 
@@ -541,13 +598,8 @@ RDB_fdb_cursor_seek(RDB_cursor *curp, int fieldc, RDB_field keyv[], int flags,
     size_t keylen;
     void *key;
     int prefixlen;
-    uint8_t *endkeybuf;
     uint8_t *key_name;
-    FDBFuture* f;
-    const FDBKeyValue *out_kv;
-    int out_count;
-    fdb_bool_t out_more;
-    fdb_error_t err;
+    const FDBKeyValue *kvp;
 
     if (curp->idxp == NULL) {
         for (i = 0; i < fieldc; i++)
@@ -591,68 +643,25 @@ RDB_fdb_cursor_seek(RDB_cursor *curp, int fieldc, RDB_field keyv[], int flags,
         return RDB_ERROR;
     }
 
-    /* Allocate and fill buffer for end key */
-    prefixlen = curp->idxp != NULL ? RDB_fdb_key_index_prefix_length(curp->idxp)
-            : RDB_fdb_key_prefix_length(curp->recmapp);
-    endkeybuf = RDB_alloc(prefixlen, ecp);
-    if (endkeybuf == NULL) {
-        return RDB_ERROR;
-    }
-    if (curp->idxp == NULL) {
-        strcpy((char *)endkeybuf, "t/");
-        strcat((char *)endkeybuf, curp->recmapp->namp);
-    }
-    else {
-        strcpy((char *)endkeybuf, "i/");
-        strcat((char *)endkeybuf, curp->idxp->namp);
-    }
-    endkeybuf[prefixlen - 1] = (uint8_t) '/' + 1;
-
-    /* Read this or next key/value pair */
-    f = fdb_transaction_get_range((FDBTransaction*)curp->tx,
-        FDB_KEYSEL_FIRST_GREATER_OR_EQUAL(key_name, prefixlen + keylen),
-        FDB_KEYSEL_FIRST_GREATER_OR_EQUAL(endkeybuf, prefixlen), 1, 0,
-        FDB_STREAMING_MODE_SMALL, 0, 0, 0);
-    RDB_free(endkeybuf);
-    err = fdb_future_block_until_ready(f);
-    if (err != 0) {
-        RDB_free(key_name);
-        fdb_future_destroy(f);
-        RDB_handle_fdb_errcode(err, ecp, (FDBTransaction*)curp->tx);
-        return RDB_ERROR;
-    }
-    err = fdb_future_get_keyvalue_array(f, &out_kv, &out_count, &out_more);
-    if (err != 0) {
-        RDB_free(key_name);
-        fdb_future_destroy(f);
-        RDB_handle_fdb_errcode(err, ecp, (FDBTransaction*)curp->tx);
-        return RDB_ERROR;
-    }
+    prefixlen = curp->cur.fdb.prefix_length;
 
-    if (out_count == 0) {
+    /* Read this and the following key/value pairs */
+    if (read_first(curp, key_name, prefixlen + keylen, ecp) != RDB_OK) {
         RDB_free(key_name);
-        fdb_future_destroy(f);
-        RDB_raise_not_found("no record", ecp);
         return RDB_ERROR;
     }
+    kvp = &curp->cur.fdb.kvv[0];
 
     if (!(RDB_REC_RANGE & flags)) {
         /* If the key has not been read, return not_found */
-        if (out_kv[0].key_length < prefixlen + keylen
-                || memcmp(out_kv[0].key, key_name, prefixlen + keylen) != 0) {
+        if (kvp->key_length < prefixlen + keylen
+                || memcmp(kvp->key, key_name, prefixlen + keylen) != 0) {
             RDB_free(key_name);
-            fdb_future_destroy(f);
             RDB_raise_not_found("no record for key", ecp);
             return RDB_ERROR;
         }
     }
 
     RDB_free(key_name);
-    if (fdbkv_to_cursor(curp, &out_kv[0], ecp) != RDB_OK) {
-        fdb_future_destroy(f);
-        return RDB_ERROR;
-    }
-
-    fdb_future_destroy(f);
-    return RDB_OK;
+    return fdbkv_to_cursor(curp, kvp, ecp);
 }
@@ -38,10 +38,6 @@ RDB_fdb_win_event_loop(_In_ LPVOID lpParameter)
 int
 RDB_fdb_close_env(RDB_environment *envp, RDB_exec_context *ecp)
 {
-    if (RDB_fdb_resultf != NULL) {
-        fdb_future_destroy(RDB_fdb_resultf);
-        RDB_fdb_resultf = NULL;
-    }
 	fdb_database_destroy(envp->env.fdb);
 	free(envp);
     return RDB_OK;
@@ -113,6 +109,9 @@ RDB_fdb_open_env(const char *path, RDB_exec_context *ecp)
     envp->xdata = NULL;
     envp->trace = 0;
     envp->queries = RDB_FALSE;
+    envp->hash_mem = 0;
+    envp->sort_mem = 0;
+    envp->fetch_rows = 0;
 
     f = fdb_create_cluster(path);
     err = fdb_future_block_until_ready(f);
@@ -58,6 +58,7 @@ new_fdb_index(RDB_recmap *rmp, const char *name,
     ixp->delete_index_fn = &RDB_delete_fdb_index;
     ixp->index_delete_rec_fn = &RDB_fdb_index_delete_rec;
     ixp->index_get_fields_fn = &RDB_fdb_index_get_fields;
+    ixp->index_get_fields_multi_fn = &RDB_fdb_index_get_fields_multi;
     ixp->index_cursor_fn = &RDB_fdb_index_cursor;
 
     return ixp;
@@ -241,24 +242,18 @@ RDB_delete_fdb_index(RDB_index *ixp, RDB_rec_transaction *rtxp,
     return RDB_close_fdb_index(ixp, ecp);
 }
 
+/*
+ * Construct the FDB key of the index entry whose key fields are given by keyv.
+ */
 static int
-RDB_fdb_index_get(RDB_index *ixp, RDB_field keyv[], RDB_rec_transaction *rtxp,
-        const uint8_t **value, int *value_length, int *pkey_name_length,
-        RDB_exec_context *ecp)
+index_key_name(RDB_index *ixp, RDB_field keyv[], uint8_t **key_namep,
+        int *key_name_lengthp, RDB_exec_context *ecp)
 {
     size_t keylen;
     void *key;
-    uint8_t *key_name;
-    int key_name_length;
-    const uint8_t *pkey;
-    int pkey_length;
     RDB_field *trkeyv;
     int i;
-    fdb_error_t err;
     int ret;
-    FDBFuture *f1;
-    fdb_bool_t present;
-    int recmap_prefix_length = RDB_fdb_key_prefix_length(ixp->rmp);
 
     for (i = 0; i < ixp->fieldc; i++) {
         keyv[i].no = ixp->fieldv[i];
@@ -287,13 +282,30 @@ RDB_fdb_index_get(RDB_index *ixp, RDB_field keyv[], RDB_rec_transaction *rtxp,
         return RDB_ERROR;
     }
 
-    key_name_length = RDB_fdb_key_index_prefix_length(ixp) + keylen;
-    key_name = RDB_fdb_prepend_key_index_prefix(ixp, key, keylen, ecp);
-    if (key_name == NULL) {
-        free(key);
-        return RDB_ERROR;
-    }
+    *key_name_lengthp = RDB_fdb_key_index_prefix_length(ixp) + keylen;
+    *key_namep = RDB_fdb_prepend_key_index_prefix(ixp, key, keylen, ecp);
     free(key);
+    if (*key_namep == NULL)
+        return RDB_ERROR;
+    return RDB_OK;
+}
+
+static int
+RDB_fdb_index_get(RDB_index *ixp, RDB_field keyv[], RDB_rec_transaction *rtxp,
+        const uint8_t **value, int *value_length, int *pkey_name_length,
+        RDB_exec_context *ecp)
+{
+    uint8_t *key_name;
+    int key_name_length;
+    const uint8_t *pkey;
+    int pkey_length;
+    fdb_error_t err;
+    FDBFuture *f1;
+    fdb_bool_t present;
+    int recmap_prefix_length = RDB_fdb_key_prefix_length(ixp->rmp);
+
+    if (index_key_name(ixp, keyv, &key_name, &key_name_length, ecp) != RDB_OK)
+        return RDB_ERROR;
 
     f1 = fdb_transaction_get((FDBTransaction*)rtxp, key_name, key_name_length, 0);
     err = fdb_future_block_until_ready(f1);
@@ -317,39 +329,32 @@ RDB_fdb_index_get(RDB_index *ixp, RDB_field keyv[], RDB_rec_transaction *rtxp,
         return RDB_ERROR;
     }
 
-    if (RDB_fdb_key_name != NULL) {
-        RDB_free(RDB_fdb_key_name);
-    }
-    RDB_fdb_key_name = RDB_fdb_prepend_key_prefix(ixp->rmp, pkey, pkey_length, ecp);
-    if (RDB_fdb_key_name == NULL) {
+    RDB_fdb_clear_get(ixp->rmp);
+    ixp->rmp->impl.fdb.key_name = RDB_fdb_prepend_key_prefix(ixp->rmp, pkey,
+            pkey_length, ecp);
+    if (ixp->rmp->impl.fdb.key_name == NULL) {
         fdb_future_destroy(f1);
         return RDB_ERROR;
     }
     *pkey_name_length = pkey_length + recmap_prefix_length;
-    if (RDB_fdb_resultf != NULL) {
-        fdb_future_destroy(RDB_fdb_resultf);
-    }
-    RDB_fdb_resultf = fdb_transaction_get((FDBTransaction*)rtxp, RDB_fdb_key_name, *pkey_name_length, 0);
-    err = fdb_future_block_until_ready(RDB_fdb_resultf);
+    ixp->rmp->impl.fdb.resultf = fdb_transaction_get((FDBTransaction*)rtxp,
+            ixp->rmp->impl.fdb.key_name, *pkey_name_length, 0);
+    err = fdb_future_block_until_ready(ixp->rmp->impl.fdb.resultf);
     fdb_future_destroy(f1);
     if (err != 0) {
-        RDB_free(RDB_fdb_key_name);
-        RDB_fdb_key_name = NULL;
-        fdb_future_destroy(RDB_fdb_resultf);
-        RDB_fdb_resultf = NULL;
+        RDB_fdb_clear_get(ixp->rmp);
         RDB_handle_fdb_errcode(err, ecp, (FDBTransaction*)rtxp);
         return RDB_ERROR;
     }
-    err = fdb_future_get_value(RDB_fdb_resultf, &present, value, value_length);
+    err = fdb_future_get_value(ixp->rmp->impl.fdb.resultf, &present, value,
+            value_length);
     if (err != 0) {
+        RDB_fdb_clear_get(ixp->rmp);
         RDB_handle_fdb_errcode(err, ecp, (FDBTransaction*)rtxp);
         return RDB_ERROR;
     }
     if (!present) {
-        RDB_free(RDB_fdb_key_name);
-        RDB_fdb_key_name = NULL;
-        fdb_future_destroy(RDB_fdb_resultf);
-        RDB_fdb_resultf = NULL;
+        RDB_fdb_clear_get(ixp->rmp);
         RDB_raise_not_found("", ecp);
         return RDB_ERROR;
     }
@@ -370,7 +375,8 @@ RDB_fdb_index_get_fields(RDB_index *ixp, RDB_field keyv[], int fieldc,
         return RDB_ERROR;
     }
 
-    ret = RDB_get_mem_fields(ixp->rmp, RDB_fdb_key_name + recmap_prefix_length,
+    ret = RDB_get_mem_fields(ixp->rmp,
+            ixp->rmp->impl.fdb.key_name + recmap_prefix_length,
             (size_t) (pkey_name_length - recmap_prefix_length),
             value, (size_t) value_length, fieldc, retfieldv);
     if (ret != RDB_OK) {
@@ -380,6 +386,86 @@ RDB_fdb_index_get_fields(RDB_index *ixp, RDB_field keyv[], int fieldc,
     return RDB_OK;
 }
 
+/*
+ * Read several records using the index. The reads of the index entries
+ * are started before waiting for the first result, and the read of each
+ * record is started as soon as its index entry is available.
+ */
+int
+RDB_fdb_index_get_fields_multi(RDB_index *ixp, int recc, RDB_field *keyvv[],
+        int fieldc, RDB_rec_transaction *rtxp, RDB_field *retfieldvv[],
+        RDB_bool foundv[], RDB_exec_context *ecp)
+{
+    int i;
+    uint8_t *key_name;
+    int key_name_length;
+    const uint8_t *pkey;
+    int pkey_length;
+    fdb_bool_t present;
+    fdb_error_t err;
+    RDB_recmap *rmp = ixp->rmp;
+    FDBFuture **fv = RDB_alloc(sizeof(FDBFuture *) * recc, ecp);
+    if (fv == NULL)
+        return RDB_ERROR;
+
+    for (i = 0; i < recc; i++) {
+        fv[i] = NULL;
+    }
+    if (RDB_fdb_alloc_gets(rmp, recc, ecp) != RDB_OK)
+        goto error;
+
+    /* Start reading the index entries */
+    for (i = 0; i < recc; i++) {
+        if (index_key_name(ixp, keyvv[i], &key_name, &key_name_length, ecp)
+                != RDB_OK)
+            goto error;
+        fv[i] = fdb_transaction_get((FDBTransaction*)rtxp, key_name,
+                key_name_length, 0);
+        RDB_free(key_name);
+    }
+
+    /* Start reading the records the index entries refer to */
+    for (i = 0; i < recc; i++) {
+        struct RDB_fdb_get *getp = &rmp->impl.fdb.getv[i];
+
+        err = fdb_future_block_until_ready(fv[i]);
+        if (err == 0)
+            err = fdb_future_get_value(fv[i], &present, &pkey, &pkey_length);
+        if (err != 0) {
+            RDB_handle_fdb_errcode(err, ecp, (FDBTransaction*)rtxp);
+            goto error;
+        }
+        if (present) {
+            getp->key_name = RDB_fdb_prepend_key_prefix(rmp, pkey, pkey_length,
+                    ecp);
+            if (getp->key_name == NULL)
+                goto error;
+            getp->key_name_length = RDB_fdb_key_prefix_length(rmp) + pkey_length;
+            getp->resultf = fdb_transaction_get((FDBTransaction*)rtxp,
+                    getp->key_name, getp->key_name_length, 0);
+        }
+        fdb_future_destroy(fv[i]);
+        fv[i] = NULL;
+    }
+    RDB_free(fv);
+
+    if (RDB_fdb_read_gets(rmp, fieldc, rtxp, retfieldvv, foundv, ecp)
+            != RDB_OK) {
+        RDB_fdb_clear_gets(rmp);
+        return RDB_ERROR;
+    }
+    return RDB_OK;
+
+error:
+    for (i = 0; i < recc; i++) {
+        if (fv[i] != NULL)
+            fdb_future_destroy(fv[i]);
+    }
+    RDB_free(fv);
+    RDB_fdb_clear_gets(rmp);
+    return RDB_ERROR;
+}
+
 int
 RDB_fdb_index_delete_rec(RDB_index *ixp, RDB_field keyv[], RDB_rec_transaction *rtxp,
         RDB_exec_context *ecp)
@@ -393,7 +479,8 @@ RDB_fdb_index_delete_rec(RDB_index *ixp, RDB_field keyv[], RDB_rec_transaction *
         return RDB_ERROR;
     }
 
-    fdb_transaction_clear((FDBTransaction*)rtxp, RDB_fdb_key_name, pkey_name_length);
+    fdb_transaction_clear((FDBTransaction*)rtxp, ixp->rmp->impl.fdb.key_name,
+            pkey_name_length);
     return RDB_OK;
 }
 
@@ -43,6 +43,10 @@ int
 RDB_fdb_index_get_fields(RDB_index *, RDB_field[], int, RDB_rec_transaction *,
            RDB_field[], RDB_exec_context *);
 
+int
+RDB_fdb_index_get_fields_multi(RDB_index *, int, RDB_field *[], int,
+        RDB_rec_transaction *, RDB_field *[], RDB_bool[], RDB_exec_context *);
+
 int
 RDB_fdb_index_delete_rec(RDB_index *, RDB_field[], RDB_rec_transaction *,
         RDB_exec_context *);
@@ -19,12 +19,6 @@
 #define FDB_API_VERSION 600
 #include <foundationdb/fdb_c.h>
 
-/* FDB key of the current record */
-uint8_t *RDB_fdb_key_name;
-
-/* FDB future of the current record */
-FDBFuture *RDB_fdb_resultf = NULL;
-
 /*
  * Allocate a RDB_recmap structure and initialize its fields for FDB.
  */
@@ -45,11 +39,16 @@ new_recmap(const char *namp,
 	rmp->update_rec_fn = &RDB_update_fdb_rec;
 	rmp->delete_rec_fn = &RDB_delete_fdb_rec;
 	rmp->get_fields_fn = &RDB_get_fdb_fields;
+	rmp->get_fields_multi_fn = &RDB_get_fdb_fields_multi;
 	rmp->contains_rec_fn = &RDB_contains_fdb_rec;
 	rmp->recmap_est_size_fn = &RDB_fdb_recmap_est_size;
 	rmp->cursor_fn = &RDB_fdb_recmap_cursor;
 	rmp->create_index_fn = &RDB_create_fdb_index;
 	rmp->open_index_fn = &RDB_open_fdb_index;
+	rmp->impl.fdb.getv = NULL;
+	rmp->impl.fdb.getc = 0;
+	rmp->impl.fdb.key_name = NULL;
+	rmp->impl.fdb.resultf = NULL;
 
 	return rmp;
 }
@@ -81,6 +80,8 @@ RDB_open_fdb_recmap(const char *name,
 int
 RDB_close_fdb_recmap(RDB_recmap *rmp, RDB_exec_context *ecp)
 {
+    RDB_fdb_clear_gets(rmp);
+    RDB_fdb_clear_get(rmp);
     RDB_free(rmp->namp);
     RDB_free(rmp->filenamp);
     RDB_free(rmp->fieldinfos);
@@ -117,6 +118,8 @@ RDB_delete_fdb_recmap(RDB_recmap *rmp, RDB_rec_transaction *rtxp, RDB_exec_conte
     RDB_free(keybuf);
     RDB_free(endkeybuf);
 
+    RDB_fdb_clear_gets(rmp);
+    RDB_fdb_clear_get(rmp);
     RDB_free(rmp->namp);
     RDB_free(rmp->filenamp);
     RDB_free(rmp->fieldinfos);
@@ -640,6 +643,22 @@ RDB_delete_fdb_rec(RDB_recmap *rmp, int fieldc, RDB_field keyv[],
 	return ret;
 }
 
+/*
+ * Destroy the key and future of the last single get on *rmp.
+ */
+void
+RDB_fdb_clear_get(RDB_recmap *rmp)
+{
+    if (rmp->impl.fdb.key_name != NULL) {
+        RDB_free(rmp->impl.fdb.key_name);
+        rmp->impl.fdb.key_name = NULL;
+    }
+    if (rmp->impl.fdb.resultf != NULL) {
+        fdb_future_destroy(rmp->impl.fdb.resultf);
+        rmp->impl.fdb.resultf = NULL;
+    }
+}
+
 int
 RDB_get_fdb_fields(RDB_recmap *rmp, RDB_field keyv[], int fieldc,
 	RDB_rec_transaction *rtxp, RDB_field retfieldv[], RDB_exec_context *ecp)
@@ -651,47 +670,33 @@ RDB_get_fdb_fields(RDB_recmap *rmp, RDB_field keyv[], int fieldc,
     fdb_bool_t present;
     fdb_error_t err;
 
-    if (RDB_fdb_key_name != NULL) {
-        RDB_free(RDB_fdb_key_name);
-        RDB_fdb_key_name = NULL;
-    }
-    if (fields_to_fdb_key(rmp, keyv, &RDB_fdb_key_name, &key_name_length, ecp) != RDB_OK) {
+    RDB_fdb_clear_get(rmp);
+    if (fields_to_fdb_key(rmp, keyv, &rmp->impl.fdb.key_name, &key_name_length, ecp) != RDB_OK) {
         return RDB_ERROR;
     }
 
-	if (RDB_fdb_resultf != NULL) {
-        fdb_future_destroy(RDB_fdb_resultf);
-    }
-    RDB_fdb_resultf = fdb_transaction_get((FDBTransaction*)rtxp, RDB_fdb_key_name, key_name_length, 0);
-    err = fdb_future_block_until_ready(RDB_fdb_resultf);
+    rmp->impl.fdb.resultf = fdb_transaction_get((FDBTransaction*)rtxp,
+            rmp->impl.fdb.key_name, key_name_length, 0);
+    err = fdb_future_block_until_ready(rmp->impl.fdb.resultf);
     if (err != 0) {
-        RDB_free(RDB_fdb_key_name);
-        RDB_fdb_key_name = NULL;
-        fdb_future_destroy(RDB_fdb_resultf);
-		RDB_fdb_resultf = NULL;
+        RDB_fdb_clear_get(rmp);
         RDB_handle_fdb_errcode(err, ecp, (FDBTransaction*)rtxp);
         return RDB_ERROR;
     }
-    err = fdb_future_get_value(RDB_fdb_resultf, &present, &value, &value_length);
+    err = fdb_future_get_value(rmp->impl.fdb.resultf, &present, &value, &value_length);
     if (err != 0) {
-        RDB_free(RDB_fdb_key_name);
-        RDB_fdb_key_name = NULL;
-        fdb_future_destroy(RDB_fdb_resultf);
-		RDB_fdb_resultf = NULL;
+        RDB_fdb_clear_get(rmp);
         RDB_handle_fdb_errcode(err, ecp, (FDBTransaction*)rtxp);
         return RDB_ERROR;
     }
     if (!present) {
-        RDB_free(RDB_fdb_key_name);
-        RDB_fdb_key_name = NULL;
-        fdb_future_destroy(RDB_fdb_resultf);
-		RDB_fdb_resultf = NULL;
+        RDB_fdb_clear_get(rmp);
         RDB_raise_not_found("", ecp);
         return RDB_ERROR;
     }
 
     int prefix_len = RDB_fdb_key_prefix_length(rmp);
-    ret = RDB_get_mem_fields(rmp, RDB_fdb_key_name + prefix_len, (size_t)(key_name_length - prefix_len),
+    ret = RDB_get_mem_fields(rmp, rmp->impl.fdb.key_name + prefix_len, (size_t)(key_name_length - prefix_len),
             value, (size_t)value_length, fieldc, retfieldv);
     if (ret != RDB_OK) {
         RDB_errcode_to_error(ret, ecp);
@@ -700,6 +705,125 @@ RDB_get_fdb_fields(RDB_recmap *rmp, RDB_field keyv[], int fieldc,
     return RDB_OK;
 }
 
+/*
+ * Destroy the keys and futures of the last multi-get on *rmp.
+ */
+void
+RDB_fdb_clear_gets(RDB_recmap *rmp)
+{
+    int i;
+
+    for (i = 0; i < rmp->impl.fdb.getc; i++) {
+        RDB_free(rmp->impl.fdb.getv[i].key_name);
+        if (rmp->impl.fdb.getv[i].resultf != NULL)
+            fdb_future_destroy(rmp->impl.fdb.getv[i].resultf);
+    }
+    RDB_free(rmp->impl.fdb.getv);
+    rmp->impl.fdb.getv = NULL;
+    rmp->impl.fdb.getc = 0;
+}
+
+/*
+ * Replace the keys and futures of the last multi-get on *rmp
+ * by getc empty entries.
+ */
+int
+RDB_fdb_alloc_gets(RDB_recmap *rmp, int getc, RDB_exec_context *ecp)
+{
+    int i;
+
+    RDB_fdb_clear_gets(rmp);
+    rmp->impl.fdb.getv = RDB_alloc(sizeof(struct RDB_fdb_get) * getc, ecp);
+    if (rmp->impl.fdb.getv == NULL)
+        return RDB_ERROR;
+    for (i = 0; i < getc; i++) {
+        rmp->impl.fdb.getv[i].key_name = NULL;
+        rmp->impl.fdb.getv[i].resultf = NULL;
+    }
+    rmp->impl.fdb.getc = getc;
+    return RDB_OK;
+}
+
+/*
+ * Wait for the futures of the multi-get on *rmp and read the fields
+ * of the records found.
+ */
+int
+RDB_fdb_read_gets(RDB_recmap *rmp, int fieldc, RDB_rec_transaction *rtxp,
+        RDB_field *retfieldvv[], RDB_bool foundv[], RDB_exec_context *ecp)
+{
+    int i;
+    int ret;
+    const uint8_t *value;
+    int value_length;
+    fdb_bool_t present;
+    fdb_error_t err;
+    int prefix_len = RDB_fdb_key_prefix_length(rmp);
+
+    for (i = 0; i < rmp->impl.fdb.getc; i++) {
+        struct RDB_fdb_get *getp = &rmp->impl.fdb.getv[i];
+
+        foundv[i] = RDB_FALSE;
+        if (getp->resultf == NULL)
+            continue;
+        err = fdb_future_block_until_ready(getp->resultf);
+        if (err == 0) {
+            err = fdb_future_get_value(getp->resultf, &present, &value,
+                    &value_length);
+        }
+        if (err != 0) {
+            RDB_handle_fdb_errcode(err, ecp, (FDBTransaction*)rtxp);
+            return RDB_ERROR;
+        }
+        if (!present)
+            continue;
+
+        ret = RDB_get_mem_fields(rmp, getp->key_name + prefix_len,
+                (size_t)(getp->key_name_length - prefix_len),
+                value, (size_t)value_length, fieldc, retfieldvv[i]);
+        if (ret != RDB_OK) {
+            RDB_errcode_to_error(ret, ecp);
+            return RDB_ERROR;
+        }
+        foundv[i] = RDB_TRUE;
+    }
+    return RDB_OK;
+}
+
+/*
+ * Read several records. All reads are started before
+ * waiting for the first result.
+ */
+int
+RDB_get_fdb_fields_multi(RDB_recmap *rmp, int recc, RDB_field *keyvv[],
+        int fieldc, RDB_rec_transaction *rtxp, RDB_field *retfieldvv[],
+        RDB_bool foundv[], RDB_exec_context *ecp)
+{
+    int i;
+
+    if (RDB_fdb_alloc_gets(rmp, recc, ecp) != RDB_OK)
+        return RDB_ERROR;
+
+    for (i = 0; i < recc; i++) {
+        struct RDB_fdb_get *getp = &rmp->impl.fdb.getv[i];
+
+        if (fields_to_fdb_key(rmp, keyvv[i], &getp->key_name,
+                &getp->key_name_length, ecp) != RDB_OK) {
+            RDB_fdb_clear_gets(rmp);
+            return RDB_ERROR;
+        }
+        getp->resultf = fdb_transaction_get((FDBTransaction*)rtxp,
+                getp->key_name, getp->key_name_length, 0);
+    }
+
+    if (RDB_fdb_read_gets(rmp, fieldc, rtxp, retfieldvv, foundv, ecp)
+            != RDB_OK) {
+        RDB_fdb_clear_gets(rmp);
+        return RDB_ERROR;
+    }
+    return RDB_OK;
+}
+
 int
 RDB_contains_fdb_rec(RDB_recmap *rmp, RDB_field fieldv[], RDB_rec_transaction *rtxp,
 	RDB_exec_context *ecp)
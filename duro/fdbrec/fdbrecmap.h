@@ -15,8 +15,15 @@
 
 typedef RDB_exec_context RDB_exec_context;
 
-extern FDBFuture *RDB_fdb_resultf;
-extern uint8_t *RDB_fdb_key_name;
+/*
+ * FDB key and future of a record read by a multi-get.
+ * resultf is NULL if the record does not exist.
+ */
+struct RDB_fdb_get {
+    uint8_t *key_name;
+    int key_name_length;
+    FDBFuture *resultf;
+};
 
 RDB_recmap *
 RDB_create_fdb_recmap(const char *,
@@ -50,6 +57,23 @@ int
 RDB_get_fdb_fields(RDB_recmap *, RDB_field[],
            int, RDB_rec_transaction *, RDB_field[], RDB_exec_context *);
 
+int
+RDB_get_fdb_fields_multi(RDB_recmap *, int, RDB_field *[], int,
+        RDB_rec_transaction *, RDB_field *[], RDB_bool[], RDB_exec_context *);
+
+int
+RDB_fdb_alloc_gets(RDB_recmap *, int, RDB_exec_context *);
+
+void
+RDB_fdb_clear_gets(RDB_recmap *);
+
+void
+RDB_fdb_clear_get(RDB_recmap *);
+
+int
+RDB_fdb_read_gets(RDB_recmap *, int, RDB_rec_transaction *,
+        RDB_field *[], RDB_bool[], RDB_exec_context *);
+
 int
 RDB_contains_fdb_rec(RDB_recmap *, RDB_field[], RDB_rec_transaction *, RDB_exec_context *);
 
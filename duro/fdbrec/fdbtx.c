@@ -33,8 +33,13 @@ RDB_fdb_begin_tx(RDB_environment *envp,
     return (RDB_rec_transaction *) txp;
 }
 
+/*
+ * Commit the transaction. FoundationDB transactions are always
+ * durable when the commit has completed, so the durability is ignored.
+ */
 int
-RDB_fdb_commit(RDB_rec_transaction *rtxp, RDB_exec_context *ecp)
+RDB_fdb_commit(RDB_rec_transaction *rtxp, RDB_environment *envp,
+        RDB_durability durability, RDB_exec_context *ecp)
 {
 	FDBTransaction *tx = (FDBTransaction *) rtxp;
 	FDBFuture *f = fdb_transaction_commit(tx);
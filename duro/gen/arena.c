@@ -0,0 +1,132 @@
+/*
+ * Arena (region) allocator
+ *
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include "arena.h"
+#include <stddef.h>
+
+enum {
+    ARENA_BLOCK_SIZE = 8192
+};
+
+/* Used to determine the alignment of the memory returned */
+typedef union {
+    void *p;
+    long l;
+    double d;
+    long double ld;
+} arena_align;
+
+#define ALIGN_SIZE(n) \
+    (((n) + sizeof(arena_align) - 1) / sizeof(arena_align) * sizeof(arena_align))
+
+struct RDB_arena_block {
+    /* Block allocated before this one */
+    RDB_arena_block *prevp;
+
+    /* Size of the data area */
+    size_t size;
+
+    /* Number of bytes allocated from the data area */
+    size_t used;
+};
+
+#define BLOCK_DATA(bp) ((char *) (bp) + ALIGN_SIZE(sizeof(RDB_arena_block)))
+
+/*
+ * Initialize the arena *ap. No memory is allocated until
+ * RDB_arena_alloc() is called.
+ */
+void
+RDB_init_arena(RDB_arena *ap)
+{
+    ap->blockp = NULL;
+}
+
+/*
+ * Free all memory allocated from the arena *ap.
+ */
+void
+RDB_destroy_arena(RDB_arena *ap)
+{
+    while (ap->blockp != NULL) {
+        RDB_arena_block *prevp = ap->blockp->prevp;
+        free(ap->blockp);
+        ap->blockp = prevp;
+    }
+}
+
+/*
+ * Allocate size bytes from the arena *ap.
+ * Returns NULL if there is insufficient memory.
+ */
+void *
+RDB_arena_alloc(RDB_arena *ap, size_t size)
+{
+    void *datap;
+
+    size = ALIGN_SIZE(size);
+    if (ap->blockp == NULL || ap->blockp->size - ap->blockp->used < size) {
+        size_t blocksize = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        RDB_arena_block *bp = malloc(ALIGN_SIZE(sizeof(RDB_arena_block))
+                + blocksize);
+        if (bp == NULL)
+            return NULL;
+        bp->prevp = ap->blockp;
+        bp->size = blocksize;
+        bp->used = 0;
+        ap->blockp = bp;
+    }
+    datap = BLOCK_DATA(ap->blockp) + ap->blockp->used;
+    ap->blockp->used += size;
+    return datap;
+}
+
+/*
+ * Store the current allocation state of *ap in *markp.
+ */
+void
+RDB_arena_get_mark(const RDB_arena *ap, RDB_arena_mark *markp)
+{
+    markp->blockp = ap->blockp;
+    markp->used = ap->blockp != NULL ? ap->blockp->used : 0;
+}
+
+/*
+ * Release all memory which has been allocated from *ap after *markp
+ * was obtained by RDB_arena_get_mark().
+ * The first block is kept so it can be reused.
+ */
+void
+RDB_arena_release(RDB_arena *ap, const RDB_arena_mark *markp)
+{
+    while (ap->blockp != markp->blockp) {
+        RDB_arena_block *prevp = ap->blockp->prevp;
+
+        if (prevp == NULL) {
+            ap->blockp->used = 0;
+            return;
+        }
+        free(ap->blockp);
+        ap->blockp = prevp;
+    }
+    if (ap->blockp != NULL)
+        ap->blockp->used = markp->used;
+}
+
+/*
+ * Release all memory allocated from *ap.
+ * The first block is kept so it can be reused.
+ */
+void
+RDB_clear_arena(RDB_arena *ap)
+{
+    RDB_arena_mark mark;
+
+    mark.blockp = NULL;
+    mark.used = 0;
+    RDB_arena_release(ap, &mark);
+}
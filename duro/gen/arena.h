@@ -0,0 +1,53 @@
+#ifndef RDB_ARENA_H
+#define RDB_ARENA_H
+
+/*
+ * Arena (region) allocator
+ *
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include <stdlib.h>
+
+/*
+ * Memory allocated from an arena cannot be freed individually.
+ * It is freed in bulk by RDB_arena_release(), RDB_clear_arena(),
+ * or RDB_destroy_arena().
+ */
+
+typedef struct RDB_arena_block RDB_arena_block;
+
+typedef struct {
+    /* The block memory is currently allocated from, NULL if there is none */
+    RDB_arena_block *blockp;
+} RDB_arena;
+
+/*
+ * Allocation state of an arena, used to release all memory
+ * allocated after the mark was obtained.
+ */
+typedef struct {
+    RDB_arena_block *blockp;
+    size_t used;
+} RDB_arena_mark;
+
+void
+RDB_init_arena(RDB_arena *);
+
+void
+RDB_destroy_arena(RDB_arena *);
+
+void *
+RDB_arena_alloc(RDB_arena *, size_t);
+
+void
+RDB_arena_get_mark(const RDB_arena *, RDB_arena_mark *);
+
+void
+RDB_arena_release(RDB_arena *, const RDB_arena_mark *);
+
+void
+RDB_clear_arena(RDB_arena *);
+
+#endif
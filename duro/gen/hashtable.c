@@ -132,6 +132,56 @@ RDB_hashtable_get(const RDB_hashtable *hp, void *entryp, void *arg)
     return hp->entries[idx];
 }
 
+/*
+ * Remove the entry which is equal to the entry given by entryp.
+ * Return the entry removed or NULL if no entry was found.
+ */
+void *
+RDB_hashtable_del(RDB_hashtable *hp, void *entryp, void *arg)
+{
+    int idx;
+    int cnt = 0;
+    void *delp;
+
+    if (hp->entries == NULL)
+        return NULL;
+
+    idx = (*hp->hfnp)(entryp, arg) % hp->capacity;
+    while (hp->entries[idx] != NULL
+            && !(*hp->efnp)(hp->entries[idx], entryp, arg)) {
+        if (++idx >= hp->capacity)
+            idx = 0;
+        if (++cnt >= hp->capacity)
+            return NULL;
+    }
+    delp = hp->entries[idx];
+    if (delp == NULL)
+        return NULL;
+    hp->entries[idx] = NULL;
+    hp->entry_count--;
+
+    /*
+     * Insert the following entries again
+     * so that no entry becomes unreachable
+     */
+    if (++idx >= hp->capacity)
+        idx = 0;
+    while (hp->entries[idx] != NULL) {
+        void *ep = hp->entries[idx];
+        int newidx = (*hp->hfnp)(ep, arg) % hp->capacity;
+
+        hp->entries[idx] = NULL;
+        while (hp->entries[newidx] != NULL) {
+            if (++newidx >= hp->capacity)
+                newidx = 0;
+        }
+        hp->entries[newidx] = ep;
+        if (++idx >= hp->capacity)
+            idx = 0;
+    }
+    return delp;
+}
+
 /*
  * Return the number of entries the hashtable contains.
  */
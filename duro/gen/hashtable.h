@@ -34,6 +34,9 @@ RDB_hashtable_put(RDB_hashtable *, void *, void *);
 void *
 RDB_hashtable_get(const RDB_hashtable *, void *, void *);
 
+void *
+RDB_hashtable_del(RDB_hashtable *, void *, void *);
+
 int
 RDB_hashtable_size(const RDB_hashtable *);
 
@@ -0,0 +1,91 @@
+/*
+ * HyperLogLog distinct value counter
+ *
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include "hll.h"
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+
+/*
+ * 64-bit FNV-1a hash, followed by the finalizer of MurmurHash3
+ * to distribute the bits of short values well.
+ * RDB_hash_bytes() is not used because 32 bits are too few
+ * for counting large numbers of values.
+ */
+static uint64_t
+hash_bytes(const void *datap, size_t len)
+{
+    size_t i;
+    uint64_t h = UINT64_C(14695981039346656037);
+
+    for (i = 0; i < len; i++) {
+        h ^= ((const unsigned char *) datap)[i];
+        h *= UINT64_C(1099511628211);
+    }
+    h ^= h >> 33;
+    h *= UINT64_C(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    h *= UINT64_C(0xc4ceb9fe1a85ec53);
+    h ^= h >> 33;
+    return h;
+}
+
+/*
+ * Initialize *hllp so it contains no values.
+ */
+void
+RDB_init_hll(RDB_hll *hllp)
+{
+    memset(hllp->regv, 0, sizeof(hllp->regv));
+}
+
+/*
+ * Add the value given by len bytes at datap.
+ */
+void
+RDB_hll_add(RDB_hll *hllp, const void *datap, size_t len)
+{
+    uint64_t h = hash_bytes(datap, len);
+    int idx = (int) (h >> (64 - RDB_HLL_INDEX_BITS));
+    unsigned char rank = 1;
+
+    /* Position of the first 1 bit in the remaining bits */
+    h <<= RDB_HLL_INDEX_BITS;
+    while (rank <= 64 - RDB_HLL_INDEX_BITS
+            && (h & (UINT64_C(1) << 63)) == 0) {
+        rank++;
+        h <<= 1;
+    }
+    if (rank > hllp->regv[idx])
+        hllp->regv[idx] = rank;
+}
+
+/*
+ * Return the estimated number of distinct values added.
+ */
+unsigned
+RDB_hll_estimate(const RDB_hll *hllp)
+{
+    int i;
+    int zeroc = 0;
+    double sum = 0.0;
+    double m = (double) RDB_HLL_REGISTERS;
+    double est;
+
+    for (i = 0; i < RDB_HLL_REGISTERS; i++) {
+        sum += ldexp(1.0, -hllp->regv[i]);
+        if (hllp->regv[i] == 0)
+            zeroc++;
+    }
+    est = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+
+    /* For small numbers of values, linear counting is more accurate */
+    if (est <= 2.5 * m && zeroc > 0)
+        est = m * log(m / (double) zeroc);
+    return est < (double) UINT_MAX ? (unsigned) (est + 0.5) : UINT_MAX;
+}
@@ -0,0 +1,37 @@
+#ifndef RDB_HLL_H
+#define RDB_HLL_H
+
+/*
+ * HyperLogLog distinct value counter
+ *
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include <stdlib.h>
+
+enum {
+    /* Number of bits of the hash value used to select a register */
+    RDB_HLL_INDEX_BITS = 10,
+
+    RDB_HLL_REGISTERS = 1 << RDB_HLL_INDEX_BITS
+};
+
+/*
+ * Estimates the number of distinct values added using a fixed
+ * amount of memory. The standard error is about 1.04 / sqrt(RDB_HLL_REGISTERS).
+ */
+typedef struct {
+    unsigned char regv[RDB_HLL_REGISTERS];
+} RDB_hll;
+
+void
+RDB_init_hll(RDB_hll *);
+
+void
+RDB_hll_add(RDB_hll *, const void *, size_t);
+
+unsigned
+RDB_hll_estimate(const RDB_hll *);
+
+#endif
@@ -72,3 +72,14 @@ RDB_hash_str(const char *str)
 
     return hash;
 }
+
+unsigned
+RDB_hash_bytes(const void *datap, size_t len)
+{
+    size_t i;
+    unsigned hash = 5381;
+
+    for (i = 0; i < len; i++)
+        hash = (hash * 33) ^ ((const unsigned char *) datap)[i];
+    return hash;
+}
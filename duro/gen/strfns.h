@@ -6,6 +6,8 @@
  * See the file COPYING for redistribution information.
  */
 
+#include <stddef.h>
+
 /*
  * Create a copy of string str on the heap, including the
  * terminating null byte.
@@ -40,4 +42,10 @@ RDB_find_str(int strc, char *strv[], const char *str);
 unsigned
 RDB_hash_str(const char *);
 
+/*
+ * Hash function for byte sequences
+ */
+unsigned
+RDB_hash_bytes(const void *, size_t);
+
 #endif
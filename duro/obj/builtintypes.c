@@ -471,6 +471,7 @@ RDB_init_builtin_basic_types(RDB_exec_context *ecp)
 
     empty_tuple_type.def.tuple.attrc = 0;
     empty_tuple_type.def.tuple.attrv = NULL;
+    empty_tuple_type.def.tuple.headingp = NULL;
 
     RDB_NO_MEMORY_ERROR.kind = RDB_TP_SCALAR;
     RDB_NO_MEMORY_ERROR.ireplen = RDB_VARIABLE_LEN;
@@ -98,6 +98,73 @@ RDB_expr_resolve_varname_expr(RDB_expression **expp, const char *varname,
     abort();
 }
 
+/* Codes of built-in operators, sorted by name */
+static const struct {
+    const char *name;
+    enum RDB_op_code code;
+} op_codes[] = {
+    { ".", RDB_OP_DOT },
+    { "all", RDB_OP_ALL },
+    { "any", RDB_OP_ANY },
+    { "avg", RDB_OP_AVG },
+    { "count", RDB_OP_COUNT },
+    { "d_union", RDB_OP_D_UNION },
+    { "divide", RDB_OP_DIVIDE },
+    { "extend", RDB_OP_EXTEND },
+    { "group", RDB_OP_GROUP },
+    { "if", RDB_OP_IF },
+    { "intersect", RDB_OP_INTERSECT },
+    { "is_empty", RDB_OP_IS_EMPTY },
+    { "join", RDB_OP_JOIN },
+    { "max", RDB_OP_MAX },
+    { "min", RDB_OP_MIN },
+    { "minus", RDB_OP_MINUS },
+    { "project", RDB_OP_PROJECT },
+    { "relation", RDB_OP_RELATION },
+    { "rename", RDB_OP_RENAME },
+    { "semijoin", RDB_OP_SEMIJOIN },
+    { "semiminus", RDB_OP_SEMIMINUS },
+    { "sum", RDB_OP_SUM },
+    { "summarize", RDB_OP_SUMMARIZE },
+    { "tclose", RDB_OP_TCLOSE },
+    { "ungroup", RDB_OP_UNGROUP },
+    { "union", RDB_OP_UNION },
+    { "unwrap", RDB_OP_UNWRAP },
+    { "update", RDB_OP_UPDATE },
+    { "where", RDB_OP_WHERE },
+    { "wrap", RDB_OP_WRAP }
+};
+
+/*
+ * Set the operator code of a read-only operator expression
+ * from the operator name.
+ */
+void
+RDB_expr_resolve_op(RDB_expression *exp)
+{
+    int lo = 0;
+    int hi = sizeof(op_codes) / sizeof(op_codes[0]) - 1;
+
+    exp->def.op.code = RDB_OP_OTHER;
+    if (exp->def.op.name == NULL)
+        return;
+
+    /* Binary search */
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp(exp->def.op.name, op_codes[mid].name);
+        if (cmp == 0) {
+            exp->def.op.code = op_codes[mid].code;
+            return;
+        }
+        if (cmp < 0) {
+            hi = mid - 1;
+        } else {
+            lo = mid + 1;
+        }
+    }
+}
+
 /**
  * Return operator name for read-only operator expressions.
  * 
@@ -356,6 +423,7 @@ RDB_ro_op(const char *opname, RDB_exec_context *ecp)
         RDB_raise_no_memory(ecp);
         return NULL;
     }
+    RDB_expr_resolve_op(exp);
     exp->def.op.op = NULL;
 
     RDB_init_expr_list(&exp->def.op.args);
@@ -363,6 +431,7 @@ RDB_ro_op(const char *opname, RDB_exec_context *ecp)
     exp->def.op.optinfo.objc = 0;
     /* exp->def.op.optinfo.objv = NULL; */
     exp->def.op.optinfo.stopexp = NULL;
+    exp->def.op.optinfo.join_method = RDB_JOIN_NESTED_LOOP;
 
     return exp;
 }
@@ -383,12 +452,14 @@ RDB_ro_op_from_expr(RDB_expression *op, RDB_exec_context *ecp)
         return NULL;
     }
     exp->def.op.name = NULL;
+    exp->def.op.code = RDB_OP_OTHER;
 
     RDB_init_expr_list(&exp->def.op.args);
 
     exp->def.op.optinfo.objc = 0;
     /* exp->def.op.optinfo.objv = NULL; */
     exp->def.op.optinfo.stopexp = NULL;
+    exp->def.op.optinfo.join_method = RDB_JOIN_NESTED_LOOP;
 
     return exp;
 }
@@ -584,6 +655,8 @@ dup_ro_op(const RDB_expression *exp, RDB_exec_context *ecp)
         goto error;
     }
 
+    newexp->def.op.optinfo.join_method = exp->def.op.optinfo.join_method;
+
     if (exp->def.op.optinfo.objc > 0) {
         int i;
 
@@ -9,8 +9,8 @@
 #include "type.h"
 #include "builtintypes.h"
 #include "key.h"
+#include "tuple.h"
 #include "objinternal.h"
-#include <gen/hashtabit.h>
 #include <gen/hashmapit.h>
 #include <gen/strfns.h>
 
@@ -141,20 +141,8 @@ RDB_destroy_obj(RDB_object *objp, RDB_exec_context *ecp)
             RDB_free(objp->val.bin.datap);
         break;
     case RDB_OB_TUPLE:
-    {
-        RDB_hashtable_iter it;
-        tuple_entry *entryp;
-
-        RDB_init_hashtable_iter(&it, (RDB_hashtable *) &objp->val.tpl_tab);
-        while ((entryp = RDB_hashtable_next(&it)) != NULL) {
-            RDB_destroy_obj(&entryp->obj, ecp);
-            RDB_free(entryp->key);
-            RDB_free(entryp);
-        }
-        RDB_destroy_hashtable_iter(&it);
-        RDB_destroy_hashtable(&objp->val.tpl_tab);
+        RDB_destroy_tuple(objp, ecp);
         break;
-    }
     case RDB_OB_ARRAY:
     {
         if (objp->val.arr.elemv != NULL) {
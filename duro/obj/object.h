@@ -92,7 +92,17 @@ struct RDB_object {
             size_t len;
         } bin;
         struct RDB_table *tbp;
-        RDB_hashtable tpl_tab;
+        struct {
+            /* Attribute names, may be shared with other tuples */
+            struct RDB_tuple_heading *hdp;
+
+            /* Attribute values, in the order of the heading */
+            struct RDB_object *valv;
+            int capacity;
+
+            /* Values which did not fit into valv */
+            struct RDB_tuple_ext *extp;
+        } tpl;
         struct {
             RDB_int length; /* length of array */
 
@@ -107,12 +117,6 @@ struct RDB_object {
      RDB_type *store_typ;
 };
 
-/* Internal */
-typedef struct {
-    char *key;
-    RDB_object obj;
-} tuple_entry;
-
 typedef struct RDB_sequence RDB_sequence;
 
 typedef struct {
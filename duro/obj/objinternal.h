@@ -26,6 +26,52 @@ enum {
 enum RDB_obj_kind
 RDB_val_kind(const RDB_type *);
 
+/* Methods for evaluating a JOIN, chosen by the optimizer */
+enum RDB_join_method {
+    RDB_JOIN_NESTED_LOOP,
+    RDB_JOIN_HASH,
+    RDB_JOIN_MERGE
+};
+
+/*
+ * Codes of built-in operators which get special treatment
+ * by the query processor and the evaluator.
+ * RDB_OP_OTHER is used for all other operators.
+ */
+enum RDB_op_code {
+    RDB_OP_OTHER,
+    RDB_OP_DOT,
+    RDB_OP_ALL,
+    RDB_OP_ANY,
+    RDB_OP_AVG,
+    RDB_OP_COUNT,
+    RDB_OP_D_UNION,
+    RDB_OP_DIVIDE,
+    RDB_OP_EXTEND,
+    RDB_OP_GROUP,
+    RDB_OP_IF,
+    RDB_OP_INTERSECT,
+    RDB_OP_IS_EMPTY,
+    RDB_OP_JOIN,
+    RDB_OP_MAX,
+    RDB_OP_MIN,
+    RDB_OP_MINUS,
+    RDB_OP_PROJECT,
+    RDB_OP_RELATION,
+    RDB_OP_RENAME,
+    RDB_OP_SEMIJOIN,
+    RDB_OP_SEMIMINUS,
+    RDB_OP_SUM,
+    RDB_OP_SUMMARIZE,
+    RDB_OP_TCLOSE,
+    RDB_OP_UNGROUP,
+    RDB_OP_UNION,
+    RDB_OP_UNWRAP,
+    RDB_OP_UPDATE,
+    RDB_OP_WHERE,
+    RDB_OP_WRAP
+};
+
 struct RDB_expression {
     enum RDB_expr_kind kind;
     union {
@@ -39,6 +85,14 @@ struct RDB_expression {
             RDB_expr_list args;
             char *name;
 
+            /*
+             * Code of the operator, determined from the name so that
+             * per-tuple dispatch does not have to compare strings.
+             * Must be updated by calling RDB_expr_resolve_op()
+             * whenever the name is changed.
+             */
+            enum RDB_op_code code;
+
             /* When the operator is stored in a variable or returned by an operator */
             RDB_expression *op;
             struct {
@@ -56,6 +110,9 @@ struct RDB_expression {
                 RDB_object **objpv;
                 RDB_bool asc;
                 RDB_bool all_eq;
+
+                /* Only used by JOIN */
+                enum RDB_join_method join_method;
             } optinfo;
         } op;
     } def;
@@ -138,6 +195,9 @@ RDB_copy_expr_typeinfo_if_needed(RDB_expression *, const RDB_expression *,
 int
 RDB_drop_expr_children(RDB_expression *, RDB_exec_context *);
 
+void
+RDB_expr_resolve_op(RDB_expression *);
+
 int
 RDB_copy_tuple(RDB_object *dstp, const RDB_object *srcp, RDB_exec_context *);
 
@@ -9,80 +9,361 @@
 #include "excontext.h"
 #include "object.h"
 #include "objinternal.h"
-#include <gen/hashtabit.h>
+#include "builtintypes.h"
 #include <gen/strfns.h>
 
 #include <string.h>
 #include <stdlib.h>
 
 enum {
-    RDB_TUPLE_CAPACITY = 31
+    RDB_TUPLE_CAPACITY = 8
 };
 
 /*
- * A tuple is implemented using a hash table, taking advantage of
- * the fact that removing attributes is not supported.
+ * A tuple consists of a heading, which contains the attribute names
+ * and can be shared by tuples which have the same attributes,
+ * and an array of values in the order of the heading.
+ * Taking advantage of the fact that removing attributes is not supported,
+ * values are never moved, so pointers to attribute values remain valid
+ * when attributes are added.
  */
 
-static unsigned
-hash_entry(const void *ep, void *arg)
+/* Additional storage for values of a tuple */
+struct RDB_tuple_ext {
+    int capacity;
+    struct RDB_tuple_ext *nextp;
+};
+
+#define EXT_VALV(extp) ((RDB_object *) ((extp) + 1))
+
+static RDB_tuple_heading *
+new_heading(int capacity, RDB_exec_context *ecp)
+{
+    RDB_tuple_heading *hdp = RDB_alloc(sizeof(RDB_tuple_heading), ecp);
+    if (hdp == NULL)
+        return NULL;
+    hdp->refcount = 1;
+    hdp->attrc = 0;
+    hdp->capacity = capacity;
+    hdp->namev = NULL;
+    hdp->hashv = NULL;
+    if (capacity > 0) {
+        hdp->namev = RDB_alloc(sizeof(char *) * capacity, ecp);
+        if (hdp->namev == NULL)
+            goto error;
+        hdp->hashv = RDB_alloc(sizeof(unsigned) * capacity, ecp);
+        if (hdp->hashv == NULL)
+            goto error;
+    }
+    return hdp;
+
+error:
+    RDB_free(hdp->namev);
+    RDB_free(hdp);
+    return NULL;
+}
+
+/*
+ * Release a reference to a heading. The heading is deleted
+ * when there are no references left.
+ */
+void
+RDB_unref_tuple_heading(RDB_tuple_heading *hdp)
+{
+    int i;
+
+    if (--hdp->refcount > 0)
+        return;
+    for (i = 0; i < hdp->attrc; i++)
+        RDB_free(hdp->namev[i]);
+    RDB_free(hdp->namev);
+    RDB_free(hdp->hashv);
+    RDB_free(hdp);
+}
+
+static int
+heading_add(RDB_tuple_heading *hdp, const char *attrname,
+        RDB_exec_context *ecp)
+{
+    char *name;
+
+    if (hdp->attrc == hdp->capacity) {
+        int capacity = hdp->capacity > 0 ? hdp->capacity * 2
+                : RDB_TUPLE_CAPACITY;
+        char **namev;
+        unsigned *hashv;
+
+        namev = RDB_realloc(hdp->namev, sizeof(char *) * capacity, ecp);
+        if (namev == NULL)
+            return RDB_ERROR;
+        hdp->namev = namev;
+        hashv = RDB_realloc(hdp->hashv, sizeof(unsigned) * capacity, ecp);
+        if (hashv == NULL)
+            return RDB_ERROR;
+        hdp->hashv = hashv;
+        hdp->capacity = capacity;
+    }
+
+    name = RDB_dup_str(attrname);
+    if (name == NULL) {
+        RDB_raise_no_memory(ecp);
+        return RDB_ERROR;
+    }
+    hdp->namev[hdp->attrc] = name;
+    hdp->hashv[hdp->attrc] = RDB_hash_str(attrname);
+    hdp->attrc++;
+    return RDB_OK;
+}
+
+/*
+ * Create a copy of *hdp with room for one more attribute
+ */
+static RDB_tuple_heading *
+copy_heading(const RDB_tuple_heading *hdp, RDB_exec_context *ecp)
+{
+    int i;
+    RDB_tuple_heading *newhdp = new_heading(hdp->attrc + 1, ecp);
+    if (newhdp == NULL)
+        return NULL;
+
+    for (i = 0; i < hdp->attrc; i++) {
+        newhdp->namev[i] = RDB_dup_str(hdp->namev[i]);
+        if (newhdp->namev[i] == NULL) {
+            RDB_raise_no_memory(ecp);
+            RDB_unref_tuple_heading(newhdp);
+            return NULL;
+        }
+        newhdp->hashv[i] = hdp->hashv[i];
+        newhdp->attrc++;
+    }
+    return newhdp;
+}
+
+/*
+ * Return the heading of the tuple type *tpltyp.
+ * The heading is created on the first call and is owned by the type.
+ */
+RDB_tuple_heading *
+RDB_type_tuple_heading(RDB_type *tpltyp, RDB_exec_context *ecp)
 {
-    return RDB_hash_str(((tuple_entry *) ep)->key);
+    int i;
+    RDB_tuple_heading *hdp;
+
+    if (tpltyp->def.tuple.headingp != NULL)
+        return tpltyp->def.tuple.headingp;
+
+    hdp = new_heading(tpltyp->def.tuple.attrc, ecp);
+    if (hdp == NULL)
+        return NULL;
+    for (i = 0; i < tpltyp->def.tuple.attrc; i++) {
+        if (heading_add(hdp, tpltyp->def.tuple.attrv[i].name, ecp)
+                != RDB_OK) {
+            RDB_unref_tuple_heading(hdp);
+            return NULL;
+        }
+    }
+    tpltyp->def.tuple.headingp = hdp;
+    return hdp;
 }
 
-static RDB_bool
-entry_equals(const void *e1p, const void *e2p, void *arg)
+/*
+ * Return the slot number of the attribute attrname, or -1 if the heading
+ * does not contain the attribute.
+ */
+int
+RDB_tuple_heading_slot(const RDB_tuple_heading *hdp, const char *attrname)
 {
-     return (RDB_bool)
-             strcmp(((tuple_entry *) e1p)->key, ((tuple_entry *) e2p)->key) == 0;
+    int i;
+    unsigned hash;
+
+    if (hdp == NULL)
+        return -1;
+    hash = RDB_hash_str(attrname);
+    for (i = 0; i < hdp->attrc; i++) {
+        if (hdp->hashv[i] == hash && strcmp(hdp->namev[i], attrname) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * Return a pointer to the value in slot i
+ */
+RDB_object *
+RDB_tuple_slot(const RDB_object *tplp, int i)
+{
+    struct RDB_tuple_ext *extp;
+
+    if (i < tplp->val.tpl.capacity)
+        return &tplp->val.tpl.valv[i];
+    i -= tplp->val.tpl.capacity;
+    extp = tplp->val.tpl.extp;
+    while (i >= extp->capacity) {
+        i -= extp->capacity;
+        extp = extp->nextp;
+    }
+    return &EXT_VALV(extp)[i];
+}
+
+/*
+ * Return the name of the attribute in slot i
+ */
+const char *
+RDB_tuple_slot_name(const RDB_object *tplp, int i)
+{
+    return tplp->val.tpl.hdp->namev[i];
 }
 
 static void
 init_tuple(RDB_object *tp)
 {
-    RDB_init_hashtable(&tp->val.tpl_tab, RDB_TUPLE_CAPACITY,
-            &hash_entry, &entry_equals);
+    tp->val.tpl.hdp = NULL;
+    tp->val.tpl.valv = NULL;
+    tp->val.tpl.capacity = 0;
+    tp->val.tpl.extp = NULL;
     tp->kind = RDB_OB_TUPLE;
 }
 
+/*
+ * Make sure there is storage for the value in slot i
+ */
+static int
+provide_slot(RDB_object *tplp, int i, RDB_exec_context *ecp)
+{
+    int capacity = tplp->val.tpl.capacity;
+    struct RDB_tuple_ext *extp;
+    struct RDB_tuple_ext **extpp = &tplp->val.tpl.extp;
+
+    if (tplp->val.tpl.valv == NULL) {
+        tplp->val.tpl.valv = RDB_alloc(sizeof(RDB_object) * RDB_TUPLE_CAPACITY,
+                ecp);
+        if (tplp->val.tpl.valv == NULL)
+            return RDB_ERROR;
+        tplp->val.tpl.capacity = RDB_TUPLE_CAPACITY;
+        return RDB_OK;
+    }
+
+    while (*extpp != NULL) {
+        capacity += (*extpp)->capacity;
+        extpp = &(*extpp)->nextp;
+    }
+    if (i < capacity)
+        return RDB_OK;
+
+    /* Add storage, the existing values are not moved */
+    extp = RDB_alloc(sizeof(struct RDB_tuple_ext)
+            + sizeof(RDB_object) * capacity, ecp);
+    if (extp == NULL)
+        return RDB_ERROR;
+    extp->capacity = capacity;
+    extp->nextp = NULL;
+    *extpp = extp;
+    return RDB_OK;
+}
+
 static int
 provide_entry(RDB_object *tplp, const char *attrname, RDB_exec_context *ecp,
         RDB_object **valpp)
 {
-    int ret;
-    tuple_entry sentry;
-    tuple_entry *entryp;
+    int i;
+    RDB_tuple_heading *hdp;
 
     if (tplp->kind == RDB_OB_INITIAL)
         init_tuple(tplp);
 
-    sentry.key = (char *) attrname;
+    /* Check if there is already a value for the attribute */
+    hdp = tplp->val.tpl.hdp;
+    i = RDB_tuple_heading_slot(hdp, attrname);
+    if (i != -1) {
+        *valpp = RDB_tuple_slot(tplp, i);
+        return RDB_OK;
+    }
 
-    /* Check if there is already a value for the key */
-    entryp = RDB_hashtable_get(&tplp->val.tpl_tab, &sentry, NULL);
-    if (entryp != NULL) {
-        /* Return pointer to value */
-    } else {
-        /* Insert new entry */
-        entryp = RDB_alloc(sizeof(tuple_entry), ecp);
-        if (entryp == NULL) {
+    /* Add attribute */
+    i = hdp != NULL ? hdp->attrc : 0;
+    if (provide_slot(tplp, i, ecp) != RDB_OK)
+        return RDB_ERROR;
+    if (hdp == NULL || hdp->refcount > 1) {
+        /* The heading is shared, so a new one is needed */
+        RDB_tuple_heading *newhdp = hdp != NULL ? copy_heading(hdp, ecp)
+                : new_heading(RDB_TUPLE_CAPACITY, ecp);
+        if (newhdp == NULL)
             return RDB_ERROR;
+        if (hdp != NULL)
+            RDB_unref_tuple_heading(hdp);
+        tplp->val.tpl.hdp = hdp = newhdp;
+    }
+    if (heading_add(hdp, attrname, ecp) != RDB_OK)
+        return RDB_ERROR;
+
+    *valpp = RDB_tuple_slot(tplp, i);
+    RDB_init_obj(*valpp);
+    return RDB_OK;
+}
+
+/*
+ * Destroy the values of a tuple and release the heading.
+ * Afterwards the tuple has no attributes.
+ */
+int
+RDB_destroy_tuple(RDB_object *tplp, RDB_exec_context *ecp)
+{
+    int i;
+    int ret = RDB_OK;
+    struct RDB_tuple_ext *extp;
+
+    if (tplp->val.tpl.hdp != NULL) {
+        for (i = 0; i < tplp->val.tpl.hdp->attrc; i++) {
+            if (RDB_destroy_obj(RDB_tuple_slot(tplp, i), ecp) != RDB_OK)
+                ret = RDB_ERROR;
         }
-        entryp->key = RDB_dup_str(attrname);
-        if (entryp->key == NULL) {
-            RDB_free(entryp);
-            RDB_raise_no_memory(ecp);
+        RDB_unref_tuple_heading(tplp->val.tpl.hdp);
+    }
+    RDB_free(tplp->val.tpl.valv);
+    extp = tplp->val.tpl.extp;
+    while (extp != NULL) {
+        struct RDB_tuple_ext *nextp = extp->nextp;
+        RDB_free(extp);
+        extp = nextp;
+    }
+    init_tuple(tplp);
+    return ret;
+}
+
+/*
+ * Make *tplp a tuple which has the attributes of the heading *hdp.
+ * If *tplp already has this heading, the values are kept,
+ * otherwise they are initialized using RDB_init_obj().
+ * This allows the values to be set by slot number.
+ */
+int
+RDB_tuple_set_heading(RDB_object *tplp, RDB_tuple_heading *hdp,
+        RDB_exec_context *ecp)
+{
+    int i;
+
+    if (tplp->kind == RDB_OB_TUPLE) {
+        if (tplp->val.tpl.hdp == hdp)
+            return RDB_OK;
+        if (RDB_destroy_tuple(tplp, ecp) != RDB_OK)
             return RDB_ERROR;
-        }
-        ret = RDB_hashtable_put(&tplp->val.tpl_tab, entryp, NULL);
-        if (ret != RDB_OK) {
-            RDB_free(entryp->key);
-            RDB_free(entryp);
-            return ret;
-        }
-        RDB_init_obj(&entryp->obj);
+    } else if (tplp->kind == RDB_OB_INITIAL) {
+        init_tuple(tplp);
+    } else {
+        RDB_raise_invalid_argument("not a tuple", ecp);
+        return RDB_ERROR;
+    }
+
+    if (hdp->attrc > 0) {
+        tplp->val.tpl.valv = RDB_alloc(sizeof(RDB_object) * hdp->attrc, ecp);
+        if (tplp->val.tpl.valv == NULL)
+            return RDB_ERROR;
+        tplp->val.tpl.capacity = hdp->attrc;
+        for (i = 0; i < hdp->attrc; i++)
+            RDB_init_obj(&tplp->val.tpl.valv[i]);
     }
-    *valpp = &entryp->obj;
+    hdp->refcount++;
+    tplp->val.tpl.hdp = hdp;
     return RDB_OK;
 }
 
@@ -243,17 +524,15 @@ attribute with that name exists.
 RDB_object *
 RDB_tuple_get(const RDB_object *tplp, const char *attrname)
 {
-    tuple_entry sentry;
-    tuple_entry *entryp;
+    int i;
 
     if (tplp->kind == RDB_OB_INITIAL)
         return NULL;
 
-    sentry.key = (char *) attrname;
-    entryp = RDB_hashtable_get(&tplp->val.tpl_tab, &sentry, NULL);
-    if (entryp == NULL)
+    i = RDB_tuple_heading_slot(tplp->val.tpl.hdp, attrname);
+    if (i == -1)
         return NULL;
-    return &entryp->obj;
+    return RDB_tuple_slot(tplp, i);
 }
 
 /**
@@ -327,9 +606,9 @@ The number of attributes.
 RDB_int
 RDB_tuple_size(const RDB_object *tplp)
 {
-    if (tplp->kind == RDB_OB_INITIAL)
+    if (tplp->kind == RDB_OB_INITIAL || tplp->val.tpl.hdp == NULL)
         return (RDB_int) 0;
-    return (RDB_int) RDB_hashtable_size(&tplp->val.tpl_tab);
+    return (RDB_int) tplp->val.tpl.hdp->attrc;
 }
 
 /**
@@ -343,18 +622,12 @@ when the tuple is destroyed.
 void
 RDB_tuple_attr_names(const RDB_object *tplp, char **namev)
 {
-    int i = 0;
-    tuple_entry *entryp;
-    RDB_hashtable_iter hiter;
-
-    if (tplp->kind == RDB_OB_INITIAL)
-        return;
+    int i;
+    int attrc = RDB_tuple_size(tplp);
 
-    RDB_init_hashtable_iter(&hiter, (RDB_hashtable *) &tplp->val.tpl_tab);
-    while ((entryp = RDB_hashtable_next(&hiter)) != NULL) {
-        namev[i++] = entryp->key;
+    for (i = 0; i < attrc; i++) {
+        namev[i] = tplp->val.tpl.hdp->namev[i];
     }
-    RDB_destroy_hashtable_iter(&hiter);
 }
 
 /**
@@ -409,9 +682,8 @@ int
 RDB_remove_tuple(const RDB_object *tplp, int attrc, const char *attrv[],
                  RDB_exec_context *ecp, RDB_object *restplp)
 {
-    RDB_hashtable_iter hiter;
-    tuple_entry *entryp;
-    int i;
+    int i, j;
+    int tplattrc;
 
     if (tplp->kind != RDB_OB_TUPLE) {
         RDB_raise_invalid_argument("not a tuple", ecp);
@@ -421,21 +693,19 @@ RDB_remove_tuple(const RDB_object *tplp, int attrc, const char *attrv[],
     RDB_destroy_obj(restplp, ecp);
     RDB_init_obj(restplp);
 
-    RDB_init_hashtable_iter(&hiter, (RDB_hashtable *) &tplp->val.tpl_tab);
-    for (;;) {
-        /* Get next attribute */
-        entryp = (tuple_entry *) RDB_hashtable_next(&hiter);
-        if (entryp == NULL)
-            break;
+    tplattrc = RDB_tuple_size(tplp);
+    for (j = 0; j < tplattrc; j++) {
+        const char *attrname = RDB_tuple_slot_name(tplp, j);
 
         /* Check if attribute is in attribute list */
-        for (i = 0; i < attrc && strcmp(entryp->key, attrv[i]) != 0; i++);
+        for (i = 0; i < attrc && strcmp(attrname, attrv[i]) != 0; i++);
         if (i >= attrc) {
             /* Not found, so copy attribute */
-            RDB_tuple_set(restplp, entryp->key, &entryp->obj, ecp);
+            if (RDB_tuple_set(restplp, attrname, RDB_tuple_slot(tplp, j), ecp)
+                    != RDB_OK)
+                return RDB_ERROR;
         }
     }
-    RDB_destroy_hashtable_iter(&hiter);
 
     return RDB_OK;
 }
@@ -459,8 +729,8 @@ int
 RDB_rename_tuple(const RDB_object *tplp, int renc, const RDB_renaming renv[],
                  RDB_exec_context *ecp, RDB_object *restup)
 {
-    RDB_hashtable_iter it;
-    tuple_entry *entryp;
+    int i;
+    int attrc;
 
     if (tplp->kind != RDB_OB_TUPLE) {
         RDB_raise_invalid_argument("not a tuple", ecp);
@@ -468,25 +738,18 @@ RDB_rename_tuple(const RDB_object *tplp, int renc, const RDB_renaming renv[],
     }
 
     /* Copy attributes to tplp */
-    RDB_init_hashtable_iter(&it, (RDB_hashtable *)&tplp->val.tpl_tab);
-    while ((entryp = RDB_hashtable_next(&it)) != NULL) {
+    attrc = RDB_tuple_size(tplp);
+    for (i = 0; i < attrc; i++) {
         int ret;
-        int ai = RDB_find_rename_from(renc, renv, entryp->key);
+        const char *attrname = RDB_tuple_slot_name(tplp, i);
+        int ai = RDB_find_rename_from(renc, renv, attrname);
 
-        if (ai >= 0) {
-            ret = RDB_tuple_set(restup, renv[ai].to, &entryp->obj, ecp);
-        } else {
-            ret = RDB_tuple_set(restup, entryp->key, &entryp->obj, ecp);
-        }
-
-        if (ret != RDB_OK) {
-            RDB_destroy_hashtable_iter(&it);
+        ret = RDB_tuple_set(restup, ai >= 0 ? renv[ai].to : attrname,
+                RDB_tuple_slot(tplp, i), ecp);
+        if (ret != RDB_OK)
             return ret;
-        }
     }
 
-    RDB_destroy_hashtable_iter(&it);
-
     return RDB_OK;
 }
 
@@ -510,8 +773,8 @@ RDB_is_tuple(const RDB_object *objp)
 int
 RDB_copy_tuple(RDB_object *dstp, const RDB_object *srcp, RDB_exec_context *ecp)
 {
-    RDB_hashtable_iter it;
-    tuple_entry *entryp;
+    int i;
+    int attrc;
 
     if (srcp->kind == RDB_OB_INITIAL)
         return RDB_OK;
@@ -521,18 +784,71 @@ RDB_copy_tuple(RDB_object *dstp, const RDB_object *srcp, RDB_exec_context *ecp)
         return RDB_ERROR;
     }
 
-    /* Copy attributes to tup */
-    RDB_init_hashtable_iter(&it, (RDB_hashtable *)&srcp->val.tpl_tab);
-    while ((entryp = RDB_hashtable_next(&it)) != NULL) {
-        int ret = RDB_tuple_set(dstp, entryp->key, &entryp->obj, ecp);
-
-        if (ret != RDB_OK) {
-            RDB_destroy_hashtable_iter(&it);
-            return ret;
+    attrc = RDB_tuple_size(srcp);
+
+    /*
+     * If the destination is empty or has the same heading,
+     * copy the values slot by slot without looking up the attribute names
+     */
+    if (srcp->val.tpl.hdp != NULL
+            && (dstp->kind == RDB_OB_INITIAL
+                || (dstp->kind == RDB_OB_TUPLE
+                    && dstp->val.tpl.hdp == srcp->val.tpl.hdp))) {
+        if (RDB_tuple_set_heading(dstp, srcp->val.tpl.hdp, ecp) != RDB_OK)
+            return RDB_ERROR;
+        for (i = 0; i < attrc; i++) {
+            if (RDB_copy_obj(RDB_tuple_slot(dstp, i), RDB_tuple_slot(srcp, i),
+                    ecp) != RDB_OK)
+                return RDB_ERROR;
         }
+        return RDB_OK;
     }
 
-    RDB_destroy_hashtable_iter(&it);
+    /* Copy attributes to dstp */
+    for (i = 0; i < attrc; i++) {
+        if (RDB_tuple_set(dstp, RDB_tuple_slot_name(srcp, i),
+                RDB_tuple_slot(srcp, i), ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
 
     return RDB_OK;
 }
+
+/*
+ * Compute a hash value from the attributes attrv of a tuple.
+ * Only values of built-in types whose equality is equality of the
+ * stored data are taken into account, so tuples whose attributes are equal
+ * always have the same hash value. Values of other types must be compared
+ * by the caller.
+ */
+unsigned
+RDB_tuple_hash_attrs(const RDB_object *tplp, int attrc, char **attrv)
+{
+    int i;
+    unsigned hash = 5381;
+
+    for (i = 0; i < attrc; i++) {
+        unsigned h;
+        RDB_object *objp = RDB_tuple_get(tplp, attrv[i]);
+
+        if (objp == NULL)
+            continue;
+        if (objp->typ == &RDB_INTEGER) {
+            h = (unsigned) objp->val.int_val;
+        } else if (objp->typ == &RDB_BOOLEAN) {
+            h = (unsigned) objp->val.bool_val;
+        } else if (objp->typ == &RDB_STRING) {
+            h = RDB_hash_str(RDB_obj_string(objp));
+        } else if (objp->typ == &RDB_BINARY) {
+            h = RDB_hash_bytes(objp->val.bin.datap, objp->val.bin.len);
+        } else if (objp->typ == &RDB_FLOAT) {
+            /* 0.0 and -0.0 are equal */
+            h = objp->val.float_val == 0.0 ? 0
+                    : RDB_hash_bytes(&objp->val.float_val, sizeof(RDB_float));
+        } else {
+            continue;
+        }
+        hash = (hash * 33) ^ h;
+    }
+    return hash;
+}
@@ -13,6 +13,20 @@
 typedef struct RDB_exec_context RDB_exec_context;
 typedef struct RDB_object RDB_object;
 
+/*
+ * Attribute names of a tuple. A heading can be shared by several tuples
+ * and by the tuple type it has been created from.
+ */
+typedef struct RDB_tuple_heading {
+    int refcount;
+    int attrc;
+    int capacity;
+    char **namev;
+
+    /* Hash values of the attribute names */
+    unsigned *hashv;
+} RDB_tuple_heading;
+
 int
 RDB_tuple_set(RDB_object *, const char *, const RDB_object *,
         RDB_exec_context *);
@@ -69,4 +83,28 @@ RDB_rename_tuple(const RDB_object *, int renc, const RDB_renaming renv[],
 RDB_bool
 RDB_is_tuple(const RDB_object *);
 
+RDB_tuple_heading *
+RDB_type_tuple_heading(RDB_type *, RDB_exec_context *);
+
+void
+RDB_unref_tuple_heading(RDB_tuple_heading *);
+
+int
+RDB_tuple_heading_slot(const RDB_tuple_heading *, const char *);
+
+int
+RDB_tuple_set_heading(RDB_object *, RDB_tuple_heading *, RDB_exec_context *);
+
+RDB_object *
+RDB_tuple_slot(const RDB_object *, int);
+
+const char *
+RDB_tuple_slot_name(const RDB_object *, int);
+
+int
+RDB_destroy_tuple(RDB_object *, RDB_exec_context *);
+
+unsigned
+RDB_tuple_hash_attrs(const RDB_object *, int, char **);
+
 #endif /* TUPLE_H_ */
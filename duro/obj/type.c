@@ -10,6 +10,7 @@
 #include "object.h"
 #include "excontext.h"
 #include "opmap.h"
+#include "tuple.h"
 #include "objinternal.h"
 #include <gen/strfns.h>
 #include <gen/types.h>
@@ -324,6 +325,7 @@ RDB_new_tuple_type(int attrc, const RDB_attr attrv[],
     tuptyp->compare_op = NULL;
     tuptyp->cleanup_fp = NULL;
     tuptyp->kind = RDB_TP_TUPLE;
+    tuptyp->def.tuple.headingp = NULL;
     tuptyp->ireplen = RDB_VARIABLE_LEN;
     if (attrc > 0) {
         tuptyp->def.tuple.attrv = RDB_alloc(sizeof(RDB_attr) * attrc, ecp);
@@ -658,6 +660,8 @@ RDB_del_nonscalar_type(RDB_type *typ, RDB_exec_context *ecp)
         }
         if (typ->def.tuple.attrc > 0)
             RDB_free(typ->def.tuple.attrv);
+        if (typ->def.tuple.headingp != NULL)
+            RDB_unref_tuple_heading(typ->def.tuple.headingp);
         break;
     case RDB_TP_RELATION:
     case RDB_TP_ARRAY:
@@ -938,6 +942,7 @@ RDB_extend_tuple_type(const RDB_type *typ, int attrc, RDB_attr attrv[],
 
     newtyp->name = NULL;
     newtyp->kind = RDB_TP_TUPLE;
+    newtyp->def.tuple.headingp = NULL;
     newtyp->ireplen = RDB_VARIABLE_LEN;
     newtyp->cleanup_fp = NULL;
     newtyp->def.tuple.attrc = typ->def.tuple.attrc + attrc;
@@ -1029,6 +1034,7 @@ RDB_union_tuple_types(const RDB_type *typ1, const RDB_type *typ2,
 
     newtyp->name = NULL;
     newtyp->kind = RDB_TP_TUPLE;
+    newtyp->def.tuple.headingp = NULL;
     newtyp->ireplen = RDB_VARIABLE_LEN;
     newtyp->cleanup_fp = NULL;
     
@@ -1145,6 +1151,7 @@ RDB_project_tuple_type(const RDB_type *typ, int attrc, const char *attrv[],
     }
     tuptyp->name = NULL;
     tuptyp->kind = RDB_TP_TUPLE;
+    tuptyp->def.tuple.headingp = NULL;
     tuptyp->ireplen = RDB_VARIABLE_LEN;
     tuptyp->def.tuple.attrc = attrc;
     tuptyp->cleanup_fp = NULL;
@@ -1263,6 +1270,7 @@ RDB_rename_tuple_type(const RDB_type *typ, int renc, const RDB_renaming renv[],
 
     newtyp->name = NULL;
     newtyp->kind = RDB_TP_TUPLE;
+    newtyp->def.tuple.headingp = NULL;
     newtyp->ireplen = RDB_VARIABLE_LEN;
     newtyp->cleanup_fp = NULL;
     newtyp->def.tuple.attrc = typ->def.tuple.attrc;
@@ -1376,6 +1384,7 @@ RDB_wrap_tuple_type(const RDB_type *typ, int wrapc, const RDB_wrapping wrapv[],
 
     newtyp->name = NULL;
     newtyp->kind = RDB_TP_TUPLE;
+    newtyp->def.tuple.headingp = NULL;
     newtyp->ireplen = RDB_VARIABLE_LEN;
     newtyp->cleanup_fp = NULL;
     newtyp->def.tuple.attrc = attrc;
@@ -1400,6 +1409,7 @@ RDB_wrap_tuple_type(const RDB_type *typ, int wrapc, const RDB_wrapping wrapv[],
         }
         tuptyp->name = NULL;
         tuptyp->kind = RDB_TP_TUPLE;
+        tuptyp->def.tuple.headingp = NULL;
         tuptyp->ireplen = RDB_VARIABLE_LEN;
         tuptyp->def.tuple.attrc = wrapv[i].attrc;
         tuptyp->def.tuple.attrv = RDB_alloc(sizeof(RDB_attr) * wrapv[i].attrc, ecp);
@@ -1514,6 +1524,7 @@ RDB_unwrap_tuple_type(const RDB_type *typ, int attrc, char *attrv[],
 
     newtyp->name = NULL;
     newtyp->kind = RDB_TP_TUPLE;
+    newtyp->def.tuple.headingp = NULL;
     newtyp->ireplen = RDB_VARIABLE_LEN;
     newtyp->cleanup_fp = NULL;
     newtyp->def.tuple.attrc = nattrc;
@@ -1635,6 +1646,7 @@ RDB_group_type(const RDB_type *typ, int attrc, char *attrv[], const char *gattr,
     }
 
     tuptyp->kind = RDB_TP_TUPLE;
+    tuptyp->def.tuple.headingp = NULL;
     tuptyp->ireplen = RDB_VARIABLE_LEN;
     tuptyp->name = NULL;
     tuptyp->cleanup_fp = NULL;
@@ -1732,6 +1744,7 @@ RDB_ungroup_type(RDB_type *typ, const char *attr, RDB_exec_context *ecp)
     }
 
     tuptyp->kind = RDB_TP_TUPLE;
+    tuptyp->def.tuple.headingp = NULL;
     tuptyp->ireplen = RDB_VARIABLE_LEN;
     tuptyp->name = NULL;
     tuptyp->cleanup_fp = NULL;
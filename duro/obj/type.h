@@ -91,6 +91,12 @@ typedef struct RDB_type {
         struct {
             int attrc;
             RDB_attr *attrv;
+
+            /*
+             * Heading shared by tuples of this type, created on demand
+             * by RDB_type_tuple_heading()
+             */
+            struct RDB_tuple_heading *headingp;
         } tuple;
         struct {
             int repc;
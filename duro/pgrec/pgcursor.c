@@ -6,6 +6,7 @@
 #include "pgcursor.h"
 #include "pgenv.h"
 #include "pgrecmap.h"
+#include "pgstmt.h"
 #include <rec/cursorimpl.h>
 #include <rec/envimpl.h>
 #include <rec/recmapimpl.h>
@@ -14,8 +15,6 @@
 #include <string.h>
 #include <arpa/inet.h>
 
-unsigned next_cur_id = 0;
-
 /*
  * Allocate and initialize a RDB_cursor structure.
  */
@@ -40,7 +39,13 @@ new_pg_cursor(RDB_environment *envp, RDB_recmap *rmp, RDB_rec_transaction *rtxp,
     curp->delete_fn = &RDB_pg_cursor_delete;
     curp->seek_fn = NULL;
 
-    curp->cur.pg.current_row = NULL;
+    curp->cur.pg.res = NULL;
+    curp->cur.pg.row = 0;
+    curp->cur.pg.pos = 0;
+    curp->cur.pg.fetch_rows = 1;
+    curp->cur.pg.eof = RDB_FALSE;
+    RDB_pg_init_stmt(&curp->cur.pg.setstmt);
+    RDB_pg_init_stmt(&curp->cur.pg.delstmt);
 
     return curp;
 }
@@ -87,7 +92,16 @@ RDB_pg_query_cursor(RDB_environment *envp, const char *query, RDB_bool wr,
     if (curp == NULL)
         goto error;
 
-    curp->cur.pg.id = next_cur_id++;
+    curp->cur.pg.id = envp->pg_next_cur_id++;
+    /*
+     * Cursors which are used for updating or deleting records fetch
+     * one row at a time, because they need the server cursor
+     * to be positioned on the current row
+     */
+    if (!wr) {
+        curp->cur.pg.fetch_rows = envp->fetch_rows > 0 ? envp->fetch_rows
+                : RDB_PG_FETCH_ROWS;
+    }
     if (RDB_string_to_obj(&command, "DECLARE c", ecp) != RDB_OK)
         goto error;
     sprintf(idbuf, "%u", curp->cur.pg.id);
@@ -124,69 +138,62 @@ error:
 int
 RDB_destroy_pg_cursor(RDB_cursor *curp, RDB_exec_context *ecp)
 {
-    RDB_object command;
-    char idbuf[12];
+    char command[32];
     PGresult *res;
+    int ret = RDB_OK;
 
-    RDB_init_obj(&command);
-    if (RDB_string_to_obj(&command, "CLOSE c", ecp) != RDB_OK)
-        goto error;
-    sprintf(idbuf, "%u", curp->cur.pg.id);
-    if (RDB_append_string(&command, idbuf, ecp) != RDB_OK)
-        goto error;
+    if (curp->cur.pg.res != NULL) {
+        PQclear(curp->cur.pg.res);
+    }
+
+    RDB_pg_dealloc_stmt(curp->envp, &curp->cur.pg.setstmt);
+    RDB_pg_dealloc_stmt(curp->envp, &curp->cur.pg.delstmt);
 
+    sprintf(command, "CLOSE c%u", curp->cur.pg.id);
     if (RDB_env_trace(curp->envp) > 0) {
-        fprintf(stderr, "Sending SQL: %s\n", RDB_obj_string(&command));
+        fprintf(stderr, "Sending SQL: %s\n", command);
     }
-    res = PQexec(curp->envp->env.pgconn, RDB_obj_string(&command));
+    res = PQexec(curp->envp->env.pgconn, command);
     if (PQresultStatus(res) != PGRES_COMMAND_OK)
     {
         RDB_pgresult_to_error(curp->envp, res, ecp);
-        PQclear(res);
-        goto error;
+        ret = RDB_ERROR;
     }
     PQclear(res);
-    if (curp->cur.pg.current_row != NULL) {
-        PQclear(curp->cur.pg.current_row);
-    }
     RDB_free(curp);
-    RDB_destroy_obj(&command, ecp);
-    return RDB_OK;
+    return ret;
+}
 
-error:
-    if (curp->cur.pg.current_row != NULL) {
-        PQclear(curp->cur.pg.current_row);
-    }
-    RDB_free(curp);
-    RDB_destroy_obj(&command, ecp);
-    return RDB_ERROR;
+/*
+ * Return RDB_TRUE if the cursor is positioned on a row in curp->cur.pg.res.
+ */
+static RDB_bool
+on_row(const RDB_cursor *curp)
+{
+    return (RDB_bool) (curp->cur.pg.res != NULL && curp->cur.pg.row >= 0
+            && curp->cur.pg.row < PQntuples(curp->cur.pg.res));
 }
 
 static int
 pg_cursor_get(RDB_cursor *curp, int fno, void **datapp, size_t *lenp,
         int flags, RDB_exec_context *ecp)
 {
-    static union {
-        RDB_int i;
-        RDB_float f;
-    } fieldval;
-
-    if (curp->cur.pg.current_row == NULL) {
+    if (!on_row(curp)) {
         RDB_raise_not_found("", ecp);
         return RDB_ERROR;
     }
-    *datapp = PQgetvalue(curp->cur.pg.current_row, 0, fno);
+    *datapp = PQgetvalue(curp->cur.pg.res, curp->cur.pg.row, fno);
     if (*datapp == NULL) {
         RDB_raise_not_found("no field data", ecp);
         return RDB_ERROR;
     }
-    *lenp = (size_t) PQgetlength(curp->cur.pg.current_row, 0, fno);
+    *lenp = (size_t) PQgetlength(curp->cur.pg.res, curp->cur.pg.row, fno);
     if (RDB_FTYPE_INTEGER & flags) {
-        fieldval.i = ntohl(*((uint32_t *)*datapp));
-        *datapp = &fieldval;
+        curp->cur.pg.fieldval.i = ntohl(*((uint32_t *)*datapp));
+        *datapp = &curp->cur.pg.fieldval;
     } else if (RDB_FTYPE_FLOAT & flags) {
-        RDB_ntoh(&fieldval, *datapp, sizeof(RDB_float));
-        *datapp = &fieldval;
+        RDB_ntoh(&curp->cur.pg.fieldval, *datapp, sizeof(RDB_float));
+        *datapp = &curp->cur.pg.fieldval;
     }
     return RDB_OK;
 }
@@ -212,7 +219,7 @@ RDB_pg_cursor_get_by_name(RDB_cursor *curp, const char *attrname, void **datapp,
 {
     RDB_object colname;
     int colnum;
-    if (curp->cur.pg.current_row == NULL) {
+    if (!on_row(curp)) {
         RDB_raise_not_found("", ecp);
         return RDB_ERROR;
     }
@@ -230,7 +237,7 @@ RDB_pg_cursor_get_by_name(RDB_cursor *curp, const char *attrname, void **datapp,
         RDB_destroy_obj(&colname, ecp);
         return RDB_ERROR;
     }
-    colnum = PQfnumber(curp->cur.pg.current_row, RDB_obj_string(&colname));
+    colnum = PQfnumber(curp->cur.pg.res, RDB_obj_string(&colname));
     RDB_destroy_obj(&colname, ecp);
     if (colnum == -1) {
         RDB_raise_not_found(attrname, ecp);
@@ -239,44 +246,60 @@ RDB_pg_cursor_get_by_name(RDB_cursor *curp, const char *attrname, void **datapp,
     return pg_cursor_get(curp, colnum, datapp, lenp, flags, ecp);
 }
 
+/*
+ * Execute a FETCH command and make the rows returned the rows of the cursor.
+ * The cursor is positioned on the first row returned.
+ */
 static int
-exec_fetch(RDB_cursor *curp, const char *curcmd, RDB_exec_context *ecp)
+exec_fetch(RDB_cursor *curp, const char *command, RDB_exec_context *ecp)
 {
-    RDB_object command;
-    char idbuf[12];
     ExecStatusType execstatus;
 
-    RDB_init_obj(&command);
-    if (RDB_string_to_obj(&command, curcmd, ecp) != RDB_OK)
-        goto error;
-    if (RDB_append_string(&command, " c", ecp) != RDB_OK)
-        goto error;
-    sprintf(idbuf, "%u", curp->cur.pg.id);
-    if (RDB_append_string(&command, idbuf, ecp) != RDB_OK)
-        goto error;
-
     if (RDB_env_trace(curp->envp) > 0) {
-        fprintf(stderr, "Sending SQL: %s\n", RDB_obj_string(&command));
+        fprintf(stderr, "Sending SQL: %s\n", command);
     }
-    if (curp->cur.pg.current_row != NULL)
-        PQclear(curp->cur.pg.current_row);
-    curp->cur.pg.current_row = PQexecParams(curp->envp->env.pgconn,
-            RDB_obj_string(&command), 0, NULL, NULL, NULL, NULL, 1);
-    execstatus = PQresultStatus(curp->cur.pg.current_row);
+    if (curp->cur.pg.res != NULL)
+        PQclear(curp->cur.pg.res);
+    curp->cur.pg.res = PQexecParams(curp->envp->env.pgconn,
+            command, 0, NULL, NULL, NULL, NULL, 1);
+    curp->cur.pg.row = 0;
+    execstatus = PQresultStatus(curp->cur.pg.res);
     if (execstatus != PGRES_TUPLES_OK && execstatus != PGRES_SINGLE_TUPLE) {
-        RDB_pgresult_to_error(curp->envp, curp->cur.pg.current_row, ecp);
-        goto error;
+        RDB_pgresult_to_error(curp->envp, curp->cur.pg.res, ecp);
+        PQclear(curp->cur.pg.res);
+        curp->cur.pg.res = NULL;
+        return RDB_ERROR;
     }
-    if (PQntuples(curp->cur.pg.current_row) == 0) {
+    if (PQntuples(curp->cur.pg.res) == 0) {
         RDB_raise_not_found(PQerrorMessage(curp->envp->env.pgconn), ecp);
-        goto error;
+        return RDB_ERROR;
     }
-    RDB_destroy_obj(&command, ecp);
     return RDB_OK;
+}
 
-error:
-    RDB_destroy_obj(&command, ecp);
-    return RDB_ERROR;
+/*
+ * Fetch the next rows from the server cursor, which must be positioned
+ * on the last row in curp->cur.pg.res.
+ */
+static int
+fetch_forward(RDB_cursor *curp, RDB_exec_context *ecp)
+{
+    char command[48];
+
+    if (curp->cur.pg.fetch_rows == 1) {
+        sprintf(command, "FETCH c%u", curp->cur.pg.id);
+    } else {
+        sprintf(command, "FETCH %d c%u", curp->cur.pg.fetch_rows,
+                curp->cur.pg.id);
+    }
+    if (exec_fetch(curp, command, ecp) != RDB_OK) {
+        if (curp->cur.pg.res != NULL)
+            curp->cur.pg.eof = RDB_TRUE;
+        return RDB_ERROR;
+    }
+    curp->cur.pg.eof = (RDB_bool)
+            (PQntuples(curp->cur.pg.res) < curp->cur.pg.fetch_rows);
+    return RDB_OK;
 }
 
 /*
@@ -286,47 +309,110 @@ error:
 int
 RDB_pg_cursor_first(RDB_cursor *curp, RDB_exec_context *ecp)
 {
-    return exec_fetch(curp, "FETCH FIRST", ecp);
+    char command[48];
+
+    if (curp->cur.pg.res == NULL && curp->cur.pg.pos == 0) {
+        /* Nothing has been fetched, so the first rows can be fetched */
+        if (fetch_forward(curp, ecp) != RDB_OK)
+            return RDB_ERROR;
+        curp->cur.pg.pos = 1;
+        return RDB_OK;
+    }
+
+    if (curp->cur.pg.fetch_rows > 1 && curp->cur.pg.res != NULL
+            && PQntuples(curp->cur.pg.res) > 0
+            && curp->cur.pg.pos - curp->cur.pg.row == 1) {
+        /* The first row has already been fetched */
+        curp->cur.pg.row = 0;
+        curp->cur.pg.pos = 1;
+        return RDB_OK;
+    }
+
+    sprintf(command, "FETCH FIRST c%u", curp->cur.pg.id);
+    if (exec_fetch(curp, command, ecp) != RDB_OK) {
+        curp->cur.pg.pos = 0;
+        return RDB_ERROR;
+    }
+    curp->cur.pg.pos = 1;
+    curp->cur.pg.eof = RDB_FALSE;
+    return RDB_OK;
 }
 
 int
 RDB_pg_cursor_next(RDB_cursor *curp, int flags, RDB_exec_context *ecp)
 {
-    return exec_fetch(curp, "FETCH", ecp);
+    if (curp->cur.pg.res != NULL
+            && curp->cur.pg.row + 1 < PQntuples(curp->cur.pg.res)) {
+        curp->cur.pg.row++;
+        curp->cur.pg.pos++;
+        return RDB_OK;
+    }
+    if (curp->cur.pg.eof) {
+        /* Move past the last row */
+        if (curp->cur.pg.res != NULL
+                && curp->cur.pg.row < PQntuples(curp->cur.pg.res)) {
+            curp->cur.pg.row++;
+            curp->cur.pg.pos++;
+        }
+        RDB_raise_not_found("", ecp);
+        return RDB_ERROR;
+    }
+    if (fetch_forward(curp, ecp) != RDB_OK) {
+        if (curp->cur.pg.eof)
+            curp->cur.pg.pos++;
+        return RDB_ERROR;
+    }
+    curp->cur.pg.pos++;
+    return RDB_OK;
 }
 
 int
 RDB_pg_cursor_prev(RDB_cursor *curp, RDB_exec_context *ecp)
 {
-    return exec_fetch(curp, "FETCH PRIOR", ecp);
+    char command[48];
+
+    /*
+     * Cursors which fetch one row at a time must keep the server cursor
+     * on the current row, so they always move the server cursor
+     */
+    if (curp->cur.pg.fetch_rows > 1 && curp->cur.pg.res != NULL
+            && curp->cur.pg.row > 0
+            && curp->cur.pg.row <= PQntuples(curp->cur.pg.res)) {
+        curp->cur.pg.row--;
+        curp->cur.pg.pos--;
+        return RDB_OK;
+    }
+    if (curp->cur.pg.pos <= 1) {
+        /* Move before the first row */
+        curp->cur.pg.row = -1;
+        curp->cur.pg.pos = 0;
+        RDB_raise_not_found("", ecp);
+        return RDB_ERROR;
+    }
+
+    /* Fetch the previous row, leaving the server cursor positioned on it */
+    sprintf(command, "FETCH ABSOLUTE %ld c%u", curp->cur.pg.pos - 1,
+            curp->cur.pg.id);
+    if (exec_fetch(curp, command, ecp) != RDB_OK)
+        return RDB_ERROR;
+    curp->cur.pg.pos--;
+    curp->cur.pg.eof = RDB_FALSE;
+    return RDB_OK;
 }
 
-int
-RDB_pg_cursor_set(RDB_cursor *curp, int fieldc, RDB_field fields[],
+/*
+ * Prepare the statement which updates the fields given by fieldc and fields
+ * of the current row.
+ */
+static int
+prepare_set(RDB_cursor *curp, int fieldc, RDB_field fields[],
         RDB_exec_context *ecp)
 {
     RDB_object command;
     char numbuf[14];
     int i;
-    int *lenv = NULL;
-    void **valuev = NULL;
-    int *formatv = NULL;
-    PGresult *res;
 
     RDB_init_obj(&command);
-    lenv = RDB_alloc(fieldc * sizeof(int), ecp);
-    if (lenv == NULL)
-        goto error;
-    valuev = RDB_alloc(fieldc * sizeof(void*), ecp);
-    if (valuev == NULL)
-        goto error;
-    for (i = 0; i < fieldc; i++) {
-        valuev[i] = NULL;
-    }
-    formatv = RDB_alloc(fieldc * sizeof(int), ecp);
-    if (formatv == NULL)
-        goto error;
-
     if (RDB_string_to_obj(&command, "UPDATE \"", ecp) != RDB_OK)
         goto error;
     if (RDB_append_string(&command, curp->recmapp->namp, ecp) != RDB_OK)
@@ -348,11 +434,6 @@ RDB_pg_cursor_set(RDB_cursor *curp, int fieldc, RDB_field fields[],
             if (RDB_append_char(&command, ',', ecp) != RDB_OK)
                 goto error;
         }
-        lenv[i] = fields[i].len;
-        valuev[i] = RDB_field_to_pg(&fields[i], &curp->recmapp->fieldinfos[fields[i].no],
-                &formatv[i], ecp);
-        if (valuev[i] == NULL)
-            goto error;
     }
 
     if (RDB_append_string(&command, " WHERE CURRENT OF c", ecp) != RDB_OK)
@@ -361,12 +442,55 @@ RDB_pg_cursor_set(RDB_cursor *curp, int fieldc, RDB_field fields[],
     if (RDB_append_string(&command, numbuf, ecp) != RDB_OK)
         goto error;
 
-    if (RDB_env_trace(curp->envp) > 0) {
-        fprintf(stderr, "Sending SQL: %s\n", RDB_obj_string(&command));
+    if (RDB_pg_prepare_stmt(curp->envp, &curp->cur.pg.setstmt,
+            RDB_obj_string(&command), fieldc, fields, ecp) != RDB_OK) {
+        goto error;
     }
-    res = PQexecParams(curp->envp->env.pgconn, RDB_obj_string(&command),
-            fieldc, NULL, (const char * const *) valuev, lenv,
-            formatv, 1);
+    return RDB_destroy_obj(&command, ecp);
+
+error:
+    RDB_destroy_obj(&command, ecp);
+    return RDB_ERROR;
+}
+
+int
+RDB_pg_cursor_set(RDB_cursor *curp, int fieldc, RDB_field fields[],
+        RDB_exec_context *ecp)
+{
+    int i;
+    int *lenv = NULL;
+    void **valuev = NULL;
+    int *formatv = NULL;
+    PGresult *res;
+
+    if (!RDB_pg_stmt_prepared(&curp->cur.pg.setstmt, fieldc, fields)) {
+        if (prepare_set(curp, fieldc, fields, ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
+
+    lenv = RDB_alloc(fieldc * sizeof(int), ecp);
+    if (lenv == NULL)
+        goto error;
+    valuev = RDB_alloc(fieldc * sizeof(void*), ecp);
+    if (valuev == NULL)
+        goto error;
+    for (i = 0; i < fieldc; i++) {
+        valuev[i] = NULL;
+    }
+    formatv = RDB_alloc(fieldc * sizeof(int), ecp);
+    if (formatv == NULL)
+        goto error;
+
+    for (i = 0; i < fieldc; i++) {
+        lenv[i] = fields[i].len;
+        valuev[i] = RDB_field_to_pg(&fields[i], &curp->recmapp->fieldinfos[fields[i].no],
+                &formatv[i], ecp);
+        if (valuev[i] == NULL)
+            goto error;
+    }
+
+    res = RDB_pg_exec_stmt(curp->envp, &curp->cur.pg.setstmt,
+            fieldc, (const char * const *) valuev, lenv, formatv, 1);
     if (PQresultStatus(res) != PGRES_COMMAND_OK)
     {
         RDB_pgresult_to_error(curp->envp, res, ecp);
@@ -381,7 +505,6 @@ RDB_pg_cursor_set(RDB_cursor *curp, int fieldc, RDB_field fields[],
     }
     RDB_free(valuev);
     RDB_free(formatv);
-    RDB_destroy_obj(&command, ecp);
     return RDB_OK;
 
 error:
@@ -396,16 +519,17 @@ error:
         }
         RDB_free(valuev);
     }
-    RDB_destroy_obj(&command, ecp);
     return RDB_ERROR;
 }
 
-int
-RDB_pg_cursor_delete(RDB_cursor *curp, RDB_exec_context *ecp)
+/*
+ * Prepare the statement which deletes the current row.
+ */
+static int
+prepare_delete(RDB_cursor *curp, RDB_exec_context *ecp)
 {
     RDB_object command;
     char numbuf[14];
-    PGresult *res;
 
     RDB_init_obj(&command);
     if (RDB_string_to_obj(&command, "DELETE FROM \"", ecp) != RDB_OK)
@@ -418,21 +542,35 @@ RDB_pg_cursor_delete(RDB_cursor *curp, RDB_exec_context *ecp)
     if (RDB_append_string(&command, numbuf, ecp) != RDB_OK)
         goto error;
 
-    if (RDB_env_trace(curp->envp) > 0) {
-        fprintf(stderr, "Sending SQL: %s\n", RDB_obj_string(&command));
+    if (RDB_pg_prepare_stmt(curp->envp, &curp->cur.pg.delstmt,
+            RDB_obj_string(&command), 0, NULL, ecp) != RDB_OK) {
+        goto error;
+    }
+    return RDB_destroy_obj(&command, ecp);
+
+error:
+    RDB_destroy_obj(&command, ecp);
+    return RDB_ERROR;
+}
+
+int
+RDB_pg_cursor_delete(RDB_cursor *curp, RDB_exec_context *ecp)
+{
+    PGresult *res;
+
+    if (!RDB_pg_stmt_prepared(&curp->cur.pg.delstmt, 0, NULL)) {
+        if (prepare_delete(curp, ecp) != RDB_OK)
+            return RDB_ERROR;
     }
-    res = PQexec(curp->envp->env.pgconn, RDB_obj_string(&command));
+
+    res = RDB_pg_exec_stmt(curp->envp, &curp->cur.pg.delstmt, 0, NULL, NULL,
+            NULL, 0);
     if (PQresultStatus(res) != PGRES_COMMAND_OK)
     {
         RDB_pgresult_to_error(curp->envp, res, ecp);
         PQclear(res);
-        goto error;
+        return RDB_ERROR;
     }
     PQclear(res);
-    RDB_destroy_obj(&command, ecp);
     return RDB_OK;
-
-error:
-    RDB_destroy_obj(&command, ecp);
-    return RDB_ERROR;
 }
@@ -14,6 +14,10 @@ typedef struct RDB_rec_transaction RDB_rec_transaction;
 typedef struct RDB_index RDB_index;
 typedef struct RDB_exec_context RDB_exec_context;
 
+enum {
+    RDB_PG_FETCH_ROWS = 256
+};
+
 RDB_cursor *
 RDB_pg_recmap_cursor(RDB_recmap *, RDB_bool wr, RDB_rec_transaction *, RDB_exec_context *);
 
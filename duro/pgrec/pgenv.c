@@ -61,6 +61,12 @@ RDB_pg_open_env(const char *path, RDB_exec_context *ecp)
     envp->xdata = NULL;
     envp->trace = 0;
     envp->queries = RDB_TRUE;
+    envp->hash_mem = 0;
+    envp->sort_mem = 0;
+    envp->fetch_rows = 0;
+    envp->pg_next_cur_id = 0;
+    envp->pg_next_stmt_id = 0;
+    envp->pg_next_savepoint_id = 0;
 
     envp->env.pgconn = PQconnectdb(path);
     if (PQstatus(envp->env.pgconn) != CONNECTION_OK)
@@ -32,6 +32,7 @@ new_min_index(const char *name, RDB_recmap *rmp, RDB_exec_context *ecp)
     ixp->delete_index_fn = &RDB_delete_pg_index;
     ixp->index_delete_rec_fn = NULL;
     ixp->index_get_fields_fn = NULL;
+    ixp->index_get_fields_multi_fn = NULL;
     ixp->index_cursor_fn = NULL;
 
     return ixp;
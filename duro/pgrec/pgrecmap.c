@@ -10,6 +10,7 @@
 #include "pgenv.h"
 #include "pgtx.h"
 #include "pgindex.h"
+#include "pgstmt.h"
 #include <rec/recmapimpl.h>
 #include <rec/envimpl.h>
 #include <rec/dbdefs.h>
@@ -25,6 +26,7 @@ new_pg_recmap(const char *name, RDB_environment *envp,
         int fieldc, const RDB_field_info fieldinfov[],
         int keyfieldc, int flags, RDB_exec_context *ecp)
 {
+    int i;
     RDB_recmap *rmp = RDB_new_recmap(name, NULL, envp, fieldc, fieldinfov,
             keyfieldc, flags, ecp);
     if (rmp == NULL) {
@@ -34,6 +36,7 @@ new_pg_recmap(const char *name, RDB_environment *envp,
     rmp->close_recmap_fn = RDB_close_pg_recmap;
     rmp->delete_recmap_fn = &RDB_delete_pg_recmap;
     rmp->insert_rec_fn = &RDB_insert_pg_rec;
+    rmp->insert_recs_fn = &RDB_insert_pg_recs;
     rmp->update_rec_fn = &RDB_update_pg_rec;
     rmp->delete_rec_fn = &RDB_delete_pg_rec;
     rmp->get_fields_fn = &RDB_get_pg_fields;
@@ -44,9 +47,43 @@ new_pg_recmap(const char *name, RDB_environment *envp,
     rmp->open_index_fn = NULL;
 
     rmp->fieldcount = fieldc;
+    for (i = 0; i < RDB_PG_STMT_COUNT; i++) {
+        RDB_pg_init_stmt(&rmp->impl.pg.stmtv[i]);
+    }
+    rmp->impl.pg.getres = NULL;
+    rmp->impl.pg.getnumv = NULL;
     return rmp;
 }
 
+/*
+ * Deallocate the prepared statements of *rmp.
+ */
+static void
+dealloc_stmts(RDB_recmap *rmp)
+{
+    int i;
+
+    for (i = 0; i < RDB_PG_STMT_COUNT; i++) {
+        RDB_pg_dealloc_stmt(rmp->envp, &rmp->impl.pg.stmtv[i]);
+    }
+}
+
+/*
+ * Free the data returned by the last RDB_get_pg_fields() call on *rmp.
+ */
+static void
+clear_get_fields(RDB_recmap *rmp)
+{
+    if (rmp->impl.pg.getres != NULL) {
+        PQclear(rmp->impl.pg.getres);
+        rmp->impl.pg.getres = NULL;
+    }
+    if (rmp->impl.pg.getnumv != NULL) {
+        RDB_free(rmp->impl.pg.getnumv);
+        rmp->impl.pg.getnumv = NULL;
+    }
+}
+
 RDB_recmap *
 RDB_create_pg_recmap(const char *name,
         RDB_environment *envp, int fieldc, const RDB_field_info fieldinfov[], int keyfieldc,
@@ -227,6 +264,8 @@ RDB_open_pg_recmap(const char *name,
 int
 RDB_close_pg_recmap(RDB_recmap *rmp, RDB_exec_context *ecp)
 {
+    dealloc_stmts(rmp);
+    clear_get_fields(rmp);
     RDB_free(rmp->namp);
     RDB_free(rmp->filenamp);
     RDB_free(rmp->fieldinfos);
@@ -240,6 +279,9 @@ RDB_delete_pg_recmap(RDB_recmap *rmp, RDB_rec_transaction *rtxp, RDB_exec_contex
     RDB_object command;
     PGresult *res;
 
+    /* The statements refer to the table, so they cannot be used anymore */
+    dealloc_stmts(rmp);
+
     RDB_init_obj(&command);
     if (RDB_string_to_obj(&command, "DROP TABLE \"", ecp) != RDB_OK)
         goto error;
@@ -259,6 +301,7 @@ RDB_delete_pg_recmap(RDB_recmap *rmp, RDB_rec_transaction *rtxp, RDB_exec_contex
         goto error;
     }
     PQclear(res);
+    clear_get_fields(rmp);
     RDB_free(rmp->namp);
     RDB_free(rmp->filenamp);
     RDB_free(rmp->fieldinfos);
@@ -321,34 +364,18 @@ RDB_field_to_pg(RDB_field *field, RDB_field_info *fieldinfo, int *formatp,
     return valuep;
 }
 
+/*
+ * Prepare the INSERT statement of *rmp.
+ */
 static int
-insert_pg_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp,
-        RDB_exec_context *ecp)
+prepare_insert(RDB_recmap *rmp, RDB_exec_context *ecp)
 {
-    RDB_object command;
     int i;
-    char parambuf[12];
-    PGresult *res = NULL;
-    int *lenv = NULL;
-    void **valuev = NULL;
-    int *formatv = NULL;
     int valuec = 0;
+    char parambuf[12];
+    RDB_object command;
 
     RDB_init_obj(&command);
-
-    lenv = RDB_alloc(rmp->fieldcount * sizeof(int), ecp);
-    if (lenv == NULL)
-        goto error;
-    valuev = RDB_alloc(rmp->fieldcount * sizeof(void*), ecp);
-    if (valuev == NULL)
-        goto error;
-    for (i = 0; i < rmp->fieldcount; i++) {
-        valuev[i] = NULL;
-    }
-    formatv = RDB_alloc(rmp->fieldcount * sizeof(int), ecp);
-    if (formatv == NULL)
-        goto error;
-
     if (RDB_string_to_obj(&command, "INSERT INTO \"", ecp) != RDB_OK) {
         goto error;
     }
@@ -368,7 +395,7 @@ insert_pg_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp,
                     goto error;
                 }
             } else {
-                sprintf(parambuf, "$%d", valuec + 1);
+                sprintf(parambuf, "$%d", ++valuec);
                 if (RDB_append_string(&command, parambuf, ecp) != RDB_OK) {
                     goto error;
                 }
@@ -378,13 +405,6 @@ insert_pg_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp,
                     goto error;
                 }
             }
-            if (!(RDB_FTYPE_SERIAL & rmp->fieldinfos[i].flags)) {
-                lenv[valuec] = (int) flds[i].len;
-                valuev[valuec] = RDB_field_to_pg(&flds[i], &rmp->fieldinfos[i], &formatv[valuec], ecp);
-                if (valuev[valuec] == NULL)
-                    goto error;
-                valuec++;
-            }
         }
         if (RDB_append_char(&command, ')', ecp) != RDB_OK) {
             goto error;
@@ -395,12 +415,59 @@ insert_pg_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp,
         }
     }
 
-    if (RDB_env_trace(rmp->envp) > 0) {
-        fprintf(stderr, "Sending SQL: %s\n", RDB_obj_string(&command));
+    if (RDB_pg_prepare_stmt(rmp->envp, &rmp->impl.pg.stmtv[RDB_PG_STMT_INSERT],
+            RDB_obj_string(&command), 0, NULL, ecp) != RDB_OK) {
+        goto error;
+    }
+    return RDB_destroy_obj(&command, ecp);
+
+error:
+    RDB_destroy_obj(&command, ecp);
+    return RDB_ERROR;
+}
+
+static int
+insert_pg_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp,
+        RDB_exec_context *ecp)
+{
+    int i;
+    PGresult *res = NULL;
+    int *lenv = NULL;
+    void **valuev = NULL;
+    int *formatv = NULL;
+    int valuec = 0;
+
+    if (!RDB_pg_stmt_prepared(&rmp->impl.pg.stmtv[RDB_PG_STMT_INSERT], 0,
+            NULL)) {
+        if (prepare_insert(rmp, ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
+
+    lenv = RDB_alloc(rmp->fieldcount * sizeof(int), ecp);
+    if (lenv == NULL)
+        goto error;
+    valuev = RDB_alloc(rmp->fieldcount * sizeof(void*), ecp);
+    if (valuev == NULL)
+        goto error;
+    for (i = 0; i < rmp->fieldcount; i++) {
+        valuev[i] = NULL;
+    }
+    formatv = RDB_alloc(rmp->fieldcount * sizeof(int), ecp);
+    if (formatv == NULL)
+        goto error;
+
+    for (i = 0; i < rmp->fieldcount; i++) {
+        if (!(RDB_FTYPE_SERIAL & rmp->fieldinfos[i].flags)) {
+            lenv[valuec] = (int) flds[i].len;
+            valuev[valuec] = RDB_field_to_pg(&flds[i], &rmp->fieldinfos[i], &formatv[valuec], ecp);
+            if (valuev[valuec] == NULL)
+                goto error;
+            valuec++;
+        }
     }
-    res = PQexecParams(rmp->envp->env.pgconn, RDB_obj_string(&command),
-            valuec, NULL, (const char * const *) valuev, lenv,
-            formatv, 0);
+
+    res = RDB_pg_exec_stmt(rmp->envp, &rmp->impl.pg.stmtv[RDB_PG_STMT_INSERT],
+            valuec, (const char * const *) valuev, lenv, formatv, 0);
     if (PQresultStatus(res) != PGRES_COMMAND_OK)
     {
         RDB_pgresult_to_error(rmp->envp, res, ecp);
@@ -415,7 +482,6 @@ insert_pg_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp,
     }
     RDB_free(formatv);
     RDB_free(valuev);
-    RDB_destroy_obj(&command, ecp);
     return RDB_OK;
 
 error:
@@ -430,7 +496,6 @@ error:
         }
         RDB_free(valuev);
     }
-    RDB_destroy_obj(&command, ecp);
     return RDB_ERROR;
 }
 
@@ -450,45 +515,286 @@ RDB_insert_pg_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp,
         RDB_pg_abort(chrtxp, ecp);
         return RDB_ERROR;
     }
-    return RDB_pg_commit(chrtxp, ecp);
+    return RDB_pg_commit(chrtxp, rmp->envp, RDB_DURABILITY_DEFAULT, ecp);
 }
 
-int
-RDB_update_pg_rec(RDB_recmap *rmp, RDB_field keyv[],
-               int fieldc, const RDB_field fieldv[], RDB_rec_transaction *rtxp,
-               RDB_exec_context *ecp)
+enum {
+    COPY_BUF_SIZE = 65536
+};
+
+/*
+ * Signature of the binary COPY format, including the terminating null byte.
+ * It is followed by the flags field and the header extension length.
+ */
+static const char COPY_HEADER[] = "PGCOPY\n\377\r\n";
+
+/*
+ * Buffer for COPY data
+ */
+typedef struct {
+    char *datap;
+    size_t len;
+} copy_buf;
+
+static int
+copy_flush(RDB_environment *envp, copy_buf *bufp, RDB_exec_context *ecp)
 {
-    RDB_raise_not_supported("RDB_update_pg_rec", ecp);
-    return RDB_ERROR;
+    if (bufp->len > 0) {
+        if (PQputCopyData(envp->env.pgconn, bufp->datap, (int) bufp->len) != 1) {
+            RDB_raise_connection(PQerrorMessage(envp->env.pgconn), ecp);
+            return RDB_ERROR;
+        }
+        bufp->len = 0;
+    }
+    return RDB_OK;
 }
 
-int
-RDB_delete_pg_rec(RDB_recmap *rmp, int fieldc, RDB_field fieldv[], RDB_rec_transaction *rtxp,
+static int
+copy_append(RDB_environment *envp, copy_buf *bufp, const void *datap,
+        size_t len, RDB_exec_context *ecp)
+{
+    if (bufp->len + len > COPY_BUF_SIZE) {
+        if (copy_flush(envp, bufp, ecp) != RDB_OK)
+            return RDB_ERROR;
+        if (len > COPY_BUF_SIZE) {
+            /* Send large values directly */
+            if (PQputCopyData(envp->env.pgconn, datap, (int) len) != 1) {
+                RDB_raise_connection(PQerrorMessage(envp->env.pgconn), ecp);
+                return RDB_ERROR;
+            }
+            return RDB_OK;
+        }
+    }
+    memcpy(bufp->datap + bufp->len, datap, len);
+    bufp->len += len;
+    return RDB_OK;
+}
+
+static int
+copy_append_int16(RDB_environment *envp, copy_buf *bufp, int16_t v,
+        RDB_exec_context *ecp)
+{
+    uint16_t nv = htons((uint16_t) v);
+    return copy_append(envp, bufp, &nv, sizeof(nv), ecp);
+}
+
+static int
+copy_append_int32(RDB_environment *envp, copy_buf *bufp, int32_t v,
+        RDB_exec_context *ecp)
+{
+    uint32_t nv = htonl((uint32_t) v);
+    return copy_append(envp, bufp, &nv, sizeof(nv), ecp);
+}
+
+/*
+ * Send the COPY data for the record given by flds.
+ */
+static int
+copy_rec(RDB_recmap *rmp, copy_buf *bufp, int valuec, RDB_field flds[],
         RDB_exec_context *ecp)
 {
-    RDB_object command;
     int i;
-    char parambuf[14];
-    PGresult *res = NULL;
-    int *lenv = NULL;
-    void **valuev = NULL;
-    int *formatv = NULL;
+    int format;
+    void *valuep;
+    size_t len;
+
+    if (copy_append_int16(rmp->envp, bufp, (int16_t) valuec, ecp) != RDB_OK)
+        return RDB_ERROR;
+    for (i = 0; i < rmp->fieldcount; i++) {
+        if (RDB_FTYPE_SERIAL & rmp->fieldinfos[i].flags)
+            continue;
+
+        valuep = RDB_field_to_pg(&flds[i], &rmp->fieldinfos[i], &format, ecp);
+        if (valuep == NULL)
+            return RDB_ERROR;
+
+        /*
+         * The binary representation of text is the string itself,
+         * without the terminating null byte
+         */
+        len = RDB_FTYPE_CHAR & rmp->fieldinfos[i].flags ?
+                strlen(valuep) : flds[i].len;
+        if (copy_append_int32(rmp->envp, bufp, (int32_t) len, ecp) != RDB_OK
+                || copy_append(rmp->envp, bufp, valuep, len, ecp) != RDB_OK) {
+            RDB_free(valuep);
+            return RDB_ERROR;
+        }
+        RDB_free(valuep);
+    }
+    return RDB_OK;
+}
+
+/*
+ * Create the COPY command for *rmp.
+ * Serial fields are omitted so they get their default values.
+ */
+static int
+copy_command(RDB_recmap *rmp, RDB_object *commandp, RDB_exec_context *ecp)
+{
+    int i;
+    RDB_bool first = RDB_TRUE;
+
+    if (RDB_string_to_obj(commandp, "COPY \"", ecp) != RDB_OK)
+        return RDB_ERROR;
+    if (RDB_append_string(commandp, rmp->namp, ecp) != RDB_OK)
+        return RDB_ERROR;
+    if (RDB_append_string(commandp, "\"(", ecp) != RDB_OK)
+        return RDB_ERROR;
+    for (i = 0; i < rmp->fieldcount; i++) {
+        if (RDB_FTYPE_SERIAL & rmp->fieldinfos[i].flags)
+            continue;
+        if (!first) {
+            if (RDB_append_char(commandp, ',', ecp) != RDB_OK)
+                return RDB_ERROR;
+        }
+        if (RDB_append_char(commandp, '"', ecp) != RDB_OK)
+            return RDB_ERROR;
+        if (RDB_append_string(commandp, rmp->fieldinfos[i].attrname, ecp) != RDB_OK)
+            return RDB_ERROR;
+        if (RDB_append_char(commandp, '"', ecp) != RDB_OK)
+            return RDB_ERROR;
+        first = RDB_FALSE;
+    }
+    return RDB_append_string(commandp, ") FROM STDIN WITH (FORMAT binary)",
+            ecp);
+}
+
+/*
+ * Insert the records using COPY in binary format.
+ */
+static int
+copy_pg_recs(RDB_recmap *rmp, int recc, RDB_field *recv[], int valuec,
+        RDB_exec_context *ecp)
+{
+    int i;
+    int ret;
+    PGresult *res;
+    RDB_object command;
+    copy_buf buf;
 
     RDB_init_obj(&command);
+    buf.datap = NULL;
+    if (copy_command(rmp, &command, ecp) != RDB_OK)
+        goto error;
 
-    lenv = RDB_alloc(fieldc * sizeof(int), ecp);
-    if (lenv == NULL)
+    buf.datap = RDB_alloc(COPY_BUF_SIZE, ecp);
+    if (buf.datap == NULL)
         goto error;
-    valuev = RDB_alloc(fieldc * sizeof(void*), ecp);
-    if (valuev == NULL)
+    buf.len = 0;
+
+    if (RDB_env_trace(rmp->envp) > 0) {
+        fprintf(stderr, "Sending SQL: %s\n", RDB_obj_string(&command));
+    }
+    res = PQexec(rmp->envp->env.pgconn, RDB_obj_string(&command));
+    if (PQresultStatus(res) != PGRES_COPY_IN) {
+        RDB_pgresult_to_error(rmp->envp, res, ecp);
+        PQclear(res);
         goto error;
-    for (i = 0; i < fieldc; i++) {
-        valuev[i] = NULL;
     }
-    formatv = RDB_alloc(fieldc * sizeof(int), ecp);
-    if (formatv == NULL)
+    PQclear(res);
+
+    ret = copy_append(rmp->envp, &buf, COPY_HEADER, sizeof(COPY_HEADER), ecp);
+    if (ret == RDB_OK)
+        ret = copy_append_int32(rmp->envp, &buf, 0, ecp);
+    if (ret == RDB_OK)
+        ret = copy_append_int32(rmp->envp, &buf, 0, ecp);
+    for (i = 0; i < recc && ret == RDB_OK; i++) {
+        ret = copy_rec(rmp, &buf, valuec, recv[i], ecp);
+    }
+    if (ret == RDB_OK) {
+        /* Trailer */
+        ret = copy_append_int16(rmp->envp, &buf, -1, ecp);
+    }
+    if (ret == RDB_OK)
+        ret = copy_flush(rmp->envp, &buf, ecp);
+
+    /* Passing an error message aborts the COPY */
+    if (PQputCopyEnd(rmp->envp->env.pgconn,
+            ret == RDB_OK ? NULL : "sending data failed") != 1
+            && ret == RDB_OK) {
+        RDB_raise_connection(PQerrorMessage(rmp->envp->env.pgconn), ecp);
+        ret = RDB_ERROR;
+    }
+
+    /* Get the result of the COPY command */
+    while ((res = PQgetResult(rmp->envp->env.pgconn)) != NULL) {
+        if (PQresultStatus(res) != PGRES_COMMAND_OK && ret == RDB_OK) {
+            RDB_pgresult_to_error(rmp->envp, res, ecp);
+            ret = RDB_ERROR;
+        }
+        PQclear(res);
+    }
+    if (ret != RDB_OK)
         goto error;
 
+    RDB_free(buf.datap);
+    return RDB_destroy_obj(&command, ecp);
+
+error:
+    RDB_free(buf.datap);
+    RDB_destroy_obj(&command, ecp);
+    return RDB_ERROR;
+}
+
+/*
+ * Insert the records given by recv using COPY.
+ * The records are inserted in a subtransaction, so none of them is inserted
+ * and the transaction remains valid if an error occurs.
+ */
+int
+RDB_insert_pg_recs(RDB_recmap *rmp, int recc, RDB_field *recv[],
+        RDB_rec_transaction *rtxp, RDB_exec_context *ecp)
+{
+    int i;
+    int ret;
+    int valuec = 0;
+    RDB_rec_transaction *chrtxp;
+
+    for (i = 0; i < rmp->fieldcount; i++) {
+        if (!(RDB_FTYPE_SERIAL & rmp->fieldinfos[i].flags))
+            valuec++;
+    }
+
+    chrtxp = RDB_pg_begin_tx(rmp->envp, rtxp, ecp);
+    if (chrtxp == NULL)
+        return RDB_ERROR;
+
+    if (valuec > 0) {
+        ret = copy_pg_recs(rmp, recc, recv, valuec, ecp);
+    } else {
+        /* COPY requires at least one column */
+        ret = RDB_OK;
+        for (i = 0; i < recc && ret == RDB_OK; i++) {
+            ret = insert_pg_rec(rmp, recv[i], chrtxp, ecp);
+        }
+    }
+    if (ret != RDB_OK) {
+        RDB_pg_abort(chrtxp, ecp);
+        return RDB_ERROR;
+    }
+    return RDB_pg_commit(chrtxp, rmp->envp, RDB_DURABILITY_DEFAULT, ecp);
+}
+
+int
+RDB_update_pg_rec(RDB_recmap *rmp, RDB_field keyv[],
+               int fieldc, const RDB_field fieldv[], RDB_rec_transaction *rtxp,
+               RDB_exec_context *ecp)
+{
+    RDB_raise_not_supported("RDB_update_pg_rec", ecp);
+    return RDB_ERROR;
+}
+
+/*
+ * Prepare the DELETE statement of *rmp for the first fieldc fields.
+ */
+static int
+prepare_delete(RDB_recmap *rmp, int fieldc, RDB_exec_context *ecp)
+{
+    int i;
+    char parambuf[14];
+    RDB_object command;
+
+    RDB_init_obj(&command);
     if (RDB_string_to_obj(&command, "DELETE FROM \"", ecp) != RDB_OK) {
         goto error;
     }
@@ -515,22 +821,62 @@ RDB_delete_pg_rec(RDB_recmap *rmp, int fieldc, RDB_field fieldv[], RDB_rec_trans
                     goto error;
                 }
             }
-            lenv[i] = (int) fieldv[i].len;
-            valuev[i] = RDB_field_to_pg(&fieldv[i], &rmp->fieldinfos[i], &formatv[i], ecp);
-            if (valuev[i] == NULL)
-                goto error;
         }
     }
 
-    if (RDB_env_trace(rmp->envp) > 0) {
-        fprintf(stderr, "Sending SQL: %s\n", RDB_obj_string(&command));
+    if (RDB_pg_prepare_stmt(rmp->envp, &rmp->impl.pg.stmtv[RDB_PG_STMT_DELETE],
+            RDB_obj_string(&command), fieldc, NULL, ecp) != RDB_OK) {
+        goto error;
+    }
+    return RDB_destroy_obj(&command, ecp);
+
+error:
+    RDB_destroy_obj(&command, ecp);
+    return RDB_ERROR;
+}
+
+int
+RDB_delete_pg_rec(RDB_recmap *rmp, int fieldc, RDB_field fieldv[], RDB_rec_transaction *rtxp,
+        RDB_exec_context *ecp)
+{
+    int i;
+    PGresult *res = NULL;
+    int *lenv = NULL;
+    void **valuev = NULL;
+    int *formatv = NULL;
+
+    if (!RDB_pg_stmt_prepared(&rmp->impl.pg.stmtv[RDB_PG_STMT_DELETE], fieldc,
+            NULL)) {
+        if (prepare_delete(rmp, fieldc, ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
+
+    lenv = RDB_alloc(fieldc * sizeof(int), ecp);
+    if (lenv == NULL)
+        goto error;
+    valuev = RDB_alloc(fieldc * sizeof(void*), ecp);
+    if (valuev == NULL)
+        goto error;
+    for (i = 0; i < fieldc; i++) {
+        valuev[i] = NULL;
+    }
+    formatv = RDB_alloc(fieldc * sizeof(int), ecp);
+    if (formatv == NULL)
+        goto error;
+
+    for (i = 0; i < fieldc; i++) {
+        lenv[i] = (int) fieldv[i].len;
+        valuev[i] = RDB_field_to_pg(&fieldv[i], &rmp->fieldinfos[i], &formatv[i], ecp);
+        if (valuev[i] == NULL)
+            goto error;
     }
-    res = PQexecParams(rmp->envp->env.pgconn, RDB_obj_string(&command),
-            fieldc, NULL, (const char * const *) valuev, lenv,
-            formatv, 0);
+
+    res = RDB_pg_exec_stmt(rmp->envp, &rmp->impl.pg.stmtv[RDB_PG_STMT_DELETE],
+            fieldc, (const char * const *) valuev, lenv, formatv, 0);
     if (PQresultStatus(res) != PGRES_COMMAND_OK)
     {
         RDB_pgresult_to_error(rmp->envp, res, ecp);
+        PQclear(res);
         goto error;
     }
     if (atoi(PQcmdTuples(res)) == 0) {
@@ -546,7 +892,6 @@ RDB_delete_pg_rec(RDB_recmap *rmp, int fieldc, RDB_field fieldv[], RDB_rec_trans
     }
     RDB_free(formatv);
     RDB_free(valuev);
-    RDB_destroy_obj(&command, ecp);
     return RDB_OK;
 
 error:
@@ -561,7 +906,6 @@ error:
         }
         RDB_free(valuev);
     }
-    RDB_destroy_obj(&command, ecp);
     return RDB_ERROR;
 }
 
@@ -570,34 +914,19 @@ union num {
     RDB_float r;
 };
 
-int
-RDB_get_pg_fields(RDB_recmap *rmp, RDB_field keyv[], int fieldc,
-        RDB_rec_transaction *rtxp, RDB_field retfieldv[], RDB_exec_context *ecp)
+/*
+ * Prepare the SELECT statement of *rmp which reads the fields given by
+ * fieldc and retfieldv.
+ */
+static int
+prepare_get_fields(RDB_recmap *rmp, int fieldc, const RDB_field retfieldv[],
+        RDB_exec_context *ecp)
 {
-    static PGresult *res = NULL;
-    static union num *numres = NULL;
     int i;
-    RDB_object command;
     char numbuf[16];
-    int *lenv = NULL;
-    void **valuev = NULL;
-    int *formatv = NULL;
+    RDB_object command;
 
     RDB_init_obj(&command);
-
-    lenv = RDB_alloc(rmp->keyfieldcount * sizeof(int), ecp);
-    if (lenv == NULL)
-        goto error;
-    valuev = RDB_alloc(rmp->keyfieldcount * sizeof(void*), ecp);
-    if (valuev == NULL)
-        goto error;
-    for (i = 0; i < rmp->keyfieldcount; i++) {
-        valuev[i] = NULL;
-    }
-    formatv = RDB_alloc(rmp->keyfieldcount * sizeof(int), ecp);
-    if (formatv == NULL)
-        goto error;
-
     if (RDB_string_to_obj(&command, "SELECT ", ecp) != RDB_OK)
         goto error;
     for (i = 0; i < fieldc; i++) {
@@ -637,37 +966,77 @@ RDB_get_pg_fields(RDB_recmap *rmp, RDB_field keyv[], int fieldc,
             if (RDB_append_string(&command, " AND ", ecp) != RDB_OK)
                 goto error;
         }
+    }
+
+    if (RDB_pg_prepare_stmt(rmp->envp,
+            &rmp->impl.pg.stmtv[RDB_PG_STMT_GET_FIELDS],
+            RDB_obj_string(&command), fieldc, retfieldv, ecp) != RDB_OK) {
+        goto error;
+    }
+    return RDB_destroy_obj(&command, ecp);
+
+error:
+    RDB_destroy_obj(&command, ecp);
+    return RDB_ERROR;
+}
+
+int
+RDB_get_pg_fields(RDB_recmap *rmp, RDB_field keyv[], int fieldc,
+        RDB_rec_transaction *rtxp, RDB_field retfieldv[], RDB_exec_context *ecp)
+{
+    PGresult *res;
+    union num *numres;
+    int i;
+    int *lenv = NULL;
+    void **valuev = NULL;
+    int *formatv = NULL;
+
+    if (!RDB_pg_stmt_prepared(&rmp->impl.pg.stmtv[RDB_PG_STMT_GET_FIELDS],
+            fieldc, retfieldv)) {
+        if (prepare_get_fields(rmp, fieldc, retfieldv, ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
+
+    lenv = RDB_alloc(rmp->keyfieldcount * sizeof(int), ecp);
+    if (lenv == NULL)
+        goto error;
+    valuev = RDB_alloc(rmp->keyfieldcount * sizeof(void*), ecp);
+    if (valuev == NULL)
+        goto error;
+    for (i = 0; i < rmp->keyfieldcount; i++) {
+        valuev[i] = NULL;
+    }
+    formatv = RDB_alloc(rmp->keyfieldcount * sizeof(int), ecp);
+    if (formatv == NULL)
+        goto error;
+
+    for (i = 0; i < rmp->keyfieldcount; i++) {
         lenv[i] = (int) keyv[i].len;
         valuev[i] = RDB_field_to_pg(&keyv[i], &rmp->fieldinfos[i], &formatv[i], ecp);
         if (valuev[i] == NULL)
             goto error;
     }
-    if (res != NULL)
-        PQclear(res);
-    if (RDB_env_trace(rmp->envp) > 0) {
-        fprintf(stderr, "Sending SQL: %s\n", RDB_obj_string(&command));
-    }
-    res = PQexecParams(rmp->envp->env.pgconn, RDB_obj_string(&command),
-            rmp->keyfieldcount, NULL, (const char * const *) valuev, lenv,
+    clear_get_fields(rmp);
+    res = RDB_pg_exec_stmt(rmp->envp,
+            &rmp->impl.pg.stmtv[RDB_PG_STMT_GET_FIELDS],
+            rmp->keyfieldcount, (const char * const *) valuev, lenv,
             formatv, 1);
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
         RDB_pgresult_to_error(rmp->envp, res, ecp);
         PQclear(res);
-        res = NULL;
         goto error;
     }
+    rmp->impl.pg.getres = res;
     if (PQntuples(res) == 0) {
         RDB_raise_not_found("no data", ecp);
         goto error;
     }
 
     /* Read integer fields and adjust byte order */
-    if (numres != NULL) {
-        RDB_free(numres);
-    }
     numres = RDB_alloc(sizeof(union num) * fieldc, ecp);
     if (numres == NULL)
         goto error;
+    rmp->impl.pg.getnumv = numres;
     for (i = 0; i < fieldc; i++) {
         retfieldv[i].datap = PQgetvalue(res, 0, i);
         retfieldv[i].len = (size_t) PQgetlength(res, 0, i);
@@ -686,7 +1055,6 @@ RDB_get_pg_fields(RDB_recmap *rmp, RDB_field keyv[], int fieldc,
     RDB_free(valuev);
     RDB_free(lenv);
     RDB_free(formatv);
-    RDB_destroy_obj(&command, ecp);
     return RDB_OK;
 
 error:
@@ -699,38 +1067,20 @@ error:
     }
     RDB_free(lenv);
     RDB_free(formatv);
-    RDB_destroy_obj(&command, ecp);
     return RDB_ERROR;
 }
 
-int
-RDB_contains_pg_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp,
-        RDB_exec_context *ecp)
+/*
+ * Prepare the statement of *rmp which checks if a record exists.
+ */
+static int
+prepare_contains(RDB_recmap *rmp, RDB_exec_context *ecp)
 {
-    RDB_object command;
-    char parambuf[16];
-    PGresult *res = NULL;
-    int *lenv = NULL;
-    void **valuev = NULL;
-    int *formatv = NULL;
     int i;
-    char *resvalp;
+    char parambuf[16];
+    RDB_object command;
 
     RDB_init_obj(&command);
-
-    lenv = RDB_alloc(rmp->fieldcount * sizeof(int), ecp);
-    if (lenv == NULL)
-        goto error;
-    valuev = RDB_alloc(rmp->fieldcount * sizeof(void*), ecp);
-    if (valuev == NULL)
-        goto error;
-    for (i = 0; i < rmp->fieldcount; i++) {
-        valuev[i] = NULL;
-    }
-    formatv = RDB_alloc(rmp->fieldcount * sizeof(int), ecp);
-    if (formatv == NULL)
-        goto error;
-
     if (RDB_string_to_obj(&command, "SELECT EXISTS(SELECT 1 FROM \"", ecp) != RDB_OK)
         goto error;
     if (RDB_append_string(&command, rmp->namp, ecp) != RDB_OK)
@@ -755,10 +1105,6 @@ RDB_contains_pg_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp
                 goto error;
             }
         }
-        lenv[i] = (int) flds[i].len;
-        valuev[i] = RDB_field_to_pg(&flds[i], &rmp->fieldinfos[i], &formatv[i], ecp);
-        if (valuev[i] == NULL)
-            goto error;
     }
     if (rmp->fieldcount == 0) {
         if (RDB_append_string(&command, "\"$dummy\"=0", ecp) != RDB_OK) {
@@ -767,11 +1113,57 @@ RDB_contains_pg_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp
     }
     if (RDB_append_char(&command, ')', ecp) != RDB_OK)
         goto error;
-    if (RDB_env_trace(rmp->envp) > 0) {
-        fprintf(stderr, "Sending SQL: %s\n", RDB_obj_string(&command));
+
+    if (RDB_pg_prepare_stmt(rmp->envp,
+            &rmp->impl.pg.stmtv[RDB_PG_STMT_CONTAINS],
+            RDB_obj_string(&command), 0, NULL, ecp) != RDB_OK) {
+        goto error;
     }
-    res = PQexecParams(rmp->envp->env.pgconn, RDB_obj_string(&command),
-            rmp->fieldcount, NULL, (const char * const *) valuev, lenv,
+    return RDB_destroy_obj(&command, ecp);
+
+error:
+    RDB_destroy_obj(&command, ecp);
+    return RDB_ERROR;
+}
+
+int
+RDB_contains_pg_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp,
+        RDB_exec_context *ecp)
+{
+    PGresult *res = NULL;
+    int *lenv = NULL;
+    void **valuev = NULL;
+    int *formatv = NULL;
+    int i;
+    char *resvalp;
+
+    if (!RDB_pg_stmt_prepared(&rmp->impl.pg.stmtv[RDB_PG_STMT_CONTAINS], 0,
+            NULL)) {
+        if (prepare_contains(rmp, ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
+
+    lenv = RDB_alloc(rmp->fieldcount * sizeof(int), ecp);
+    if (lenv == NULL)
+        goto error;
+    valuev = RDB_alloc(rmp->fieldcount * sizeof(void*), ecp);
+    if (valuev == NULL)
+        goto error;
+    for (i = 0; i < rmp->fieldcount; i++) {
+        valuev[i] = NULL;
+    }
+    formatv = RDB_alloc(rmp->fieldcount * sizeof(int), ecp);
+    if (formatv == NULL)
+        goto error;
+
+    for (i = 0; i < rmp->fieldcount; i++) {
+        lenv[i] = (int) flds[i].len;
+        valuev[i] = RDB_field_to_pg(&flds[i], &rmp->fieldinfos[i], &formatv[i], ecp);
+        if (valuev[i] == NULL)
+            goto error;
+    }
+    res = RDB_pg_exec_stmt(rmp->envp, &rmp->impl.pg.stmtv[RDB_PG_STMT_CONTAINS],
+            rmp->fieldcount, (const char * const *) valuev, lenv,
             formatv, 1);
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
         RDB_pgresult_to_error(rmp->envp, res, ecp);
@@ -798,7 +1190,6 @@ RDB_contains_pg_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp
     }
     RDB_free(formatv);
     RDB_free(valuev);
-    RDB_destroy_obj(&command, ecp);
     return RDB_OK;
 
 error:
@@ -813,7 +1204,6 @@ error:
         }
         RDB_free(valuev);
     }
-    RDB_destroy_obj(&command, ecp);
     return RDB_ERROR;
 }
 
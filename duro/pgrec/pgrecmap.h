@@ -34,6 +34,10 @@ RDB_delete_pg_recmap(RDB_recmap *, RDB_rec_transaction *, RDB_exec_context *);
 int
 RDB_insert_pg_rec(RDB_recmap *, RDB_field[], RDB_rec_transaction *, RDB_exec_context *);
 
+int
+RDB_insert_pg_recs(RDB_recmap *, int, RDB_field *[], RDB_rec_transaction *,
+        RDB_exec_context *);
+
 int
 RDB_update_pg_rec(RDB_recmap *, RDB_field[],
                int, const RDB_field[], RDB_rec_transaction *, RDB_exec_context *);
@@ -0,0 +1,125 @@
+/*
+ * Prepared statements
+ *
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include "pgstmt.h"
+#include "pgenv.h"
+#include <rec/envimpl.h>
+#include <obj/excontext.h>
+#include <obj/object.h>
+
+#include <stdio.h>
+#include <string.h>
+
+void
+RDB_pg_init_stmt(RDB_pg_stmt *stmtp)
+{
+    stmtp->name[0] = '\0';
+    stmtp->fieldc = 0;
+    stmtp->fieldnov = NULL;
+}
+
+/*
+ * Check if *stmtp has been prepared for the fields given by fieldc and fieldv.
+ * If fieldv is NULL, only the number of fields is compared.
+ */
+RDB_bool
+RDB_pg_stmt_prepared(const RDB_pg_stmt *stmtp, int fieldc,
+        const RDB_field fieldv[])
+{
+    int i;
+
+    if (stmtp->name[0] == '\0' || stmtp->fieldc != fieldc)
+        return RDB_FALSE;
+    if (fieldv != NULL) {
+        for (i = 0; i < fieldc; i++) {
+            if (stmtp->fieldnov[i] != fieldv[i].no)
+                return RDB_FALSE;
+        }
+    }
+    return RDB_TRUE;
+}
+
+/*
+ * Prepare the SQL command, replacing the statement *stmtp
+ * if it has already been prepared.
+ * fieldc and fieldv are stored so RDB_pg_stmt_prepared() can check
+ * if the statement can be used for a given set of fields.
+ */
+int
+RDB_pg_prepare_stmt(RDB_environment *envp, RDB_pg_stmt *stmtp,
+        const char *command, int fieldc, const RDB_field fieldv[],
+        RDB_exec_context *ecp)
+{
+    int i;
+    PGresult *res;
+
+    RDB_pg_dealloc_stmt(envp, stmtp);
+
+    if (fieldv != NULL && fieldc > 0) {
+        stmtp->fieldnov = RDB_alloc(sizeof(int) * fieldc, ecp);
+        if (stmtp->fieldnov == NULL)
+            return RDB_ERROR;
+        for (i = 0; i < fieldc; i++) {
+            stmtp->fieldnov[i] = fieldv[i].no;
+        }
+    }
+
+    snprintf(stmtp->name, sizeof(stmtp->name), "duro_s%u",
+            envp->pg_next_stmt_id++);
+    if (RDB_env_trace(envp) > 0) {
+        fprintf(stderr, "Preparing SQL as %s: %s\n", stmtp->name, command);
+    }
+    res = PQprepare(envp->env.pgconn, stmtp->name, command, 0, NULL);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        RDB_pgresult_to_error(envp, res, ecp);
+        PQclear(res);
+        RDB_free(stmtp->fieldnov);
+        RDB_pg_init_stmt(stmtp);
+        return RDB_ERROR;
+    }
+    PQclear(res);
+    stmtp->fieldc = fieldc;
+    return RDB_OK;
+}
+
+/*
+ * Execute the prepared statement *stmtp.
+ */
+PGresult *
+RDB_pg_exec_stmt(RDB_environment *envp, const RDB_pg_stmt *stmtp,
+        int nparams, const char * const *valuev, const int *lenv,
+        const int *formatv, int resultformat)
+{
+    if (RDB_env_trace(envp) > 0) {
+        fprintf(stderr, "Executing %s\n", stmtp->name);
+    }
+    return PQexecPrepared(envp->env.pgconn, stmtp->name, nparams,
+            valuev, lenv, formatv, resultformat);
+}
+
+/*
+ * Deallocate the prepared statement, if it has been prepared.
+ * Errors are ignored, because this is called when recmaps and cursors
+ * are closed, which may happen in an aborted transaction.
+ * A statement which could not be deallocated remains until the connection
+ * is closed.
+ */
+void
+RDB_pg_dealloc_stmt(RDB_environment *envp, RDB_pg_stmt *stmtp)
+{
+    char command[48];
+
+    if (stmtp->name[0] != '\0') {
+        snprintf(command, sizeof(command), "DEALLOCATE %s", stmtp->name);
+        if (RDB_env_trace(envp) > 0) {
+            fprintf(stderr, "Sending SQL: %s\n", command);
+        }
+        PQclear(PQexec(envp->env.pgconn, command));
+    }
+    RDB_free(stmtp->fieldnov);
+    RDB_pg_init_stmt(stmtp);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#ifndef PGREC_PGSTMT_H_
+#define PGREC_PGSTMT_H_
+
+#include <gen/types.h>
+#include <rec/recmap.h>
+#include <libpq-fe.h>
+
+typedef struct RDB_exec_context RDB_exec_context;
+
+/*
+ * Prepared statement. Recmaps and cursors keep the statements
+ * they execute repeatedly, so PostgreSQL does not have to parse
+ * and plan them again on every call.
+ */
+typedef struct RDB_pg_stmt {
+    /* Statement name, empty if the statement has not been prepared */
+    char name[24];
+
+    /*
+     * Number of fields the statement has been prepared for
+     * and their numbers, if the statement depends on them
+     */
+    int fieldc;
+    int *fieldnov;
+} RDB_pg_stmt;
+
+/* Statements of a recmap */
+enum {
+    RDB_PG_STMT_INSERT,
+    RDB_PG_STMT_DELETE,
+    RDB_PG_STMT_GET_FIELDS,
+    RDB_PG_STMT_CONTAINS,
+
+    RDB_PG_STMT_COUNT
+};
+
+void
+RDB_pg_init_stmt(RDB_pg_stmt *);
+
+RDB_bool
+RDB_pg_stmt_prepared(const RDB_pg_stmt *, int fieldc, const RDB_field[]);
+
+int
+RDB_pg_prepare_stmt(RDB_environment *, RDB_pg_stmt *, const char *,
+        int fieldc, const RDB_field[], RDB_exec_context *);
+
+PGresult *
+RDB_pg_exec_stmt(RDB_environment *, const RDB_pg_stmt *, int nparams,
+        const char * const *, const int *, const int *, int);
+
+void
+RDB_pg_dealloc_stmt(RDB_environment *, RDB_pg_stmt *);
+
+#endif /* PGREC_PGSTMT_H_ */
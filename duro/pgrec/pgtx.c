@@ -12,8 +12,6 @@
 
 #include <libpq-fe.h>
 
-static unsigned next_savepoint_id = 0;
-
 static const char SQL_BEGIN_TX[] = "BEGIN";
 static const char SQL_COMMIT[] = "COMMIT";
 static const char SQL_ROLLBACK[] = "ROLLBACK";
@@ -34,7 +32,7 @@ nested_begin_tx(RDB_environment *envp,
     if (tx == NULL)
         return NULL;
     tx->envp = envp;
-    tx->savepoint_id = next_savepoint_id++;
+    tx->savepoint_id = envp->pg_next_savepoint_id++;
 
     RDB_init_obj(&command);
     if (RDB_string_to_obj(&command, "SAVEPOINT s", ecp) != RDB_OK)
@@ -130,8 +128,49 @@ error:
     return RDB_ERROR;
 }
 
+/*
+ * Set synchronous_commit for the current transaction
+ */
+static int
+set_synchronous_commit(RDB_pg_tx *tx, RDB_durability durability,
+        RDB_exec_context *ecp)
+{
+    PGresult *res;
+    const char *command;
+
+    switch (durability) {
+        case RDB_DURABILITY_SYNC:
+            command = "SET LOCAL synchronous_commit TO on";
+            break;
+        case RDB_DURABILITY_WRITE_NOSYNC:
+        case RDB_DURABILITY_NOSYNC:
+            command = "SET LOCAL synchronous_commit TO off";
+            break;
+        default:
+            return RDB_OK;
+    }
+
+    if (RDB_env_trace(tx->envp) > 0) {
+        fprintf(stderr, "Sending SQL: %s\n", command);
+    }
+    res = PQexec(tx->envp->env.pgconn, command);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        RDB_pgresult_to_error(tx->envp, res, ecp);
+        PQclear(res);
+        return RDB_ERROR;
+    }
+    PQclear(res);
+    return RDB_OK;
+}
+
+/*
+ * Commit the transaction.
+ * For top-level transactions, synchronous_commit is set according to
+ * durability. PostgreSQL does not distinguish between write_nosync and nosync.
+ */
 int
-RDB_pg_commit(RDB_rec_transaction *rtxp, RDB_exec_context *ecp)
+RDB_pg_commit(RDB_rec_transaction *rtxp, RDB_environment *envp,
+        RDB_durability durability, RDB_exec_context *ecp)
 {
     RDB_pg_tx *tx = (RDB_pg_tx *)rtxp;
     PGresult *res;
@@ -140,6 +179,13 @@ RDB_pg_commit(RDB_rec_transaction *rtxp, RDB_exec_context *ecp)
         return nested_commit(tx, ecp);
     }
 
+    if (set_synchronous_commit(tx, durability, ecp) != RDB_OK) {
+        /* End the transaction on the server */
+        PQclear(PQexec(tx->envp->env.pgconn, SQL_ROLLBACK));
+        RDB_free(tx);
+        return RDB_ERROR;
+    }
+
     if (RDB_env_trace(tx->envp) > 0) {
         fprintf(stderr, "Sending SQL: %s\n", SQL_COMMIT);
     }
@@ -12,10 +12,13 @@ typedef struct RDB_rec_transaction RDB_rec_transaction;
 typedef struct RDB_environment RDB_environment;
 typedef struct RDB_exec_context RDB_exec_context;
 
+#include <rec/env.h>
+
 RDB_rec_transaction * RDB_pg_begin_tx(RDB_environment *,
         RDB_rec_transaction *, RDB_exec_context *);
 
-int RDB_pg_commit(RDB_rec_transaction *, RDB_exec_context *);
+int RDB_pg_commit(RDB_rec_transaction *, RDB_environment *, RDB_durability,
+        RDB_exec_context *);
 
 int RDB_pg_abort(RDB_rec_transaction *, RDB_exec_context *);
 
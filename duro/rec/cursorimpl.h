@@ -16,6 +16,12 @@
 
 #ifdef POSTGRESQL
 #include <libpq-fe.h>
+#include <pgrec/pgstmt.h>
+#endif
+
+#ifdef FOUNDATIONDB
+#define FDB_API_VERSION 600
+#include <foundationdb/fdb_c.h>
 #endif
 
 typedef struct RDB_exec_context RDB_exec_context;
@@ -28,12 +34,53 @@ typedef struct RDB_cursor {
             DBC *cursorp;
             DBT current_key;
             DBT current_data;
+
+            /*
+             * RDB_TRUE if next() reads records in bulk.
+             * Only used for read-only cursors over recmaps.
+             */
+            RDB_bool bulk_read;
+
+            /* Buffer for bulk reads, data is NULL if not allocated */
+            DBT bulk;
+
+            /*
+             * Position of the next record in the bulk buffer,
+             * NULL if there are no buffered records.
+             * If it is not NULL, the Berkeley DB cursor may be positioned
+             * after the current record.
+             */
+            void *bulkp;
         } bdb;
 #endif
 #ifdef POSTGRESQL
         struct {
             unsigned id;
-            PGresult *current_row;
+
+            /* Rows fetched from the server, NULL if nothing has been fetched */
+            PGresult *res;
+
+            /* Index of the current row in res */
+            int row;
+
+            /* Position of the current row in the result, starting with 1 */
+            long pos;
+
+            /* Maximum number of rows fetched by a single FETCH */
+            int fetch_rows;
+
+            /* RDB_TRUE if the server cursor has been moved past the last row */
+            RDB_bool eof;
+
+            /* Numeric field value converted to host byte order */
+            union {
+                RDB_int i;
+                RDB_float f;
+            } fieldval;
+
+            /* Statements for updating and deleting the current row */
+            RDB_pg_stmt setstmt;
+            RDB_pg_stmt delstmt;
         } pg;
 #endif
 #ifdef FOUNDATIONDB
@@ -42,11 +89,56 @@ typedef struct RDB_cursor {
 			int key_length;
 			uint8_t *value;
 			int value_length;
+
+            /* First key of the recmap or index and first key after it */
+            uint8_t *startkey;
+            uint8_t *endkey;
+            int prefix_length;
+
+            /*
+             * Future holding the key/value pairs read by the last range read,
+             * NULL if there are none
+             */
+            FDBFuture *batchf;
+            const FDBKeyValue *kvv;
+            int kvc;
+
+            /* Index of the current pair in kvv */
+            int kvi;
+
+            /*
+             * Range read of the pairs following the batch, started
+             * while the batch is consumed. NULL if there are no more pairs.
+             */
+            FDBFuture *nextf;
+
+            /* Iteration number for FDB_STREAMING_MODE_ITERATOR */
+            int iteration;
 		} fdb;
 #endif
 		struct {
             RDB_binary_tree *treep;
-            RDB_tree_node *nodep;
+            RDB_tree_pos pos;
+
+            /*
+             * RDB_TRUE if the record at the cursor position has been deleted,
+             * so pos is already the position of the next record
+             */
+            RDB_bool deleted;
+
+            /* Modification count of the tree when pos was obtained */
+            unsigned long modcount;
+
+            /*
+             * Copy of the key of the record at the cursor position,
+             * used to find the position again after the tree has been
+             * modified. haskey is RDB_FALSE if the cursor is not
+             * positioned on a record.
+             */
+            RDB_bool haskey;
+            void *key;
+            size_t keylen;
+            size_t keycap;
         } tree;
     } cur;
     RDB_recmap *recmapp;
@@ -19,6 +19,8 @@
 #endif
 
 #include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
 #include <errno.h>
 
 /** @defgroup env Database environment functions 
@@ -49,6 +51,30 @@
  */
 RDB_environment *
 RDB_open_env(const char *path, int flags, RDB_exec_context *ecp)
+{
+    return RDB_open_env_config(path, flags, NULL, ecp);
+}
+
+/**
+ * Opens a database environment like RDB_open_env(), using the settings
+ * given by \a configp.
+ *
+ * With Berkeley DB, the settings are applied when the environment
+ * is created, that is, when \a flags is RDB_RECOVER or the environment
+ * does not exist yet.
+ * Settings in the DB_CONFIG file in the environment directory take
+ * precedence.
+ *
+ * @param path  pathname of the direcory where the data is stored.
+ * @param flags can be zero or RDB_RECOVER.
+ * @param configp   the settings. If it is NULL, default settings are used.
+ *
+ * @return On success, a pointer to the environment is returned.
+ * On failure, NULL is returned and an error value is stored in *ecp.
+ */
+RDB_environment *
+RDB_open_env_config(const char *path, int flags,
+        const RDB_env_config *configp, RDB_exec_context *ecp)
 {
     RDB_environment *envp;
 #ifdef BERKELEYDB
@@ -57,24 +83,36 @@ RDB_open_env(const char *path, int flags, RDB_exec_context *ecp)
 
 #ifdef POSTGRESQL
     if (strstr(path, "postgresql://") == path) {
-        return RDB_pg_open_env(path, ecp);
+        envp = RDB_pg_open_env(path, ecp);
+        goto opened;
     }
 #endif
 #ifdef FOUNDATIONDB
 	if (strstr(path, "foundationdb://") == path) {
-		return RDB_fdb_open_env(path + 15, ecp);
+		envp = RDB_fdb_open_env(path + 15, ecp);
+		goto opened;
 	}
 #endif
 #ifdef BERKELEYDB
-    ret = RDB_bdb_open_env(path, &envp, flags);
+    ret = RDB_bdb_open_env(path, &envp, flags, configp);
     if (ret != RDB_OK) {
         RDB_errcode_to_error(ret, ecp);
         return NULL;
     }
 #else
     RDB_raise_not_supported("environment type not supported", ecp);
-    envp = NULL;
+    return NULL;
 #endif
+
+#if defined(POSTGRESQL) || defined(FOUNDATIONDB)
+opened:
+#endif
+    /* Settings which are not specific to the storage engine */
+    if (envp != NULL) {
+        envp->hash_mem = configp != NULL ? configp->hash_mem : 0;
+        envp->sort_mem = configp != NULL ? configp->sort_mem : 0;
+        envp->fetch_rows = configp != NULL ? configp->fetch_rows : 0;
+    }
     return envp;
 }
 
@@ -93,7 +131,7 @@ RDB_create_env(const char *path, RDB_exec_context *ecp)
 {
 #ifdef BERKELEYDB
     RDB_environment *envp;
-    int ret = RDB_bdb_create_env(path, &envp);
+    int ret = RDB_bdb_create_env(path, &envp, NULL);
     if (ret != RDB_OK) {
         RDB_bdb_errcode_to_error(ret, ecp);
         return NULL;
@@ -105,6 +143,159 @@ RDB_create_env(const char *path, RDB_exec_context *ecp)
 #endif
 }
 
+/**
+ * Initializes *configp so that default settings are used.
+ */
+void
+RDB_init_env_config(RDB_env_config *configp)
+{
+    memset(configp, 0, sizeof(RDB_env_config));
+}
+
+/*
+ * Convert a number which may be followed by K, M, or G.
+ */
+static int
+parse_size(const char *str, size_t *sizep)
+{
+    char *endp;
+    unsigned long val = strtoul(str, &endp, 10);
+
+    if (endp == str)
+        return RDB_ERROR;
+    switch (*endp) {
+        case 'K':
+        case 'k':
+            val *= 1024;
+            endp++;
+            break;
+        case 'M':
+        case 'm':
+            val *= 1024 * 1024;
+            endp++;
+            break;
+        case 'G':
+        case 'g':
+            val *= 1024 * 1024 * 1024;
+            endp++;
+            break;
+    }
+    if (*endp != '\0')
+        return RDB_ERROR;
+    *sizep = (size_t) val;
+    return RDB_OK;
+}
+
+static int
+set_config_value(RDB_env_config *configp, const char *name,
+        const char *value)
+{
+    size_t size;
+
+    if (strcmp(name, "durability") == 0) {
+        if (strcmp(value, "sync") == 0) {
+            configp->durability = RDB_DURABILITY_SYNC;
+        } else if (strcmp(value, "write_nosync") == 0) {
+            configp->durability = RDB_DURABILITY_WRITE_NOSYNC;
+        } else if (strcmp(value, "nosync") == 0) {
+            configp->durability = RDB_DURABILITY_NOSYNC;
+        } else {
+            return RDB_ERROR;
+        }
+        return RDB_OK;
+    }
+
+    if (parse_size(value, &size) != RDB_OK)
+        return RDB_ERROR;
+    if (strcmp(name, "cache_size") == 0) {
+        configp->cache_size = size;
+    } else if (strcmp(name, "log_buf_size") == 0) {
+        configp->log_buf_size = (unsigned) size;
+    } else if (strcmp(name, "max_locks") == 0) {
+        configp->max_locks = (unsigned) size;
+    } else if (strcmp(name, "max_lockers") == 0) {
+        configp->max_lockers = (unsigned) size;
+    } else if (strcmp(name, "max_lock_objects") == 0) {
+        configp->max_lock_objects = (unsigned) size;
+    } else if (strcmp(name, "max_txns") == 0) {
+        configp->max_txns = (unsigned) size;
+    } else if (strcmp(name, "page_size") == 0) {
+        configp->page_size = (unsigned) size;
+    } else if (strcmp(name, "hash_ffactor") == 0) {
+        configp->hash_ffactor = (unsigned) size;
+    } else if (strcmp(name, "group_commit_delay") == 0) {
+        configp->group_commit_delay = (unsigned) size;
+    } else if (strcmp(name, "hash_mem") == 0) {
+        configp->hash_mem = size;
+    } else if (strcmp(name, "sort_mem") == 0) {
+        configp->sort_mem = size;
+    } else if (strcmp(name, "fetch_rows") == 0) {
+        configp->fetch_rows = (unsigned) size;
+    } else {
+        return RDB_ERROR;
+    }
+    return RDB_OK;
+}
+
+/**
+ * Reads environment settings from a string of the form
+ * <code>name=value ...</code> and stores them in *configp.
+ * The settings are separated by whitespace or commas.
+ * Settings not contained in \a str are not modified.
+ *
+ * The following settings are supported:
+ * cache_size, log_buf_size, max_locks, max_lockers, max_lock_objects,
+ * max_txns, page_size, hash_ffactor, durability, group_commit_delay,
+ * hash_mem, sort_mem, and fetch_rows.
+ * Sizes can be followed by K, M, or G.
+ * The value of durability can be sync, write_nosync, or nosync.
+ *
+ * @returns RDB_OK on success, RDB_ERROR if an error occurred.
+ *
+ * @par Errors:
+ * <dl>
+ * <dt>invalid_argument_error
+ * <dd>\a str contains an invalid setting.
+ * </dl>
+ */
+int
+RDB_parse_env_config(const char *str, RDB_env_config *configp,
+        RDB_exec_context *ecp)
+{
+    char name[32];
+    char value[32];
+    const char *cp = str;
+
+    for(;;) {
+        size_t len;
+        const char *eqp;
+
+        while (isspace((unsigned char) *cp) || *cp == ',')
+            cp++;
+        if (*cp == '\0')
+            break;
+
+        len = strcspn(cp, " \t\r\n,");
+        eqp = memchr(cp, '=', len);
+        if (eqp == NULL || eqp - cp >= (ptrdiff_t) sizeof(name)
+                || len - (eqp - cp) > sizeof(value)) {
+            RDB_raise_invalid_argument("invalid environment setting", ecp);
+            return RDB_ERROR;
+        }
+        memcpy(name, cp, eqp - cp);
+        name[eqp - cp] = '\0';
+        memcpy(value, eqp + 1, len - (eqp - cp) - 1);
+        value[len - (eqp - cp) - 1] = '\0';
+
+        if (set_config_value(configp, name, value) != RDB_OK) {
+            RDB_raise_invalid_argument("invalid environment setting", ecp);
+            return RDB_ERROR;
+        }
+        cp += len;
+    }
+    return RDB_OK;
+}
+
 /**
  * RDB_close_env closes the database environment specified by
  * \a envp.
@@ -214,3 +405,23 @@ RDB_bool
 RDB_env_queries(const RDB_environment *envp) {
     return envp->queries;
 }
+
+/**
+ * Return the number of bytes SUMMARIZE and GROUP may use for an
+ * in-memory hash table, or 0 if the default is used.
+ */
+size_t
+RDB_env_hash_mem(const RDB_environment *envp)
+{
+    return envp->hash_mem;
+}
+
+/**
+ * Return the number of bytes a sorter may use before it writes
+ * sorted runs to temporary files, or 0 if the default is used.
+ */
+size_t
+RDB_env_sort_mem(const RDB_environment *envp)
+{
+    return envp->sort_mem;
+}
@@ -13,6 +13,78 @@ enum {
     RDB_RECOVER = 1
 };
 
+/* Durability of committed transactions */
+typedef enum {
+    /* Use the setting of the environment, which is sync by default */
+    RDB_DURABILITY_DEFAULT = 0,
+
+    /* Write and flush the log on commit */
+    RDB_DURABILITY_SYNC,
+
+    /* Write the log on commit, but do not flush it */
+    RDB_DURABILITY_WRITE_NOSYNC,
+
+    /* Neither write nor flush the log on commit */
+    RDB_DURABILITY_NOSYNC
+} RDB_durability;
+
+/*
+ * Settings for opening a database environment.
+ * A value of zero means that the default is used.
+ * Settings not supported by a storage engine are ignored.
+ */
+typedef struct RDB_env_config {
+    /* Size of the cache (buffer pool) in bytes */
+    size_t cache_size;
+
+    /* Size of the log buffer in bytes */
+    unsigned log_buf_size;
+
+    /* Maximum numbers of locks, lockers, and locked objects */
+    unsigned max_locks;
+    unsigned max_lockers;
+    unsigned max_lock_objects;
+
+    /* Maximum number of active transactions */
+    unsigned max_txns;
+
+    RDB_durability durability;
+
+    /*
+     * Time in microseconds a committing transaction waits
+     * so that its log flush can be combined with the log flushes of
+     * concurrent commits (group commit). 0 disables group commit.
+     */
+    unsigned group_commit_delay;
+
+    /*
+     * Page size of the data file. Only takes effect when the
+     * data file is created.
+     */
+    unsigned page_size;
+
+    /* Fill factor of unordered record maps */
+    unsigned hash_ffactor;
+
+    /*
+     * Number of bytes SUMMARIZE and GROUP may use for an in-memory
+     * hash table. Overrides the value set by RDB_set_hash_mem().
+     */
+    size_t hash_mem;
+
+    /*
+     * Number of bytes a sorter may use before it writes sorted runs
+     * to temporary files. Overrides the value set by RDB_set_sort_mem().
+     */
+    size_t sort_mem;
+
+    /*
+     * PostgreSQL: Maximum number of rows a read-only cursor
+     * fetches with a single FETCH command
+     */
+    unsigned fetch_rows;
+} RDB_env_config;
+
 typedef void (RDB_errfn)(const char *msg, void *arg);
 
 typedef struct RDB_exec_context RDB_exec_context;
@@ -33,9 +105,19 @@ RDB_env_set_trace(RDB_environment *, unsigned);
 RDB_environment *
 RDB_open_env(const char *, int, RDB_exec_context *);
 
+RDB_environment *
+RDB_open_env_config(const char *, int, const RDB_env_config *,
+        RDB_exec_context *);
+
 RDB_environment *
 RDB_create_env(const char *, RDB_exec_context *);
 
+void
+RDB_init_env_config(RDB_env_config *);
+
+int
+RDB_parse_env_config(const char *, RDB_env_config *, RDB_exec_context *);
+
 int
 RDB_close_env(RDB_environment *, RDB_exec_context *);
 
@@ -51,6 +133,12 @@ RDB_errcode_to_error(int, RDB_exec_context *);
 RDB_bool
 RDB_env_queries(const RDB_environment *);
 
+size_t
+RDB_env_hash_mem(const RDB_environment *);
+
+size_t
+RDB_env_sort_mem(const RDB_environment *);
+
 void
 RDB_env_set_errfile(RDB_environment *, FILE *);
 
@@ -59,7 +59,8 @@ typedef struct RDB_environment {
             RDB_rec_transaction *, RDB_exec_context *);
     RDB_rec_transaction *(*begin_tx_fn)(RDB_environment *,
             RDB_rec_transaction *, RDB_exec_context *);
-    int (*commit_fn)(RDB_rec_transaction *, RDB_exec_context *);
+    int (*commit_fn)(RDB_rec_transaction *, struct RDB_environment *,
+            RDB_durability, RDB_exec_context *);
     int (*abort_fn)(RDB_rec_transaction *, RDB_exec_context *);
     int (*tx_id_fn)(RDB_rec_transaction *);
     void (*set_errfile_fn)(RDB_environment *, FILE *);
@@ -79,6 +80,32 @@ typedef struct RDB_environment {
 
     /* TRUE if the storage engine supports queries (SQL), FALSE if not (Berkeley DB) */
     RDB_bool queries;
+
+    /* Page size and fill factor for new record maps, 0 for default (Berkeley DB) */
+    unsigned page_size;
+    unsigned hash_ffactor;
+
+    /* Group commit delay in microseconds, 0 if disabled (Berkeley DB) */
+    unsigned group_commit_delay;
+
+    /* Memory limit for hash tables used by queries, 0 for default */
+    size_t hash_mem;
+
+    /* Memory limit for sorting, 0 for default */
+    size_t sort_mem;
+
+    /* Number of rows fetched at once by PostgreSQL cursors, 0 for default */
+    unsigned fetch_rows;
+
+#ifdef POSTGRESQL
+    /*
+     * Numbers for the names of cursors, prepared statements and savepoints,
+     * which must be unique per connection
+     */
+    unsigned pg_next_cur_id;
+    unsigned pg_next_stmt_id;
+    unsigned pg_next_savepoint_id;
+#endif
 } RDB_environment;
 
 #endif /* REC_ENVIMPL_H_ */
@@ -54,6 +54,33 @@ RDB_index_get_fields(RDB_index *ixp, RDB_field keyv[], int fieldc, RDB_rec_trans
     return (*ixp->index_get_fields_fn)(ixp, keyv, fieldc, rtxp, retfieldv, ecp);
 }
 
+/*
+ * Read field values of several records using the unique index *ixp,
+ * like RDB_get_fields_multi() does using the primary index.
+ * Only supported if RDB_index_multi_get() returns RDB_TRUE.
+ */
+int
+RDB_index_get_fields_multi(RDB_index *ixp, int recc, RDB_field *keyvv[],
+        int fieldc, RDB_rec_transaction *rtxp, RDB_field *retfieldvv[],
+        RDB_bool foundv[], RDB_exec_context *ecp)
+{
+    if (ixp->index_get_fields_multi_fn == NULL) {
+        RDB_raise_not_supported("RDB_index_get_fields_multi", ecp);
+        return RDB_ERROR;
+    }
+    return (*ixp->index_get_fields_multi_fn)(ixp, recc, keyvv, fieldc, rtxp,
+            retfieldvv, foundv, ecp);
+}
+
+/*
+ * Return RDB_TRUE if the index supports RDB_index_get_fields_multi().
+ */
+RDB_bool
+RDB_index_multi_get(RDB_index *ixp)
+{
+    return (RDB_bool) (ixp->index_get_fields_multi_fn != NULL);
+}
+
 int
 RDB_index_delete_rec(RDB_index *ixp, RDB_field keyv[], RDB_rec_transaction *rtxp,
         RDB_exec_context *ecp)
@@ -75,6 +102,7 @@ RDB_new_index(RDB_recmap *rmp, const char *name, const char *filename,
     ixp->fieldv = NULL;
     ixp->rmp = rmp;
     ixp->flags = flags;
+    ixp->index_get_fields_multi_fn = NULL;
 
     ixp->namp = ixp->filenamp = NULL;
     if (name != NULL) {
@@ -39,6 +39,13 @@ int
 RDB_index_get_fields(RDB_index *, RDB_field[], int, RDB_rec_transaction *,
            RDB_field[], RDB_exec_context *);
 
+int
+RDB_index_get_fields_multi(RDB_index *, int, RDB_field *[], int,
+        RDB_rec_transaction *, RDB_field *[], RDB_bool[], RDB_exec_context *);
+
+RDB_bool
+RDB_index_multi_get(RDB_index *);
+
 int
 RDB_index_delete_rec(RDB_index *, RDB_field[], RDB_rec_transaction *,
         RDB_exec_context *);
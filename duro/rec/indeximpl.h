@@ -42,6 +42,10 @@ typedef struct RDB_index {
             RDB_exec_context *);
     int (*index_get_fields_fn)(RDB_index *, RDB_field[], int, RDB_rec_transaction *,
                RDB_field[], RDB_exec_context *);
+
+    /* May be NULL if the index does not support reading records in batches */
+    int (*index_get_fields_multi_fn)(RDB_index *, int, RDB_field *[], int,
+            RDB_rec_transaction *, RDB_field *[], RDB_bool[], RDB_exec_context *);
     int (*index_delete_rec_fn)(RDB_index *, RDB_field[], RDB_rec_transaction *,
             RDB_exec_context *);
     RDB_cursor * (*index_cursor_fn)(RDB_index *, RDB_bool, RDB_rec_transaction *,
@@ -85,6 +85,23 @@ RDB_insert_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp,
     return (*rmp->insert_rec_fn)(rmp, flds, rtxp, ecp);
 }
 
+/*
+ * Insert the records given by recv[0] .. recv[recc - 1] into a recmap
+ * using a single bulk operation.
+ * Either all records are inserted or, if an error occurs, none.
+ * Only supported if RDB_recmap_bulk_insert() returns RDB_TRUE.
+ */
+int
+RDB_insert_recs(RDB_recmap *rmp, int recc, RDB_field *recv[],
+        RDB_rec_transaction *rtxp, RDB_exec_context *ecp)
+{
+    if (rmp->insert_recs_fn == NULL) {
+        RDB_raise_not_supported("RDB_insert_recs", ecp);
+        return RDB_ERROR;
+    }
+    return (*rmp->insert_recs_fn)(rmp, recc, recv, rtxp, ecp);
+}
+
 /* Update the record whose key values are given by keyv.
  * The new values are given by fieldv.
  * keyv[..].no is ignored.
@@ -129,6 +146,31 @@ RDB_get_fields(RDB_recmap *rmp, RDB_field keyv[], int fieldc,
     return (*rmp->get_fields_fn)(rmp, keyv, fieldc, rtxp, retfieldv, ecp);
 }
 
+/*
+ * Read field values of the records whose keys are given by
+ * keyvv[0] .. keyvv[recc - 1] from a recmap using the primary index.
+ * The lookups are issued together, so the storage layer can process them
+ * concurrently.
+ * For each record, the fields given by retfieldvv[i] are read
+ * as by RDB_get_fields(). foundv[i] is set to RDB_TRUE
+ * if the record was found, to RDB_FALSE if not.
+ * The field data is valid until the next multi-get on the recmap
+ * or until the recmap is closed.
+ * Only supported if RDB_recmap_multi_get() returns RDB_TRUE.
+ */
+int
+RDB_get_fields_multi(RDB_recmap *rmp, int recc, RDB_field *keyvv[],
+        int fieldc, RDB_rec_transaction *rtxp, RDB_field *retfieldvv[],
+        RDB_bool foundv[], RDB_exec_context *ecp)
+{
+    if (rmp->get_fields_multi_fn == NULL) {
+        RDB_raise_not_supported("RDB_get_fields_multi", ecp);
+        return RDB_ERROR;
+    }
+    return (*rmp->get_fields_multi_fn)(rmp, recc, keyvv, fieldc, rtxp,
+            retfieldvv, foundv, ecp);
+}
+
 /*
  * Check if the recmap contains the record whose values are given by valv.
  * Return RDB_OK if yes, RDB_ERROR with RDB_NOT_FOUND_FOUND_ERROR in *ecp if no.
@@ -159,6 +201,24 @@ RDB_recmap_delayed_deletion(RDB_recmap *rmp)
     return rmp->delayed_deletion;
 }
 
+/*
+ * Return RDB_TRUE if the recmap supports RDB_insert_recs().
+ */
+RDB_bool
+RDB_recmap_bulk_insert(RDB_recmap *rmp)
+{
+    return (RDB_bool) (rmp->insert_recs_fn != NULL);
+}
+
+/*
+ * Return RDB_TRUE if the recmap supports RDB_get_fields_multi().
+ */
+RDB_bool
+RDB_recmap_multi_get(RDB_recmap *rmp)
+{
+    return (RDB_bool) (rmp->get_fields_multi_fn != NULL);
+}
+
 /*
  * Allocate a RDB_recmap structure and initialize its storage-independent fields.
  */
@@ -222,6 +282,8 @@ RDB_new_recmap(const char *namp, const char *filenamp,
         rmp->fieldinfos[i].attrname = fieldinfov[i].attrname;
     }
     rmp->delayed_deletion = RDB_FALSE;
+    rmp->insert_recs_fn = NULL;
+    rmp->get_fields_multi_fn = NULL;
 
     return rmp;
 
@@ -82,6 +82,10 @@ RDB_delete_recmap(RDB_recmap *, RDB_rec_transaction *, RDB_exec_context *);
 int
 RDB_insert_rec(RDB_recmap *, RDB_field[], RDB_rec_transaction *, RDB_exec_context *);
 
+int
+RDB_insert_recs(RDB_recmap *, int, RDB_field *[], RDB_rec_transaction *,
+        RDB_exec_context *);
+
 int
 RDB_update_rec(RDB_recmap *, RDB_field[],
                int, const RDB_field[], RDB_rec_transaction *, RDB_exec_context *);
@@ -93,6 +97,10 @@ int
 RDB_get_fields(RDB_recmap *, RDB_field[], int,
         RDB_rec_transaction *, RDB_field[], RDB_exec_context *);
 
+int
+RDB_get_fields_multi(RDB_recmap *, int, RDB_field *[], int,
+        RDB_rec_transaction *, RDB_field *[], RDB_bool[], RDB_exec_context *);
+
 int
 RDB_contains_rec(RDB_recmap *, RDB_field[], RDB_rec_transaction *, RDB_exec_context *);
 
@@ -102,4 +110,10 @@ RDB_recmap_est_size(RDB_recmap *, RDB_rec_transaction *, unsigned *, RDB_exec_co
 RDB_bool
 RDB_recmap_delayed_deletion(RDB_recmap *);
 
+RDB_bool
+RDB_recmap_bulk_insert(RDB_recmap *);
+
+RDB_bool
+RDB_recmap_multi_get(RDB_recmap *);
+
 #endif
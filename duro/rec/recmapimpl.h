@@ -17,6 +17,14 @@
 
 #include <treerec/tree.h>
 
+#ifdef POSTGRESQL
+#include <pgrec/pgstmt.h>
+#endif
+
+#ifdef FOUNDATIONDB
+#include <stdint.h>
+#endif
+
 typedef struct RDB_cursor RDB_cursor;
 typedef struct RDB_exec_context RDB_exec_context;
 typedef struct RDB_index RDB_index;
@@ -31,6 +39,37 @@ typedef struct RDB_recmap {
         struct {
             RDB_binary_tree *treep;
         } tree;
+#ifdef POSTGRESQL
+        struct {
+            /* Prepared statements, indexed by RDB_PG_STMT_* */
+            RDB_pg_stmt stmtv[RDB_PG_STMT_COUNT];
+
+            /*
+             * Result of the last RDB_get_pg_fields() call and its numeric
+             * fields in host byte order, kept because the fields returned
+             * point into them
+             */
+            PGresult *getres;
+            void *getnumv;
+        } pg;
+#endif
+#ifdef FOUNDATIONDB
+        struct {
+            /*
+             * Keys and futures of the records read by the last multi-get,
+             * kept because the fields returned point into them
+             */
+            struct RDB_fdb_get *getv;
+            int getc;
+
+            /*
+             * Key and future of the record read by the last single get,
+             * kept for the same reason
+             */
+            uint8_t *key_name;
+            struct FDB_future *resultf;
+        } fdb;
+#endif
     } impl;
     RDB_index *indexes;
     char *namp;
@@ -62,12 +101,20 @@ typedef struct RDB_recmap {
     int (*delete_recmap_fn)(RDB_recmap *, RDB_rec_transaction *, RDB_exec_context *);
     int (*insert_rec_fn)(RDB_recmap *, RDB_field[], RDB_rec_transaction *,
             RDB_exec_context *);
+
+    /* May be NULL if the recmap does not support bulk insertion */
+    int (*insert_recs_fn)(RDB_recmap *, int, RDB_field *[],
+            RDB_rec_transaction *, RDB_exec_context *);
     int (*update_rec_fn)(RDB_recmap *, RDB_field[],
                    int, const RDB_field[], RDB_rec_transaction *, RDB_exec_context *);
     int (*delete_rec_fn)(RDB_recmap *, int, RDB_field[], RDB_rec_transaction *,
             RDB_exec_context *);
     int (*get_fields_fn)(RDB_recmap *, RDB_field[],
                int, RDB_rec_transaction *, RDB_field[], RDB_exec_context *);
+
+    /* May be NULL if the recmap does not support reading records in batches */
+    int (*get_fields_multi_fn)(RDB_recmap *, int, RDB_field *[], int,
+            RDB_rec_transaction *, RDB_field *[], RDB_bool[], RDB_exec_context *);
     int (*contains_rec_fn)(RDB_recmap *, RDB_field[], RDB_rec_transaction *,
             RDB_exec_context *);
     int (*recmap_est_size_fn)(RDB_recmap *, RDB_rec_transaction *, unsigned *,
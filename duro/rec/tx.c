@@ -15,11 +15,15 @@ RDB_begin_rec_tx(RDB_environment *envp,
     return (*envp->begin_tx_fn)(envp, parent_rtxp, ecp);
 }
 
+/*
+ * Commit the transaction *rtxp. The durability is ignored for
+ * nested transactions and by storage engines which do not support it.
+ */
 int
 RDB_commit_rec_tx(RDB_rec_transaction *rtxp, RDB_environment *envp,
-        RDB_exec_context *ecp)
+        RDB_durability durability, RDB_exec_context *ecp)
 {
-    return (*envp->commit_fn)(rtxp, ecp);
+    return (*envp->commit_fn)(rtxp, envp, durability, ecp);
 }
 
 int
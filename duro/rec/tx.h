@@ -13,11 +13,13 @@ typedef struct RDB_rec_transaction RDB_rec_transaction;
 typedef struct RDB_environment RDB_environment;
 typedef struct RDB_exec_context RDB_exec_context;
 
+#include "env.h"
+
 RDB_rec_transaction *RDB_begin_rec_tx(RDB_environment *,
         RDB_rec_transaction *, RDB_exec_context *);
 
 int RDB_commit_rec_tx(RDB_rec_transaction *, RDB_environment *,
-        RDB_exec_context *);
+        RDB_durability, RDB_exec_context *);
 
 int RDB_abort_rec_tx(RDB_rec_transaction *, RDB_environment *,
         RDB_exec_context *);
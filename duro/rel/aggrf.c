@@ -9,6 +9,7 @@
 
 #include "rdb.h"
 #include "internal.h"
+#include "qresult.h"
 #include "optimize.h"
 
 /** @addtogroup table
@@ -56,7 +57,8 @@ RDB_all(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
         RDB_transaction *txp, RDB_bool *resultp)
 {
     RDB_type *attrtyp;
-    RDB_object tpl;
+    RDB_object *tplp;
+    RDB_tuple_batch batch;
     RDB_object hobj;
     RDB_qresult *qrp = NULL;
     RDB_bool del_over = RDB_FALSE;
@@ -92,22 +94,23 @@ RDB_all(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
     if (qrp == NULL)
         return RDB_ERROR;
 
-    RDB_init_obj(&tpl);
     RDB_init_obj(&hobj);
+    if (RDB_init_tuple_batch(&batch, qrp, ecp) != RDB_OK)
+        goto error;
 
-    while (RDB_next_tuple(qrp, &tpl, ecp, txp) == RDB_OK) {
-        if (RDB_evaluate(exp, &RDB_tpl_get, &tpl, NULL, ecp, txp, &hobj)
+    while ((tplp = RDB_batch_next_tuple(&batch, ecp, txp)) != NULL) {
+        if (RDB_evaluate(exp, &RDB_tpl_get, tplp, NULL, ecp, txp, &hobj)
                 != RDB_OK) {
             goto error;
         }
         if (!RDB_obj_bool(&hobj))
             *resultp = RDB_FALSE;
     }
-    if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR) {
+    if (RDB_get_err(ecp) != NULL) {
         goto error;
     }
 
-    RDB_destroy_obj(&tpl, ecp);
+    RDB_destroy_tuple_batch(&batch, ecp);
     RDB_destroy_obj(&hobj, ecp);
 
     if (del_over) {
@@ -117,7 +120,7 @@ RDB_all(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
     return RDB_del_table_iterator(qrp, ecp, txp);
 
 error:
-    RDB_destroy_obj(&tpl, ecp);
+    RDB_destroy_tuple_batch(&batch, ecp);
     RDB_destroy_obj(&hobj, ecp);
 
     if (qrp != NULL) {
@@ -172,7 +175,8 @@ RDB_any(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
         RDB_transaction *txp, RDB_bool *resultp)
 {
     RDB_type *attrtyp;
-    RDB_object tpl;
+    RDB_object *tplp;
+    RDB_tuple_batch batch;
     RDB_object hobj;
     RDB_qresult *qrp = NULL;
     RDB_bool del_over = RDB_FALSE;
@@ -208,22 +212,23 @@ RDB_any(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
     if (qrp == NULL)
         return RDB_ERROR;
 
-    RDB_init_obj(&tpl);
     RDB_init_obj(&hobj);
+    if (RDB_init_tuple_batch(&batch, qrp, ecp) != RDB_OK)
+        goto error;
 
-    while (RDB_next_tuple(qrp, &tpl, ecp, txp) == RDB_OK) {
-        if (RDB_evaluate(exp, &RDB_tpl_get, &tpl, NULL, ecp, txp, &hobj)
+    while ((tplp = RDB_batch_next_tuple(&batch, ecp, txp)) != NULL) {
+        if (RDB_evaluate(exp, &RDB_tpl_get, tplp, NULL, ecp, txp, &hobj)
                 != RDB_OK) {
             goto error;
         }
         if (RDB_obj_bool(&hobj))
             *resultp = RDB_TRUE;
     }
-    if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR) {
+    if (RDB_get_err(ecp) != NULL) {
         goto error;
     }
 
-    RDB_destroy_obj(&tpl, ecp);
+    RDB_destroy_tuple_batch(&batch, ecp);
     RDB_destroy_obj(&hobj, ecp);
 
     if (del_over) {
@@ -233,7 +238,7 @@ RDB_any(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
     return RDB_del_table_iterator(qrp, ecp, txp);
 
 error:
-    RDB_destroy_obj(&tpl, ecp);
+    RDB_destroy_tuple_batch(&batch, ecp);
     RDB_destroy_obj(&hobj, ecp);
 
     if (qrp != NULL) {
@@ -289,7 +294,8 @@ RDB_max(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
 {
     RDB_type *attrtyp;
     RDB_qresult *qrp = NULL;
-    RDB_object tpl;
+    RDB_object *tplp;
+    RDB_tuple_batch batch;
     RDB_object hobj;
     RDB_bool del_over = RDB_FALSE;
 
@@ -329,11 +335,12 @@ RDB_max(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
     if (qrp == NULL)
         return RDB_ERROR;
 
-    RDB_init_obj(&tpl);
     RDB_init_obj(&hobj);
+    if (RDB_init_tuple_batch(&batch, qrp, ecp) != RDB_OK)
+        goto error;
 
-    while (RDB_next_tuple(qrp, &tpl, ecp, txp) == RDB_OK) {
-        if (RDB_evaluate(exp, &RDB_tpl_get, &tpl, NULL, ecp, txp, &hobj)
+    while ((tplp = RDB_batch_next_tuple(&batch, ecp, txp)) != NULL) {
+        if (RDB_evaluate(exp, &RDB_tpl_get, tplp, NULL, ecp, txp, &hobj)
                 != RDB_OK) {
             goto error;
         }
@@ -349,11 +356,11 @@ RDB_max(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
                 resultp->val.float_val = val;
         }
     }
-    if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR) {
+    if (RDB_get_err(ecp) != NULL) {
         goto error;
     }
 
-    RDB_destroy_obj(&tpl, ecp);
+    RDB_destroy_tuple_batch(&batch, ecp);
     RDB_destroy_obj(&hobj, ecp);
 
     if (del_over) {
@@ -363,7 +370,7 @@ RDB_max(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
     return RDB_del_table_iterator(qrp, ecp, txp);
 
 error:
-    RDB_destroy_obj(&tpl, ecp);
+    RDB_destroy_tuple_batch(&batch, ecp);
     RDB_destroy_obj(&hobj, ecp);
 
     if (qrp != NULL) {
@@ -419,7 +426,8 @@ RDB_min(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
 {
     RDB_type *attrtyp;
     RDB_qresult *qrp = NULL;
-    RDB_object tpl;
+    RDB_object *tplp;
+    RDB_tuple_batch batch;
     RDB_object hobj;
     RDB_bool del_over = RDB_FALSE;
 
@@ -459,11 +467,12 @@ RDB_min(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
     if (qrp == NULL)
         return RDB_ERROR;
 
-    RDB_init_obj(&tpl);
     RDB_init_obj(&hobj);
+    if (RDB_init_tuple_batch(&batch, qrp, ecp) != RDB_OK)
+        goto error;
 
-    while (RDB_next_tuple(qrp, &tpl, ecp, txp) == RDB_OK) {
-        if (RDB_evaluate(exp, &RDB_tpl_get, &tpl, NULL, ecp, txp, &hobj)
+    while ((tplp = RDB_batch_next_tuple(&batch, ecp, txp)) != NULL) {
+        if (RDB_evaluate(exp, &RDB_tpl_get, tplp, NULL, ecp, txp, &hobj)
                 != RDB_OK) {
             goto error;
         }
@@ -479,11 +488,11 @@ RDB_min(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
                 resultp->val.float_val = val;
         }
     }
-    if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR) {
+    if (RDB_get_err(ecp) != NULL) {
         goto error;
     }
 
-    RDB_destroy_obj(&tpl, ecp);
+    RDB_destroy_tuple_batch(&batch, ecp);
     RDB_destroy_obj(&hobj, ecp);
 
     if (del_over) {
@@ -493,7 +502,7 @@ RDB_min(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
     return RDB_del_table_iterator(qrp, ecp, txp);
 
 error:
-    RDB_destroy_obj(&tpl, ecp);
+    RDB_destroy_tuple_batch(&batch, ecp);
     RDB_destroy_obj(&hobj, ecp);
 
     if (qrp != NULL) {
@@ -549,7 +558,8 @@ RDB_sum(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
 {
     RDB_type *attrtyp;
     RDB_qresult *qrp = NULL;
-    RDB_object tpl;
+    RDB_object *tplp;
+    RDB_tuple_batch batch;
     RDB_object hobj;
     RDB_bool del_over = RDB_FALSE;
 
@@ -589,11 +599,12 @@ RDB_sum(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
     if (qrp == NULL)
         return RDB_ERROR;
 
-    RDB_init_obj(&tpl);
     RDB_init_obj(&hobj);
+    if (RDB_init_tuple_batch(&batch, qrp, ecp) != RDB_OK)
+        goto error;
 
-    while (RDB_next_tuple(qrp, &tpl, ecp, txp) == RDB_OK) {
-        if (RDB_evaluate(exp, &RDB_tpl_get, &tpl, NULL, ecp, txp, &hobj)
+    while ((tplp = RDB_batch_next_tuple(&batch, ecp, txp)) != NULL) {
+        if (RDB_evaluate(exp, &RDB_tpl_get, tplp, NULL, ecp, txp, &hobj)
                 != RDB_OK) {
             goto error;
         }
@@ -615,11 +626,11 @@ RDB_sum(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
             resultp->val.float_val += RDB_obj_float(&hobj);
     }
 
-    if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR) {
+    if (RDB_get_err(ecp) != NULL) {
         goto error;
     }
 
-    RDB_destroy_obj(&tpl, ecp);
+    RDB_destroy_tuple_batch(&batch, ecp);
     RDB_destroy_obj(&hobj, ecp);
 
     if (del_over) {
@@ -629,7 +640,7 @@ RDB_sum(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
     return RDB_del_table_iterator(qrp, ecp, txp);
 
 error:
-    RDB_destroy_obj(&tpl, ecp);
+    RDB_destroy_tuple_batch(&batch, ecp);
     RDB_destroy_obj(&hobj, ecp);
 
     if (qrp != NULL) {
@@ -686,7 +697,8 @@ RDB_avg(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
         RDB_transaction *txp, RDB_float *resultp)
 {
     RDB_type *attrtyp;
-    RDB_object tpl;
+    RDB_object *tplp;
+    RDB_tuple_batch batch;
     RDB_object hobj;
     unsigned long count;
     RDB_qresult *qrp = NULL;
@@ -722,14 +734,15 @@ RDB_avg(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
     if (qrp == NULL)
         return RDB_ERROR;
 
-    RDB_init_obj(&tpl);
     RDB_init_obj(&hobj);
+    if (RDB_init_tuple_batch(&batch, qrp, ecp) != RDB_OK)
+        goto error;
 
     count = 0;
     *resultp = 0.0;
-    while (RDB_next_tuple(qrp, &tpl, ecp, txp) == RDB_OK) {
+    while ((tplp = RDB_batch_next_tuple(&batch, ecp, txp)) != NULL) {
         count++;
-        if (RDB_evaluate(exp, &RDB_tpl_get, &tpl, NULL, ecp, txp, &hobj)
+        if (RDB_evaluate(exp, &RDB_tpl_get, tplp, NULL, ecp, txp, &hobj)
                 != RDB_OK) {
             goto error;
         }
@@ -739,7 +752,7 @@ RDB_avg(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
             *resultp += RDB_obj_float(&hobj);
     }
 
-    if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR) {
+    if (RDB_get_err(ecp) != NULL) {
         goto error;
     }
 
@@ -749,7 +762,7 @@ RDB_avg(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
     }
     *resultp /= count;
 
-    RDB_destroy_obj(&tpl, ecp);
+    RDB_destroy_tuple_batch(&batch, ecp);
     RDB_destroy_obj(&hobj, ecp);
 
     if (del_over) {
@@ -759,7 +772,7 @@ RDB_avg(RDB_object *tbp, RDB_expression *exp, RDB_exec_context *ecp,
     return RDB_del_table_iterator(qrp, ecp, txp);
 
 error:
-    RDB_destroy_obj(&tpl, ecp);
+    RDB_destroy_tuple_batch(&batch, ecp);
     RDB_destroy_obj(&hobj, ecp);
 
     if (qrp != NULL) {
@@ -5,6 +5,7 @@
 
 #include "rdb.h"
 #include "qresult.h"
+#include "qr_sort.h"
 #include "internal.h"
 #include "stable.h"
 #include "optimize.h"
@@ -36,7 +37,7 @@ init_expr_array(RDB_object *arrp, RDB_expression *texp,
             if (txp != NULL && RDB_env_trace(RDB_db_env(RDB_tx_db(txp))) > 0) {
                 fputs("Creating sorter\n", stderr);
             }
-            if (RDB_sorter(texp, &qrp, ecp, txp, seqitc, seqitv) != RDB_OK)
+            if (RDB_sorter(texp, &qrp, ecp, txp, seqitc, seqitv, limit) != RDB_OK)
                 goto error;
         }
     }
@@ -61,29 +62,28 @@ init_expr_array(RDB_object *arrp, RDB_expression *texp,
     arrp->val.arr.length = 0;
     arrp->val.arr.capacity = 0;
 
-    for (;;) {
-        /* Extend elemv if necessary to make room for the next element */
-        if (arrp->val.arr.capacity <= arrp->val.arr.length) {
+    while (arrp->val.arr.length < limit) {
+        int tplc;
+        RDB_int batchsize = limit - arrp->val.arr.length;
+        if (batchsize > BUF_INCREMENT)
+            batchsize = BUF_INCREMENT;
+
+        /* Extend elemv if necessary to make room for the next batch */
+        if (arrp->val.arr.capacity < arrp->val.arr.length + batchsize) {
             if (RDB_enlarge_array_buf(arrp, arrp->val.arr.capacity + BUF_INCREMENT, ecp)
                     != RDB_OK) {
                 goto error;
             }
         }
 
-        /* Get next tuple */
-        if (RDB_next_tuple(qrp, &arrp->val.arr.elemv[arrp->val.arr.length],
-                ecp, txp) != RDB_OK) {
-            break;
-        }
-        if (arrp->val.arr.length == limit) {
-            break;
-        }
-        arrp->val.arr.length++;
-    }
-    if (RDB_get_err(ecp) != NULL) {
-        if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR)
+        /* Read the next tuples directly into the array */
+        tplc = RDB_next_tuples(qrp, &arrp->val.arr.elemv[arrp->val.arr.length],
+                (int) batchsize, ecp, txp);
+        if (tplc == RDB_ERROR)
             goto error;
-        RDB_clear_err(ecp);
+        arrp->val.arr.length += tplc;
+        if (tplc < batchsize)
+            break;
     }
 
     if (RDB_del_qresult(qrp, ecp, txp) != RDB_OK) {
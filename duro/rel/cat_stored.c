@@ -8,6 +8,7 @@
 #include "cat_stored.h"
 #include "internal.h"
 #include "insert.h"
+#include "stable.h"
 #include <gen/strfns.h>
 #include <obj/objinternal.h>
 
@@ -344,3 +345,224 @@ error:
     RDB_destroy_obj(&tpl, ecp);
     return RDB_ERROR;
 }
+
+/*
+ * Store the statistics of the stored table of *tbp in the catalog,
+ * replacing the statistics stored previously.
+ */
+int
+RDB_cat_put_table_stats(RDB_object *tbp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    int i;
+    int ret;
+    RDB_object tpl;
+    RDB_object tbnameobj;
+    RDB_object attrnameobj;
+    RDB_stored_table *stp = tbp->val.tbp->stp;
+    RDB_type *tpltyp = tbp->typ->def.basetyp;
+    RDB_dbroot *dbrootp = txp->dbp->dbrootp;
+    RDB_expression *exp = RDB_tablename_id_eq_expr(RDB_table_name(tbp), ecp);
+    if (exp == NULL)
+        return RDB_ERROR;
+
+    RDB_init_obj(&tpl);
+    RDB_init_obj(&tbnameobj);
+    RDB_init_obj(&attrnameobj);
+
+    if (RDB_delete(dbrootp->table_stats_tbp, exp, ecp, txp) == RDB_ERROR) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    if (RDB_delete(dbrootp->attr_stats_tbp, exp, ecp, txp) == RDB_ERROR) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+
+    ret = RDB_string_to_id(&tbnameobj, RDB_table_name(tbp), ecp);
+    if (ret != RDB_OK)
+        goto cleanup;
+
+    ret = RDB_tuple_set(&tpl, "tablename", &tbnameobj, ecp);
+    if (ret != RDB_OK)
+        goto cleanup;
+
+    ret = RDB_tuple_set_int(&tpl, "cardinality",
+            (RDB_int) stp->est_cardinality, ecp);
+    if (ret != RDB_OK)
+        goto cleanup;
+
+    ret = RDB_insert(dbrootp->table_stats_tbp, &tpl, ecp, txp);
+    if (ret != RDB_OK)
+        goto cleanup;
+
+    if (stp->est_distinctv != NULL) {
+        RDB_destroy_obj(&tpl, ecp);
+        RDB_init_obj(&tpl);
+        ret = RDB_tuple_set(&tpl, "tablename", &tbnameobj, ecp);
+        if (ret != RDB_OK)
+            goto cleanup;
+
+        for (i = 0; i < tpltyp->def.tuple.attrc; i++) {
+            RDB_int fno = *RDB_field_no(stp, tpltyp->def.tuple.attrv[i].name);
+
+            if (stp->est_distinctv[fno] == 0)
+                continue;
+
+            ret = RDB_string_to_id(&attrnameobj,
+                    tpltyp->def.tuple.attrv[i].name, ecp);
+            if (ret != RDB_OK)
+                goto cleanup;
+            ret = RDB_tuple_set(&tpl, "attrname", &attrnameobj, ecp);
+            if (ret != RDB_OK)
+                goto cleanup;
+            ret = RDB_tuple_set_int(&tpl, "distinct_count",
+                    (RDB_int) stp->est_distinctv[fno], ecp);
+            if (ret != RDB_OK)
+                goto cleanup;
+            ret = RDB_insert(dbrootp->attr_stats_tbp, &tpl, ecp, txp);
+            if (ret != RDB_OK)
+                goto cleanup;
+        }
+    }
+
+cleanup:
+    RDB_del_expr(exp, ecp);
+    RDB_destroy_obj(&attrnameobj, ecp);
+    RDB_destroy_obj(&tbnameobj, ecp);
+    RDB_destroy_obj(&tpl, ecp);
+    return ret;
+}
+
+/*
+ * Read the statistics of the stored table of *tbp from the catalog.
+ * The estimated numbers of distinct attribute values are stored in the
+ * stored table.
+ * The cardinality is stored in *cardp, or -1 if the table has
+ * no statistics.
+ */
+int
+RDB_cat_get_table_stats(RDB_object *tbp, RDB_int *cardp,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int ret;
+    int i;
+    RDB_int attrc;
+    RDB_object tpl;
+    RDB_object arr;
+    RDB_object *vtbp = NULL;
+    RDB_expression *argp;
+    RDB_stored_table *stp = tbp->val.tbp->stp;
+    RDB_dbroot *dbrootp = txp->dbp->dbrootp;
+    RDB_expression *exp = RDB_ro_op("where", ecp);
+    if (exp == NULL) {
+        return RDB_ERROR;
+    }
+
+    RDB_init_obj(&tpl);
+    RDB_init_obj(&arr);
+
+    argp = RDB_table_ref(dbrootp->table_stats_tbp, ecp);
+    if (argp == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    RDB_add_arg(exp, argp);
+    argp = RDB_tablename_id_eq_expr(RDB_table_name(tbp), ecp);
+    if (argp == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    RDB_add_arg(exp, argp);
+
+    vtbp = RDB_expr_to_vtable(exp, ecp, txp);
+    if (vtbp == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    exp = NULL;
+
+    ret = RDB_extract_tuple(vtbp, ecp, txp, &tpl);
+    if (ret != RDB_OK) {
+        if (RDB_obj_type(RDB_get_err(ecp)) == &RDB_NOT_FOUND_ERROR) {
+            RDB_clear_err(ecp);
+            *cardp = (RDB_int) -1;
+            ret = RDB_OK;
+        }
+        goto cleanup;
+    }
+    *cardp = RDB_tuple_get_int(&tpl, "cardinality");
+    RDB_drop_table(vtbp, ecp, NULL);
+    vtbp = NULL;
+
+    exp = RDB_ro_op("where", ecp);
+    if (exp == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    argp = RDB_table_ref(dbrootp->attr_stats_tbp, ecp);
+    if (argp == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    RDB_add_arg(exp, argp);
+    argp = RDB_tablename_id_eq_expr(RDB_table_name(tbp), ecp);
+    if (argp == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    RDB_add_arg(exp, argp);
+
+    vtbp = RDB_expr_to_vtable(exp, ecp, txp);
+    if (vtbp == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    exp = NULL;
+
+    ret = RDB_table_to_array(&arr, vtbp, 0, NULL, 0, ecp, txp);
+    if (ret != RDB_OK)
+        goto cleanup;
+
+    attrc = RDB_array_length(&arr, ecp);
+    if (attrc < 0) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    if (attrc > 0) {
+        unsigned *distinctv = RDB_alloc(sizeof(unsigned)
+                * tbp->typ->def.basetyp->def.tuple.attrc, ecp);
+        if (distinctv == NULL) {
+            ret = RDB_ERROR;
+            goto cleanup;
+        }
+        for (i = 0; i < tbp->typ->def.basetyp->def.tuple.attrc; i++) {
+            distinctv[i] = 0;
+        }
+        for (i = 0; i < attrc; i++) {
+            RDB_int *fnop;
+            RDB_object *tplp = RDB_array_get(&arr, (RDB_int) i, ecp);
+            if (tplp == NULL) {
+                RDB_free(distinctv);
+                ret = RDB_ERROR;
+                goto cleanup;
+            }
+            fnop = RDB_field_no(stp, RDB_tuple_get_string(tplp, "attrname"));
+            if (fnop != NULL) {
+                distinctv[*fnop] = (unsigned) RDB_tuple_get_int(tplp,
+                        "distinct_count");
+            }
+        }
+        RDB_free(stp->est_distinctv);
+        stp->est_distinctv = distinctv;
+    }
+
+cleanup:
+    if (vtbp != NULL)
+        RDB_drop_table(vtbp, ecp, NULL);
+    if (exp != NULL)
+        RDB_del_expr(exp, ecp);
+    RDB_destroy_obj(&arr, ecp);
+    RDB_destroy_obj(&tpl, ecp);
+    return ret;
+}
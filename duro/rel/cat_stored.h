@@ -31,6 +31,13 @@ int
 RDB_cat_recmap_name(RDB_object *, RDB_object *, RDB_exec_context *,
         RDB_transaction *);
 
+int
+RDB_cat_put_table_stats(RDB_object *, RDB_exec_context *, RDB_transaction *);
+
+int
+RDB_cat_get_table_stats(RDB_object *, RDB_int *, RDB_exec_context *,
+        RDB_transaction *);
+
 int
 RDB_string_to_id(RDB_object *, const char *, RDB_exec_context *);
 
@@ -219,6 +219,21 @@ static RDB_attr subtype_attrv[] = {
 static char *subtype_keyattrv[] = { "typename", "supertypename" };
 static RDB_string_vec subtype_keyv[] = { { 2, subtype_keyattrv } };
 
+static RDB_attr table_stats_attrv[] = {
+    { "tablename", &RDB_IDENTIFIER, NULL, 0 },
+    { "cardinality", &RDB_INTEGER, NULL, 0 }
+};
+static char *table_stats_keyattrv[] = { "tablename" };
+static RDB_string_vec table_stats_keyv[] = { { 1, table_stats_keyattrv } };
+
+static RDB_attr attr_stats_attrv[] = {
+    { "attrname", &RDB_IDENTIFIER, NULL, 0 },
+    { "tablename", &RDB_IDENTIFIER, NULL, 0 },
+    { "distinct_count", &RDB_INTEGER, NULL, 0 }
+};
+static char *attr_stats_keyattrv[] = { "attrname", "tablename" };
+static RDB_string_vec attr_stats_keyv[] = { { 2, attr_stats_keyattrv } };
+
 int
 RDB_cat_dbtables_insert(RDB_object *tbp, RDB_database *dbp, RDB_exec_context *ecp, RDB_transaction *txp)
 {
@@ -922,6 +937,14 @@ delete_rtable(RDB_object *tbp, RDB_exec_context *ecp, RDB_transaction *txp)
     if (ret == RDB_ERROR)
         goto cleanup;
 
+    ret = RDB_delete(txp->dbp->dbrootp->table_stats_tbp, idexprp, ecp, txp);
+    if (ret == RDB_ERROR)
+        goto cleanup;
+
+    ret = RDB_delete(txp->dbp->dbrootp->attr_stats_tbp, idexprp, ecp, txp);
+    if (ret == RDB_ERROR)
+        goto cleanup;
+
     ret = RDB_delete(txp->dbp->dbrootp->dbtables_tbp, idexprp, ecp, txp);
 
 cleanup:
@@ -1507,6 +1530,21 @@ RDB_open_systables(RDB_dbroot *dbrootp, RDB_exec_context *ecp,
         return ret;
     }
 
+    /* New with version 1.8, so create if they do not exist */
+    ret = provide_systable("sys_table_stats", 2, table_stats_attrv,
+            1, table_stats_keyv, create, RDB_TRUE, ecp, txp, dbrootp->envp,
+            &dbrootp->table_stats_tbp);
+    if (ret != RDB_OK) {
+        return ret;
+    }
+
+    ret = provide_systable("sys_attr_stats", 3, attr_stats_attrv,
+            1, attr_stats_keyv, create, RDB_TRUE, ecp, txp, dbrootp->envp,
+            &dbrootp->attr_stats_tbp);
+    if (ret != RDB_OK) {
+        return ret;
+    }
+
     if (create) {
         /* Add referential constraint INDEX -> RTABLE */
         RDB_expression *exp = index_rtable_constraint(dbrootp, ecp);
@@ -1601,6 +1639,14 @@ RDB_open_systables(RDB_dbroot *dbrootp, RDB_exec_context *ecp,
         ret = open_indexes(dbrootp->subtype_tbp, dbrootp, ecp, txp);
         if (ret != RDB_OK)
             return ret;
+
+        ret = open_indexes(dbrootp->table_stats_tbp, dbrootp, ecp, txp);
+        if (ret != RDB_OK)
+            return ret;
+
+        ret = open_indexes(dbrootp->attr_stats_tbp, dbrootp, ecp, txp);
+        if (ret != RDB_OK)
+            return ret;
     }
     return RDB_OK;
 }
@@ -1666,6 +1712,12 @@ RDB_cat_create_db(RDB_exec_context *ecp, RDB_transaction *txp)
             if (ret != RDB_OK)
                 return ret;
             ret = RDB_cat_dbtables_insert(txp->dbp->dbrootp->subtype_tbp, RDB_tx_db(txp), ecp, txp);
+            if (ret != RDB_OK)
+                return ret;
+            ret = RDB_cat_dbtables_insert(txp->dbp->dbrootp->table_stats_tbp, RDB_tx_db(txp), ecp, txp);
+            if (ret != RDB_OK)
+                return ret;
+            ret = RDB_cat_dbtables_insert(txp->dbp->dbrootp->attr_stats_tbp, RDB_tx_db(txp), ecp, txp);
         }
         return ret;
     }
@@ -1753,6 +1805,14 @@ RDB_cat_create_db(RDB_exec_context *ecp, RDB_transaction *txp)
     if (ret != RDB_OK) {
         return ret;
     }
+    ret = RDB_cat_insert(txp->dbp->dbrootp->table_stats_tbp, ecp, txp);
+    if (ret != RDB_OK) {
+        return ret;
+    }
+    ret = RDB_cat_insert(txp->dbp->dbrootp->attr_stats_tbp, ecp, txp);
+    if (ret != RDB_OK) {
+        return ret;
+    }
     return RDB_OK;
 }
 
@@ -2694,7 +2754,7 @@ RDB_cat_rename_table(RDB_object *tbp, const char *name, RDB_exec_context *ecp,
     int ret;
     RDB_attr_update updid;
     RDB_attr_update upd;
-    RDB_ma_update updv[5];
+    RDB_ma_update updv[7];
     RDB_transaction tx;
     RDB_bool subtx_active;
     RDB_expression *idcondp = NULL;
@@ -2761,7 +2821,18 @@ RDB_cat_rename_table(RDB_object *tbp, const char *name, RDB_exec_context *ecp,
         updv[4].updc = 1;
         updv[4].updv = &updid;
 
-        ret = RDB_multi_assign(0, NULL, 5, updv, 0, NULL, 0, NULL, 0, NULL,
+        /* Keep the statistics of the table */
+        updv[5].condp = idcondp;
+        updv[5].tbp = txp->dbp->dbrootp->table_stats_tbp;
+        updv[5].updc = 1;
+        updv[5].updv = &updid;
+
+        updv[6].condp = idcondp;
+        updv[6].tbp = txp->dbp->dbrootp->attr_stats_tbp;
+        updv[6].updc = 1;
+        updv[6].updv = &updid;
+
+        ret = RDB_multi_assign(0, NULL, 7, updv, 0, NULL, 0, NULL, 0, NULL,
                 NULL, NULL, ecp, subtx_active ? &tx : txp);
         if (ret == RDB_ERROR)
             goto error;
@@ -0,0 +1,447 @@
+/*
+ * Compiled expressions.
+ *
+ * An expression which is evaluated for each tuple of a table, like
+ * a WHERE condition, is converted to a flat list of instructions
+ * in evaluation order. Each instruction stores its result in an
+ * object owned by the instruction, so evaluating the expression
+ * for the next tuple can reuse the objects.
+ * Operators are looked up when the instruction is executed for the
+ * first time and are then reused as long as the argument types do not
+ * change. Subexpressions which cannot be compiled are evaluated
+ * by RDB_evaluate().
+ *
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include "cexpr.h"
+#include "rdb.h"
+#include "internal.h"
+#include <obj/objinternal.h>
+#include <obj/builtintypes.h>
+#include <obj/tuple.h>
+
+#include <string.h>
+
+enum cx_kind {
+    /* Constant or table, the result does not change */
+    CX_CONST,
+
+    /* Reference to a tuple attribute or table */
+    CX_ATTR,
+
+    /* Invocation of a read-only operator */
+    CX_CALL,
+
+    /* Subexpression evaluated by RDB_evaluate() */
+    CX_EVAL
+};
+
+typedef struct {
+    enum cx_kind kind;
+    RDB_expression *exp;
+
+    /* Points to the result of the instruction */
+    RDB_object *valp;
+
+    /* Result of CX_CALL and CX_EVAL */
+    RDB_object val;
+
+    /* CX_ATTR: Slot of the attribute in the last tuple, -1 if unknown */
+    int slot;
+
+    /* CX_CALL: Indexes of the instructions which compute the arguments */
+    int argc;
+    int *argiv;
+    RDB_object **argpv;
+
+    /*
+     * CX_CALL: The operator found for the argument types argtv,
+     * NULL if no operator has been looked up yet.
+     */
+    RDB_operator *op;
+    RDB_type **argtv;
+} cx_instr;
+
+struct RDB_cexpr {
+    int instrc;
+    int capacity;
+    cx_instr *instrv;
+    RDB_environment *envp;
+};
+
+/*
+ * Check if *exp can be compiled to a CX_CALL instruction.
+ * This is the case if the operator is not handled specially
+ * by RDB_evaluate() and all arguments are scalar.
+ */
+static RDB_bool
+call_compilable(RDB_expression *exp, const RDB_type *tpltyp,
+        RDB_environment *envp, RDB_transaction *txp)
+{
+    RDB_expression *argp;
+    RDB_type *typ;
+    RDB_exec_context ec;
+
+    if (exp->def.op.name == NULL || exp->def.op.code != RDB_OP_OTHER
+            || strcmp(exp->def.op.name, "array") == 0)
+        return RDB_FALSE;
+
+    /* Errors are raised when the expression is evaluated */
+    RDB_init_exec_context(&ec);
+    for (argp = exp->def.op.args.firstp; argp != NULL; argp = argp->nextp) {
+        typ = RDB_expr_type_tpltyp(argp, tpltyp, NULL, NULL, envp, &ec, txp);
+        if (typ == NULL || !RDB_type_is_scalar(typ))
+            break;
+    }
+    RDB_destroy_exec_context(&ec);
+    return (RDB_bool) (argp == NULL);
+}
+
+static int
+add_instr(RDB_cexpr *cxp, enum cx_kind kind, RDB_expression *exp,
+        RDB_exec_context *ecp)
+{
+    cx_instr *ip;
+
+    if (cxp->instrc == cxp->capacity) {
+        int capacity = cxp->capacity * 2;
+        cx_instr *instrv = RDB_realloc(cxp->instrv,
+                sizeof(cx_instr) * capacity, ecp);
+        if (instrv == NULL)
+            return RDB_ERROR;
+        cxp->instrv = instrv;
+        cxp->capacity = capacity;
+    }
+    ip = &cxp->instrv[cxp->instrc++];
+    ip->kind = kind;
+    ip->exp = exp;
+    ip->valp = NULL;
+    RDB_init_obj(&ip->val);
+    ip->slot = -1;
+    ip->argc = 0;
+    ip->argiv = NULL;
+    ip->argpv = NULL;
+    ip->op = NULL;
+    ip->argtv = NULL;
+    return RDB_OK;
+}
+
+/*
+ * Append the instructions for *exp and store the index of the
+ * instruction which computes the result in *idxp.
+ */
+static int
+compile_expr(RDB_cexpr *cxp, RDB_expression *exp, const RDB_type *tpltyp,
+        RDB_exec_context *ecp, RDB_transaction *txp, int *idxp)
+{
+    int i;
+    int argc;
+    int *argiv;
+    RDB_expression *argp;
+    cx_instr *ip;
+
+    switch (exp->kind) {
+    case RDB_EX_OBJ:
+        if (add_instr(cxp, CX_CONST, exp, ecp) != RDB_OK)
+            return RDB_ERROR;
+        cxp->instrv[cxp->instrc - 1].valp = &exp->def.obj;
+        break;
+    case RDB_EX_TBP:
+        if (add_instr(cxp, CX_CONST, exp, ecp) != RDB_OK)
+            return RDB_ERROR;
+        cxp->instrv[cxp->instrc - 1].valp = exp->def.tbref.tbp;
+        break;
+    case RDB_EX_VAR:
+        if (add_instr(cxp, CX_ATTR, exp, ecp) != RDB_OK)
+            return RDB_ERROR;
+        break;
+    case RDB_EX_RO_OP:
+        if (!call_compilable(exp, tpltyp, cxp->envp, txp)) {
+            if (add_instr(cxp, CX_EVAL, exp, ecp) != RDB_OK)
+                return RDB_ERROR;
+            break;
+        }
+
+        /* Compile the arguments first so their results are available */
+        argc = RDB_expr_list_length(&exp->def.op.args);
+        argiv = RDB_alloc(sizeof(int) * (argc > 0 ? argc : 1), ecp);
+        if (argiv == NULL)
+            return RDB_ERROR;
+        argp = exp->def.op.args.firstp;
+        for (i = 0; i < argc; i++) {
+            if (compile_expr(cxp, argp, tpltyp, ecp, txp, &argiv[i])
+                    != RDB_OK) {
+                RDB_free(argiv);
+                return RDB_ERROR;
+            }
+            argp = argp->nextp;
+        }
+        if (add_instr(cxp, CX_CALL, exp, ecp) != RDB_OK) {
+            RDB_free(argiv);
+            return RDB_ERROR;
+        }
+        ip = &cxp->instrv[cxp->instrc - 1];
+        ip->argc = argc;
+        ip->argiv = argiv;
+        ip->argpv = RDB_alloc(sizeof(RDB_object *) * (argc > 0 ? argc : 1),
+                ecp);
+        if (ip->argpv == NULL)
+            return RDB_ERROR;
+        ip->argtv = RDB_alloc(sizeof(RDB_type *) * (argc > 0 ? argc : 1),
+                ecp);
+        if (ip->argtv == NULL)
+            return RDB_ERROR;
+        break;
+    }
+    *idxp = cxp->instrc - 1;
+    return RDB_OK;
+}
+
+/**
+ * Compile the expression *exp for evaluation with tuples of type *tpltyp.
+ * *tpltyp is only used to determine the types of subexpressions.
+ * The expression must not be modified or deleted
+ * before the compiled expression is deleted.
+ */
+RDB_cexpr *
+RDB_compile_expr(RDB_expression *exp, const RDB_type *tpltyp,
+        RDB_environment *envp, RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int i;
+    int idx;
+    RDB_cexpr *cxp = RDB_alloc(sizeof(RDB_cexpr), ecp);
+    if (cxp == NULL)
+        return NULL;
+
+    cxp->instrc = 0;
+    cxp->capacity = 8;
+    cxp->envp = txp != NULL ? txp->envp : envp;
+    cxp->instrv = RDB_alloc(sizeof(cx_instr) * cxp->capacity, ecp);
+    if (cxp->instrv == NULL) {
+        RDB_free(cxp);
+        return NULL;
+    }
+
+    if (compile_expr(cxp, exp, tpltyp, ecp, txp, &idx) != RDB_OK) {
+        RDB_del_cexpr(cxp, ecp);
+        return NULL;
+    }
+
+    /*
+     * The instructions no longer move, so the results of
+     * CX_CALL and CX_EVAL can be pointed to
+     */
+    for (i = 0; i < cxp->instrc; i++) {
+        if (cxp->instrv[i].kind == CX_CALL || cxp->instrv[i].kind == CX_EVAL)
+            cxp->instrv[i].valp = &cxp->instrv[i].val;
+    }
+    return cxp;
+}
+
+void
+RDB_del_cexpr(RDB_cexpr *cxp, RDB_exec_context *ecp)
+{
+    int i;
+
+    for (i = 0; i < cxp->instrc; i++) {
+        RDB_destroy_obj(&cxp->instrv[i].val, ecp);
+        RDB_free(cxp->instrv[i].argiv);
+        RDB_free(cxp->instrv[i].argpv);
+        RDB_free(cxp->instrv[i].argtv);
+    }
+    RDB_free(cxp->instrv);
+    RDB_free(cxp);
+}
+
+static void
+reset_val(cx_instr *ip, RDB_exec_context *ecp)
+{
+    RDB_destroy_obj(&ip->val, ecp);
+    RDB_init_obj(&ip->val);
+}
+
+/*
+ * Get the attribute from the tuple, or a table if there is no such
+ * attribute.
+ */
+static RDB_object *
+attr_obj(cx_instr *ip, RDB_object *tplp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    RDB_object *objp;
+    const char *name = ip->exp->def.varname;
+    RDB_tuple_heading *hdp = tplp->kind == RDB_OB_TUPLE ? tplp->val.tpl.hdp
+            : NULL;
+
+    if (hdp != NULL) {
+        /* Tuples read from a table usually have the same heading */
+        if (ip->slot != -1 && ip->slot < hdp->attrc
+                && strcmp(hdp->namev[ip->slot], name) == 0)
+            return RDB_tuple_slot(tplp, ip->slot);
+
+        ip->slot = RDB_tuple_heading_slot(hdp, name);
+        if (ip->slot != -1)
+            return RDB_tuple_slot(tplp, ip->slot);
+    }
+
+    objp = NULL;
+    if (txp != NULL) {
+        /* Try to get table */
+        objp = RDB_get_table(name, ecp, txp);
+    }
+    if (objp == NULL) {
+        RDB_raise_name(name, ecp);
+    }
+    return objp;
+}
+
+/*
+ * Check if results of the operator can be stored in an object
+ * which contains a previous result without destroying it first.
+ */
+static RDB_bool
+reusable_result(const cx_instr *ip)
+{
+    RDB_type *typ = ip->op->rtyp;
+
+    return (RDB_bool) (ip->val.kind != RDB_OB_INITIAL && ip->val.typ == typ
+            && (typ == &RDB_BOOLEAN || typ == &RDB_INTEGER
+                || typ == &RDB_FLOAT || typ == &RDB_STRING
+                || typ == &RDB_DATETIME));
+}
+
+/*
+ * Check if the operator found before can be used for the current arguments
+ */
+static RDB_bool
+op_matches(const cx_instr *ip)
+{
+    int i;
+
+    if (ip->op == NULL)
+        return RDB_FALSE;
+    for (i = 0; i < ip->argc; i++) {
+        if (ip->argpv[i]->typ != ip->argtv[i])
+            return RDB_FALSE;
+    }
+    return RDB_TRUE;
+}
+
+static int
+exec_call(RDB_cexpr *cxp, cx_instr *ip, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    int i;
+
+    for (i = 0; i < ip->argc; i++) {
+        ip->argpv[i] = cxp->instrv[ip->argiv[i]].valp;
+    }
+
+    if (!op_matches(ip)) {
+        ip->op = NULL;
+        reset_val(ip, ecp);
+
+        for (i = 0; i < ip->argc; i++) {
+            if (ip->argpv[i]->typ == NULL
+                    || !RDB_type_is_scalar(ip->argpv[i]->typ)) {
+                /* Not handled here, so do not store operator */
+                if (RDB_call_ro_op_by_name_e(ip->exp->def.op.name, ip->argc,
+                        ip->argpv, cxp->envp, ecp, txp, &ip->val) != RDB_OK) {
+                    reset_val(ip, ecp);
+                    return RDB_ERROR;
+                }
+                return RDB_OK;
+            }
+        }
+
+        ip->op = RDB_get_ro_op_by_args(ip->exp->def.op.name, ip->argc,
+                ip->argpv, cxp->envp, ecp, txp);
+        if (ip->op == NULL)
+            return RDB_ERROR;
+        for (i = 0; i < ip->argc; i++) {
+            ip->argtv[i] = ip->argpv[i]->typ;
+        }
+    } else if (!reusable_result(ip)) {
+        reset_val(ip, ecp);
+    }
+
+    /* Set return type to make it available to the function */
+    ip->val.typ = ip->op->rtyp;
+
+    if ((*ip->op->opfn.ro_fp)(ip->argc, ip->argpv, ip->op, ecp, txp,
+            &ip->val) != RDB_OK) {
+        reset_val(ip, ecp);
+        return RDB_ERROR;
+    }
+
+    /* Check type constraint if the operator is a selector */
+    if (ip->val.typ != NULL && RDB_is_selector(ip->op)) {
+        if (RDB_check_type_constraint(&ip->val, cxp->envp, ecp, txp)
+                != RDB_OK) {
+            reset_val(ip, ecp);
+            return RDB_ERROR;
+        }
+    }
+    return RDB_OK;
+}
+
+/**
+ * Evaluate the compiled expression for the tuple *tplp.
+ * On success, *valpp points to the result, which is managed by the compiled
+ * expression and remains valid until the compiled expression is evaluated
+ * again or deleted, or until *tplp is modified.
+ */
+int
+RDB_cexpr_evaluate(RDB_cexpr *cxp, RDB_object *tplp, RDB_exec_context *ecp,
+        RDB_transaction *txp, RDB_object **valpp)
+{
+    int i;
+    cx_instr *ip;
+
+    for (i = 0; i < cxp->instrc; i++) {
+        ip = &cxp->instrv[i];
+        switch (ip->kind) {
+        case CX_CONST:
+            break;
+        case CX_ATTR:
+            ip->valp = attr_obj(ip, tplp, ecp, txp);
+            if (ip->valp == NULL)
+                return RDB_ERROR;
+            break;
+        case CX_CALL:
+            if (exec_call(cxp, ip, ecp, txp) != RDB_OK)
+                return RDB_ERROR;
+            break;
+        case CX_EVAL:
+            reset_val(ip, ecp);
+            if (RDB_evaluate(ip->exp, &RDB_tpl_get, tplp, cxp->envp, ecp, txp,
+                    &ip->val) != RDB_OK)
+                return RDB_ERROR;
+            break;
+        }
+    }
+    *valpp = cxp->instrv[cxp->instrc - 1].valp;
+    return RDB_OK;
+}
+
+/**
+ * Evaluate the compiled expression for the tuple *tplp.
+ * The result must be boolean.
+ */
+int
+RDB_cexpr_evaluate_bool(RDB_cexpr *cxp, RDB_object *tplp,
+        RDB_exec_context *ecp, RDB_transaction *txp, RDB_bool *resp)
+{
+    RDB_object *valp;
+
+    if (RDB_cexpr_evaluate(cxp, tplp, ecp, txp, &valp) != RDB_OK)
+        return RDB_ERROR;
+    if (RDB_obj_type(valp) != &RDB_BOOLEAN) {
+        RDB_raise_type_mismatch("expression type must be boolean", ecp);
+        return RDB_ERROR;
+    }
+    *resp = valp->val.bool_val;
+    return RDB_OK;
+}
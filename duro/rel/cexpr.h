@@ -0,0 +1,36 @@
+/*
+ * Compiled expressions
+ *
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#ifndef CEXPR_H_
+#define CEXPR_H_
+
+#include <gen/types.h>
+
+typedef struct RDB_object RDB_object;
+typedef struct RDB_exec_context RDB_exec_context;
+typedef struct RDB_transaction RDB_transaction;
+typedef struct RDB_environment RDB_environment;
+typedef struct RDB_expression RDB_expression;
+typedef struct RDB_type RDB_type;
+typedef struct RDB_cexpr RDB_cexpr;
+
+RDB_cexpr *
+RDB_compile_expr(RDB_expression *, const RDB_type *, RDB_environment *,
+        RDB_exec_context *, RDB_transaction *);
+
+void
+RDB_del_cexpr(RDB_cexpr *, RDB_exec_context *);
+
+int
+RDB_cexpr_evaluate(RDB_cexpr *, RDB_object *, RDB_exec_context *,
+        RDB_transaction *, RDB_object **);
+
+int
+RDB_cexpr_evaluate_bool(RDB_cexpr *, RDB_object *, RDB_exec_context *,
+        RDB_transaction *, RDB_bool *);
+
+#endif /* CEXPR_H_ */
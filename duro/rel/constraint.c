@@ -41,6 +41,7 @@ optimize_constr_expr(RDB_expression *exp, RDB_exec_context *ecp)
         minusexp->nextp = NULL;
         RDB_free(exp->def.op.name);
         exp->def.op.name = isenamp;
+        RDB_expr_resolve_op(exp);
         exp->def.op.args.firstp = exp->def.op.args.lastp = minusexp;
     }
     return RDB_OK;
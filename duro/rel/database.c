@@ -20,12 +20,28 @@
 #include <ctype.h>
 #include <stdio.h>
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 /*
  * Marker object indicating that a previous search for a table has failed.
  * Must not be accessed.
  */
 static RDB_object null_tb;
 
+/*
+ * Number of committed catalog modifications in the process.
+ * It is shared by all environment handles, because the catalog
+ * may be modified using one handle while other handles have cached
+ * data derived from it.
+ */
+static unsigned long shared_cat_version = 0;
+
+#ifndef _WIN32
+static pthread_mutex_t shared_cat_version_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 /** @defgroup db Database functions
  * \#include <rel/rdb.h>
  * @{
@@ -249,6 +265,8 @@ close_systables(RDB_dbroot *dbrootp, RDB_exec_context *ecp)
     close_table(dbrootp->constraints_tbp, dbrootp->envp, ecp);
     close_table(dbrootp->version_info_tbp, dbrootp->envp, ecp);
     close_table(dbrootp->subtype_tbp, dbrootp->envp, ecp);
+    close_table(dbrootp->table_stats_tbp, dbrootp->envp, ecp);
+    close_table(dbrootp->attr_stats_tbp, dbrootp->envp, ecp);
 }
 
 static int
@@ -318,6 +336,7 @@ new_dbroot(RDB_environment *envp, RDB_exec_context *ecp)
     dbrootp->first_dbp = NULL;
     dbrootp->first_constrp = NULL;
     dbrootp->constraints_read = RDB_FALSE;
+    dbrootp->cat_version = 0;
 
     return dbrootp;
 }
@@ -393,6 +412,10 @@ assoc_systables(RDB_dbroot *dbrootp, RDB_database *dbp, RDB_exec_context *ecp)
         return RDB_ERROR;
     if (RDB_assoc_table_db(dbrootp->subtype_tbp, dbp, ecp) != RDB_OK)
         return RDB_ERROR;
+    if (RDB_assoc_table_db(dbrootp->table_stats_tbp, dbp, ecp) != RDB_OK)
+        return RDB_ERROR;
+    if (RDB_assoc_table_db(dbrootp->attr_stats_tbp, dbp, ecp) != RDB_OK)
+        return RDB_ERROR;
     return RDB_OK;
 }
 
@@ -1008,6 +1031,68 @@ cleanup:
     return RDB_ERROR;
 }
 
+/**
+ * Returns a number which is increased each time the catalog is modified,
+for example when a table, an index, a type or an operator
+is created or dropped. It is also increased when a transaction using
+*<var>envp</var> is rolled back, because table definitions are then read again
+from the catalog.
+
+Modifications of the catalog using other environment handles
+of the same process are taken into account when the transaction which
+made them has been committed.
+
+The catalog version can be used to invalidate data derived from the catalog,
+like optimized expressions.
+ */
+unsigned long
+RDB_catalog_version(RDB_environment *envp)
+{
+    unsigned long version;
+    RDB_dbroot *dbrootp = (RDB_dbroot *) RDB_env_xdata(envp);
+
+#ifndef _WIN32
+    pthread_mutex_lock(&shared_cat_version_mutex);
+#endif
+    version = shared_cat_version;
+#ifndef _WIN32
+    pthread_mutex_unlock(&shared_cat_version_mutex);
+#endif
+
+    return dbrootp != NULL ? version + dbrootp->cat_version : version;
+}
+
+/*
+ * Must be called before the persistent table *tbp is modified.
+ * If *tbp is a catalog table, the catalog version is increased
+ * and the transaction is marked as having modified the catalog.
+ */
+void
+RDB_catalog_write(RDB_object *tbp, RDB_transaction *txp)
+{
+    if (txp != NULL && txp->dbp != NULL && RDB_table_is_persistent(tbp)
+            && !RDB_table_is_user(tbp)) {
+        txp->dbp->dbrootp->cat_version++;
+        txp->cat_modified = RDB_TRUE;
+    }
+}
+
+/*
+ * Increase the catalog version of all environment handles.
+ * Called when a transaction which modified the catalog has been committed.
+ */
+void
+RDB_catalog_modified(void)
+{
+#ifndef _WIN32
+    pthread_mutex_lock(&shared_cat_version_mutex);
+#endif
+    shared_cat_version++;
+#ifndef _WIN32
+    pthread_mutex_unlock(&shared_cat_version_mutex);
+#endif
+}
+
 /*@}*/
 
 /**
@@ -1980,6 +2065,9 @@ RDB_set_user_tables_check(RDB_database *dbp, RDB_exec_context *ecp)
     RDB_hashmap_iter it;
     void *datap;
 
+    /* Invalidates table information derived from the catalog */
+    dbp->dbrootp->cat_version++;
+
     /* Public tables */
 
     RDB_init_hashmap_iter(&it, &dbp->dbrootp->ptbmap);
@@ -19,6 +19,23 @@
 #include <string.h>
 #include <stdio.h>
 
+/*
+ * Adjust the estimated cardinality of *tbp after rcount tuples
+ * have been deleted.
+ */
+static void
+deleted(RDB_object *tbp, RDB_int rcount)
+{
+    RDB_stored_table *stp = tbp->val.tbp->stp;
+
+    if (rcount <= 0)
+        return;
+    if (stp->est_cardinality > (unsigned) rcount)
+        stp->est_cardinality -= (unsigned) rcount;
+    else
+        stp->est_cardinality = 0;
+}
+
 static RDB_int
 delete_by_uindex(RDB_object *tbp, RDB_object *objpv[], RDB_tbindex *indexp,
         RDB_exec_context *ecp, RDB_transaction *txp)
@@ -54,6 +71,7 @@ delete_by_uindex(RDB_object *tbp, RDB_object *objpv[], RDB_tbindex *indexp,
     }
     if (ret == RDB_OK) {
         rcount = 1;
+        deleted(tbp, rcount);
     } else {
         if (RDB_obj_type(RDB_get_err(ecp)) == &RDB_NOT_FOUND_ERROR) {
             rcount = 0;
@@ -122,6 +140,8 @@ RDB_delete_nonvirtual(RDB_object *tbp, RDB_expression *condp,
     RDB_bool b;
     RDB_type *tpltyp = tbp->typ->def.basetyp;
 
+    RDB_catalog_write(tbp, txp);
+
     if (tbp->val.tbp->stp == NULL) {
         /*
          * The stored table may have been created by another process,
@@ -152,6 +172,7 @@ RDB_delete_nonvirtual(RDB_object *tbp, RDB_expression *condp,
             cnt = sql_delete(tbp, repcondp, ecp, txp);
             if (repcondp != NULL)
                 RDB_del_expr(repcondp, ecp);
+            deleted(tbp, cnt);
             return cnt;
         }
         if (repcondp != NULL)
@@ -234,6 +255,7 @@ RDB_delete_nonvirtual(RDB_object *tbp, RDB_expression *condp,
         curp = NULL;
         goto error;
     }
+    deleted(tbp, rcount);
     return rcount;
 
 error:
@@ -270,7 +292,7 @@ delete_where_uindex(RDB_expression *texp, RDB_expression *condp,
          */
         if (RDB_get_by_uindex(refexp->def.tbref.tbp,
                 texp->def.op.optinfo.objpv, refexp->def.tbref.indexp,
-                refexp->def.tbref.tbp->typ->def.basetyp, ecp, txp, &tpl)
+                refexp->def.tbref.tbp->typ->def.basetyp, NULL, ecp, txp, &tpl)
                     != RDB_OK) {
             RDB_destroy_obj(&tpl, ecp);
             rcount = RDB_ERROR;
@@ -449,6 +471,7 @@ cleanup:
             rcount = RDB_ERROR;
         }
     }
+    deleted(refexp->def.tbref.tbp, rcount);
     RDB_free(fv);
     return rcount;
 }
@@ -467,6 +490,8 @@ RDB_delete_where_index(RDB_expression *texp, RDB_expression *condp,
         refexp = texp->def.op.args.firstp->def.op.args.firstp;
     }
 
+    RDB_catalog_write(refexp->def.tbref.tbp, txp);
+
     if (refexp->def.tbref.indexp->unique) {
         return delete_where_uindex(texp, condp, getfn, getarg, ecp, txp);
     }
@@ -534,6 +559,8 @@ RDB_delete_nonvirtual_tuple(RDB_object *tbp, RDB_object *tplp, int flags, RDB_ex
     RDB_bool contains;
     RDB_object **objpv;
 
+    RDB_catalog_write(tbp, txp);
+
     if (tbp->val.tbp->stp == NULL) {
         if (RDB_provide_stored_table(tbp, RDB_FALSE, ecp, txp) != RDB_OK) {
             return RDB_ERROR;
@@ -554,7 +581,10 @@ RDB_delete_nonvirtual_tuple(RDB_object *tbp, RDB_object *tplp, int flags, RDB_ex
         if (ret == RDB_ERROR && RDB_obj_type(RDB_get_err(ecp)) == &RDB_NOT_FOUND_ERROR) {
             return (RDB_INCLUDED & flags) != 0 ? (RDB_int) RDB_ERROR : 1;
         }
-        return ret == RDB_ERROR ? (RDB_int) RDB_ERROR : 1;
+        if (ret == RDB_ERROR)
+            return (RDB_int) RDB_ERROR;
+        deleted(tbp, 1);
+        return 1;
     }
 
     /* Check if the table contains the tuple */
@@ -90,6 +90,10 @@ evaluate_is_empty(RDB_expression *exp, RDB_getobjfn *getfnp, void *getdata,
         goto error;
     }
 
+    /* The attribute values are not needed */
+    if (RDB_set_needed_attrs(qrp, 0, NULL, ecp, txp) != RDB_OK)
+        goto error;
+
     /*
      * Read first tuple
      */
@@ -145,6 +149,15 @@ evaluate_count(RDB_expression *exp, RDB_getobjfn *getfnp, void *getdata,
         return RDB_ERROR;
     }
 
+    /*
+     * The attribute values are not needed,
+     * unless they are required for removing duplicates
+     */
+    if (RDB_set_needed_attrs(qrp, 0, NULL, ecp, txp) != RDB_OK) {
+        RDB_del_qresult(qrp, ecp, txp);
+        return RDB_ERROR;
+    }
+
     RDB_init_obj(&tpl);
 
     count = 0;
@@ -434,7 +447,7 @@ evaluate_ro_op(RDB_expression *exp, RDB_getobjfn *getfnp, void *getdata,
     }
 
     /* Transform UPDATE */
-    if (strcmp(exp->def.op.name, "update") == 0) {
+    if (exp->def.op.code == RDB_OP_UPDATE) {
         if (RDB_convert_update(exp, getfnp != NULL ? get_type : NULL,
                 getfnp != NULL ? &gtinfo : NULL, ecp, txp) != RDB_OK)
             return RDB_ERROR;
@@ -445,7 +458,7 @@ evaluate_ro_op(RDB_expression *exp, RDB_getobjfn *getfnp, void *getdata,
      * and calling an operator function, so they get special treatment
      */
 
-    if (strcmp(exp->def.op.name, "extend") == 0) {
+    if (exp->def.op.code == RDB_OP_EXTEND) {
         RDB_type *typ = RDB_expr_type(exp->def.op.args.firstp,
                 getfnp != NULL ? get_type : NULL, getfnp != NULL ? &gtinfo : NULL,
                 envp, ecp, txp);
@@ -459,8 +472,8 @@ evaluate_ro_op(RDB_expression *exp, RDB_getobjfn *getfnp, void *getdata,
         }
     }
 
-    if (strcmp(exp->def.op.name, "where") == 0
-            || strcmp(exp->def.op.name, "summarize") == 0) {
+    if (exp->def.op.code == RDB_OP_WHERE
+            || exp->def.op.code == RDB_OP_SUMMARIZE) {
         return evaluate_vt(exp, getfnp, getdata, ecp, txp, valp);
     }
 
@@ -471,7 +484,7 @@ evaluate_ro_op(RDB_expression *exp, RDB_getobjfn *getfnp, void *getdata,
      * First check if there are 2 arguments and the second is a variable name
      */
     if (argc == 1 || argc == 2) {
-        if (strcmp(exp->def.op.name, "sum") == 0) {
+        if (exp->def.op.code == RDB_OP_SUM) {
             RDB_init_obj(&tb);
 
             if (RDB_evaluate(exp->def.op.args.firstp, getfnp, getdata, envp,
@@ -484,7 +497,7 @@ evaluate_ro_op(RDB_expression *exp, RDB_getobjfn *getfnp, void *getdata,
             RDB_destroy_obj(&tb, ecp);
             return ret;
         }
-        if (strcmp(exp->def.op.name, "avg") == 0) {
+        if (exp->def.op.code == RDB_OP_AVG) {
             RDB_float res;
 
             RDB_init_obj(&tb);
@@ -499,7 +512,7 @@ evaluate_ro_op(RDB_expression *exp, RDB_getobjfn *getfnp, void *getdata,
             }
             return ret;
         }
-        if (strcmp(exp->def.op.name, "min") == 0) {
+        if (exp->def.op.code == RDB_OP_MIN) {
             RDB_init_obj(&tb);
             if (RDB_evaluate(exp->def.op.args.firstp, getfnp, getdata, envp,
                     ecp, txp, &tb) != RDB_OK) {
@@ -511,7 +524,7 @@ evaluate_ro_op(RDB_expression *exp, RDB_getobjfn *getfnp, void *getdata,
             RDB_destroy_obj(&tb, ecp);
             return ret;
         }
-        if (strcmp(exp->def.op.name, "max") == 0) {
+        if (exp->def.op.code == RDB_OP_MAX) {
             RDB_init_obj(&tb);
             if (RDB_evaluate(exp->def.op.args.firstp, getfnp, getdata, envp, ecp,
                     txp, &tb) != RDB_OK) {
@@ -522,7 +535,7 @@ evaluate_ro_op(RDB_expression *exp, RDB_getobjfn *getfnp, void *getdata,
             RDB_destroy_obj(&tb, ecp);
             return ret;
         }
-        if (strcmp(exp->def.op.name, "all") == 0) {
+        if (exp->def.op.code == RDB_OP_ALL) {
             RDB_bool res;
 
             RDB_init_obj(&tb);
@@ -538,7 +551,7 @@ evaluate_ro_op(RDB_expression *exp, RDB_getobjfn *getfnp, void *getdata,
             }
             return ret;
         }
-        if (strcmp(exp->def.op.name, "any") == 0) {
+        if (exp->def.op.code == RDB_OP_ANY) {
             RDB_bool res;
 
             RDB_init_obj(&tb);
@@ -554,7 +567,7 @@ evaluate_ro_op(RDB_expression *exp, RDB_getobjfn *getfnp, void *getdata,
             }
             return ret;
         }
-        if (strcmp(exp->def.op.name, ".") == 0) {
+        if (exp->def.op.code == RDB_OP_DOT) {
             int ret;
             RDB_object obj;
             RDB_object *attrp;
@@ -623,18 +636,18 @@ evaluate_ro_op(RDB_expression *exp, RDB_getobjfn *getfnp, void *getdata,
     }
 
     if (argc == 1) {
-        if (strcmp(exp->def.op.name, "is_empty") == 0) {
+        if (exp->def.op.code == RDB_OP_IS_EMPTY) {
             return evaluate_is_empty(exp, getfnp, getdata, envp,
                     ecp, txp, valp);
         }
-        if (strcmp(exp->def.op.name, "count") == 0) {
+        if (exp->def.op.code == RDB_OP_COUNT) {
             return evaluate_count(exp, getfnp, getdata, envp,
                     ecp, txp, valp);
         }
     }
 
     /* If-then-else is already handled here so args #2 and #3 can be evaluated lazily */
-    if (argc == 3 && strcmp(exp->def.op.name, "if") == 0) {
+    if (argc == 3 && exp->def.op.code == RDB_OP_IF) {
         return evaluate_if(exp, getfnp, getdata, envp, ecp, txp, valp);
     }
 
@@ -12,21 +12,14 @@
 
 #include <string.h>
 
-int
-RDB_insert_nonvirtual(RDB_object *tbp, const RDB_object *tplp,
-                 RDB_exec_context *ecp, RDB_transaction *txp)
+/*
+ * If the tuple has type information, check if all attributes are present in the
+ * destination table
+ */
+static int
+check_tuple_attrs(RDB_type *tuptyp, const RDB_object *tplp,
+        RDB_exec_context *ecp)
 {
-    int i;
-    int ret;
-    RDB_field *fvp;
-    RDB_type *tuptyp = tbp->typ->def.basetyp;
-    int attrcount = tuptyp->def.tuple.attrc;
-    RDB_object serial_val;
-
-    /*
-     * If the tuple has type information, check if all attributes are present in the
-     * destination table
-     */
     if (tplp->typ != NULL) {
         int i;
         int attrc;
@@ -42,21 +35,23 @@ RDB_insert_nonvirtual(RDB_object *tbp, const RDB_object *tplp,
             }
         }
     }
+    return RDB_OK;
+}
 
-    if (tbp->val.tbp->stp == NULL) {
-        /* Create physical table */
-        if (RDB_provide_stored_table(tbp, RDB_TRUE, ecp, txp) != RDB_OK) {
-            return RDB_ERROR;
-        }
-    }
-
-    RDB_init_obj(&serial_val);
+/*
+ * Convert the tuple *tplp to the fields of a record of the stored table
+ * of *tbp.
+ * A value obtained from a sequence is stored in *serial_valp.
+ */
+static int
+tuple_to_fields(RDB_object *tbp, const RDB_object *tplp, RDB_field *fvp,
+        RDB_object *serial_valp, RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int i;
+    int ret;
+    RDB_type *tuptyp = tbp->typ->def.basetyp;
+    int attrcount = tuptyp->def.tuple.attrc;
 
-    fvp = RDB_alloc(sizeof(RDB_field) * attrcount, ecp);
-    if (fvp == NULL) {
-        ret = RDB_ERROR;
-        goto cleanup;
-    }
     for (i = 0; i < attrcount; i++) {
         RDB_int nextval;
         int *fnop = RDB_field_no(tbp->val.tbp->stp, tuptyp->def.tuple.attrv[i].name);
@@ -73,16 +68,14 @@ RDB_insert_nonvirtual(RDB_object *tbp, const RDB_object *tplp,
         if (valp == NULL) {
             if (dflp == NULL) {
                 RDB_raise_invalid_argument("missing value", ecp);
-                ret = RDB_ERROR;
-                goto cleanup;
+                return RDB_ERROR;
             }
             if (RDB_expr_is_serial(dflp->exp)) {
                 /* With PostgreSQL, the default value is generated by PostgreSQL */
                 if (txp == NULL || !RDB_env_queries(txp->envp)) {
                     if (!RDB_table_is_persistent(tbp)) {
                         RDB_raise_internal("serial() not supported for local tables", ecp);
-                        ret = RDB_ERROR;
-                        goto cleanup;
+                        return RDB_ERROR;
                     }
                     if (dflp->seqp == NULL) {
                         RDB_object seqname;
@@ -92,8 +85,7 @@ RDB_insert_nonvirtual(RDB_object *tbp, const RDB_object *tplp,
                                 tuptyp->def.tuple.attrv[i].name, &seqname,
                                 ecp) != RDB_OK) {
                             RDB_destroy_obj(&seqname, ecp);
-                            ret = RDB_ERROR;
-                            goto cleanup;
+                            return RDB_ERROR;
                         }
 
                         dflp->seqp = RDB_open_sequence(RDB_obj_string(&seqname),
@@ -101,33 +93,29 @@ RDB_insert_nonvirtual(RDB_object *tbp, const RDB_object *tplp,
                         if (dflp->seqp == NULL) {
                             RDB_destroy_obj(&seqname, ecp);
                             RDB_handle_err(ecp, txp);
-                            ret = RDB_ERROR;
-                            goto cleanup;
+                            return RDB_ERROR;
                         }
                         RDB_destroy_obj(&seqname, ecp);
                     }
                     ret = RDB_sequence_next(dflp->seqp, txp->tx, &nextval, ecp);
                     if (ret != 0) {
                         RDB_handle_err(ecp, txp);
-                        ret = RDB_ERROR;
-                        goto cleanup;
+                        return RDB_ERROR;
                     }
-                    RDB_int_to_obj(&serial_val, nextval);
-                    valp = &serial_val;
+                    RDB_int_to_obj(serial_valp, nextval);
+                    valp = serial_valp;
                 }
             } else {
                 valp = RDB_expr_obj(dflp->exp);
                 if (valp == NULL) {
                     RDB_raise_internal("invalid default value", ecp);
-                    ret = RDB_ERROR;
-                    goto cleanup;
+                    return RDB_ERROR;
                 }
             }
         } else {
             if (dflp != NULL && RDB_expr_is_serial(dflp->exp)) {
                 RDB_raise_invalid_argument("explicit value not permitted", ecp);
-                ret = RDB_ERROR;
-                goto cleanup;
+                return RDB_ERROR;
             }
         }
 
@@ -137,19 +125,52 @@ RDB_insert_nonvirtual(RDB_object *tbp, const RDB_object *tplp,
                 RDB_raise_type_mismatch(
                         "tuple attribute type does not match table attribute type",
                         ecp);
-                ret = RDB_ERROR;
-                goto cleanup;
+                return RDB_ERROR;
             }
 
             /* Set type information for storage */
             valp->store_typ = attrtyp;
 
-            ret = RDB_obj_to_field(&fvp[*fnop], valp, ecp);
-            if (ret != RDB_OK) {
-                goto cleanup;
+            if (RDB_obj_to_field(&fvp[*fnop], valp, ecp) != RDB_OK) {
+                return RDB_ERROR;
             }
         }
     }
+    return RDB_OK;
+}
+
+int
+RDB_insert_nonvirtual(RDB_object *tbp, const RDB_object *tplp,
+                 RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int ret;
+    RDB_field *fvp;
+    RDB_type *tuptyp = tbp->typ->def.basetyp;
+    int attrcount = tuptyp->def.tuple.attrc;
+    RDB_object serial_val;
+
+    if (check_tuple_attrs(tuptyp, tplp, ecp) != RDB_OK)
+        return RDB_ERROR;
+
+    RDB_catalog_write(tbp, txp);
+
+    if (tbp->val.tbp->stp == NULL) {
+        /* Create physical table */
+        if (RDB_provide_stored_table(tbp, RDB_TRUE, ecp, txp) != RDB_OK) {
+            return RDB_ERROR;
+        }
+    }
+
+    RDB_init_obj(&serial_val);
+
+    fvp = RDB_alloc(sizeof(RDB_field) * attrcount, ecp);
+    if (fvp == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    ret = tuple_to_fields(tbp, tplp, fvp, &serial_val, ecp, txp);
+    if (ret != RDB_OK)
+        goto cleanup;
 
     RDB_cmp_ecp = ecp;
     ret = RDB_insert_rec(tbp->val.tbp->stp->recmapp, fvp,
@@ -176,3 +197,89 @@ cleanup:
     RDB_free(fvp);
     return ret;
 }
+
+/*
+ * Check if tuples can be inserted into the real table *tbp
+ * using RDB_insert_nonvirtual_bulk().
+ */
+RDB_bool
+RDB_bulk_insert_supported(RDB_object *tbp)
+{
+    return (RDB_bool) (RDB_table_is_persistent(tbp)
+            && tbp->val.tbp->stp != NULL
+            && RDB_recmap_bulk_insert(tbp->val.tbp->stp->recmapp));
+}
+
+/*
+ * Insert the tuples tplv[0] .. tplv[tplc - 1] into the real table *tbp
+ * using a single bulk operation of the record layer.
+ * Either all tuples are inserted or none.
+ * If a tuple is already in the table or violates a key constraint,
+ * RDB_KEY_VIOLATION_ERROR is raised.
+ * Must only be called if RDB_bulk_insert_supported() returns RDB_TRUE.
+ */
+int
+RDB_insert_nonvirtual_bulk(RDB_object *tbp, int tplc, RDB_object tplv[],
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int i;
+    int ret;
+    RDB_type *tuptyp = tbp->typ->def.basetyp;
+    int attrcount = tuptyp->def.tuple.attrc;
+    RDB_field *fieldv;
+    RDB_field **recv = NULL;
+    RDB_object *serial_valv = NULL;
+
+    RDB_catalog_write(tbp, txp);
+
+    fieldv = RDB_alloc(sizeof(RDB_field) * attrcount * tplc, ecp);
+    if (fieldv == NULL)
+        return RDB_ERROR;
+    recv = RDB_alloc(sizeof(RDB_field *) * tplc, ecp);
+    if (recv == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    serial_valv = RDB_alloc(sizeof(RDB_object) * tplc, ecp);
+    if (serial_valv == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    for (i = 0; i < tplc; i++) {
+        RDB_init_obj(&serial_valv[i]);
+    }
+
+    for (i = 0; i < tplc; i++) {
+        if (check_tuple_attrs(tuptyp, &tplv[i], ecp) != RDB_OK) {
+            ret = RDB_ERROR;
+            goto cleanup;
+        }
+        recv[i] = fieldv + i * attrcount;
+        if (tuple_to_fields(tbp, &tplv[i], recv[i], &serial_valv[i], ecp,
+                txp) != RDB_OK) {
+            ret = RDB_ERROR;
+            goto cleanup;
+        }
+    }
+
+    RDB_cmp_ecp = ecp;
+    ret = RDB_insert_recs(tbp->val.tbp->stp->recmapp, tplc, recv, txp->tx,
+            ecp);
+    if (ret != RDB_OK) {
+        if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_KEY_VIOLATION_ERROR)
+            RDB_handle_err(ecp, txp);
+        goto cleanup;
+    }
+    tbp->val.tbp->stp->est_cardinality += tplc;
+
+cleanup:
+    if (serial_valv != NULL) {
+        for (i = 0; i < tplc; i++) {
+            RDB_destroy_obj(&serial_valv[i], ecp);
+        }
+        RDB_free(serial_valv);
+    }
+    RDB_free(recv);
+    RDB_free(fieldv);
+    return ret;
+}
@@ -5,9 +5,11 @@
  * Copyright (C) 2006, 2012 Rene Hartmann.
  * See the file COPYING for redistribution information.
  * 
- * Declares an internal function for inserting tuples into tables.
+ * Declares internal functions for inserting tuples into tables.
  */
 
+#include <gen/types.h>
+
 typedef struct RDB_object RDB_object;
 typedef struct RDB_exec_context RDB_exec_context;
 typedef struct RDB_transaction RDB_transaction;
@@ -16,4 +18,11 @@ int
 RDB_insert_nonvirtual(RDB_object *tbp, const RDB_object *tplp, RDB_exec_context *,
         RDB_transaction *);
 
+RDB_bool
+RDB_bulk_insert_supported(RDB_object *);
+
+int
+RDB_insert_nonvirtual_bulk(RDB_object *, int, RDB_object *, RDB_exec_context *,
+        RDB_transaction *);
+
 #endif /*INSERT_H*/
@@ -91,6 +91,16 @@ typedef struct RDB_dbroot {
     RDB_object *constraints_tbp;
     RDB_object *version_info_tbp;
     RDB_object *subtype_tbp;
+
+    /** Table and attribute statistics */
+    RDB_object *table_stats_tbp;
+    RDB_object *attr_stats_tbp;
+
+    /*
+     * Increased when the catalog is modified or when cached tables
+     * become invalid, see RDB_catalog_version()
+     */
+    unsigned long cat_version;
 } RDB_dbroot;
 
 typedef struct RDB_table {
@@ -140,8 +150,18 @@ struct RDB_tuple_and_getfn {
 
 extern RDB_hashmap RDB_builtin_type_map;
 
-/* Used to pass the execution context (not MT-safe!) */
-extern RDB_exec_context *RDB_cmp_ecp;
+#ifdef _MSC_VER
+#define RDB_THREAD_LOCAL __declspec(thread)
+#else
+#define RDB_THREAD_LOCAL __thread
+#endif
+
+/*
+ * Used to pass the execution context to comparison functions.
+ * Thread-local so different threads can access the record layer
+ * at the same time.
+ */
+extern RDB_THREAD_LOCAL RDB_exec_context *RDB_cmp_ecp;
 
 extern RDB_op_map RDB_builtin_ro_op_map;
 extern RDB_op_map RDB_builtin_upd_op_map;
@@ -194,6 +214,12 @@ RDB_close_user_tables(RDB_database *, RDB_exec_context *);
 int
 RDB_set_user_tables_check(RDB_database *, RDB_exec_context *);
 
+void
+RDB_catalog_write(RDB_object *, RDB_transaction *);
+
+void
+RDB_catalog_modified(void);
+
 int
 RDB_check_table(RDB_object *, RDB_exec_context *, RDB_transaction *);
 
@@ -218,6 +218,18 @@ append_obj_json(RDB_object *strobjp, const RDB_object *objp, RDB_exec_context *e
     return RDB_ERROR;
 }
 
+/**
+ * Appends the JSON representation of a RDB_object to the string *strobjp.
+ * Tables are not supported.
+ * Can be used to convert large amounts of data piece by piece.
+ */
+int
+RDB_append_json(RDB_object *strobjp, const RDB_object *objp,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    return append_obj_json(strobjp, objp, ecp, txp);
+}
+
 /**
  * Converts a RDB_object to JSON. Tables are not supported.
  */
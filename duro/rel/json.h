@@ -15,4 +15,7 @@ typedef struct RDB_transaction RDB_transaction;
 int
 RDB_obj_to_json(RDB_object *, const RDB_object *, RDB_exec_context *, RDB_transaction *);
 
+int
+RDB_append_json(RDB_object *, const RDB_object *, RDB_exec_context *, RDB_transaction *);
+
 #endif /* RDB_JSON_H_ */
@@ -147,8 +147,8 @@ stored_matching_uindex(RDB_object *tbp, const RDB_object *tplp, RDB_tbindex *ind
                 indexp->attrv[i].attrname);
     }
     RDB_init_obj(&tpl);
-    ret = RDB_get_by_uindex(tbp, objpv, indexp, tbp->typ->def.basetyp, ecp,
-            txp, &tpl);
+    ret = RDB_get_by_uindex(tbp, objpv, indexp, tbp->typ->def.basetyp, NULL,
+            ecp, txp, &tpl);
     if (ret == RDB_ERROR) {
         if (RDB_obj_type(RDB_get_err(ecp)) == &RDB_NOT_FOUND_ERROR) {
             RDB_clear_err(ecp);
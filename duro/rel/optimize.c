@@ -8,6 +8,7 @@
 #include "internal.h"
 #include "stable.h"
 #include "tostr.h"
+#include "qr_join.h"
 #include <obj/objinternal.h>
 #include <gen/strfns.h>
 
@@ -55,6 +56,7 @@ alter_op(RDB_expression *exp, const char *name, RDB_exec_context *ecp)
     }
     strcpy(newname, name);
     exp->def.op.name = newname;
+    RDB_expr_resolve_op(exp);
 
     return RDB_OK;
 }
@@ -690,6 +692,71 @@ table_can_use_index(const RDB_expression *exp, RDB_bool *childp)
 static unsigned
 table_cost(const RDB_expression *);
 
+/*
+ * If the argument of the WHERE expression *exp is a stored table
+ * or a projection of a stored table, return the stored table,
+ * otherwise NULL.
+ */
+static RDB_stored_table *
+where_stored_table(const RDB_expression *exp)
+{
+    const RDB_expression *argp = exp->def.op.args.firstp;
+
+    if (RDB_expr_is_op(argp, "project"))
+        argp = argp->def.op.args.firstp;
+    if (argp->kind == RDB_EX_TBP)
+        return argp->def.tbref.tbp->val.tbp->stp;
+    return NULL;
+}
+
+/*
+ * Estimate how many of card tuples of the stored table *stp
+ * satisfy the condition *condp. Only terms of the form <attribute> = <value>
+ * are taken into account, using the estimated numbers of distinct
+ * attribute values.
+ */
+static unsigned
+eq_est_cardinality(RDB_stored_table *stp, const RDB_expression *condp,
+        unsigned card)
+{
+    unsigned distinct;
+
+    if (RDB_expr_is_binop(condp, "and")) {
+        card = eq_est_cardinality(stp, condp->def.op.args.firstp, card);
+        return eq_est_cardinality(stp, condp->def.op.args.firstp->nextp, card);
+    }
+    if (RDB_expr_is_binop(condp, "=")
+            && condp->def.op.args.firstp->kind == RDB_EX_VAR
+            && condp->def.op.args.firstp->nextp->kind == RDB_EX_OBJ) {
+        distinct = RDB_est_distinct(stp, condp->def.op.args.firstp->def.varname);
+        if (distinct > 0)
+            return (card + distinct - 1) / distinct;
+    }
+    return card;
+}
+
+/*
+ * Return the estimated number of tuples of the stored table *stp
+ * per value of the non-unique index *indexp, or 0 if it is not known.
+ */
+static unsigned
+index_est_tuples(RDB_stored_table *stp, const RDB_tbindex *indexp)
+{
+    int i;
+    unsigned distinct;
+    unsigned card = stp->est_cardinality;
+
+    if (stp->est_distinctv == NULL)
+        return 0;
+    for (i = 0; i < indexp->attrc; i++) {
+        distinct = RDB_est_distinct(stp, indexp->attrv[i].attrname);
+        if (distinct == 0)
+            return 0;
+        card = (card + distinct - 1) / distinct;
+    }
+    return card > 0 ? card : 1;
+}
+
 static unsigned
 table_est_cardinality(const RDB_expression *exp)
 {
@@ -709,9 +776,19 @@ table_est_cardinality(const RDB_expression *exp)
     }
 
     if (RDB_expr_is_binop(exp, "where")) {
+        RDB_stored_table *stp = where_stored_table(exp);
+
+        /* Use the statistics, if available */
+        if (stp != NULL && stp->est_distinctv != NULL) {
+            unsigned card = table_est_cardinality(exp->def.op.args.firstp);
+            unsigned eqcard = eq_est_cardinality(stp,
+                    exp->def.op.args.firstp->nextp, card);
+            if (eqcard < card)
+                return eqcard;
+        }
+
         /*
-         * Keeping track of the selectivity is not supported yet,
-         * so simply divide the estimated cost by half
+         * Otherwise simply divide the estimated cost by half
          */
         return (table_cost(exp) + 1) / 2;
     }
@@ -722,6 +799,7 @@ static unsigned
 table_cost(const RDB_expression *exp)
 {
     RDB_tbindex *indexp;
+    const RDB_expression *tbexp;
     RDB_bool child;
 
     if (exp->kind != RDB_EX_RO_OP)
@@ -758,10 +836,11 @@ table_cost(const RDB_expression *exp)
         if (exp->def.op.optinfo.objc == 0 && exp->def.op.optinfo.stopexp == NULL)
             return table_cost(exp->def.op.args.firstp);
         if (exp->def.op.args.firstp->kind == RDB_EX_TBP) {
-            indexp = exp->def.op.args.firstp->def.tbref.indexp;
+            tbexp = exp->def.op.args.firstp;
         } else {
-            indexp = exp->def.op.args.firstp->def.op.args.firstp->def.tbref.indexp;
+            tbexp = exp->def.op.args.firstp->def.op.args.firstp;
         }
+        indexp = tbexp->def.tbref.indexp;
         if (indexp == NULL) {
             return table_cost(exp->def.op.args.firstp);
         }
@@ -769,18 +848,60 @@ table_cost(const RDB_expression *exp)
             return 1;
         if (indexp->unique)
             return 2;
+        if (exp->def.op.optinfo.all_eq
+                && exp->def.op.optinfo.objc == indexp->attrc) {
+            /*
+             * If the number of tuples per index value is known,
+             * add it to the cost
+             */
+            unsigned ntuples = index_est_tuples(
+                    tbexp->def.tbref.tbp->val.tbp->stp, indexp);
+            if (ntuples > 0)
+                return (indexp->ordered ? 3 : 2) + ntuples;
+        }
         if (!indexp->ordered)
             return 3;
         return 4;
     }
     if (RDB_expr_is_binop(exp, "join")) {
+        if (exp->def.op.optinfo.join_method == RDB_JOIN_HASH) {
+            /*
+             * Both tables are read once, but the tuples of the 2nd table
+             * have to be hashed and kept in memory
+             */
+            return table_cost(exp->def.op.args.firstp)
+                    + table_cost(exp->def.op.args.firstp->nextp) * 4;
+        }
+        if (exp->def.op.optinfo.join_method == RDB_JOIN_MERGE) {
+            /*
+             * Both tables are read once in index order, which is cheaper
+             * than looking up each tuple of the 1st table in the index.
+             * If the 1st table is not sorted by an index, it must be sorted first.
+             */
+            unsigned cost = table_cost(exp->def.op.args.firstp)
+                    + table_cost(exp->def.op.args.firstp->nextp) / 2;
+            if (!RDB_merge_join_sorted((RDB_expression *) exp))
+                cost += table_cost(exp->def.op.args.firstp);
+            return cost;
+        }
         if (exp->def.op.args.firstp->nextp->kind == RDB_EX_TBP
                 && exp->def.op.args.firstp->nextp->def.tbref.indexp != NULL) {
+            unsigned ntuples;
+
             indexp = exp->def.op.args.firstp->nextp->def.tbref.indexp;
             if (indexp->idxp == NULL)
                 return table_cost(exp->def.op.args.firstp);
             if (indexp->unique)
                 return table_cost(exp->def.op.args.firstp) * 2;
+
+            /* Use the number of tuples per index value, if it is known */
+            ntuples = index_est_tuples(
+                    exp->def.op.args.firstp->nextp->def.tbref.tbp->val.tbp->stp,
+                    indexp);
+            if (ntuples > 0) {
+                return table_cost(exp->def.op.args.firstp)
+                        * ((indexp->ordered ? 3 : 2) + ntuples);
+            }
             if (!indexp->ordered)
                 return table_cost(exp->def.op.args.firstp) * 3;
             return table_cost(exp->def.op.args.firstp) * 4;
@@ -1096,6 +1217,7 @@ mutate_vt(RDB_expression *texp, int nargc, RDB_expression **tbpv, int cap,
             RDB_expression *nexp = RDB_ro_op(texp->def.op.name, ecp);
             if (nexp == NULL)
                 return RDB_ERROR;
+            nexp->def.op.optinfo.join_method = texp->def.op.optinfo.join_method;
 
             argp2 = texp->def.op.args.firstp;
             for (k = 0; k < argc; k++) {
@@ -1712,25 +1834,174 @@ index_joins(RDB_expression *otexp, RDB_expression *itexp,
     return tbc;
 }
 
+/*
+ * Create hash join versions of *texp, one for each order of the arguments
+ */
+static int
+hash_joins(RDB_expression *texp, RDB_expression **tbpv, int cap,
+        RDB_exec_context *ecp)
+{
+    int i;
+    int tbc = 0;
+
+    if (texp->def.op.optinfo.join_method == RDB_JOIN_HASH)
+        return 0;
+
+    for (i = 0; i < 2 && tbc < cap; i++) {
+        RDB_expression *arg1p, *arg2p;
+        RDB_expression *ntexp = RDB_ro_op("join", ecp);
+        if (ntexp == NULL)
+            return RDB_ERROR;
+
+        arg1p = RDB_dup_expr(i == 0 ? texp->def.op.args.firstp
+                : texp->def.op.args.firstp->nextp, ecp);
+        if (arg1p == NULL) {
+            RDB_del_expr(ntexp, ecp);
+            return RDB_ERROR;
+        }
+        RDB_add_arg(ntexp, arg1p);
+
+        arg2p = RDB_dup_expr(i == 0 ? texp->def.op.args.firstp->nextp
+                : texp->def.op.args.firstp, ecp);
+        if (arg2p == NULL) {
+            RDB_del_expr(ntexp, ecp);
+            return RDB_ERROR;
+        }
+        RDB_add_arg(ntexp, arg2p);
+
+        ntexp->def.op.optinfo.join_method = RDB_JOIN_HASH;
+        tbpv[tbc++] = ntexp;
+    }
+    return tbc;
+}
+
+/*
+ * Create merge join versions of *texp, using the ordered indexes
+ * of the argument tables over the common attributes
+ */
+static int
+merge_joins(RDB_expression *texp, RDB_expression **tbpv, int cap,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int i, j, k;
+    int tbc = 0;
+
+    if (texp->def.op.optinfo.join_method != RDB_JOIN_NESTED_LOOP)
+        return 0;
+
+    /* Let the DBMS evaluate the JOIN if the tables are stored in SQL */
+    if (txp != NULL && RDB_env_queries(txp->envp))
+        return 0;
+
+    for (i = 0; i < 2 && tbc < cap; i++) {
+        RDB_expression *otexp = i == 0 ? texp->def.op.args.firstp
+                : texp->def.op.args.firstp->nextp;
+        RDB_expression *itexp = i == 0 ? texp->def.op.args.firstp->nextp
+                : texp->def.op.args.firstp;
+        RDB_type *ottyp, *ittyp;
+        RDB_object *tbp;
+
+        if (itexp->kind != RDB_EX_TBP)
+            continue;
+        tbp = itexp->def.tbref.tbp;
+        if (!RDB_table_is_stored(tbp) || tbp->kind != RDB_OB_TABLE)
+            continue;
+        if (tbp->val.tbp->stp == NULL) {
+            if (RDB_provide_stored_table(tbp, RDB_TRUE, ecp, txp) != RDB_OK)
+                return RDB_ERROR;
+        }
+
+        ottyp = RDB_expr_type(otexp, NULL, NULL, NULL, ecp, txp);
+        if (ottyp == NULL)
+            return RDB_ERROR;
+        ittyp = RDB_expr_type(itexp, NULL, NULL, NULL, ecp, txp);
+        if (ittyp == NULL)
+            return RDB_ERROR;
+
+        for (j = 0; j < tbp->val.tbp->stp->indexc && tbc < cap; j++) {
+            RDB_expression *arg1p, *arg2p;
+            RDB_expression *ntexp;
+            RDB_tbindex *indexp = &tbp->val.tbp->stp->indexv[j];
+
+            if (!RDB_merge_join_index(indexp, RDB_base_type(ottyp),
+                    RDB_base_type(ittyp)))
+                continue;
+
+            ntexp = RDB_ro_op("join", ecp);
+            if (ntexp == NULL)
+                return RDB_ERROR;
+
+            arg1p = RDB_dup_expr(otexp, ecp);
+            if (arg1p == NULL) {
+                RDB_del_expr(ntexp, ecp);
+                return RDB_ERROR;
+            }
+            RDB_add_arg(ntexp, arg1p);
+
+            /*
+             * If table #1 is a stored table with an index which sorts it
+             * by the common attributes, use that index so it need not be sorted
+             */
+            if (arg1p->kind == RDB_EX_TBP
+                    && arg1p->def.tbref.tbp->kind == RDB_OB_TABLE
+                    && arg1p->def.tbref.tbp->val.tbp->stp != NULL) {
+                RDB_stored_table *ostp = arg1p->def.tbref.tbp->val.tbp->stp;
+
+                for (k = 0; k < ostp->indexc; k++) {
+                    if (RDB_index_sorts(&ostp->indexv[k], indexp->attrc,
+                            indexp->attrv)) {
+                        arg1p->def.tbref.indexp = &ostp->indexv[k];
+                        break;
+                    }
+                }
+            }
+
+            arg2p = RDB_dup_expr(itexp, ecp);
+            if (arg2p == NULL) {
+                RDB_del_expr(ntexp, ecp);
+                return RDB_ERROR;
+            }
+            arg2p->def.tbref.indexp = indexp;
+            RDB_add_arg(ntexp, arg2p);
+
+            ntexp->def.op.optinfo.join_method = RDB_JOIN_MERGE;
+            tbpv[tbc++] = ntexp;
+        }
+    }
+    return tbc;
+}
+
 static int
 mutate_join(RDB_expression *texp, RDB_expression **tbpv, int cap,
         RDB_expression *empty_exp, RDB_exec_context *ecp, RDB_transaction *txp)
 {
+    int ret;
     int tbc = 0;
 
     if (texp->def.op.args.firstp->kind != RDB_EX_TBP
             && texp->def.op.args.firstp->nextp->kind != RDB_EX_TBP) {
-        return mutate_full_vt(texp, tbpv, cap, empty_exp, ecp, txp);
+        tbc = mutate_full_vt(texp, tbpv, cap, empty_exp, ecp, txp);
+        if (tbc == RDB_ERROR)
+            return RDB_ERROR;
+        ret = hash_joins(texp, tbpv + tbc, cap - tbc, ecp);
+        if (ret == RDB_ERROR)
+            return RDB_ERROR;
+        return tbc + ret;
     }
 
+    tbc = merge_joins(texp, tbpv, cap, ecp, txp);
+    if (tbc == RDB_ERROR)
+        return RDB_ERROR;
+
     if (texp->def.op.args.firstp->nextp->kind == RDB_EX_TBP
             || (RDB_expr_is_op(texp->def.op.args.firstp->nextp, "rename")
                && texp->def.op.args.firstp->nextp->def.op.args.firstp->kind == RDB_EX_TBP)) {
         /* Arg #2 is stored table or rename over stored table */
-        tbc = index_joins(texp->def.op.args.firstp, texp->def.op.args.firstp->nextp,
-                tbpv, cap, ecp, txp);
-        if (tbc == RDB_ERROR)
+        ret = index_joins(texp->def.op.args.firstp, texp->def.op.args.firstp->nextp,
+                tbpv + tbc, cap - tbc, ecp, txp);
+        if (ret == RDB_ERROR)
             return RDB_ERROR;
+        tbc += ret;
     }
 
     if (texp->def.op.args.firstp->kind == RDB_EX_TBP
@@ -1740,13 +2011,17 @@ mutate_join(RDB_expression *texp, RDB_expression **tbpv, int cap,
          * Arg #1 is stored table or rename over stored table,
          * reverse order of arguments
          */
-        int ret = index_joins(texp->def.op.args.firstp->nextp, texp->def.op.args.firstp,
+        ret = index_joins(texp->def.op.args.firstp->nextp, texp->def.op.args.firstp,
                 tbpv + tbc, cap - tbc, ecp, txp);
         if (ret == RDB_ERROR)
             return RDB_ERROR;
         tbc += ret;
     }
-    return tbc;
+
+    ret = hash_joins(texp, tbpv + tbc, cap - tbc, ecp);
+    if (ret == RDB_ERROR)
+        return RDB_ERROR;
+    return tbc + ret;
 }
 
 static int
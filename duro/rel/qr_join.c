@@ -8,9 +8,331 @@
 #include "qr_join.h"
 #include "qresult.h"
 #include "qr_stored.h"
+#include "qr_sort.h"
 #include "stable.h"
 #include "internal.h"
+#include "optimize.h"
 #include "obj/objinternal.h"
+#include <gen/hashtabit.h>
+#include <gen/strfns.h>
+
+#include <string.h>
+
+/*
+ * A tuple of the 2nd argument of a hash join.
+ * Tuples with the same hash value are chained.
+ * The entries are allocated from the arena of the qresult.
+ */
+typedef struct RDB_join_htuple {
+    unsigned hash;
+    RDB_object tpl;
+    struct RDB_join_htuple *nextp;
+} RDB_join_htuple;
+
+struct RDB_join_hashtab {
+    /* Contains the first RDB_join_htuple of each chain */
+    RDB_hashtable tab;
+
+    /* The attributes both arguments have in common */
+    int attrc;
+    char **attrv;
+
+    /* RDB_TRUE if all tuples of the 2nd argument have been read */
+    RDB_bool built;
+
+    /* Next tuple to check against the current 'outer' tuple */
+    RDB_join_htuple *curp;
+};
+
+enum {
+    JOIN_HASHTAB_CAPACITY = 256
+};
+
+/*
+ * A tuple of the 2nd argument of a merge join.
+ * Tuples with the same values of the join attributes are chained.
+ */
+typedef struct RDB_join_mtuple {
+    RDB_object tpl;
+    struct RDB_join_mtuple *nextp;
+} RDB_join_mtuple;
+
+/*
+ * State of a merge join. The 2nd argument is read in the order
+ * of an ordered index, the 1st argument in the same order.
+ */
+struct RDB_join_merge {
+    /* Index of the 2nd argument, its attributes are the common attributes */
+    RDB_tbindex *indexp;
+
+    /* Types of the common attributes */
+    RDB_type **typv;
+
+    /*
+     * Tuples of the 2nd argument which match the current 'outer' tuple.
+     * If the join attributes are unique in the 2nd argument,
+     * there is at most one.
+     */
+    RDB_join_mtuple *groupp;
+
+    /* The group entries are allocated from this arena */
+    RDB_arena grouparena;
+
+    /* Next tuple of the group to join with the current 'outer' tuple */
+    RDB_join_mtuple *curp;
+
+    /* Tuple of the 2nd argument which follows the group */
+    RDB_object tpl;
+    RDB_bool tpl_valid;
+
+    /* RDB_TRUE if all tuples of the 2nd argument have been read */
+    RDB_bool end2;
+};
+
+enum {
+    JOIN_UIX_BATCH_SIZE = 64
+};
+
+/*
+ * State of a nested loop join over a unique index of the 2nd argument
+ * which reads the tuples of the 2nd argument matching a batch
+ * of 'outer' tuples using a single multi-get.
+ */
+struct RDB_join_uix {
+    /* 'Outer' tuples */
+    RDB_object tplv[JOIN_UIX_BATCH_SIZE];
+
+    /* Tuples of the 2nd argument, tpl2v[i] is only valid if foundv[i] is true */
+    RDB_object tpl2v[JOIN_UIX_BATCH_SIZE];
+    RDB_bool foundv[JOIN_UIX_BATCH_SIZE];
+
+    /* Number of tuples in tplv */
+    int tplc;
+
+    /* Index of the next 'outer' tuple to join */
+    int pos;
+
+    /* RDB_TRUE if all tuples of the 1st argument have been read */
+    RDB_bool end1;
+};
+
+static unsigned
+hash_htuple(const void *entryp, void *arg)
+{
+    return ((const RDB_join_htuple *) entryp)->hash;
+}
+
+static RDB_bool
+htuple_equals(const void *e1p, const void *e2p, void *arg)
+{
+    return (RDB_bool) (((const RDB_join_htuple *) e1p)->hash
+            == ((const RDB_join_htuple *) e2p)->hash);
+}
+
+static RDB_join_hashtab *
+new_join_hashtab(RDB_expression *exp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    int i;
+    RDB_type *tpltyp1, *tpltyp2;
+    RDB_join_hashtab *hjp;
+    RDB_type *typ = RDB_expr_type(exp->def.op.args.firstp, NULL, NULL, NULL,
+            ecp, txp);
+    if (typ == NULL)
+        return NULL;
+    tpltyp1 = RDB_base_type(typ);
+    typ = RDB_expr_type(exp->def.op.args.firstp->nextp, NULL, NULL, NULL,
+            ecp, txp);
+    if (typ == NULL)
+        return NULL;
+    tpltyp2 = RDB_base_type(typ);
+
+    hjp = RDB_alloc(sizeof(RDB_join_hashtab), ecp);
+    if (hjp == NULL)
+        return NULL;
+
+    hjp->attrc = 0;
+    hjp->attrv = NULL;
+    if (tpltyp1->def.tuple.attrc > 0) {
+        hjp->attrv = RDB_alloc(sizeof(char *) * tpltyp1->def.tuple.attrc, ecp);
+        if (hjp->attrv == NULL) {
+            RDB_free(hjp);
+            return NULL;
+        }
+    }
+    for (i = 0; i < tpltyp1->def.tuple.attrc; i++) {
+        char *attrname = tpltyp1->def.tuple.attrv[i].name;
+        if (RDB_tuple_type_attr(tpltyp2, attrname) != NULL)
+            hjp->attrv[hjp->attrc++] = attrname;
+    }
+
+    RDB_init_hashtable(&hjp->tab, JOIN_HASHTAB_CAPACITY, &hash_htuple,
+            &htuple_equals);
+    hjp->built = RDB_FALSE;
+    hjp->curp = NULL;
+    return hjp;
+}
+
+void
+RDB_del_join_hashtab(RDB_join_hashtab *hjp, RDB_exec_context *ecp)
+{
+    RDB_hashtable_iter hiter;
+    RDB_join_htuple *htp;
+
+    RDB_init_hashtable_iter(&hiter, &hjp->tab);
+    while ((htp = RDB_hashtable_next(&hiter)) != NULL) {
+        do {
+            RDB_join_htuple *nextp = htp->nextp;
+            RDB_destroy_obj(&htp->tpl, ecp);
+            htp = nextp;
+        } while (htp != NULL);
+    }
+    RDB_destroy_hashtable_iter(&hiter);
+    RDB_destroy_hashtable(&hjp->tab);
+    RDB_free(hjp->attrv);
+    RDB_free(hjp);
+}
+
+/*
+ * Check if the ordered index indexp of the 2nd argument of a JOIN can be used
+ * for a merge join. This is the case if the index attributes are
+ * the common attributes in ascending order and if the attribute types
+ * are ordered. tpltyp1 and tpltyp2 are the tuple types of the arguments.
+ */
+RDB_bool
+RDB_merge_join_index(const RDB_tbindex *indexp, RDB_type *tpltyp1,
+        RDB_type *tpltyp2)
+{
+    int i;
+    int attrc = 0;
+
+    if (indexp->idxp == NULL || !indexp->ordered)
+        return RDB_FALSE;
+
+    for (i = 0; i < tpltyp1->def.tuple.attrc; i++) {
+        if (RDB_tuple_type_attr(tpltyp2, tpltyp1->def.tuple.attrv[i].name)
+                != NULL)
+            attrc++;
+    }
+    if (attrc == 0 || attrc != indexp->attrc)
+        return RDB_FALSE;
+
+    for (i = 0; i < indexp->attrc; i++) {
+        RDB_attr *attrp = RDB_tuple_type_attr(tpltyp1,
+                indexp->attrv[i].attrname);
+        if (attrp == NULL || !indexp->attrv[i].asc
+                || attrp->typ->compare_op == NULL)
+            return RDB_FALSE;
+    }
+    return RDB_TRUE;
+}
+
+/*
+ * Check if the 1st argument of a merge join is already sorted
+ * by the attributes of the index used for the 2nd argument
+ */
+RDB_bool
+RDB_merge_join_sorted(RDB_expression *exp)
+{
+    RDB_tbindex *indexp = exp->def.op.args.firstp->nextp->def.tbref.indexp;
+    RDB_tbindex *sindexp = RDB_expr_sortindex(exp->def.op.args.firstp);
+
+    return (RDB_bool) (sindexp != NULL
+            && RDB_index_sorts(sindexp, indexp->attrc, indexp->attrv));
+}
+
+static RDB_join_merge *
+new_join_merge(RDB_expression *exp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    int i;
+    RDB_join_merge *mjp;
+    RDB_type *tpltyp;
+    RDB_expression *arg2p = exp->def.op.args.firstp->nextp;
+    RDB_type *typ = RDB_expr_type(arg2p, NULL, NULL, NULL, ecp, txp);
+    if (typ == NULL)
+        return NULL;
+    tpltyp = RDB_base_type(typ);
+
+    mjp = RDB_alloc(sizeof(RDB_join_merge), ecp);
+    if (mjp == NULL)
+        return NULL;
+    mjp->indexp = arg2p->def.tbref.indexp;
+    mjp->typv = RDB_alloc(sizeof(RDB_type *) * mjp->indexp->attrc, ecp);
+    if (mjp->typv == NULL) {
+        RDB_free(mjp);
+        return NULL;
+    }
+    for (i = 0; i < mjp->indexp->attrc; i++) {
+        mjp->typv[i] = RDB_tuple_type_attr(tpltyp,
+                mjp->indexp->attrv[i].attrname)->typ;
+    }
+    mjp->groupp = NULL;
+    RDB_init_arena(&mjp->grouparena);
+    mjp->curp = NULL;
+    mjp->tpl_valid = RDB_FALSE;
+    mjp->end2 = RDB_FALSE;
+    return mjp;
+}
+
+static void
+clear_merge_group(RDB_join_merge *mjp, RDB_exec_context *ecp)
+{
+    while (mjp->groupp != NULL) {
+        RDB_join_mtuple *nextp = mjp->groupp->nextp;
+        RDB_destroy_obj(&mjp->groupp->tpl, ecp);
+        mjp->groupp = nextp;
+    }
+    RDB_clear_arena(&mjp->grouparena);
+    mjp->curp = NULL;
+}
+
+void
+RDB_del_join_merge(RDB_join_merge *mjp, RDB_exec_context *ecp)
+{
+    clear_merge_group(mjp, ecp);
+    if (mjp->tpl_valid)
+        RDB_destroy_obj(&mjp->tpl, ecp);
+    RDB_destroy_arena(&mjp->grouparena);
+    RDB_free(mjp->typv);
+    RDB_free(mjp);
+}
+
+static RDB_join_uix *
+new_join_uix(RDB_exec_context *ecp)
+{
+    int i;
+    RDB_join_uix *uixp = RDB_alloc(sizeof(RDB_join_uix), ecp);
+    if (uixp == NULL)
+        return NULL;
+
+    for (i = 0; i < JOIN_UIX_BATCH_SIZE; i++) {
+        RDB_init_obj(&uixp->tplv[i]);
+        RDB_init_obj(&uixp->tpl2v[i]);
+    }
+    RDB_reset_join_uix(uixp);
+    return uixp;
+}
+
+void
+RDB_reset_join_uix(RDB_join_uix *uixp)
+{
+    uixp->tplc = 0;
+    uixp->pos = 0;
+    uixp->end1 = RDB_FALSE;
+}
+
+void
+RDB_del_join_uix(RDB_join_uix *uixp, RDB_exec_context *ecp)
+{
+    int i;
+
+    for (i = 0; i < JOIN_UIX_BATCH_SIZE; i++) {
+        RDB_destroy_obj(&uixp->tplv[i], ecp);
+        RDB_destroy_obj(&uixp->tpl2v[i], ecp);
+    }
+    RDB_free(uixp);
+}
 
 int
 RDB_join_qresult(RDB_qresult *qrp, RDB_expression *exp,
@@ -18,31 +340,361 @@ RDB_join_qresult(RDB_qresult *qrp, RDB_expression *exp,
 {
     RDB_expression *arg2p;
 
-    /* Create qresult for the first table */
     qrp->exp = exp;
     qrp->nested = RDB_TRUE;
-    qrp->val.children.qrp = RDB_expr_qresult(qrp->exp->def.op.args.firstp,
-            ecp, txp);
-    if (qrp->val.children.qrp == NULL)
-        return RDB_ERROR;
+    qrp->val.children.hjp = NULL;
+    qrp->val.children.mjp = NULL;
+    qrp->val.children.uixp = NULL;
+
+    /* Create qresult for the first table */
+    if (exp->def.op.optinfo.join_method == RDB_JOIN_MERGE) {
+        qrp->val.children.mjp = new_join_merge(exp, ecp, txp);
+        if (qrp->val.children.mjp == NULL)
+            return RDB_ERROR;
+    }
+    if (qrp->val.children.mjp != NULL
+            && !RDB_merge_join_sorted(exp)) {
+        /* Sort the 1st table by the common attributes */
+        if (RDB_sorter(exp->def.op.args.firstp, &qrp->val.children.qrp,
+                ecp, txp, qrp->val.children.mjp->indexp->attrc,
+                qrp->val.children.mjp->indexp->attrv, RDB_INT_MAX)
+                != RDB_OK) {
+            RDB_del_join_merge(qrp->val.children.mjp, ecp);
+            return RDB_ERROR;
+        }
+    } else {
+        qrp->val.children.qrp = RDB_expr_qresult(qrp->exp->def.op.args.firstp,
+                ecp, txp);
+        if (qrp->val.children.qrp == NULL) {
+            if (qrp->val.children.mjp != NULL)
+                RDB_del_join_merge(qrp->val.children.mjp, ecp);
+            return RDB_ERROR;
+        }
+    }
 
     qrp->val.children.tpl_valid = RDB_FALSE;
 
     /* Create qresult for 2nd table, except if the primary index is used */
     arg2p = qrp->exp->def.op.args.firstp->nextp;
-    if (arg2p->kind != RDB_EX_TBP || arg2p->def.tbref.indexp == NULL
+    if (exp->def.op.optinfo.join_method != RDB_JOIN_NESTED_LOOP
+            || arg2p->kind != RDB_EX_TBP || arg2p->def.tbref.indexp == NULL
             || !arg2p->def.tbref.indexp->unique) {
         qrp->val.children.qr2p = RDB_expr_qresult(arg2p, ecp, txp);
         if (qrp->val.children.qr2p == NULL) {
             RDB_del_qresult(qrp->val.children.qrp, ecp, txp);
+            if (qrp->val.children.mjp != NULL)
+                RDB_del_join_merge(qrp->val.children.mjp, ecp);
             return RDB_ERROR;
         }
     } else {
         qrp->val.children.qr2p = NULL;
+
+        /*
+         * If the record layer supports it, read the matching tuples
+         * of the 2nd table for a batch of tuples of the 1st table at once
+         */
+        if (RDB_multi_get_supported(arg2p->def.tbref.tbp,
+                arg2p->def.tbref.indexp)) {
+            qrp->val.children.uixp = new_join_uix(ecp);
+            if (qrp->val.children.uixp == NULL) {
+                RDB_del_qresult(qrp->val.children.qrp, ecp, txp);
+                return RDB_ERROR;
+            }
+        }
+    }
+
+    if (exp->def.op.optinfo.join_method == RDB_JOIN_HASH) {
+        qrp->val.children.hjp = new_join_hashtab(exp, ecp, txp);
+        if (qrp->val.children.hjp == NULL) {
+            RDB_del_qresult(qrp->val.children.qrp, ecp, txp);
+            RDB_del_qresult(qrp->val.children.qr2p, ecp, txp);
+            return RDB_ERROR;
+        }
+    }
+    return RDB_OK;
+}
+
+/*
+ * Read all tuples of the 2nd argument and store them in the hashtable
+ */
+static int
+build_join_hashtab(RDB_qresult *qrp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    RDB_join_hashtab *hjp = qrp->val.children.hjp;
+
+    for (;;) {
+        RDB_join_htuple *headp;
+        RDB_join_htuple *htp = RDB_arena_alloc(&qrp->arena,
+                sizeof(RDB_join_htuple));
+        if (htp == NULL) {
+            RDB_raise_no_memory(ecp);
+            return RDB_ERROR;
+        }
+
+        RDB_init_obj(&htp->tpl);
+        if (RDB_next_tuple(qrp->val.children.qr2p, &htp->tpl, ecp, txp)
+                != RDB_OK) {
+            RDB_destroy_obj(&htp->tpl, ecp);
+            if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR)
+                return RDB_ERROR;
+            RDB_clear_err(ecp);
+            break;
+        }
+        htp->hash = RDB_tuple_hash_attrs(&htp->tpl, hjp->attrc, hjp->attrv);
+
+        /* Add tuple to the chain, if there is one */
+        headp = RDB_hashtable_get(&hjp->tab, htp, NULL);
+        if (headp != NULL) {
+            htp->nextp = headp->nextp;
+            headp->nextp = htp;
+        } else {
+            htp->nextp = NULL;
+            if (RDB_hashtable_put(&hjp->tab, htp, NULL) != RDB_OK) {
+                RDB_destroy_obj(&htp->tpl, ecp);
+                RDB_raise_no_memory(ecp);
+                return RDB_ERROR;
+            }
+        }
     }
+    hjp->built = RDB_TRUE;
     return RDB_OK;
 }
 
+static int
+next_join_hash(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    RDB_join_htuple key;
+    RDB_join_hashtab *hjp = qrp->val.children.hjp;
+
+    /* Read the 2nd table on the first invocation */
+    if (!hjp->built) {
+        if (build_join_hashtab(qrp, ecp, txp) != RDB_OK)
+            return RDB_ERROR;
+    }
+
+    if (!qrp->val.children.tpl_valid) {
+        RDB_init_obj(&qrp->val.children.tpl);
+        qrp->val.children.tpl_valid = RDB_TRUE;
+        hjp->curp = NULL;
+    }
+
+    for (;;) {
+        /* Search the chain for tuples matching the 'outer' tuple */
+        while (hjp->curp != NULL) {
+            RDB_bool match;
+            RDB_join_htuple *htp = hjp->curp;
+
+            hjp->curp = htp->nextp;
+            if (RDB_tuple_matches(&htp->tpl, &qrp->val.children.tpl, ecp, txp,
+                    &match) != RDB_OK) {
+                return RDB_ERROR;
+            }
+            if (match) {
+                /* join the two tuples into tplp */
+                RDB_destroy_obj(tplp, ecp);
+                RDB_init_obj(tplp);
+                if (RDB_copy_tuple(tplp, &htp->tpl, ecp) != RDB_OK)
+                    return RDB_ERROR;
+                return RDB_add_tuple(tplp, &qrp->val.children.tpl, ecp, txp);
+            }
+        }
+
+        /* read next 'outer' tuple */
+        if (RDB_next_tuple(qrp->val.children.qrp, &qrp->val.children.tpl,
+                ecp, txp) != RDB_OK) {
+            return RDB_ERROR;
+        }
+        key.hash = RDB_tuple_hash_attrs(&qrp->val.children.tpl, hjp->attrc,
+                hjp->attrv);
+        hjp->curp = RDB_hashtable_get(&hjp->tab, &key, NULL);
+    }
+}
+
+/*
+ * Compare the common attributes of two tuples using the comparison operators
+ * of the attribute types
+ */
+static int
+compare_merge_attrs(RDB_join_merge *mjp, RDB_object *tpl1p,
+        RDB_object *tpl2p, RDB_exec_context *ecp, RDB_transaction *txp,
+        int *resp)
+{
+    int i;
+    RDB_object *valv[2];
+    RDB_object retval;
+
+    *resp = 0;
+    RDB_init_obj(&retval);
+    for (i = 0; i < mjp->indexp->attrc; i++) {
+        RDB_operator *cmpop = mjp->typv[i]->compare_op;
+
+        valv[0] = RDB_tuple_get(tpl1p, mjp->indexp->attrv[i].attrname);
+        valv[1] = RDB_tuple_get(tpl2p, mjp->indexp->attrv[i].attrname);
+        if ((*cmpop->opfn.ro_fp)(2, valv, cmpop, ecp, txp, &retval)
+                != RDB_OK) {
+            RDB_destroy_obj(&retval, ecp);
+            return RDB_ERROR;
+        }
+        *resp = (int) RDB_obj_int(&retval);
+        if (*resp != 0)
+            break;
+    }
+    return RDB_destroy_obj(&retval, ecp);
+}
+
+/*
+ * Read the next tuple of the 2nd argument into mjp->tpl.
+ * Sets mjp->end2 if there are no more tuples.
+ */
+static int
+next_merge_tuple(RDB_qresult *qrp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    RDB_join_merge *mjp = qrp->val.children.mjp;
+
+    RDB_init_obj(&mjp->tpl);
+    if (RDB_next_tuple(qrp->val.children.qr2p, &mjp->tpl, ecp, txp)
+            != RDB_OK) {
+        RDB_destroy_obj(&mjp->tpl, ecp);
+        if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR)
+            return RDB_ERROR;
+        RDB_clear_err(ecp);
+        mjp->end2 = RDB_TRUE;
+        return RDB_OK;
+    }
+    mjp->tpl_valid = RDB_TRUE;
+    return RDB_OK;
+}
+
+/*
+ * Find the tuples of the 2nd argument which match the current 'outer' tuple
+ * and store them in the group. The 2nd argument is only read forward,
+ * as the 'outer' tuples arrive in ascending order.
+ */
+static int
+read_merge_group(RDB_qresult *qrp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    int res;
+    RDB_join_mtuple **lastpp;
+    RDB_join_merge *mjp = qrp->val.children.mjp;
+
+    /* Check if the current group matches, too */
+    if (mjp->groupp != NULL) {
+        if (compare_merge_attrs(mjp, &mjp->groupp->tpl,
+                &qrp->val.children.tpl, ecp, txp, &res) != RDB_OK)
+            return RDB_ERROR;
+        if (res == 0) {
+            mjp->curp = mjp->groupp;
+            return RDB_OK;
+        }
+        clear_merge_group(mjp, ecp);
+    }
+
+    /* Skip tuples which are less than the 'outer' tuple */
+    for (;;) {
+        if (!mjp->tpl_valid) {
+            if (mjp->end2)
+                return RDB_OK;
+            if (next_merge_tuple(qrp, ecp, txp) != RDB_OK)
+                return RDB_ERROR;
+            if (mjp->end2)
+                return RDB_OK;
+        }
+        if (compare_merge_attrs(mjp, &mjp->tpl, &qrp->val.children.tpl,
+                ecp, txp, &res) != RDB_OK)
+            return RDB_ERROR;
+        if (res > 0)
+            return RDB_OK;
+        if (res == 0)
+            break;
+        RDB_destroy_obj(&mjp->tpl, ecp);
+        mjp->tpl_valid = RDB_FALSE;
+    }
+
+    /* Move the matching tuples into the group */
+    lastpp = &mjp->groupp;
+    do {
+        RDB_join_mtuple *mtp = RDB_arena_alloc(&mjp->grouparena,
+                sizeof(RDB_join_mtuple));
+        if (mtp == NULL) {
+            RDB_raise_no_memory(ecp);
+            return RDB_ERROR;
+        }
+        RDB_init_obj(&mtp->tpl);
+        if (RDB_copy_obj(&mtp->tpl, &mjp->tpl, ecp) != RDB_OK) {
+            RDB_destroy_obj(&mtp->tpl, ecp);
+            return RDB_ERROR;
+        }
+        mtp->nextp = NULL;
+        *lastpp = mtp;
+        lastpp = &mtp->nextp;
+
+        RDB_destroy_obj(&mjp->tpl, ecp);
+        mjp->tpl_valid = RDB_FALSE;
+        if (next_merge_tuple(qrp, ecp, txp) != RDB_OK)
+            return RDB_ERROR;
+        if (mjp->end2)
+            break;
+        if (compare_merge_attrs(mjp, &mjp->tpl, &qrp->val.children.tpl,
+                ecp, txp, &res) != RDB_OK)
+            return RDB_ERROR;
+    } while (res == 0);
+    mjp->curp = mjp->groupp;
+    return RDB_OK;
+}
+
+/*
+ * Both arguments are read only once. Besides the current tuple of each
+ * argument, only the tuples of the 2nd argument with the current values
+ * of the common attributes are kept in memory.
+ */
+static int
+next_join_merge(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    RDB_join_merge *mjp = qrp->val.children.mjp;
+
+    if (!qrp->val.children.tpl_valid) {
+        RDB_init_obj(&qrp->val.children.tpl);
+        qrp->val.children.tpl_valid = RDB_TRUE;
+
+        /* The qresult may have been reset */
+        clear_merge_group(mjp, ecp);
+        if (mjp->tpl_valid) {
+            RDB_destroy_obj(&mjp->tpl, ecp);
+            mjp->tpl_valid = RDB_FALSE;
+        }
+        mjp->end2 = RDB_FALSE;
+    }
+
+    while (mjp->curp == NULL) {
+        if (mjp->end2 && !mjp->tpl_valid && mjp->groupp == NULL) {
+            /* No more matching tuples */
+            RDB_raise_not_found("", ecp);
+            return RDB_ERROR;
+        }
+
+        /* read next 'outer' tuple */
+        if (RDB_next_tuple(qrp->val.children.qrp, &qrp->val.children.tpl,
+                ecp, txp) != RDB_OK) {
+            return RDB_ERROR;
+        }
+        if (read_merge_group(qrp, ecp, txp) != RDB_OK)
+            return RDB_ERROR;
+    }
+
+    /* join the two tuples into tplp */
+    RDB_destroy_obj(tplp, ecp);
+    RDB_init_obj(tplp);
+    if (RDB_copy_tuple(tplp, &mjp->curp->tpl, ecp) != RDB_OK)
+        return RDB_ERROR;
+    mjp->curp = mjp->curp->nextp;
+    return RDB_add_tuple(tplp, &qrp->val.children.tpl, ecp, txp);
+}
+
 static int
 next_join_rename_uix(RDB_qresult *qrp, RDB_object *tplp, RDB_tbindex *indexp,
         RDB_exec_context *ecp, RDB_transaction *txp)
@@ -55,8 +707,11 @@ next_join_rename_uix(RDB_qresult *qrp, RDB_object *tplp, RDB_tbindex *indexp,
     RDB_object *tbp = qrp->val.children.qr2p->exp->def.op.args.firstp
             ->def.tbref.tbp;
     RDB_bool match = RDB_FALSE;
+    RDB_arena_mark mark;
 
-    objpv = RDB_alloc(sizeof(RDB_object *) * indexp->attrc, ecp);
+    /* The key value pointers are only needed for reading this tuple */
+    RDB_arena_get_mark(&qrp->arena, &mark);
+    objpv = RDB_arena_alloc(&qrp->arena, sizeof(RDB_object *) * indexp->attrc);
     if (objpv == NULL) {
         RDB_raise_no_memory(ecp);
         return RDB_ERROR;
@@ -82,7 +737,7 @@ next_join_rename_uix(RDB_qresult *qrp, RDB_object *tplp, RDB_tbindex *indexp,
         }
         ret = RDB_get_by_uindex(tbp, objpv, indexp,
                 tbp->typ->def.basetyp,
-                ecp, txp, &tpl);
+                &qrp->arena, ecp, txp, &tpl);
         if (ret == RDB_ERROR) {
             if (RDB_obj_type(RDB_get_err(ecp)) == &RDB_NOT_FOUND_ERROR) {
                 RDB_clear_err(ecp);
@@ -106,7 +761,7 @@ next_join_rename_uix(RDB_qresult *qrp, RDB_object *tplp, RDB_tbindex *indexp,
     ret = RDB_add_tuple(tplp, &rtpl, ecp, txp);
 
 cleanup:
-    RDB_free(objpv);
+    RDB_arena_release(&qrp->arena, &mark);
     RDB_destroy_obj(&tpl, ecp);
     RDB_destroy_obj(&rtpl, ecp);
 
@@ -213,9 +868,11 @@ next_join_uix(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
     RDB_object tpl;
     RDB_object **objpv;
     RDB_bool match = RDB_FALSE;
+    RDB_arena_mark mark;
     RDB_tbindex *indexp = qrp->exp->def.op.args.firstp->nextp->def.tbref.indexp;
 
-    objpv = RDB_alloc(sizeof(RDB_object *) * indexp->attrc, ecp);
+    RDB_arena_get_mark(&qrp->arena, &mark);
+    objpv = RDB_arena_alloc(&qrp->arena, sizeof(RDB_object *) * indexp->attrc);
     if (objpv == NULL) {
         RDB_raise_no_memory(ecp);
         return RDB_ERROR;
@@ -240,7 +897,7 @@ next_join_uix(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
         ret = RDB_get_by_uindex(qrp->exp->def.op.args.firstp->nextp->def.tbref.tbp,
                 objpv, indexp,
                 qrp->exp->def.op.args.firstp->nextp->def.tbref.tbp->typ->def.basetyp,
-                ecp, txp, &tpl);
+                &qrp->arena, ecp, txp, &tpl);
         if (ret == RDB_ERROR) {
             if (RDB_obj_type(RDB_get_err(ecp)) == &RDB_NOT_FOUND_ERROR) {
                 RDB_clear_err(ecp);
@@ -257,12 +914,80 @@ next_join_uix(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
     ret = RDB_add_tuple(tplp, &tpl, ecp, txp);
 
 cleanup:
-    RDB_free(objpv);
+    RDB_arena_release(&qrp->arena, &mark);
     RDB_destroy_obj(&tpl, ecp);
 
     return ret;
 }
 
+/*
+ * Read the next batch of 'outer' tuples and the matching tuples
+ * of the 2nd argument
+ */
+static int
+read_join_uix_batch(RDB_qresult *qrp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    RDB_join_uix *uixp = qrp->val.children.uixp;
+    RDB_expression *arg2p = qrp->exp->def.op.args.firstp->nextp;
+    int tplc = RDB_next_tuples(qrp->val.children.qrp, uixp->tplv,
+            JOIN_UIX_BATCH_SIZE, ecp, txp);
+    if (tplc == RDB_ERROR)
+        return RDB_ERROR;
+
+    uixp->tplc = tplc;
+    uixp->pos = 0;
+    if (tplc < JOIN_UIX_BATCH_SIZE)
+        uixp->end1 = RDB_TRUE;
+    if (tplc == 0)
+        return RDB_OK;
+
+    return RDB_get_by_uindex_multi(arg2p->def.tbref.tbp, tplc, uixp->tplv,
+            arg2p->def.tbref.indexp, arg2p->def.tbref.tbp->typ->def.basetyp,
+            &qrp->arena, ecp, txp, uixp->tpl2v, uixp->foundv);
+}
+
+/*
+ * Like next_join_uix(), but reads the tuples of the 2nd argument
+ * in batches
+ */
+static int
+next_join_uix_batch(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    RDB_join_uix *uixp = qrp->val.children.uixp;
+    RDB_bool match;
+    int i;
+
+    for (;;) {
+        if (uixp->pos >= uixp->tplc) {
+            if (uixp->end1) {
+                RDB_raise_not_found("", ecp);
+                return RDB_ERROR;
+            }
+            if (read_join_uix_batch(qrp, ecp, txp) != RDB_OK)
+                return RDB_ERROR;
+            continue;
+        }
+
+        i = uixp->pos++;
+        if (!uixp->foundv[i])
+            continue;
+
+        if (RDB_tuple_matches(&uixp->tplv[i], &uixp->tpl2v[i], ecp, txp,
+                &match) != RDB_OK)
+            return RDB_ERROR;
+        if (match)
+            break;
+    }
+
+    RDB_destroy_obj(tplp, ecp);
+    RDB_init_obj(tplp);
+    if (RDB_copy_obj(tplp, &uixp->tplv[i], ecp) != RDB_OK)
+        return RDB_ERROR;
+    return RDB_add_tuple(tplp, &uixp->tpl2v[i], ecp, txp);
+}
+
 static int
 next_join_nuix(RDB_qresult *qrp, RDB_object *tplp,
         RDB_exec_context *ecp, RDB_transaction *txp)
@@ -341,11 +1066,19 @@ RDB_next_join(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
 {
     int ret;
 
+    if (qrp->val.children.hjp != NULL)
+        return next_join_hash(qrp, tplp, ecp, txp);
+    if (qrp->val.children.mjp != NULL)
+        return next_join_merge(qrp, tplp, ecp, txp);
+
     if (qrp->exp->def.op.args.firstp->nextp->kind == RDB_EX_TBP
             && qrp->exp->def.op.args.firstp->nextp->def.tbref.indexp != NULL) {
         RDB_tbindex *indexp = qrp->exp->def.op.args.firstp->nextp->def.tbref.indexp;
-        return indexp->unique ? next_join_uix(qrp, tplp, ecp, txp)
-                : next_join_nuix(qrp, tplp, ecp, txp);
+        if (!indexp->unique)
+            return next_join_nuix(qrp, tplp, ecp, txp);
+        return qrp->val.children.uixp != NULL
+                ? next_join_uix_batch(qrp, tplp, ecp, txp)
+                : next_join_uix(qrp, tplp, ecp, txp);
     }
 
     /* Check if the 2nd arg is a RENAME over a stored table */
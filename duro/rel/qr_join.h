@@ -8,11 +8,18 @@
 #ifndef QR_JOIN_H_
 #define QR_JOIN_H_
 
+#include <gen/types.h>
+
 typedef struct RDB_object RDB_object;
 typedef struct RDB_exec_context RDB_exec_context;
 typedef struct RDB_transaction RDB_transaction;
 typedef struct RDB_qresult RDB_qresult;
 typedef struct RDB_expression RDB_expression;
+typedef struct RDB_type RDB_type;
+typedef struct RDB_join_hashtab RDB_join_hashtab;
+typedef struct RDB_join_merge RDB_join_merge;
+typedef struct RDB_join_uix RDB_join_uix;
+typedef struct RDB_tbindex RDB_tbindex;
 
 int
 RDB_join_qresult(RDB_qresult *, RDB_expression *,
@@ -22,4 +29,22 @@ int
 RDB_next_join(RDB_qresult *, RDB_object *, RDB_exec_context *,
         RDB_transaction *);
 
+void
+RDB_del_join_hashtab(RDB_join_hashtab *, RDB_exec_context *);
+
+void
+RDB_del_join_merge(RDB_join_merge *, RDB_exec_context *);
+
+void
+RDB_reset_join_uix(RDB_join_uix *);
+
+void
+RDB_del_join_uix(RDB_join_uix *, RDB_exec_context *);
+
+RDB_bool
+RDB_merge_join_index(const RDB_tbindex *, RDB_type *, RDB_type *);
+
+RDB_bool
+RDB_merge_join_sorted(RDB_expression *);
+
 #endif /* QR_JOIN_H_ */
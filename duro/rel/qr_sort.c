@@ -0,0 +1,961 @@
+/*
+ * Sorting the tuples of a table.
+ *
+ * The tuples are converted to their internal representation and collected
+ * in memory. When the memory used exceeds the limit set by RDB_set_sort_mem()
+ * or the sort_mem environment setting, the tuples collected so far are sorted and written to a temporary file
+ * as a sorted run. After all tuples have been read, the runs are merged.
+ *
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include "qr_sort.h"
+#include "qresult.h"
+#include "qr_stored.h"
+#include "internal.h"
+#include "typeimpl.h"
+#include "sqlgen.h"
+#include <obj/objinternal.h>
+#include <gen/arena.h>
+
+#ifdef POSTGRESQL
+#include <pgrec/pgcursor.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+enum {
+    RDB_DEFAULT_SORT_MEM = 16 * 1024 * 1024,
+
+    /* Maximum number of runs which are merged in one pass */
+    SORT_MERGE_ORDER = 32,
+
+    RECV_INCREMENT = 1024
+};
+
+static size_t sort_mem = RDB_DEFAULT_SORT_MEM;
+
+/*
+ * A record consists of the lengths of the internal representations
+ * of the sort attributes and of the tuple (as size_t values),
+ * followed by the internal representations themselves.
+ */
+
+typedef struct {
+    const char *attrname;
+    RDB_type *typ;
+    RDB_bool asc;
+} sort_key;
+
+/* A sorted run which has been written to a temporary file */
+typedef struct {
+    FILE *fp;
+
+    /* Buffer holding the current record of the run */
+    char *bufp;
+    size_t bufsize;
+
+    /* RDB_FALSE if the end of the run has been reached */
+    RDB_bool valid;
+} sort_run;
+
+struct RDB_sort {
+    /* Relation type, owned by the RDB_sort */
+    RDB_type *reltyp;
+
+    int keyc;
+    sort_key *keyv;
+
+    /* Buffer for the lengths of a record */
+    size_t *lenv;
+
+    /* Maximum number of tuples returned */
+    RDB_int limit;
+
+    /* The records which are kept in memory */
+    RDB_arena arena;
+    char **recv;
+    int recc;
+    int reccap;
+
+    /* Number of bytes used by the records in memory */
+    size_t memsize;
+
+    /* Runs written to temporary files */
+    sort_run *runv;
+    int runc;
+
+    /* Binary heap of the runs being merged, ordered by their current record */
+    int *heapv;
+    int heapc;
+
+    /* Position of the next record if all records are in memory */
+    int pos;
+
+    /* Number of tuples returned */
+    RDB_int count;
+
+    /* Internal representation of the last tuple, used for duplicate removal */
+    char *lastp;
+    size_t lastlen;
+    size_t lastsize;
+    RDB_bool lastvalid;
+
+    /*
+     * Used by compare_recs(). If a comparison fails, the error
+     * is stored in *ecp and cmperr is set.
+     */
+    RDB_exec_context *ecp;
+    RDB_transaction *txp;
+    RDB_bool cmperr;
+};
+
+/**
+ * Set the maximum amount of memory a sorter uses before it writes
+ * sorted runs to temporary files.
+ * The limit can be set per environment using the sort_mem setting
+ * of RDB_open_env_config(), which takes precedence.
+ */
+void
+RDB_set_sort_mem(size_t size)
+{
+    sort_mem = size;
+}
+
+/**
+ * Return the amount of memory a sorter may use.
+ */
+size_t
+RDB_sort_mem(void)
+{
+    return sort_mem;
+}
+
+/*
+ * Return the sort memory limit of the environment, if it has been
+ * configured, otherwise the value set by RDB_set_sort_mem().
+ */
+static size_t
+tx_sort_mem(RDB_transaction *txp)
+{
+    if (txp != NULL) {
+        size_t size = RDB_env_sort_mem(txp->envp);
+        if (size > 0)
+            return size;
+    }
+    return sort_mem;
+}
+
+#define REC_HDRSIZE(sp) (sizeof(size_t) * ((sp)->keyc + 1))
+
+#define REC_LENV(recp) ((const size_t *) (recp))
+
+/*
+ * Return a pointer to the internal representation of the tuple
+ */
+static const char *
+rec_tuple(const RDB_sort *sp, const char *recp)
+{
+    int i;
+    const char *datap = recp + REC_HDRSIZE(sp);
+
+    for (i = 0; i < sp->keyc; i++)
+        datap += REC_LENV(recp)[i];
+    return datap;
+}
+
+static size_t
+rec_size(const RDB_sort *sp, const char *recp)
+{
+    return rec_tuple(sp, recp) - recp + REC_LENV(recp)[sp->keyc];
+}
+
+static int
+compare_bytes(const char *d1, size_t len1, const char *d2, size_t len2)
+{
+    int res = memcmp(d1, d2, len1 < len2 ? len1 : len2);
+    if (res != 0)
+        return res;
+    return len1 < len2 ? -1 : (len1 > len2 ? 1 : 0);
+}
+
+/*
+ * Compare two values of a user-defined type using the type's
+ * comparison operator.
+ */
+static int
+compare_vals(RDB_sort *sp, RDB_type *typ, const char *d1, size_t len1,
+        const char *d2, size_t len2)
+{
+    RDB_object val1, val2, retval;
+    RDB_object *valv[2];
+    int res = 0;
+
+    RDB_init_obj(&val1);
+    RDB_init_obj(&val2);
+    RDB_init_obj(&retval);
+
+    if (RDB_irep_to_obj(&val1, typ, d1, len1, sp->ecp) != RDB_OK
+            || RDB_irep_to_obj(&val2, typ, d2, len2, sp->ecp) != RDB_OK) {
+        sp->cmperr = RDB_TRUE;
+        goto cleanup;
+    }
+    valv[0] = &val1;
+    valv[1] = &val2;
+    if ((*typ->compare_op->opfn.ro_fp)(2, valv, typ->compare_op, sp->ecp,
+            sp->txp, &retval) != RDB_OK) {
+        sp->cmperr = RDB_TRUE;
+        goto cleanup;
+    }
+    res = (int) RDB_obj_int(&retval);
+
+cleanup:
+    RDB_destroy_obj(&val1, sp->ecp);
+    RDB_destroy_obj(&val2, sp->ecp);
+    RDB_destroy_obj(&retval, sp->ecp);
+    return res;
+}
+
+static int
+compare_key(RDB_sort *sp, RDB_type *typ, const char *d1, size_t len1,
+        const char *d2, size_t len2)
+{
+    if (typ == &RDB_INTEGER) {
+        RDB_int v1, v2;
+
+        memcpy(&v1, d1, sizeof(RDB_int));
+        memcpy(&v2, d2, sizeof(RDB_int));
+        return v1 < v2 ? -1 : (v1 > v2 ? 1 : 0);
+    }
+    if (typ == &RDB_FLOAT) {
+        RDB_float v1, v2;
+
+        memcpy(&v1, d1, sizeof(RDB_float));
+        memcpy(&v2, d2, sizeof(RDB_float));
+        return v1 < v2 ? -1 : (v1 > v2 ? 1 : 0);
+    }
+    if (typ == &RDB_STRING) {
+        /* The internal representation includes the terminating nullbyte */
+        return strcoll(d1, d2);
+    }
+    if (typ->compare_op == NULL)
+        return compare_bytes(d1, len1, d2, len2);
+    return compare_vals(sp, typ, d1, len1, d2, len2);
+}
+
+/*
+ * Compare two records by their sort attributes.
+ * Records with the same sort attributes are ordered by the internal
+ * representation of the tuple, so duplicates are adjacent after sorting.
+ */
+static int
+compare_recs(RDB_sort *sp, const char *r1p, const char *r2p)
+{
+    int i;
+    int res;
+    const char *d1 = r1p + REC_HDRSIZE(sp);
+    const char *d2 = r2p + REC_HDRSIZE(sp);
+
+    for (i = 0; i < sp->keyc; i++) {
+        res = compare_key(sp, sp->keyv[i].typ, d1, REC_LENV(r1p)[i],
+                d2, REC_LENV(r2p)[i]);
+        if (res != 0)
+            return sp->keyv[i].asc ? res : -res;
+        d1 += REC_LENV(r1p)[i];
+        d2 += REC_LENV(r2p)[i];
+    }
+    return compare_bytes(d1, REC_LENV(r1p)[sp->keyc],
+            d2, REC_LENV(r2p)[sp->keyc]);
+}
+
+/*
+ * Sort recv using merge sort. tmpv must have room for n / 2 entries.
+ */
+static void
+merge_sort(RDB_sort *sp, char **recv, char **tmpv, int n)
+{
+    int i, j, k;
+    int mid;
+
+    if (n < 2)
+        return;
+    mid = n / 2;
+    merge_sort(sp, recv, tmpv, mid);
+    merge_sort(sp, recv + mid, tmpv, n - mid);
+
+    /* Nothing to do if the two halves are already in order */
+    if (compare_recs(sp, recv[mid - 1], recv[mid]) <= 0)
+        return;
+
+    memcpy(tmpv, recv, sizeof(char *) * mid);
+    i = 0;
+    j = mid;
+    k = 0;
+    while (i < mid && j < n) {
+        if (compare_recs(sp, recv[j], tmpv[i]) < 0)
+            recv[k++] = recv[j++];
+        else
+            recv[k++] = tmpv[i++];
+    }
+    while (i < mid)
+        recv[k++] = tmpv[i++];
+}
+
+/*
+ * Sort the records in memory, remove duplicates and records beyond the limit.
+ */
+static int
+sort_recs(RDB_sort *sp, RDB_exec_context *ecp)
+{
+    int i, n;
+    char **tmpv;
+
+    if (sp->recc < 2)
+        return RDB_OK;
+
+    tmpv = RDB_alloc(sizeof(char *) * (sp->recc / 2), ecp);
+    if (tmpv == NULL)
+        return RDB_ERROR;
+    merge_sort(sp, sp->recv, tmpv, sp->recc);
+    RDB_free(tmpv);
+    if (sp->cmperr)
+        return RDB_ERROR;
+
+    n = 1;
+    for (i = 1; i < sp->recc && n < sp->limit; i++) {
+        if (compare_bytes(rec_tuple(sp, sp->recv[i]),
+                REC_LENV(sp->recv[i])[sp->keyc],
+                rec_tuple(sp, sp->recv[n - 1]),
+                REC_LENV(sp->recv[n - 1])[sp->keyc]) != 0) {
+            sp->recv[n++] = sp->recv[i];
+        }
+    }
+    sp->recc = n;
+    return RDB_OK;
+}
+
+/*
+ * Copy the records to a new arena so the memory of the records
+ * which have been removed by sort_recs() is freed.
+ */
+static int
+compact_recs(RDB_sort *sp, RDB_exec_context *ecp)
+{
+    int i;
+    RDB_arena arena;
+
+    RDB_init_arena(&arena);
+    sp->memsize = 0;
+    for (i = 0; i < sp->recc; i++) {
+        size_t size = rec_size(sp, sp->recv[i]);
+        char *recp = RDB_arena_alloc(&arena, size);
+        if (recp == NULL) {
+            RDB_destroy_arena(&arena);
+            RDB_raise_no_memory(ecp);
+            return RDB_ERROR;
+        }
+        memcpy(recp, sp->recv[i], size);
+        sp->recv[i] = recp;
+        sp->memsize += size + sizeof(char *);
+    }
+    RDB_destroy_arena(&sp->arena);
+    sp->arena = arena;
+    return RDB_OK;
+}
+
+static int
+add_run(RDB_sort *sp, FILE *fp, RDB_exec_context *ecp)
+{
+    sort_run *runv = RDB_realloc(sp->runv, sizeof(sort_run) * (sp->runc + 1),
+            ecp);
+    if (runv == NULL)
+        return RDB_ERROR;
+    sp->runv = runv;
+    runv[sp->runc].fp = fp;
+    runv[sp->runc].bufp = NULL;
+    runv[sp->runc].bufsize = 0;
+    runv[sp->runc].valid = RDB_FALSE;
+    sp->runc++;
+    return RDB_OK;
+}
+
+static int
+write_rec(FILE *fp, const char *recp, size_t size, RDB_exec_context *ecp)
+{
+    if (fwrite(&size, sizeof(size_t), 1, fp) != 1
+            || fwrite(recp, 1, size, fp) != size) {
+        RDB_raise_system("writing temporary file failed", ecp);
+        return RDB_ERROR;
+    }
+    return RDB_OK;
+}
+
+static FILE *
+create_run_file(RDB_exec_context *ecp)
+{
+    FILE *fp = tmpfile();
+    if (fp == NULL) {
+        RDB_raise_system("creating temporary file failed", ecp);
+    }
+    return fp;
+}
+
+/*
+ * Sort the records in memory and write them to a temporary file.
+ */
+static int
+write_run(RDB_sort *sp, RDB_exec_context *ecp)
+{
+    int i;
+    FILE *fp;
+
+    if (sort_recs(sp, ecp) != RDB_OK)
+        return RDB_ERROR;
+
+    fp = create_run_file(ecp);
+    if (fp == NULL)
+        return RDB_ERROR;
+    if (add_run(sp, fp, ecp) != RDB_OK) {
+        fclose(fp);
+        return RDB_ERROR;
+    }
+
+    for (i = 0; i < sp->recc; i++) {
+        if (write_rec(fp, sp->recv[i], rec_size(sp, sp->recv[i]), ecp)
+                != RDB_OK)
+            return RDB_ERROR;
+    }
+
+    RDB_clear_arena(&sp->arena);
+    sp->recc = 0;
+    sp->memsize = 0;
+    return RDB_OK;
+}
+
+/*
+ * Read the next record of a run into its buffer.
+ */
+static int
+read_run_rec(sort_run *runp, RDB_exec_context *ecp)
+{
+    size_t size;
+
+    if (fread(&size, sizeof(size_t), 1, runp->fp) != 1) {
+        if (ferror(runp->fp)) {
+            RDB_raise_system("reading temporary file failed", ecp);
+            return RDB_ERROR;
+        }
+        runp->valid = RDB_FALSE;
+        return RDB_OK;
+    }
+    if (size > runp->bufsize) {
+        char *bufp = RDB_realloc(runp->bufp, size, ecp);
+        if (bufp == NULL)
+            return RDB_ERROR;
+        runp->bufp = bufp;
+        runp->bufsize = size;
+    }
+    if (fread(runp->bufp, 1, size, runp->fp) != size) {
+        RDB_raise_system("reading temporary file failed", ecp);
+        return RDB_ERROR;
+    }
+    runp->valid = RDB_TRUE;
+    return RDB_OK;
+}
+
+#define HEAP_REC(sp, i) ((sp)->runv[(sp)->heapv[i]].bufp)
+
+static void
+heap_sift_down(RDB_sort *sp, int i)
+{
+    for (;;) {
+        int l = 2 * i + 1;
+        int minpos = i;
+
+        if (l < sp->heapc
+                && compare_recs(sp, HEAP_REC(sp, l), HEAP_REC(sp, minpos)) < 0)
+            minpos = l;
+        if (l + 1 < sp->heapc
+                && compare_recs(sp, HEAP_REC(sp, l + 1), HEAP_REC(sp, minpos)) < 0)
+            minpos = l + 1;
+        if (minpos == i)
+            break;
+        l = sp->heapv[i];
+        sp->heapv[i] = sp->heapv[minpos];
+        sp->heapv[minpos] = l;
+        i = minpos;
+    }
+}
+
+/*
+ * Start merging the first runc runs.
+ */
+static int
+start_merge(RDB_sort *sp, int runc, RDB_exec_context *ecp)
+{
+    int i;
+
+    if (sp->heapv == NULL) {
+        sp->heapv = RDB_alloc(sizeof(int) * SORT_MERGE_ORDER, ecp);
+        if (sp->heapv == NULL)
+            return RDB_ERROR;
+    }
+
+    sp->heapc = 0;
+    for (i = 0; i < runc; i++) {
+        rewind(sp->runv[i].fp);
+        if (read_run_rec(&sp->runv[i], ecp) != RDB_OK)
+            return RDB_ERROR;
+        if (sp->runv[i].valid)
+            sp->heapv[sp->heapc++] = i;
+    }
+    for (i = sp->heapc / 2 - 1; i >= 0; i--)
+        heap_sift_down(sp, i);
+    sp->lastvalid = RDB_FALSE;
+    return sp->cmperr ? RDB_ERROR : RDB_OK;
+}
+
+/*
+ * Advance the run which holds the smallest record.
+ */
+static int
+merge_pop(RDB_sort *sp, RDB_exec_context *ecp)
+{
+    sort_run *runp = &sp->runv[sp->heapv[0]];
+
+    if (read_run_rec(runp, ecp) != RDB_OK)
+        return RDB_ERROR;
+    if (!runp->valid)
+        sp->heapv[0] = sp->heapv[--sp->heapc];
+    if (sp->heapc > 0)
+        heap_sift_down(sp, 0);
+    return sp->cmperr ? RDB_ERROR : RDB_OK;
+}
+
+/*
+ * Check if the tuple of the record is the same as the last tuple.
+ */
+static RDB_bool
+is_last_tuple(const RDB_sort *sp, const char *recp)
+{
+    return sp->lastvalid && compare_bytes(rec_tuple(sp, recp),
+            REC_LENV(recp)[sp->keyc], sp->lastp, sp->lastlen) == 0;
+}
+
+static int
+set_last_tuple(RDB_sort *sp, const char *recp, RDB_exec_context *ecp)
+{
+    size_t len = REC_LENV(recp)[sp->keyc];
+
+    if (len > sp->lastsize) {
+        char *lastp = RDB_realloc(sp->lastp, len, ecp);
+        if (lastp == NULL)
+            return RDB_ERROR;
+        sp->lastp = lastp;
+        sp->lastsize = len;
+    }
+    memcpy(sp->lastp, rec_tuple(sp, recp), len);
+    sp->lastlen = len;
+    sp->lastvalid = RDB_TRUE;
+    return RDB_OK;
+}
+
+/*
+ * Merge the first SORT_MERGE_ORDER runs into a new run.
+ */
+static int
+merge_runs(RDB_sort *sp, RDB_exec_context *ecp)
+{
+    int i;
+    RDB_int count = 0;
+    FILE *fp = create_run_file(ecp);
+    if (fp == NULL)
+        return RDB_ERROR;
+    if (add_run(sp, fp, ecp) != RDB_OK) {
+        fclose(fp);
+        return RDB_ERROR;
+    }
+
+    if (start_merge(sp, SORT_MERGE_ORDER, ecp) != RDB_OK)
+        return RDB_ERROR;
+    while (sp->heapc > 0 && count < sp->limit) {
+        const char *recp = HEAP_REC(sp, 0);
+        if (!is_last_tuple(sp, recp)) {
+            if (write_rec(fp, recp, rec_size(sp, recp), ecp) != RDB_OK)
+                return RDB_ERROR;
+            if (set_last_tuple(sp, recp, ecp) != RDB_OK)
+                return RDB_ERROR;
+            count++;
+        }
+        if (merge_pop(sp, ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
+
+    for (i = 0; i < SORT_MERGE_ORDER; i++) {
+        fclose(sp->runv[i].fp);
+        RDB_free(sp->runv[i].bufp);
+    }
+    memmove(sp->runv, sp->runv + SORT_MERGE_ORDER,
+            sizeof(sort_run) * (sp->runc - SORT_MERGE_ORDER));
+    sp->runc -= SORT_MERGE_ORDER;
+    return RDB_OK;
+}
+
+static int
+add_tuple(RDB_sort *sp, RDB_object *tplp, RDB_exec_context *ecp)
+{
+    int i;
+    size_t size;
+    char *recp;
+    char *datap;
+
+    tplp->store_typ = RDB_base_type(sp->reltyp);
+    if (RDB_obj_ilen(tplp, &sp->lenv[sp->keyc], ecp) != RDB_OK)
+        return RDB_ERROR;
+    size = REC_HDRSIZE(sp) + sp->lenv[sp->keyc];
+    for (i = 0; i < sp->keyc; i++) {
+        RDB_object *attrp = RDB_tuple_get(tplp, sp->keyv[i].attrname);
+        if (RDB_obj_ilen(attrp, &sp->lenv[i], ecp) != RDB_OK)
+            return RDB_ERROR;
+        size += sp->lenv[i];
+    }
+
+    if (sp->recc == sp->reccap) {
+        char **recv = RDB_realloc(sp->recv,
+                sizeof(char *) * (sp->reccap + RECV_INCREMENT), ecp);
+        if (recv == NULL)
+            return RDB_ERROR;
+        sp->recv = recv;
+        sp->reccap += RECV_INCREMENT;
+    }
+
+    recp = RDB_arena_alloc(&sp->arena, size);
+    if (recp == NULL) {
+        RDB_raise_no_memory(ecp);
+        return RDB_ERROR;
+    }
+    memcpy(recp, sp->lenv, REC_HDRSIZE(sp));
+    datap = recp + REC_HDRSIZE(sp);
+    for (i = 0; i < sp->keyc; i++) {
+        RDB_obj_to_irep(datap, RDB_tuple_get(tplp, sp->keyv[i].attrname),
+                sp->lenv[i]);
+        datap += sp->lenv[i];
+    }
+    RDB_obj_to_irep(datap, tplp, sp->lenv[sp->keyc]);
+
+    sp->recv[sp->recc++] = recp;
+    sp->memsize += size + sizeof(char *);
+    return RDB_OK;
+}
+
+/*
+ * Read the tuples of the table and sort them.
+ */
+static int
+read_tuples(RDB_sort *sp, RDB_expression *texp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    RDB_object *tplp;
+    RDB_tuple_batch batch;
+    size_t memlimit = tx_sort_mem(txp);
+    RDB_qresult *qrp = RDB_expr_qresult(texp, ecp, txp);
+    if (qrp == NULL)
+        return RDB_ERROR;
+
+    if (RDB_init_tuple_batch(&batch, qrp, ecp) != RDB_OK)
+        goto error;
+    while ((tplp = RDB_batch_next_tuple(&batch, ecp, txp)) != NULL) {
+        if (add_tuple(sp, tplp, ecp) != RDB_OK)
+            goto error;
+        if (sp->memsize > memlimit) {
+            if (write_run(sp, ecp) != RDB_OK)
+                goto error;
+        } else if (sp->limit <= RDB_INT_MAX / 2
+                && sp->recc >= sp->limit * 2) {
+            /*
+             * Only the first limit tuples are needed,
+             * so the others can be discarded
+             */
+            if (sort_recs(sp, ecp) != RDB_OK)
+                goto error;
+            if (compact_recs(sp, ecp) != RDB_OK)
+                goto error;
+        }
+    }
+    if (RDB_get_err(ecp) != NULL)
+        goto error;
+    RDB_destroy_tuple_batch(&batch, ecp);
+
+    if (RDB_del_qresult(qrp, ecp, txp) != RDB_OK)
+        return RDB_ERROR;
+
+    if (sp->runc == 0) {
+        return sort_recs(sp, ecp);
+    }
+
+    if (sp->recc > 0) {
+        if (write_run(sp, ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
+    /* Free memory which is no longer needed */
+    RDB_destroy_arena(&sp->arena);
+    RDB_init_arena(&sp->arena);
+
+    while (sp->runc > SORT_MERGE_ORDER) {
+        if (merge_runs(sp, ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
+    return start_merge(sp, sp->runc, ecp);
+
+error:
+    RDB_destroy_tuple_batch(&batch, ecp);
+    RDB_del_qresult(qrp, ecp, txp);
+    return RDB_ERROR;
+}
+
+static RDB_sort *
+new_sort(RDB_type *reltyp, int seqitc, const RDB_seq_item seqitv[],
+        RDB_int limit, RDB_exec_context *ecp)
+{
+    int i;
+    RDB_sort *sp = RDB_alloc(sizeof(RDB_sort), ecp);
+    if (sp == NULL)
+        return NULL;
+
+    sp->reltyp = NULL;
+    sp->keyc = seqitc;
+    sp->keyv = NULL;
+    sp->limit = limit;
+    RDB_init_arena(&sp->arena);
+    sp->recv = NULL;
+    sp->recc = 0;
+    sp->reccap = 0;
+    sp->memsize = 0;
+    sp->runv = NULL;
+    sp->runc = 0;
+    sp->heapv = NULL;
+    sp->heapc = 0;
+    sp->pos = 0;
+    sp->count = 0;
+    sp->lastp = NULL;
+    sp->lastsize = 0;
+    sp->lastvalid = RDB_FALSE;
+    sp->ecp = ecp;
+    sp->txp = NULL;
+    sp->cmperr = RDB_FALSE;
+
+    sp->lenv = RDB_alloc(sizeof(size_t) * (seqitc + 1), ecp);
+    if (sp->lenv == NULL)
+        goto error;
+
+    sp->reltyp = RDB_dup_nonscalar_type(reltyp, ecp);
+    if (sp->reltyp == NULL)
+        goto error;
+
+    if (seqitc > 0) {
+        sp->keyv = RDB_alloc(sizeof(sort_key) * seqitc, ecp);
+        if (sp->keyv == NULL)
+            goto error;
+        for (i = 0; i < seqitc; i++) {
+            RDB_attr *attrp = RDB_tuple_type_attr(RDB_base_type(sp->reltyp),
+                    seqitv[i].attrname);
+            if (attrp == NULL) {
+                RDB_raise_name(seqitv[i].attrname, ecp);
+                goto error;
+            }
+            sp->keyv[i].attrname = attrp->name;
+            sp->keyv[i].typ = attrp->typ;
+            sp->keyv[i].asc = seqitv[i].asc;
+        }
+    }
+    return sp;
+
+error:
+    RDB_del_sort(sp, ecp);
+    return NULL;
+}
+
+void
+RDB_del_sort(RDB_sort *sp, RDB_exec_context *ecp)
+{
+    int i;
+
+    for (i = 0; i < sp->runc; i++) {
+        fclose(sp->runv[i].fp);
+        RDB_free(sp->runv[i].bufp);
+    }
+    RDB_free(sp->runv);
+    RDB_free(sp->heapv);
+    RDB_free(sp->recv);
+    RDB_destroy_arena(&sp->arena);
+    RDB_free(sp->lastp);
+    RDB_free(sp->keyv);
+    RDB_free(sp->lenv);
+    if (sp->reltyp != NULL)
+        RDB_del_nonscalar_type(sp->reltyp, ecp);
+    RDB_free(sp);
+}
+
+int
+RDB_reset_sort(RDB_sort *sp, RDB_exec_context *ecp)
+{
+    sp->count = 0;
+    if (sp->runc == 0) {
+        sp->pos = 0;
+        return RDB_OK;
+    }
+    return start_merge(sp, sp->runc, ecp);
+}
+
+int
+RDB_next_sorted_tuple(RDB_qresult *qrp, RDB_object *tplp,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    const char *recp;
+    RDB_sort *sp = qrp->val.stored.sortp;
+
+    sp->ecp = ecp;
+    sp->txp = txp;
+
+    if (sp->count >= sp->limit)
+        goto end;
+
+    if (sp->runc == 0) {
+        if (sp->pos >= sp->recc)
+            goto end;
+        recp = sp->recv[sp->pos++];
+    } else {
+        /* Skip duplicates */
+        for (;;) {
+            if (sp->heapc == 0)
+                goto end;
+            if (!is_last_tuple(sp, HEAP_REC(sp, 0)))
+                break;
+            if (merge_pop(sp, ecp) != RDB_OK)
+                return RDB_ERROR;
+        }
+        recp = HEAP_REC(sp, 0);
+    }
+
+    if (RDB_irep_to_obj(tplp, RDB_base_type(sp->reltyp), rec_tuple(sp, recp),
+            REC_LENV(recp)[sp->keyc], ecp) != RDB_OK)
+        return RDB_ERROR;
+    if (sp->runc > 0) {
+        if (set_last_tuple(sp, recp, ecp) != RDB_OK)
+            return RDB_ERROR;
+        if (merge_pop(sp, ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
+    sp->count++;
+    return RDB_OK;
+
+end:
+    qrp->endreached = RDB_TRUE;
+    RDB_raise_not_found("", ecp);
+    return RDB_ERROR;
+}
+
+#ifdef POSTGRESQL
+static RDB_bool
+order_contains_nonsql_type(const RDB_type *reltyp, int seqitc,
+        const RDB_seq_item seqitv[])
+{
+    int i;
+    RDB_type *attrtyp;
+
+    for (i = 0; i < seqitc; i++) {
+        attrtyp = RDB_type_attr_type(reltyp, seqitv[i].attrname);
+        if (attrtyp != &RDB_BOOLEAN && attrtyp != &RDB_INTEGER && attrtyp != &RDB_FLOAT
+                && attrtyp != &RDB_STRING && attrtyp != &RDB_BINARY) {
+            return RDB_TRUE;
+        }
+    }
+    return RDB_FALSE;
+}
+#endif
+
+/*
+ * Creates a qresult which sorts a table.
+ * At most limit tuples are returned.
+ */
+int
+RDB_sorter(RDB_expression *texp, RDB_qresult **qrpp, RDB_exec_context *ecp,
+        RDB_transaction *txp, int seqitc, const RDB_seq_item seqitv[],
+        RDB_int limit)
+{
+    RDB_type *typ;
+    RDB_sort *sp = NULL;
+    RDB_qresult *qrp = RDB_alloc(sizeof (RDB_qresult), ecp);
+    if (qrp == NULL) {
+        return RDB_ERROR;
+    }
+
+    typ = RDB_expr_type(texp, NULL, NULL, NULL, ecp, txp);
+    if (typ == NULL)
+        goto error;
+
+#ifdef POSTGRESQL
+    if (txp != NULL && RDB_env_queries(txp->envp)
+            && !order_contains_nonsql_type(typ, seqitc, seqitv)
+            && RDB_sql_convertible(texp)) {
+        RDB_object sql;
+        RDB_cursor *curp;
+        RDB_init_obj(&sql);
+        if (RDB_expr_to_sql_select(&sql, texp, seqitc, seqitv, txp->envp, ecp)
+                != RDB_OK) {
+            RDB_destroy_obj(&sql, ecp);
+            goto error;
+        }
+        if (limit != RDB_INT_MAX) {
+            char limitbuf[24];
+
+            sprintf(limitbuf, " LIMIT %d", (int) limit);
+            if (RDB_append_string(&sql, limitbuf, ecp) != RDB_OK) {
+                RDB_destroy_obj(&sql, ecp);
+                goto error;
+            }
+        }
+        curp = RDB_pg_query_cursor(txp->envp, RDB_obj_string(&sql), RDB_FALSE,
+                txp->tx, ecp);
+        RDB_destroy_obj(&sql, ecp);
+        if (curp == NULL)
+            goto error;
+        if (RDB_init_cursor_qresult(qrp, curp, NULL, texp, ecp, txp) != RDB_OK)
+            goto error;
+        *qrpp = qrp;
+        return RDB_OK;
+    }
+#endif
+
+    qrp->exp = NULL;
+    qrp->nested = RDB_FALSE;
+    qrp->val.stored.tbp = NULL;
+    qrp->val.stored.curp = NULL;
+    qrp->val.stored.attrv = NULL;
+    qrp->endreached = RDB_FALSE;
+    qrp->matp = NULL;
+    RDB_init_arena(&qrp->arena);
+    qrp->dupsetp = NULL;
+
+    sp = new_sort(typ, seqitc, seqitv, limit, ecp);
+    if (sp == NULL)
+        goto error;
+    sp->txp = txp;
+
+    if (limit > 0) {
+        if (read_tuples(sp, texp, ecp, txp) != RDB_OK)
+            goto error;
+    }
+    qrp->val.stored.sortp = sp;
+
+    *qrpp = qrp;
+    return RDB_OK;
+
+error:
+    if (sp != NULL)
+        RDB_del_sort(sp, ecp);
+    RDB_free(qrp);
+    return RDB_ERROR;
+}
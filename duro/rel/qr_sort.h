@@ -0,0 +1,30 @@
+/*
+ * qr_sort.h
+ *
+ *  Created on: 16.10.2018
+ *      Author: Rene Hartmann
+ */
+
+#ifndef QR_SORT_H_
+#define QR_SORT_H_
+
+#include "rdb.h"
+
+typedef struct RDB_sort RDB_sort;
+
+int
+RDB_sorter(RDB_expression *, RDB_qresult **qrespp, RDB_exec_context *,
+        RDB_transaction *, int seqitc, const RDB_seq_item seqitv[],
+        RDB_int limit);
+
+int
+RDB_next_sorted_tuple(RDB_qresult *, RDB_object *, RDB_exec_context *,
+        RDB_transaction *);
+
+int
+RDB_reset_sort(RDB_sort *, RDB_exec_context *);
+
+void
+RDB_del_sort(RDB_sort *, RDB_exec_context *);
+
+#endif /* QR_SORT_H_ */
@@ -27,6 +27,9 @@ RDB_init_cursor_qresult(RDB_qresult *qrp, RDB_cursor *curp, RDB_object *tbp,
     qrp->val.stored.tbp = tbp;
     qrp->endreached = RDB_FALSE;
     qrp->matp = NULL;
+    RDB_init_arena(&qrp->arena);
+    qrp->dupsetp = NULL;
+    qrp->val.stored.attrv = NULL;
 
     qrp->val.stored.curp = curp;
     ret = RDB_cursor_first(qrp->val.stored.curp, ecp);
@@ -65,8 +68,11 @@ RDB_init_stored_qresult(RDB_qresult *qrp, RDB_object *tbp, RDB_expression *exp,
             qrp->nested = RDB_FALSE;
             qrp->val.stored.tbp = tbp;
             qrp->matp = NULL;
+            RDB_init_arena(&qrp->arena);
+            qrp->dupsetp = NULL;
             qrp->endreached = RDB_TRUE;
             qrp->val.stored.curp = NULL;
+            qrp->val.stored.attrv = NULL;
             return RDB_OK;
         }
     }
@@ -83,64 +89,108 @@ RDB_init_stored_qresult(RDB_qresult *qrp, RDB_object *tbp, RDB_expression *exp,
     return RDB_OK;
 }
 
-int
-RDB_next_stored_tuple(RDB_qresult *qrp, RDB_object *tbp, RDB_object *tplp,
-        RDB_bool asc, RDB_bool dup, RDB_type *tpltyp,
-        RDB_exec_context *ecp, RDB_transaction *txp)
+/*
+ * Return the field numbers of the attributes of *tpltyp,
+ * which must be the tuple type of the table.
+ */
+static RDB_int *
+table_fnov(RDB_stored_table *stp, RDB_type *tpltyp, RDB_exec_context *ecp)
 {
-    int ret;
-
-    if (qrp->endreached) {
-        RDB_raise_not_found("", ecp);
-        return RDB_ERROR;
-    }
+    int i;
 
-    if (tplp != NULL) {
-        ret = RDB_get_by_cursor(tbp, qrp->val.stored.curp, tpltyp, tplp, ecp, txp);
-        if (ret != RDB_OK) {
-            return RDB_ERROR;
-        }
-    }
-    if (asc) {
-        ret = RDB_cursor_next(qrp->val.stored.curp, dup ? RDB_REC_DUP : 0, ecp);
-    } else {
-        if (dup) {
-            RDB_raise_invalid_argument("", ecp);
-            return RDB_ERROR;
+    if (stp->fnov == NULL) {
+        stp->fnov = RDB_alloc(sizeof(RDB_int) * tpltyp->def.tuple.attrc, ecp);
+        if (stp->fnov == NULL)
+            return NULL;
+        for (i = 0; i < tpltyp->def.tuple.attrc; i++) {
+            stp->fnov[i] = *RDB_field_no(stp, tpltyp->def.tuple.attrv[i].name);
         }
-        ret = RDB_cursor_prev(qrp->val.stored.curp, ecp);
     }
-    if (ret == RDB_ERROR && RDB_obj_type(RDB_get_err(ecp)) == &RDB_NOT_FOUND_ERROR) {
-        qrp->endreached = RDB_TRUE;
+    return stp->fnov;
+}
+
+/*
+ * Remove the value of attribute i from *tplp, if there is one.
+ * If hdp is not NULL, the value is stored in slot i.
+ */
+static int
+clear_attr(RDB_object *tplp, RDB_tuple_heading *hdp, int i,
+        const char *attrname, RDB_exec_context *ecp)
+{
+    RDB_object *valp = hdp != NULL ? RDB_tuple_slot(tplp, i)
+            : RDB_tuple_get(tplp, attrname);
+
+    if (valp == NULL || valp->kind == RDB_OB_INITIAL)
         return RDB_OK;
-    }
-    if (ret != RDB_OK) {
-        RDB_handle_err(ecp, txp);
+    if (RDB_destroy_obj(valp, ecp) != RDB_OK)
         return RDB_ERROR;
-    }
+    RDB_init_obj(valp);
     return RDB_OK;
 }
 
 /*
- * Get the next tuple using cursor *curp and store the result tuple in *tplp.
+ * Read the attributes of the tuple at the position of cursor *curp
+ * and store them in *tplp.
+ * If attrv is not NULL, only the attributes whose indexes are given by
+ * attrc and attrv are read. attrv must be in ascending order.
+ * The other attributes are not decoded, values which are left in *tplp
+ * from a previous call are removed so that no stale value is returned.
  */
-int
-RDB_get_by_cursor(RDB_object *tbp, RDB_cursor *curp, RDB_type *tpltyp,
-        RDB_object *tplp, RDB_exec_context *ecp, RDB_transaction *txp)
+static int
+get_by_cursor(RDB_object *tbp, RDB_cursor *curp, RDB_type *tpltyp,
+        int attrc, const int attrv[], RDB_object *tplp,
+        RDB_exec_context *ecp, RDB_transaction *txp)
 {
     int i;
+    int j;
     int ret;
-    RDB_object val;
     RDB_int fno;
     RDB_attr *attrp;
     void *datap;
     size_t len;
+    RDB_object *valp;
+    RDB_int *fnov = NULL;
+    RDB_tuple_heading *hdp = RDB_type_tuple_heading(tpltyp, ecp);
+    if (hdp == NULL)
+        return RDB_ERROR;
 
+    /*
+     * If the tuple is empty or has the heading of the tuple type,
+     * the attribute values can be stored by slot number
+     */
+    if (tplp->kind == RDB_OB_INITIAL
+            || (tplp->kind == RDB_OB_TUPLE && tplp->val.tpl.hdp == hdp)) {
+        if (RDB_tuple_set_heading(tplp, hdp, ecp) != RDB_OK)
+            return RDB_ERROR;
+    } else {
+        hdp = NULL;
+    }
+
+    if (tbp != NULL && tpltyp->def.tuple.attrc > 0
+            && tpltyp == RDB_base_type(RDB_obj_type(tbp))) {
+        fnov = table_fnov(tbp->val.tbp->stp, tpltyp, ecp);
+        if (fnov == NULL)
+            return RDB_ERROR;
+    }
+
+    j = 0;
     for (i = 0; i < tpltyp->def.tuple.attrc; i++) {
         attrp = &tpltyp->def.tuple.attrv[i];
 
+        if (attrv != NULL) {
+            if (j < attrc && attrv[j] == i) {
+                j++;
+            } else {
+                /* Attribute is not decoded */
+                if (clear_attr(tplp, hdp, i, attrp->name, ecp) != RDB_OK)
+                    return RDB_ERROR;
+                continue;
+            }
+        }
+
         if (tbp != NULL) {
-            fno = *RDB_field_no(tbp->val.tbp->stp, attrp->name);
+            fno = fnov != NULL ? fnov[i]
+                    : *RDB_field_no(tbp->val.tbp->stp, attrp->name);
             ret = RDB_cursor_get(curp, fno, &datap, &len, ecp);
         } else {
 #ifdef POSTGRESQL
@@ -155,17 +205,66 @@ RDB_get_by_cursor(RDB_object *tbp, RDB_cursor *curp, RDB_type *tpltyp,
             RDB_handle_err(ecp, txp);
             return RDB_ERROR;
         }
-        RDB_init_obj(&val);
-        ret = RDB_tuple_set(tplp, attrp->name, &val, ecp);
-        RDB_destroy_obj(&val, ecp);
+        if (hdp != NULL) {
+            valp = RDB_tuple_slot(tplp, i);
+        } else {
+            if (RDB_tuple_set(tplp, attrp->name, NULL, ecp) != RDB_OK)
+                return RDB_ERROR;
+            valp = RDB_tuple_get(tplp, attrp->name);
+        }
+        ret = RDB_irep_to_obj(valp, attrp->typ, datap, len, ecp);
         if (ret != RDB_OK) {
             return RDB_ERROR;
         }
-        ret = RDB_irep_to_obj(RDB_tuple_get(tplp, attrp->name),
-                attrp->typ, datap, len, ecp);
+    }
+    return RDB_OK;
+}
+
+int
+RDB_next_stored_tuple(RDB_qresult *qrp, RDB_object *tbp, RDB_object *tplp,
+        RDB_bool asc, RDB_bool dup, RDB_type *tpltyp,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int ret;
+
+    if (qrp->endreached) {
+        RDB_raise_not_found("", ecp);
+        return RDB_ERROR;
+    }
+
+    if (tplp != NULL) {
+        ret = get_by_cursor(tbp, qrp->val.stored.curp, tpltyp,
+                qrp->val.stored.attrc, qrp->val.stored.attrv, tplp, ecp, txp);
         if (ret != RDB_OK) {
             return RDB_ERROR;
         }
     }
+    if (asc) {
+        ret = RDB_cursor_next(qrp->val.stored.curp, dup ? RDB_REC_DUP : 0, ecp);
+    } else {
+        if (dup) {
+            RDB_raise_invalid_argument("", ecp);
+            return RDB_ERROR;
+        }
+        ret = RDB_cursor_prev(qrp->val.stored.curp, ecp);
+    }
+    if (ret == RDB_ERROR && RDB_obj_type(RDB_get_err(ecp)) == &RDB_NOT_FOUND_ERROR) {
+        qrp->endreached = RDB_TRUE;
+        return RDB_OK;
+    }
+    if (ret != RDB_OK) {
+        RDB_handle_err(ecp, txp);
+        return RDB_ERROR;
+    }
     return RDB_OK;
 }
+
+/*
+ * Get the tuple at the position of cursor *curp and store it in *tplp.
+ */
+int
+RDB_get_by_cursor(RDB_object *tbp, RDB_cursor *curp, RDB_type *tpltyp,
+        RDB_object *tplp, RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    return get_by_cursor(tbp, curp, tpltyp, 0, NULL, tplp, ecp, txp);
+}
@@ -9,6 +9,9 @@
 #include "qr_stored.h"
 #include "qr_join.h"
 #include "qr_tclose.h"
+#include "qr_sort.h"
+#include "tupleset.h"
+#include "cexpr.h"
 #include "internal.h"
 #include "insert.h"
 #include "delete.h"
@@ -20,8 +23,8 @@
 #include <obj/key.h>
 #include <obj/objinternal.h>
 #include <rec/indeximpl.h>
-#include <gen/hashtabit.h>
 #include <gen/strfns.h>
+#include <gen/hashtabit.h>
 
 #ifdef POSTGRESQL
 #include <pgrec/pgcursor.h>
@@ -43,16 +46,19 @@ struct RDB_summval {
 
 static int
 summ_step(struct RDB_summval *svalp, const RDB_object *addvalp,
-        const char *opname, RDB_int count, RDB_exec_context *ecp)
+        enum RDB_op_code code, RDB_int count, RDB_exec_context *ecp)
 {
-    if (strcmp(opname, "count") == 0) {
+    switch (code) {
+    case RDB_OP_COUNT:
         svalp->val.val.int_val++;
-    } else if (strcmp(opname, "avg") == 0) {
+        break;
+    case RDB_OP_AVG:
         svalp->val.val.float_val =
                 (svalp->val.val.float_val * count
                 + addvalp->val.float_val)
                 / (count + 1);
-    } else if (strcmp(opname, "sum") == 0) {
+        break;
+    case RDB_OP_SUM:
         if (svalp->val.typ == &RDB_INTEGER) {
             if (addvalp->val.int_val > 0) {
                 if (svalp->val.val.int_val > RDB_INT_MAX - addvalp->val.int_val) {
@@ -68,15 +74,17 @@ summ_step(struct RDB_summval *svalp, const RDB_object *addvalp,
             svalp->val.val.int_val += addvalp->val.int_val;
         } else
             svalp->val.val.float_val += addvalp->val.float_val;
-    } else if (strcmp(opname, "max") == 0) {
-            if (svalp->val.typ == &RDB_INTEGER) {
-                if (addvalp->val.int_val > svalp->val.val.int_val)
-                    svalp->val.val.int_val = addvalp->val.int_val;
-            } else {
-                if (addvalp->val.float_val > svalp->val.val.float_val)
-                    svalp->val.val.float_val = addvalp->val.float_val;
-            }
-    } else if (strcmp(opname, "min") == 0) {
+        break;
+    case RDB_OP_MAX:
+        if (svalp->val.typ == &RDB_INTEGER) {
+            if (addvalp->val.int_val > svalp->val.val.int_val)
+                svalp->val.val.int_val = addvalp->val.int_val;
+        } else {
+            if (addvalp->val.float_val > svalp->val.val.float_val)
+                svalp->val.val.float_val = addvalp->val.float_val;
+        }
+        break;
+    case RDB_OP_MIN:
         if (svalp->val.typ == &RDB_INTEGER) {
             if (addvalp->val.int_val < svalp->val.val.int_val)
                 svalp->val.val.int_val = addvalp->val.int_val;
@@ -84,16 +92,539 @@ summ_step(struct RDB_summval *svalp, const RDB_object *addvalp,
             if (addvalp->val.float_val < svalp->val.val.float_val)
                 svalp->val.val.float_val = addvalp->val.float_val;
         }
-    } else if (strcmp(opname, "any") == 0) {
+        break;
+    case RDB_OP_ANY:
         if (addvalp->val.bool_val)
             svalp->val.val.bool_val = RDB_TRUE;
-    } else if (strcmp(opname, "all") == 0) {
+        break;
+    case RDB_OP_ALL:
         if (!addvalp->val.bool_val)
             svalp->val.val.bool_val = RDB_FALSE;
+        break;
+    default: ;
     }
     return RDB_OK;
 }
 
+/*
+ * Set *valp to the value of the aggregate operator invocation opexp
+ * for an empty group
+ */
+static int
+summ_init_val(RDB_expression *opexp, RDB_type *tb1typ, RDB_object *valp,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    RDB_type *typ;
+
+    switch (opexp->def.op.code) {
+    case RDB_OP_COUNT:
+        RDB_int_to_obj(valp, 0);
+        return RDB_OK;
+    case RDB_OP_AVG:
+        RDB_float_to_obj(valp, 0.0);
+        return RDB_OK;
+    case RDB_OP_ALL:
+        RDB_bool_to_obj(valp, RDB_TRUE);
+        return RDB_OK;
+    case RDB_OP_ANY:
+        RDB_bool_to_obj(valp, RDB_FALSE);
+        return RDB_OK;
+    case RDB_OP_SUM:
+    case RDB_OP_MAX:
+    case RDB_OP_MIN:
+        break;
+    default:
+        RDB_raise_invalid_argument(opexp->def.op.name, ecp);
+        return RDB_ERROR;
+    }
+
+    typ = RDB_expr_type_tpltyp(opexp->def.op.args.firstp,
+            tb1typ->def.basetyp, NULL, NULL, NULL, ecp, txp);
+    if (typ == NULL)
+        return RDB_ERROR;
+    if (opexp->def.op.code == RDB_OP_SUM) {
+        if (typ == &RDB_INTEGER)
+            RDB_int_to_obj(valp, 0);
+        else
+            RDB_float_to_obj(valp, 0.0);
+    } else if (opexp->def.op.code == RDB_OP_MAX) {
+        if (typ == &RDB_INTEGER)
+            RDB_int_to_obj(valp, RDB_INT_MIN);
+        else
+            RDB_float_to_obj(valp, RDB_FLOAT_MIN);
+    } else {
+        if (typ == &RDB_INTEGER)
+            RDB_int_to_obj(valp, RDB_INT_MAX);
+        else
+            RDB_float_to_obj(valp, RDB_FLOAT_MAX);
+    }
+    return RDB_OK;
+}
+
+/*
+ * A group of SUMMARIZE PER or GROUP, identified by the values of the
+ * PER attributes or of the attributes which are not grouped.
+ * Groups with the same hash value are chained.
+ */
+typedef struct RDB_hgroup {
+    unsigned hash;
+
+    /* Contains the attributes which identify the group */
+    RDB_object tpl;
+
+    /* SUMMARIZE: one accumulator for each aggregate operator invocation */
+    struct RDB_summval *svalv;
+
+    /* GROUP: the relation-valued attribute */
+    RDB_object gtb;
+
+    /* Number of tuples which have been added to the group */
+    RDB_int count;
+
+    struct RDB_hgroup *nextp;
+} RDB_hgroup;
+
+typedef struct {
+    /* Contains the first RDB_hgroup of each chain */
+    RDB_hashtable tab;
+
+    /* The attributes which identify a group */
+    int attrc;
+    char **attrv;
+
+    /* Number of accumulators per group */
+    int svalc;
+
+    /* The groups and accumulators are allocated from this arena */
+    RDB_arena arena;
+
+    /* Estimated number of bytes used by the groups */
+    size_t memsize;
+} RDB_hgroup_tab;
+
+enum {
+    HGROUP_TAB_CAPACITY = 256,
+    RDB_DEFAULT_HASH_MEM = 16 * 1024 * 1024
+};
+
+static size_t hash_mem = RDB_DEFAULT_HASH_MEM;
+
+/**
+ * Set the number of bytes SUMMARIZE and GROUP may use for an
+ * in-memory hash table. If the limit is exceeded, the groups are stored
+ * in a temporary table and the remaining tuples are added
+ * to that table.
+ * The limit can be set per environment using the hash_mem setting
+ * of RDB_open_env_config(), which takes precedence.
+ */
+void
+RDB_set_hash_mem(size_t size)
+{
+    hash_mem = size;
+}
+
+/**
+ * Return the number of bytes SUMMARIZE and GROUP may use for an
+ * in-memory hash table.
+ */
+size_t
+RDB_hash_mem(void)
+{
+    return hash_mem;
+}
+
+/*
+ * Return the hash table memory limit of the environment, if it has been
+ * configured, otherwise the value set by RDB_set_hash_mem().
+ */
+static size_t
+tx_hash_mem(RDB_transaction *txp)
+{
+    if (txp != NULL) {
+        size_t size = RDB_env_hash_mem(RDB_db_env(RDB_tx_db(txp)));
+        if (size > 0)
+            return size;
+    }
+    return hash_mem;
+}
+
+static unsigned
+hash_hgroup(const void *entryp, void *arg)
+{
+    return ((const RDB_hgroup *) entryp)->hash;
+}
+
+static RDB_bool
+hgroup_equals(const void *e1p, const void *e2p, void *arg)
+{
+    return (RDB_bool) (((const RDB_hgroup *) e1p)->hash
+            == ((const RDB_hgroup *) e2p)->hash);
+}
+
+static void
+init_hgroup_tab(RDB_hgroup_tab *hgtp, int attrc, char **attrv, int svalc)
+{
+    RDB_init_hashtable(&hgtp->tab, HGROUP_TAB_CAPACITY, &hash_hgroup,
+            &hgroup_equals);
+    hgtp->attrc = attrc;
+    hgtp->attrv = attrv;
+    hgtp->svalc = svalc;
+    RDB_init_arena(&hgtp->arena);
+    hgtp->memsize = 0;
+}
+
+static void
+destroy_hgroup_tab(RDB_hgroup_tab *hgtp, RDB_exec_context *ecp)
+{
+    int i;
+    RDB_hashtable_iter hiter;
+    RDB_hgroup *grp;
+
+    RDB_init_hashtable_iter(&hiter, &hgtp->tab);
+    while ((grp = RDB_hashtable_next(&hiter)) != NULL) {
+        do {
+            RDB_hgroup *nextp = grp->nextp;
+
+            RDB_destroy_obj(&grp->tpl, ecp);
+            for (i = 0; i < hgtp->svalc; i++)
+                RDB_destroy_obj(&grp->svalv[i].val, ecp);
+            RDB_destroy_obj(&grp->gtb, ecp);
+            grp = nextp;
+        } while (grp != NULL);
+    }
+    RDB_destroy_hashtable_iter(&hiter);
+    RDB_destroy_hashtable(&hgtp->tab);
+    RDB_destroy_arena(&hgtp->arena);
+}
+
+/*
+ * Estimate the number of bytes used by a tuple
+ */
+static size_t
+tuple_mem_size(const RDB_object *tplp)
+{
+    int i;
+    int attrc = RDB_tuple_size(tplp);
+    size_t size = sizeof(RDB_object) * attrc;
+
+    for (i = 0; i < attrc; i++) {
+        RDB_object *attrp = RDB_tuple_slot(tplp, i);
+
+        if (attrp->kind == RDB_OB_BIN)
+            size += attrp->val.bin.len;
+    }
+    return size;
+}
+
+/*
+ * Allocate a new group, initialize it and add it to the hashtable.
+ * The caller must fill grp->tpl.
+ */
+static RDB_hgroup *
+add_hgroup(RDB_hgroup_tab *hgtp, unsigned hash, RDB_exec_context *ecp)
+{
+    int i;
+    RDB_hgroup *headp;
+    RDB_hgroup *grp = RDB_arena_alloc(&hgtp->arena, sizeof(RDB_hgroup));
+    if (grp == NULL) {
+        RDB_raise_no_memory(ecp);
+        return NULL;
+    }
+    grp->svalv = NULL;
+    if (hgtp->svalc > 0) {
+        grp->svalv = RDB_arena_alloc(&hgtp->arena,
+                sizeof(struct RDB_summval) * hgtp->svalc);
+        if (grp->svalv == NULL) {
+            RDB_raise_no_memory(ecp);
+            return NULL;
+        }
+    }
+    grp->hash = hash;
+    RDB_init_obj(&grp->tpl);
+    for (i = 0; i < hgtp->svalc; i++)
+        RDB_init_obj(&grp->svalv[i].val);
+    RDB_init_obj(&grp->gtb);
+    grp->count = 0;
+
+    /* Add group to the chain, if there is one */
+    headp = RDB_hashtable_get(&hgtp->tab, grp, NULL);
+    if (headp != NULL) {
+        grp->nextp = headp->nextp;
+        headp->nextp = grp;
+    } else {
+        grp->nextp = NULL;
+        if (RDB_hashtable_put(&hgtp->tab, grp, NULL) != RDB_OK) {
+            RDB_raise_no_memory(ecp);
+            return NULL;
+        }
+    }
+    hgtp->memsize += sizeof(RDB_hgroup)
+            + sizeof(struct RDB_summval) * hgtp->svalc;
+    return grp;
+}
+
+/*
+ * Find the group the tuple *tplp belongs to and store a pointer to it in
+ * *grpp, or NULL if there is no such group.
+ */
+static int
+find_hgroup(RDB_hgroup_tab *hgtp, const RDB_object *tplp, unsigned hash,
+        RDB_exec_context *ecp, RDB_transaction *txp, RDB_hgroup **grpp)
+{
+    RDB_hgroup key;
+    RDB_bool match;
+    RDB_hgroup *grp;
+
+    key.hash = hash;
+    for (grp = RDB_hashtable_get(&hgtp->tab, &key, NULL); grp != NULL;
+            grp = grp->nextp) {
+        if (RDB_tuple_matches(&grp->tpl, tplp, ecp, txp, &match) != RDB_OK)
+            return RDB_ERROR;
+        if (match)
+            break;
+    }
+    *grpp = grp;
+    return RDB_OK;
+}
+
+/*
+ * Store the SUMMARIZE groups in the materialized table
+ */
+static int
+store_summ_groups(RDB_qresult *qrp, RDB_hgroup_tab *hgtp,
+        RDB_expression *aggargp, RDB_bool hasavg, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    int i;
+    RDB_expression *argp;
+    RDB_hashtable_iter hiter;
+    RDB_hgroup *grp;
+
+    RDB_init_hashtable_iter(&hiter, &hgtp->tab);
+    while ((grp = RDB_hashtable_next(&hiter)) != NULL) {
+        do {
+            for (i = 0, argp = aggargp; i < hgtp->svalc;
+                    i++, argp = argp->nextp->nextp) {
+                if (RDB_tuple_set(&grp->tpl,
+                        RDB_obj_string(&argp->nextp->def.obj),
+                        &grp->svalv[i].val, ecp) != RDB_OK)
+                    goto error;
+            }
+            if (hasavg) {
+                if (RDB_tuple_set_int(&grp->tpl, AVG_COUNT, grp->count, ecp)
+                        != RDB_OK)
+                    goto error;
+            }
+            if (RDB_insert(qrp->matp, &grp->tpl, ecp, txp) != RDB_OK)
+                goto error;
+            grp = grp->nextp;
+        } while (grp != NULL);
+    }
+    RDB_destroy_hashtable_iter(&hiter);
+    return RDB_OK;
+
+error:
+    RDB_destroy_hashtable_iter(&hiter);
+    return RDB_ERROR;
+}
+
+/*
+ * Insert a tuple of table #2 into the materialized table,
+ * with the accumulators set to their initial values
+ */
+static int
+insert_summ_init_tuple(RDB_qresult *qrp, const RDB_object *tplp,
+        RDB_expression *aggargp, int addc, RDB_object *initv, RDB_bool hasavg,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int i;
+    RDB_expression *argp;
+    RDB_object tpl;
+
+    RDB_init_obj(&tpl);
+    if (RDB_copy_obj(&tpl, tplp, ecp) != RDB_OK)
+        goto error;
+    for (i = 0, argp = aggargp; i < addc; i++, argp = argp->nextp->nextp) {
+        if (RDB_tuple_set(&tpl, RDB_obj_string(&argp->nextp->def.obj),
+                &initv[i], ecp) != RDB_OK)
+            goto error;
+    }
+    if (hasavg) {
+        if (RDB_tuple_set_int(&tpl, AVG_COUNT, 0, ecp) != RDB_OK)
+            goto error;
+    }
+    if (RDB_insert(qrp->matp, &tpl, ecp, txp) != RDB_OK)
+        goto error;
+    return RDB_destroy_obj(&tpl, ecp);
+
+error:
+    RDB_destroy_obj(&tpl, ecp);
+    return RDB_ERROR;
+}
+
+/*
+ * Compute SUMMARIZE PER using a hashtable which maps the values of the
+ * PER attributes to the accumulators and store the result in qrp->matp.
+ * If the hashtable would exceed the memory limit, the groups created so far
+ * and the remaining tuples of table #2 are stored in qrp->matp with
+ * the accumulators set to their initial values, and *donep is set to
+ * RDB_FALSE. The caller must then add the tuples of table #1 to
+ * the materialized table.
+ */
+static int
+hash_summarize(RDB_qresult *qrp, RDB_type *tb1typ, RDB_string_vec *attrsp,
+        RDB_bool hasavg, RDB_exec_context *ecp, RDB_transaction *txp,
+        RDB_bool *donep)
+{
+    int i;
+    RDB_hgroup_tab hgtab;
+    RDB_hgroup *grp;
+    RDB_object *tplp;
+    RDB_expression *argp;
+    RDB_tuple_batch batch;
+    int ret = RDB_ERROR;
+    RDB_bool hashed = RDB_TRUE;
+    RDB_qresult *lqrp = NULL;
+    RDB_object *initv = NULL;
+    RDB_object *addv = NULL;
+    int addc = (RDB_expr_list_length(&qrp->exp->def.op.args) - 2) / 2;
+    RDB_expression *aggargp = qrp->exp->def.op.args.firstp->nextp->nextp;
+
+    batch.tplv = NULL;
+    init_hgroup_tab(&hgtab, attrsp->strc, attrsp->strv, addc);
+
+    /*
+     * Allocate the values of the accumulators for empty groups
+     * and the values which are added
+     */
+    if (addc > 0) {
+        initv = RDB_alloc(sizeof(RDB_object) * addc * 2, ecp);
+        if (initv == NULL)
+            goto cleanup;
+        addv = initv + addc;
+    }
+    for (i = 0; i < addc * 2; i++)
+        RDB_init_obj(&initv[i]);
+    for (i = 0, argp = aggargp; i < addc; i++, argp = argp->nextp->nextp) {
+        if (summ_init_val(argp, tb1typ, &initv[i], ecp, txp) != RDB_OK)
+            goto cleanup;
+    }
+
+    /*
+     * Create a group for each tuple of table #2
+     */
+
+    lqrp = RDB_expr_qresult(qrp->exp->def.op.args.firstp->nextp, ecp, txp);
+    if (lqrp == NULL)
+        goto cleanup;
+    if (RDB_duprem(lqrp, ecp, txp) != RDB_OK)
+        goto cleanup;
+    if (RDB_init_tuple_batch(&batch, lqrp, ecp) != RDB_OK)
+        goto cleanup;
+    while ((tplp = RDB_batch_next_tuple(&batch, ecp, txp)) != NULL) {
+        if (!hashed) {
+            if (insert_summ_init_tuple(qrp, tplp, aggargp, addc, initv, hasavg,
+                    ecp, txp) != RDB_OK)
+                goto cleanup;
+            continue;
+        }
+
+        grp = add_hgroup(&hgtab, RDB_tuple_hash_attrs(tplp, hgtab.attrc,
+                hgtab.attrv), ecp);
+        if (grp == NULL)
+            goto cleanup;
+        if (RDB_copy_obj(&grp->tpl, tplp, ecp) != RDB_OK)
+            goto cleanup;
+        for (i = 0; i < addc; i++) {
+            if (RDB_copy_obj(&grp->svalv[i].val, &initv[i], ecp) != RDB_OK)
+                goto cleanup;
+        }
+        hgtab.memsize += tuple_mem_size(tplp);
+
+        /*
+         * If the memory limit has been exceeded, store the groups
+         * and continue with the materialized table
+         */
+        if (hgtab.memsize > tx_hash_mem(txp)) {
+            if (store_summ_groups(qrp, &hgtab, aggargp, hasavg, ecp, txp)
+                    != RDB_OK)
+                goto cleanup;
+            destroy_hgroup_tab(&hgtab, ecp);
+            init_hgroup_tab(&hgtab, attrsp->strc, attrsp->strv, addc);
+            hashed = RDB_FALSE;
+        }
+    }
+    if (RDB_get_err(ecp) != NULL)
+        goto cleanup;
+    if (RDB_destroy_tuple_batch(&batch, ecp) != RDB_OK)
+        goto cleanup;
+    ret = RDB_del_qresult(lqrp, ecp, txp);
+    lqrp = NULL;
+    if (ret != RDB_OK)
+        goto cleanup;
+    ret = RDB_ERROR;
+
+    if (!hashed) {
+        *donep = RDB_FALSE;
+        ret = RDB_OK;
+        goto cleanup;
+    }
+
+    /*
+     * Add the tuples of table #1 to the groups
+     */
+
+    lqrp = RDB_expr_qresult(qrp->exp->def.op.args.firstp, ecp, txp);
+    if (lqrp == NULL)
+        goto cleanup;
+    if (RDB_duprem(lqrp, ecp, txp) != RDB_OK)
+        goto cleanup;
+    if (RDB_init_tuple_batch(&batch, lqrp, ecp) != RDB_OK)
+        goto cleanup;
+    while ((tplp = RDB_batch_next_tuple(&batch, ecp, txp)) != NULL) {
+        if (find_hgroup(&hgtab, tplp, RDB_tuple_hash_attrs(tplp, hgtab.attrc,
+                hgtab.attrv), ecp, txp, &grp) != RDB_OK)
+            goto cleanup;
+        if (grp == NULL)
+            continue;
+
+        for (i = 0, argp = aggargp; i < addc; i++, argp = argp->nextp->nextp) {
+            if (argp->def.op.code != RDB_OP_COUNT) {
+                if (RDB_evaluate(argp->def.op.args.firstp, &RDB_tpl_get, tplp,
+                        NULL, ecp, txp, &addv[i]) != RDB_OK)
+                    goto cleanup;
+            }
+            if (summ_step(&grp->svalv[i], &addv[i], argp->def.op.code,
+                    grp->count, ecp) != RDB_OK)
+                goto cleanup;
+        }
+        grp->count++;
+    }
+    if (RDB_get_err(ecp) != NULL)
+        goto cleanup;
+
+    /*
+     * Store the groups in the materialized table
+     */
+
+    if (store_summ_groups(qrp, &hgtab, aggargp, hasavg, ecp, txp) != RDB_OK)
+        goto cleanup;
+    *donep = RDB_TRUE;
+    ret = RDB_OK;
+
+cleanup:
+    RDB_destroy_tuple_batch(&batch, ecp);
+    if (lqrp != NULL)
+        RDB_del_qresult(lqrp, ecp, txp);
+    if (initv != NULL) {
+        for (i = 0; i < addc * 2; i++)
+            RDB_destroy_obj(&initv[i], ecp);
+        RDB_free(initv);
+    }
+    destroy_hgroup_tab(&hgtab, ecp);
+    return ret;
+}
+
 static int
 do_summarize(RDB_qresult *qrp, RDB_type *tb1typ, RDB_bool hasavg,
         RDB_exec_context *ecp, RDB_transaction *txp)
@@ -180,10 +711,9 @@ do_summarize(RDB_qresult *qrp, RDB_type *tb1typ, RDB_bool hasavg,
                 for (i = 0; i < addc; i++) {
                     RDB_type *typ;
                     RDB_object addval;
-                    char *opname = argp->def.op.name;
 
                     RDB_init_obj(&addval);
-                    if (strcmp(opname, "count") == 0) {
+                    if (argp->def.op.code == RDB_OP_COUNT) {
                         ret = RDB_irep_to_obj(&svalv[i].val, &RDB_INTEGER,
                                 nonkeyfv[i].datap, nonkeyfv[i].len, ecp);
                     } else {
@@ -208,7 +738,8 @@ do_summarize(RDB_qresult *qrp, RDB_type *tb1typ, RDB_bool hasavg,
                             goto cleanup;
                         }
                     }
-                    ret = summ_step(&svalv[i], &addval, opname, count, ecp);
+                    ret = summ_step(&svalv[i], &addval, argp->def.op.code,
+                            count, ecp);
                     if (ret != RDB_OK)
                         goto cleanup;
                     RDB_destroy_obj(&addval, ecp);
@@ -260,120 +791,13 @@ cleanup:
     return ret;
 }
 
-static int
-init_summ_table(RDB_qresult *qrp, RDB_type *tb1typ, RDB_bool hasavg, RDB_exec_context *ecp,
-        RDB_transaction *txp)
-{
-    int ret;
-    RDB_qresult *lqrp;
-    RDB_object tpl;
-    RDB_expression *argp;
-
-    /*
-     * Initialize table from table #2
-     */
-
-    lqrp = RDB_expr_qresult(qrp->exp->def.op.args.firstp->nextp, ecp, txp);
-    if (lqrp == NULL) {
-        return RDB_ERROR;
-    }
-    ret = RDB_duprem(lqrp, ecp, txp);
-    if (ret != RDB_OK) {
-        return RDB_ERROR;
-    }
-
-    RDB_init_obj(&tpl);
-    for(;;) {
-        ret = RDB_next_tuple(lqrp, &tpl, ecp, txp);
-        if (ret != RDB_OK)
-            break;
-
-        /* Extend tuple */
-        argp = qrp->exp->def.op.args.firstp->nextp->nextp;
-        while (argp != NULL) {
-            char *name = RDB_obj_string(&argp->nextp->def.obj);
-            RDB_expression *opexp = argp;
-            char *opname = opexp->def.op.name;
-            RDB_type *typ;
-
-            if (strcmp(opname, "count") == 0) {
-                ret = RDB_tuple_set_int(&tpl, name, 0, ecp);
-            } else if (strcmp(opname, "avg") == 0) {
-                ret = RDB_tuple_set_float(&tpl, name, 0, ecp);
-            } else if (strcmp(opname, "sum") == 0) {
-                typ = RDB_expr_type_tpltyp(opexp->def.op.args.firstp,
-                        tb1typ->def.basetyp, NULL, NULL, NULL, ecp, txp);
-                if (typ == NULL)
-                    goto error;
-                if (typ == &RDB_INTEGER)
-                    ret = RDB_tuple_set_int(&tpl, name, 0, ecp);
-                else
-                    ret = RDB_tuple_set_float(&tpl, name, 0.0, ecp);
-            } else if (strcmp(opname, "max") == 0) {
-                typ = RDB_expr_type_tpltyp(opexp->def.op.args.firstp,
-                        tb1typ->def.basetyp, NULL, NULL, NULL, ecp, txp);
-                if (typ == NULL)
-                    goto error;
-                if (typ == &RDB_INTEGER)
-                    ret = RDB_tuple_set_int(&tpl, name, RDB_INT_MIN, ecp);
-                else {
-                    ret = RDB_tuple_set_float(&tpl, name,
-                            RDB_FLOAT_MIN, ecp);
-                }
-            } else if (strcmp(opname, "min") == 0) {
-                typ = RDB_expr_type_tpltyp(opexp->def.op.args.firstp,
-                        tb1typ->def.basetyp, NULL, NULL, NULL, ecp, txp);
-                if (typ == NULL)
-                    goto error;
-                if (typ == &RDB_INTEGER)
-                    ret = RDB_tuple_set_int(&tpl, name, RDB_INT_MAX, ecp);
-                else {
-                    ret = RDB_tuple_set_float(&tpl, name,
-                            RDB_FLOAT_MAX, ecp);
-                }
-            } else if (strcmp(opname, "all") == 0) {
-                ret = RDB_tuple_set_bool(&tpl, name, RDB_TRUE, ecp);
-            } else if (strcmp(opname, "any") == 0) {
-                ret = RDB_tuple_set_bool(&tpl, name, RDB_FALSE, ecp);
-            }
-            if (ret != RDB_OK)
-                goto error;
-            argp = argp->nextp->nextp;
-        } /* for */
-
-        if (hasavg) {
-            if (RDB_tuple_set_int(&tpl, AVG_COUNT, 0, ecp) != RDB_OK)
-                goto error;
-        }
-
-        ret = RDB_insert(qrp->matp, &tpl, ecp, txp);
-        if (ret != RDB_OK)
-            goto error;
-    };
-
-    if (ret != RDB_OK) {
-        if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR) {
-            goto error;
-        }
-        RDB_clear_err(ecp);
-    }
-
-    RDB_destroy_obj(&tpl, ecp);
-    return RDB_del_qresult(lqrp, ecp, txp);
-
-error:
-    RDB_destroy_obj(&tpl, ecp);
-    RDB_del_qresult(lqrp, ecp, txp);
-
-    return RDB_ERROR;
-}
-
 static int
 summarize_qresult(RDB_qresult *qrp, RDB_expression *exp, RDB_exec_context *ecp,
         RDB_transaction *txp)
 {
     int i;
     RDB_bool hasavg;
+    RDB_bool hashed = RDB_FALSE;
     RDB_string_vec key;
     RDB_expression *argp;
     RDB_type *tb1typ;
@@ -404,7 +828,7 @@ summarize_qresult(RDB_qresult *qrp, RDB_expression *exp, RDB_exec_context *ecp,
     hasavg = RDB_FALSE;
     argp = exp->def.op.args.firstp->nextp->nextp;
     while (argp != NULL) {
-        if (strcmp(argp->def.op.name, "avg") == 0) {
+        if (argp->def.op.code == RDB_OP_AVG) {
             hasavg = RDB_TRUE;
             break;
         }
@@ -436,7 +860,7 @@ summarize_qresult(RDB_qresult *qrp, RDB_expression *exp, RDB_exec_context *ecp,
         goto error;
     }
     for (i = 0; i < key.strc; i++) {
-        key.strv[0] = tb2typ->def.basetyp->def.tuple.attrv[i].name;
+        key.strv[i] = tb2typ->def.basetyp->def.tuple.attrv[i].name;
     }
 
     /* Create materialized table */
@@ -449,13 +873,20 @@ summarize_qresult(RDB_qresult *qrp, RDB_expression *exp, RDB_exec_context *ecp,
         goto error;
 
     qrp->matp = matp;
-    if (init_summ_table(qrp, tb1typ, hasavg, ecp, txp) != RDB_OK) {
+    if (hash_summarize(qrp, tb1typ, &key, hasavg, ecp, txp, &hashed)
+            != RDB_OK) {
         goto error;
     }
 
-    /* summarize over table 1 */
-    if (do_summarize(qrp, tb1typ, hasavg, ecp, txp) != RDB_OK) {
-        goto error;
+    /*
+     * If the groups did not fit into memory, the materialized table
+     * has been initialized from table 2, so update it
+     * for each tuple of table 1
+     */
+    if (!hashed) {
+        if (do_summarize(qrp, tb1typ, hasavg, ecp, txp) != RDB_OK) {
+            goto error;
+        }
     }
 
     if (RDB_init_stored_qresult(qrp, matp, NULL, ecp, txp) != RDB_OK) {
@@ -498,149 +929,262 @@ sdivide_qresult(RDB_qresult *qrp, RDB_expression *exp, RDB_exec_context *ecp,
     return RDB_OK;
 }
 
+/*
+ * Add the tuple *tplp to the materialized table of a GROUP,
+ * reading and updating the relation-valued attribute of the group
+ * if the group already exists
+ */
 static int
-do_group(RDB_qresult *qrp, RDB_exec_context *ecp, RDB_transaction *txp)
+group_tuple_rec(RDB_qresult *qrp, RDB_object *tplp, RDB_field *keyfv,
+        RDB_object *gvalp, RDB_exec_context *ecp, RDB_transaction *txp)
 {
-    RDB_qresult *newqrp;
-    RDB_object tpl;
-    RDB_field *keyfv;
     RDB_field gfield;
-    RDB_object gval;
     int ret;
     int i;
-    int keyfc;
+    int keyfc = RDB_pkey_len(qrp->matp);
     char *gattrname = RDB_obj_string(&qrp->exp->def.op.args.lastp->def.obj);
     RDB_type *greltyp = RDB_tuple_type_attr(qrp->matp->typ->def.basetyp,
                         gattrname)->typ;
 
-    keyfc = RDB_pkey_len(qrp->matp);
+    /* Build key */
+    for (i = 0; i < keyfc; i++) {
+        RDB_object *attrobjp = RDB_tuple_get(tplp,
+                qrp->matp->val.tbp->keyv[0].strv[i]);
+        attrobjp->store_typ = RDB_type_attr_type(
+                qrp->matp->typ->def.basetyp,
+                qrp->matp->val.tbp->keyv[0].strv[i]);
+        if (RDB_obj_to_field(&keyfv[i], attrobjp, ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
+
+    if (qrp->matp->val.tbp->stp != NULL) {
+        gfield.no = *RDB_field_no(qrp->matp->val.tbp->stp, gattrname);
+
+        /* Try to read tuple of the materialized table */
+        ret = RDB_get_fields(qrp->matp->val.tbp->stp->recmapp, keyfv,
+                1, NULL, &gfield, ecp);
+        if (ret != RDB_OK)
+            RDB_handle_err(ecp, txp);
+    } else {
+        RDB_raise_not_found("", ecp);
+        ret = RDB_ERROR;
+    }
+    if (ret == RDB_OK) {
+        /*
+         * A tuple has been found, add read tuple to
+         * relation-valued attribute
+         */
+
+        /* Get relation-valued attribute */
+        if (RDB_irep_to_obj(gvalp, greltyp, gfield.datap,
+                gfield.len, ecp) != RDB_OK)
+            return RDB_ERROR;
+
+        /* Insert tuple (not-grouped attributes will be ignored) */
+        if (RDB_insert(gvalp, tplp, ecp, txp) != RDB_OK)
+            return RDB_ERROR;
+
+        /* Update materialized table */
+        gvalp->store_typ = greltyp;
+        if (RDB_obj_to_field(&gfield, gvalp, ecp) != RDB_OK)
+            return RDB_ERROR;
+        RDB_cmp_ecp = ecp;
+        return RDB_update_rec(qrp->matp->val.tbp->stp->recmapp, keyfv,
+                1, &gfield, NULL, ecp);
+    }
+    if (RDB_obj_type(RDB_get_err(ecp)) == &RDB_NOT_FOUND_ERROR) {
+        /*
+         * A tuple has not been found, build tuple and insert it
+         */
+        RDB_object gtb;
+        RDB_type *reltyp;
+
+        RDB_clear_err(ecp);
+        reltyp = RDB_dup_nonscalar_type(greltyp, ecp);
+        if (reltyp == NULL)
+            return RDB_ERROR;
+        RDB_init_obj(&gtb);
+        if (RDB_init_table_from_type(&gtb, NULL, reltyp, 0, NULL,
+                0, NULL, ecp) != RDB_OK) {
+            RDB_destroy_obj(&gtb, ecp);
+            RDB_del_nonscalar_type(reltyp, ecp);
+            return RDB_ERROR;
+        }
+
+        if (RDB_insert(&gtb, tplp, ecp, NULL) != RDB_OK) {
+            RDB_destroy_obj(&gtb, ecp);
+            return RDB_ERROR;
+        }
+
+        /*
+         * Set then attribute first, then assign the table value to it
+         */
+        if (RDB_tuple_set(tplp, gattrname, &gtb, ecp) != RDB_OK) {
+            RDB_destroy_obj(&gtb, ecp);
+            return RDB_ERROR;
+        }
+        if (RDB_destroy_obj(&gtb, ecp) != RDB_OK)
+            return RDB_ERROR;
+
+        return RDB_insert(qrp->matp, tplp, ecp, NULL);
+    }
+    return RDB_ERROR;
+}
+
+/*
+ * Store the groups in the materialized table of a GROUP
+ */
+static int
+store_hgroups(RDB_qresult *qrp, RDB_hgroup_tab *hgtp, RDB_exec_context *ecp)
+{
+    RDB_hashtable_iter hiter;
+    RDB_hgroup *grp;
+    char *gattrname = RDB_obj_string(&qrp->exp->def.op.args.lastp->def.obj);
+
+    RDB_init_hashtable_iter(&hiter, &hgtp->tab);
+    while ((grp = RDB_hashtable_next(&hiter)) != NULL) {
+        do {
+            if (RDB_tuple_set(&grp->tpl, gattrname, &grp->gtb, ecp) != RDB_OK)
+                goto error;
+            if (RDB_insert(qrp->matp, &grp->tpl, ecp, NULL) != RDB_OK)
+                goto error;
+            grp = grp->nextp;
+        } while (grp != NULL);
+    }
+    RDB_destroy_hashtable_iter(&hiter);
+    return RDB_OK;
+
+error:
+    RDB_destroy_hashtable_iter(&hiter);
+    return RDB_ERROR;
+}
+
+/*
+ * Compute the groups in a hashtable which maps the values of the attributes
+ * which are not grouped to the relation-valued attribute.
+ * If the hashtable exceeds the memory limit, the groups are stored
+ * in the materialized table and the remaining tuples are added to the
+ * materialized table directly.
+ */
+static int
+do_group(RDB_qresult *qrp, RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    RDB_qresult *newqrp;
+    RDB_tuple_batch batch;
+    RDB_object *tplp;
+    RDB_hgroup_tab hgtab;
+    RDB_hgroup *grp;
+    RDB_field *keyfv;
+    RDB_object gval;
+    int ret = RDB_ERROR;
+    int i;
+    int attrc = 0;
+    char **attrv;
+    RDB_bool hashed = RDB_TRUE;
+    int keyfc = RDB_pkey_len(qrp->matp);
+    RDB_type *tpltyp = qrp->matp->typ->def.basetyp;
+    char *gattrname = RDB_obj_string(&qrp->exp->def.op.args.lastp->def.obj);
+    RDB_type *greltyp = RDB_tuple_type_attr(tpltyp, gattrname)->typ;
+
+    /* The attributes which are not grouped identify a group */
+    attrv = RDB_alloc(sizeof(char *) * tpltyp->def.tuple.attrc, ecp);
+    if (attrv == NULL)
+        return RDB_ERROR;
+    for (i = 0; i < tpltyp->def.tuple.attrc; i++) {
+        if (strcmp(tpltyp->def.tuple.attrv[i].name, gattrname) != 0)
+            attrv[attrc++] = tpltyp->def.tuple.attrv[i].name;
+    }
 
     if (keyfc > 0) {
         keyfv = RDB_alloc(sizeof (RDB_field) * keyfc, ecp);
         if (keyfv == NULL) {
+            RDB_free(attrv);
             return RDB_ERROR;
         }
     } else {
         keyfv = NULL;
     }
 
-    /*
-     * Iterate over the original table, modifying the materialized table
-     */
-
     newqrp = RDB_expr_qresult(qrp->exp->def.op.args.firstp, ecp, txp);
     if (newqrp == NULL) {
+        RDB_free(attrv);
+        RDB_free(keyfv);
         return RDB_ERROR;
     }
-    if (RDB_duprem(qrp, ecp, txp) != RDB_OK)
-        return RDB_ERROR;
 
-    RDB_init_obj(&tpl);
+    init_hgroup_tab(&hgtab, attrc, attrv, 0);
+    batch.tplv = NULL;
     RDB_init_obj(&gval);
-    do {
-        ret = RDB_next_tuple(newqrp, &tpl, ecp, txp);
-        if (ret == RDB_OK) {
-            /* Build key */
-            for (i = 0; i < keyfc; i++) {
-                RDB_object *attrobjp = RDB_tuple_get(&tpl,
-                        qrp->matp->val.tbp->keyv[0].strv[i]);
-                attrobjp->store_typ = RDB_type_attr_type(
-                        qrp->matp->typ->def.basetyp,
-                        qrp->matp->val.tbp->keyv[0].strv[i]);
-                ret = RDB_obj_to_field(&keyfv[i], attrobjp, ecp);
-                if (ret != RDB_OK)
-                    goto cleanup;
-            }
-
-            if (qrp->matp->val.tbp->stp != NULL) {
-                gfield.no = *RDB_field_no(qrp->matp->val.tbp->stp, gattrname);
-
-                /* Try to read tuple of the materialized table */
-                ret = RDB_get_fields(qrp->matp->val.tbp->stp->recmapp, keyfv,
-                        1, NULL, &gfield, ecp);
-                if (ret != RDB_OK)
-                    RDB_handle_err(ecp, txp);
-            } else {
-                RDB_raise_not_found("", ecp);
-                ret = RDB_ERROR;
-            }
-            if (ret == RDB_OK) {
-                /*
-                 * A tuple has been found, add read tuple to
-                 * relation-valued attribute
-                 */
-
-                /* Get relation-valued attribute */
-                ret = RDB_irep_to_obj(&gval, greltyp, gfield.datap,
-                        gfield.len, ecp);
-                if (ret != RDB_OK)
-                    goto cleanup;
-
-                /* Insert tuple (not-grouped attributes will be ignored) */
-                ret = RDB_insert(&gval, &tpl, ecp, txp);
-                if (ret != RDB_OK)
-                    goto cleanup;
-
-                /* Update materialized table */
-                gval.store_typ = greltyp;
-                ret = RDB_obj_to_field(&gfield, &gval, ecp);
-                if (ret != RDB_OK)
-                    goto cleanup;
-                RDB_cmp_ecp = ecp;
-                ret = RDB_update_rec(qrp->matp->val.tbp->stp->recmapp, keyfv,
-                        1, &gfield, NULL, ecp);
-                if (ret != RDB_OK)
-                    goto cleanup;
-            } else if (RDB_obj_type(RDB_get_err(ecp)) == &RDB_NOT_FOUND_ERROR) {
-                /*
-                 * A tuple has not been found, build tuple and insert it
-                 */
-                RDB_object gtb;
-                RDB_type *reltyp;
-
-                RDB_clear_err(ecp);
-                reltyp = RDB_dup_nonscalar_type(greltyp, ecp);
-                if (reltyp == NULL)
-                    goto cleanup;
-                RDB_init_obj(&gtb);
-                if (RDB_init_table_from_type(&gtb, NULL, reltyp, 0, NULL,
-                        0, NULL, ecp) != RDB_OK) {
-                    RDB_destroy_obj(&gtb, ecp);
-                    RDB_del_nonscalar_type(reltyp, ecp);
-                    goto cleanup;
-                }
 
-                ret = RDB_insert(&gtb, &tpl, ecp, NULL);
-                if (ret != RDB_OK)
-                    goto cleanup;
+    if (RDB_duprem(newqrp, ecp, txp) != RDB_OK)
+        goto cleanup;
+    if (RDB_init_tuple_batch(&batch, newqrp, ecp) != RDB_OK)
+        goto cleanup;
+    while ((tplp = RDB_batch_next_tuple(&batch, ecp, txp)) != NULL) {
+        if (!hashed) {
+            if (group_tuple_rec(qrp, tplp, keyfv, &gval, ecp, txp) != RDB_OK)
+                goto cleanup;
+            continue;
+        }
 
-                /*
-                 * Set then attribute first, then assign the table value to it
-                 */
-                ret = RDB_tuple_set(&tpl, gattrname, &gtb, ecp);
-                if (ret != RDB_OK)
-                    goto cleanup;
+        if (find_hgroup(&hgtab, tplp, RDB_tuple_hash_attrs(tplp, attrc, attrv),
+                ecp, txp, &grp) != RDB_OK)
+            goto cleanup;
+        if (grp == NULL) {
+            RDB_type *reltyp;
 
-                ret = RDB_insert(qrp->matp, &tpl, ecp, NULL);
-                if (ret != RDB_OK)
-                    goto cleanup;
-            } else {
+            grp = add_hgroup(&hgtab, RDB_tuple_hash_attrs(tplp, attrc, attrv),
+                    ecp);
+            if (grp == NULL)
+                goto cleanup;
+            if (RDB_project_tuple(tplp, attrc, (const char **) attrv, ecp,
+                    &grp->tpl) != RDB_OK)
+                goto cleanup;
+            reltyp = RDB_dup_nonscalar_type(greltyp, ecp);
+            if (reltyp == NULL)
+                goto cleanup;
+            if (RDB_init_table_from_type(&grp->gtb, NULL, reltyp, 0, NULL,
+                    0, NULL, ecp) != RDB_OK) {
+                RDB_del_nonscalar_type(reltyp, ecp);
                 goto cleanup;
             }
+            hgtab.memsize += tuple_mem_size(&grp->tpl);
         }
-    } while (ret == RDB_OK);
 
-    if (ret != RDB_OK
-            && RDB_obj_type(RDB_get_err(ecp)) == &RDB_NOT_FOUND_ERROR) {
-        RDB_clear_err(ecp);
-        ret = RDB_OK;
+        /* Insert tuple (not-grouped attributes will be ignored) */
+        if (RDB_insert(&grp->gtb, tplp, ecp, NULL) != RDB_OK)
+            goto cleanup;
+        grp->count++;
+        hgtab.memsize += tuple_mem_size(tplp);
+
+        /*
+         * If the memory limit has been exceeded, store the groups
+         * and continue with the materialized table
+         */
+        if (hgtab.memsize > tx_hash_mem(txp)) {
+            if (store_hgroups(qrp, &hgtab, ecp) != RDB_OK)
+                goto cleanup;
+            destroy_hgroup_tab(&hgtab, ecp);
+            init_hgroup_tab(&hgtab, attrc, attrv, 0);
+            hashed = RDB_FALSE;
+        }
     }
+    if (RDB_get_err(ecp) != NULL)
+        goto cleanup;
+
+    if (hashed) {
+        if (store_hgroups(qrp, &hgtab, ecp) != RDB_OK)
+            goto cleanup;
+    }
+    ret = RDB_OK;
 
 cleanup:
-    RDB_destroy_obj(&tpl, ecp);
+    RDB_destroy_tuple_batch(&batch, ecp);
+    destroy_hgroup_tab(&hgtab, ecp);
     RDB_destroy_obj(&gval, ecp);
     RDB_del_qresult(newqrp, ecp, txp);
     RDB_free(keyfv);
+    RDB_free(attrv);
 
     return ret;
 } /* do_group */
@@ -724,6 +1268,9 @@ init_index_qresult(RDB_qresult *qrp, RDB_object *tbp, RDB_tbindex *indexp,
     qrp->nested = RDB_FALSE;
     qrp->val.stored.tbp = tbp;
     qrp->matp = NULL;
+    RDB_init_arena(&qrp->arena);
+    qrp->dupsetp = NULL;
+    qrp->val.stored.attrv = NULL;
     qrp->val.stored.curp = RDB_index_cursor(indexp->idxp, RDB_FALSE,
             txp != NULL ? txp->tx : NULL, ecp);
     if (qrp->val.stored.curp == NULL) {
@@ -754,6 +1301,9 @@ init_where_index_qresult(RDB_qresult *qrp, RDB_expression *texp,
     qrp->exp = texp;
     qrp->nested = RDB_FALSE;
     qrp->matp = NULL;
+    RDB_init_arena(&qrp->arena);
+    qrp->dupsetp = NULL;
+    qrp->val.stored.attrv = NULL;
     if (texp->def.op.args.firstp->kind == RDB_EX_TBP) {
         qrp->val.stored.tbp = texp->def.op.args.firstp->def.tbref.tbp;
     } else {
@@ -839,6 +1389,28 @@ error:
     return RDB_ERROR;
 }
 
+static int
+set_project_needed_attrs(RDB_qresult *qrp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    int ret;
+    int i;
+    RDB_expression *argp;
+    int attrc = RDB_expr_list_length(&qrp->exp->def.op.args) - 1;
+    char **attrv = RDB_alloc(sizeof(char *) * (attrc + 1), ecp);
+    if (attrv == NULL)
+        return RDB_ERROR;
+
+    argp = qrp->exp->def.op.args.firstp->nextp;
+    for (i = 0; i < attrc; i++) {
+        attrv[i] = RDB_obj_string(&argp->def.obj);
+        argp = argp->nextp;
+    }
+    ret = RDB_set_needed_attrs(qrp->val.children.qrp, attrc, attrv, ecp, txp);
+    RDB_free(attrv);
+    return ret;
+}
+
 /*
  * Initialize qresult from expression.
  */
@@ -900,6 +1472,8 @@ init_expr_qresult(RDB_qresult *qrp, RDB_expression *exp, RDB_exec_context *ecp,
 
     qrp->endreached = RDB_FALSE;
     qrp->matp = NULL;
+    RDB_init_arena(&qrp->arena);
+    qrp->dupsetp = NULL;
 
     if (strcmp(exp->def.op.name, "where") == 0
             && (exp->def.op.optinfo.objc > 0
@@ -930,10 +1504,17 @@ init_expr_qresult(RDB_qresult *qrp, RDB_expression *exp, RDB_exec_context *ecp,
         } else {
             qrp->exp = exp;
             qrp->nested = RDB_TRUE;
+            qrp->val.children.batchv = NULL;
             qrp->val.children.qrp = RDB_expr_qresult(exp->def.op.args.firstp, ecp, txp);
             if (qrp->val.children.qrp == NULL)
                 return RDB_ERROR;
             qrp->val.children.qr2p = NULL;
+
+            /* Only the projected attributes are needed */
+            if (set_project_needed_attrs(qrp, ecp, txp) != RDB_OK) {
+                RDB_del_qresult(qrp->val.children.qrp, ecp, txp);
+                return RDB_ERROR;
+            }
         }
         return RDB_OK;
     }
@@ -952,6 +1533,8 @@ init_expr_qresult(RDB_qresult *qrp, RDB_expression *exp, RDB_exec_context *ecp,
         qrp->exp = exp;
         qrp->nested = RDB_TRUE;
         qrp->val.children.tpl_valid = RDB_FALSE;
+        qrp->val.children.cexpv = NULL;
+        qrp->val.children.cexpc = 0;
         qrp->val.children.qrp = RDB_expr_qresult(exp->def.op.args.firstp, ecp, txp);
         if (qrp->val.children.qrp == NULL)
             return RDB_ERROR;
@@ -1026,6 +1609,8 @@ init_qresult(RDB_qresult *qrp, RDB_object *tbp, RDB_exec_context *ecp,
 {
     qrp->endreached = RDB_FALSE;
     qrp->matp = NULL;
+    RDB_init_arena(&qrp->arena);
+    qrp->dupsetp = NULL;
 
     if (RDB_TB_CHECK & tbp->val.tbp->flags) {
         if (RDB_check_table(tbp, ecp, txp) != RDB_OK)
@@ -1043,6 +1628,125 @@ init_qresult(RDB_qresult *qrp, RDB_object *tbp, RDB_exec_context *ecp,
     return init_expr_qresult(qrp, tbp->val.tbp->exp, ecp, txp);
 }
 
+/*
+ * Check if the RELATION expression *exp may return duplicates.
+ * If all arguments are tuple values, check if they are distinct.
+ */
+static int
+relation_dups(RDB_expression *exp, RDB_exec_context *ecp, RDB_bool *resp)
+{
+    RDB_type *reltyp;
+    RDB_tupleset *tsp;
+    RDB_expression *argp;
+
+    *resp = RDB_TRUE;
+    for (argp = exp->def.op.args.firstp; argp != NULL; argp = argp->nextp) {
+        if (argp->kind != RDB_EX_OBJ || argp->def.obj.kind != RDB_OB_TUPLE)
+            return RDB_OK;
+    }
+
+    reltyp = RDB_expr_type(exp, NULL, NULL, NULL, ecp, NULL);
+    if (reltyp == NULL)
+        return RDB_ERROR;
+    tsp = RDB_new_tupleset(RDB_base_type(reltyp), ecp);
+    if (tsp == NULL)
+        return RDB_ERROR;
+    *resp = RDB_FALSE;
+    for (argp = exp->def.op.args.firstp; argp != NULL && !*resp;
+            argp = argp->nextp) {
+        RDB_bool inserted;
+
+        if (RDB_tupleset_insert(tsp, &argp->def.obj, ecp, &inserted)
+                != RDB_OK) {
+            RDB_del_tupleset(tsp, ecp);
+            return RDB_ERROR;
+        }
+        *resp = (RDB_bool) !inserted;
+    }
+    RDB_del_tupleset(tsp, ecp);
+    return RDB_OK;
+}
+
+/*
+ * If the attribute *attrname has the same value in all tuples of the relation
+ * given by *exp, return that value, otherwise NULL.
+ * Only values given by a literal in EXTEND or in a WHERE condition
+ * of the form <attrname> = <literal> are recognized.
+ */
+static RDB_object *
+const_attr_value(RDB_expression *exp, const char *attrname)
+{
+    RDB_expression *argp;
+    RDB_object *valp;
+
+    if (exp->kind != RDB_EX_RO_OP)
+        return NULL;
+
+    switch (exp->def.op.code) {
+    case RDB_OP_WHERE:
+        argp = RDB_attr_node(exp->def.op.args.firstp->nextp, attrname, "=");
+        if (argp != NULL)
+            return &argp->def.op.args.firstp->nextp->def.obj;
+        return const_attr_value(exp->def.op.args.firstp, attrname);
+    case RDB_OP_EXTEND:
+        for (argp = exp->def.op.args.firstp->nextp; argp != NULL;
+                argp = argp->nextp->nextp) {
+            if (strcmp(RDB_obj_string(&argp->nextp->def.obj), attrname) == 0)
+                return argp->kind == RDB_EX_OBJ ? &argp->def.obj : NULL;
+        }
+        return const_attr_value(exp->def.op.args.firstp, attrname);
+    case RDB_OP_JOIN:
+        valp = const_attr_value(exp->def.op.args.firstp, attrname);
+        if (valp != NULL)
+            return valp;
+        return const_attr_value(exp->def.op.args.firstp->nextp, attrname);
+    case RDB_OP_PROJECT:
+    case RDB_OP_MINUS:
+    case RDB_OP_SEMIMINUS:
+    case RDB_OP_INTERSECT:
+    case RDB_OP_SEMIJOIN:
+        return const_attr_value(exp->def.op.args.firstp, attrname);
+    default:
+        return NULL;
+    }
+}
+
+/*
+ * Check if the arguments of the UNION *exp cannot have a tuple in common
+ * because there is an attribute which has a different constant value
+ * in each argument. Stores the result in *resp.
+ */
+static int
+union_disjoint(RDB_expression *exp, RDB_exec_context *ecp, RDB_bool *resp)
+{
+    int i;
+    RDB_type *tpltyp;
+    RDB_type *reltyp = RDB_expr_type(exp, NULL, NULL, NULL, ecp, NULL);
+    if (reltyp == NULL)
+        return RDB_ERROR;
+
+    *resp = RDB_FALSE;
+    tpltyp = RDB_base_type(reltyp);
+    for (i = 0; i < tpltyp->def.tuple.attrc && !*resp; i++) {
+        RDB_bool eq;
+        char *attrname = tpltyp->def.tuple.attrv[i].name;
+        RDB_object *val1p = const_attr_value(exp->def.op.args.firstp,
+                attrname);
+        RDB_object *val2p;
+
+        if (val1p == NULL)
+            continue;
+        val2p = const_attr_value(exp->def.op.args.firstp->nextp, attrname);
+        if (val2p == NULL || RDB_obj_type(val1p) == NULL
+                || RDB_obj_type(val1p) != RDB_obj_type(val2p))
+            continue;
+        if (RDB_obj_equals(val1p, val2p, ecp, NULL, &eq) != RDB_OK)
+            return RDB_ERROR;
+        *resp = (RDB_bool) !eq;
+    }
+    return RDB_OK;
+}
+
 /*
  * Check if a qresult based on *exp may return duplicates and store the result in *resp.
  */
@@ -1070,33 +1774,30 @@ expr_dups(RDB_expression *exp, RDB_exec_context *ecp, RDB_bool *resp)
         return RDB_ERROR;
     }
 
-    if (strcmp(exp->def.op.name, "relation") == 0) {
+    switch (exp->def.op.code) {
+    case RDB_OP_RELATION:
         /* A tuple may appear twice among the arguments */
-        *resp = RDB_TRUE;
-        return RDB_OK;
-    }
-
-    if (strcmp(exp->def.op.name, "where") == 0
-            || strcmp(exp->def.op.name, "minus") == 0
-            || strcmp(exp->def.op.name, "semiminus") == 0
-            || strcmp(exp->def.op.name, "intersect") == 0
-            || strcmp(exp->def.op.name, "semijoin") == 0
-            || strcmp(exp->def.op.name, "extend") == 0
-            || strcmp(exp->def.op.name, "rename") == 0
-            || strcmp(exp->def.op.name, "extend") == 0
-            || strcmp(exp->def.op.name, "rename") == 0
-            || strcmp(exp->def.op.name, "wrap") == 0
-            || strcmp(exp->def.op.name, "unwrap") == 0
-            || strcmp(exp->def.op.name, "ungroup") == 0
-            || strcmp(exp->def.op.name, "divide") == 0) {
+        return relation_dups(exp, ecp, resp);
+    case RDB_OP_WHERE:
+    case RDB_OP_MINUS:
+    case RDB_OP_SEMIMINUS:
+    case RDB_OP_INTERSECT:
+    case RDB_OP_SEMIJOIN:
+    case RDB_OP_EXTEND:
+    case RDB_OP_RENAME:
+    case RDB_OP_WRAP:
+    case RDB_OP_UNWRAP:
+    case RDB_OP_UNGROUP:
+    case RDB_OP_DIVIDE:
         return expr_dups(exp->def.op.args.firstp, ecp, resp);
-    } else if (strcmp(exp->def.op.name, "union") == 0) {
-        *resp = RDB_TRUE;
-        return RDB_OK;
-    } else if (strcmp(exp->def.op.name, "d_union") == 0) {
-        *resp = RDB_FALSE;
-        return RDB_OK;
-    } else if (strcmp(exp->def.op.name, "join") == 0) {
+    case RDB_OP_UNION:
+    {
+        RDB_bool disjoint;
+
+        /*
+         * If the arguments are free of duplicates and cannot have
+         * a tuple in common, the union is free of duplicates too
+         */
         if (expr_dups(exp->def.op.args.firstp, ecp, resp) != RDB_OK)
             return RDB_ERROR;
         if (*resp)
@@ -1105,7 +1806,22 @@ expr_dups(RDB_expression *exp, RDB_exec_context *ecp, RDB_bool *resp)
             return RDB_ERROR;
         if (*resp)
             return RDB_OK;
-    } else if (strcmp(exp->def.op.name, "project") == 0) {
+        if (union_disjoint(exp, ecp, &disjoint) != RDB_OK)
+            return RDB_ERROR;
+        *resp = (RDB_bool) !disjoint;
+        return RDB_OK;
+    }
+    case RDB_OP_D_UNION:
+        *resp = RDB_FALSE;
+        return RDB_OK;
+    case RDB_OP_JOIN:
+        if (expr_dups(exp->def.op.args.firstp, ecp, resp) != RDB_OK)
+            return RDB_ERROR;
+        if (*resp)
+            return RDB_OK;
+        return expr_dups(exp->def.op.args.firstp->nextp, ecp, resp);
+    case RDB_OP_PROJECT:
+    {
         int keyc, newkeyc;
         RDB_string_vec *keyv;
         RDB_bool freekey;
@@ -1133,8 +1849,10 @@ expr_dups(RDB_expression *exp, RDB_exec_context *ecp, RDB_bool *resp)
         }
         return RDB_OK;
     }
-    *resp = RDB_FALSE;
-    return RDB_OK;
+    default:
+        *resp = RDB_FALSE;
+        return RDB_OK;
+    }
 }
 
 /*
@@ -1165,31 +1883,121 @@ RDB_duprem(RDB_qresult *qrp, RDB_exec_context *ecp, RDB_transaction *txp)
     /*
      * Add duplicate remover only if the qresult may return duplicates
      */
-    if (rd) {
-        int ret;
-
+    if (rd && qrp->dupsetp == NULL) {
         /* rd can only be true for virtual tables */
         RDB_type *reltyp = RDB_expr_type(qrp->exp, NULL, NULL, NULL, ecp, txp);
-        if (reltyp == NULL)
-            return RDB_ERROR;
-        reltyp = RDB_dup_nonscalar_type(reltyp, ecp);
         if (reltyp == NULL)
             return RDB_ERROR;
 
-        /* Create materialized (all-key) table */
-        qrp->matp = RDB_new_obj(ecp);
-        if (qrp->matp == NULL) {
-            RDB_del_nonscalar_type(reltyp, ecp);
-            return RDB_ERROR;
-        }            
-        ret = RDB_init_table_i(qrp->matp, NULL, RDB_FALSE, reltyp, 0, NULL,
-                0, NULL, RDB_TRUE, NULL, ecp);
-        if (ret != RDB_OK) {
-            RDB_del_nonscalar_type(reltyp, ecp);
-            RDB_free_obj(qrp->matp, ecp);
+        qrp->dupsetp = RDB_new_tupleset(RDB_base_type(reltyp), ecp);
+        if (qrp->dupsetp == NULL)
             return RDB_ERROR;
+    }
+    return RDB_OK;
+}
+
+/*
+ * Return the type of the tuples read from stored table *tbp.
+ */
+static RDB_type *
+stored_tuple_type(RDB_object *tbp)
+{
+    return tbp->typ->kind == RDB_TP_RELATION ? tbp->typ->def.basetyp
+            : RDB_obj_impl_type(tbp)->def.scalar.arep->def.basetyp;
+}
+
+static int
+set_stored_needed_attrs(RDB_qresult *qrp, int attrc, char *attrv[],
+        RDB_exec_context *ecp)
+{
+    int i, j;
+    int *idxv;
+    int idxc = 0;
+    RDB_type *tpltyp = stored_tuple_type(qrp->val.stored.tbp);
+
+    idxv = RDB_arena_alloc(&qrp->arena,
+            sizeof(int) * (tpltyp->def.tuple.attrc + 1));
+    if (idxv == NULL) {
+        RDB_raise_no_memory(ecp);
+        return RDB_ERROR;
+    }
+    for (i = 0; i < tpltyp->def.tuple.attrc; i++) {
+        for (j = 0; j < attrc; j++) {
+            if (strcmp(tpltyp->def.tuple.attrv[i].name, attrv[j]) == 0) {
+                idxv[idxc++] = i;
+                break;
+            }
         }
     }
+    if (idxc < tpltyp->def.tuple.attrc) {
+        qrp->val.stored.attrv = idxv;
+        qrp->val.stored.attrc = idxc;
+    }
+    return RDB_OK;
+}
+
+/*
+ * Pass the attributes needed by the caller and the attributes
+ * referred to by the condition to the argument of WHERE.
+ */
+static int
+set_where_needed_attrs(RDB_qresult *qrp, int attrc, char *attrv[],
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int i;
+    int ret;
+    char **nattrv;
+    int nattrc = attrc;
+    RDB_expression *condp = qrp->exp->def.op.args.firstp->nextp;
+    RDB_type *reltyp = RDB_expr_type(qrp->exp, NULL, NULL, NULL, ecp, txp);
+    if (reltyp == NULL)
+        return RDB_ERROR;
+
+    nattrv = RDB_alloc(sizeof(char *)
+            * (attrc + reltyp->def.basetyp->def.tuple.attrc), ecp);
+    if (nattrv == NULL)
+        return RDB_ERROR;
+    for (i = 0; i < attrc; i++)
+        nattrv[i] = attrv[i];
+    for (i = 0; i < reltyp->def.basetyp->def.tuple.attrc; i++) {
+        char *attrname = reltyp->def.basetyp->def.tuple.attrv[i].name;
+
+        if (RDB_expr_refers_var(condp, attrname))
+            nattrv[nattrc++] = attrname;
+    }
+    ret = RDB_set_needed_attrs(qrp->val.children.qrp, nattrc, nattrv,
+            ecp, txp);
+    RDB_free(nattrv);
+    return ret;
+}
+
+/*
+ * Specify that the caller only needs the attributes in attrv
+ * of the tuples returned by *qrp.
+ * Tuples read from stored tables are then only partially decoded,
+ * the values of the other attributes of the tuples returned are
+ * uninitialized (RDB_OB_INITIAL) and must not be used.
+ * Has no effect on qresults which cannot make use of it,
+ * and on qresults which remove duplicates, since this requires
+ * complete tuples.
+ */
+int
+RDB_set_needed_attrs(RDB_qresult *qrp, int attrc, char *attrv[],
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    if (qrp->dupsetp != NULL)
+        return RDB_OK;
+
+    if (qrp->exp == NULL) {
+        /* Sorters return complete tuples */
+        if (qrp->val.stored.tbp == NULL)
+            return RDB_OK;
+        return set_stored_needed_attrs(qrp, attrc, attrv, ecp);
+    }
+    if (qrp->nested && qrp->exp->kind == RDB_EX_RO_OP
+            && qrp->exp->def.op.code == RDB_OP_WHERE) {
+        return set_where_needed_attrs(qrp, attrc, attrv, ecp, txp);
+    }
     return RDB_OK;
 }
 
@@ -1247,7 +2055,7 @@ RDB_table_iterator(RDB_object *tbp,
             if (txp != NULL && RDB_env_trace(RDB_db_env(RDB_tx_db(txp))) > 0) {
                 fputs("Creating sorter\n", stderr);
             }
-            if (RDB_sorter(texp, &qrp, ecp, txp, seqitc, seqitv) != RDB_OK)
+            if (RDB_sorter(texp, &qrp, ecp, txp, seqitc, seqitv, RDB_INT_MAX) != RDB_OK)
                 return NULL;
         }
     }
@@ -1266,187 +2074,42 @@ RDB_table_iterator(RDB_object *tbp,
     return qrp;
 }
 
-static int
-strvec_find(const char *str, const RDB_string_vec *strvec)
-{
-    int i;
-
-    for (i = 0; i < strvec->strc; i++) {
-        if (strcmp(strvec->strv[i], str) == 0)
-            return i;
-    }
-    return -1;
-}
-
-#ifdef POSTGRESQL
-static RDB_bool
-order_contains_nonsql_type(const RDB_type *reltyp, int seqitc,
-        const RDB_seq_item seqitv[])
+/*
+ * Return an optimized expression for reading *tbp
+ * using RDB_optimized_table_iterator().
+ */
+RDB_expression *
+RDB_optimize_table(RDB_object *tbp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
 {
-    int i;
-    RDB_type *attrtyp;
-
-    for (i = 0; i < seqitc; i++) {
-        attrtyp = RDB_type_attr_type(reltyp, seqitv[i].attrname);
-        if (attrtyp != &RDB_BOOLEAN && attrtyp != &RDB_INTEGER && attrtyp != &RDB_FLOAT
-                && attrtyp != &RDB_STRING && attrtyp != &RDB_BINARY) {
-            return RDB_TRUE;
-        }
+    if (RDB_TB_CHECK & tbp->val.tbp->flags) {
+        if (RDB_check_table(tbp, ecp, txp) != RDB_OK)
+            return NULL;
     }
-    return RDB_FALSE;
+    return RDB_optimize(tbp, 0, NULL, ecp, txp);
 }
-#endif
 
 /*
- * Creates a qresult which sorts a table.
+ * Create an iterator over the expression *texp, which must have been
+ * returned by RDB_optimize_table(). *texp is not owned by the iterator,
+ * so it can be used again after the iterator has been deleted
+ * as long as the catalog version has not changed.
  */
-int
-RDB_sorter(RDB_expression *texp, RDB_qresult **qrpp, RDB_exec_context *ecp,
-        RDB_transaction *txp, int seqitc, const RDB_seq_item seqitv[])
+RDB_qresult *
+RDB_optimized_table_iterator(RDB_expression *texp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
 {
-    RDB_string_vec key;
-    int ret;
-    int i;
-    RDB_qresult *tmpqrp;
-    RDB_object tpl;
-    RDB_type *typ = NULL;
-    RDB_object *matp = NULL;
-    RDB_compare_field *cmpv = NULL;
-    RDB_qresult *qrp = RDB_alloc(sizeof (RDB_qresult), ecp);
-    if (qrp == NULL) {
-        return RDB_ERROR;
-    }
-
-    key.strv = NULL;
-
-    typ = RDB_expr_type(texp, NULL, NULL, NULL, ecp, txp);
-    if (typ == NULL)
-        goto error;
-
-#ifdef POSTGRESQL
-    if (txp != NULL && RDB_env_queries(txp->envp)
-            && !order_contains_nonsql_type(typ, seqitc, seqitv)
-            && RDB_sql_convertible(texp)) {
-        RDB_object sql;
-        RDB_cursor *curp;
-        RDB_init_obj(&sql);
-        if (RDB_expr_to_sql_select(&sql, texp, seqitc, seqitv, txp->envp, ecp)
-                != RDB_OK) {
-            RDB_destroy_obj(&sql, ecp);
-            goto error;
-        }
-        curp = RDB_pg_query_cursor(txp->envp, RDB_obj_string(&sql), RDB_FALSE,
-                txp->tx, ecp);
-        RDB_destroy_obj(&sql, ecp);
-        if (curp == NULL)
-            goto error;
-        if (RDB_init_cursor_qresult(qrp, curp, NULL, texp, ecp, txp) != RDB_OK)
-            goto error;
-        *qrpp = qrp;
-        return RDB_OK;
-    }
-#endif
-
-    qrp->nested = RDB_FALSE;
-    qrp->val.stored.tbp = NULL;
-    qrp->endreached = RDB_FALSE;
-
-    /*
-     * Create a sorted all-key table
-     */
-
-    typ = RDB_dup_nonscalar_type(typ, ecp);
-    if (typ == NULL)
-        goto error;
-
-    key.strc = RDB_base_type(typ)->def.tuple.attrc;
-    key.strv = RDB_alloc(sizeof (char *) * RDB_base_type(typ)->def.tuple.attrc, ecp);
-    if (key.strv == NULL) {
-        RDB_del_nonscalar_type(typ, ecp);
-        goto error;
-    }
-    for (i = 0; i < key.strc; i++) {
-        key.strv[i] = RDB_base_type(typ)->def.tuple.attrv[i].name;
-    }
-
-    matp = RDB_new_rtable(NULL, RDB_FALSE,
-            typ, 1, &key, 0, NULL, RDB_TRUE, ecp);
-    if (matp == NULL) {
-        RDB_del_nonscalar_type(typ, ecp);
-        goto error;
-    }
-
-    cmpv = RDB_alloc(seqitc * sizeof(RDB_compare_field), ecp);
-    if (cmpv == NULL)
-        goto error;
-    for (i = 0; i < seqitc; i++) {
-        RDB_type *attrtyp;
-
-        cmpv[i].fno = strvec_find(seqitv[i].attrname, &key);
-        attrtyp = RDB_base_type(typ)->def.tuple.attrv[cmpv[i].fno].typ;
-        RDB_type_to_compare(&cmpv[i], attrtyp);
-        cmpv[i].asc = seqitv[i].asc;
-    }
-
-    if (RDB_create_stored_table(matp, txp != NULL ? txp->dbp->dbrootp->envp : NULL,
-            seqitc, cmpv, ecp, txp) != RDB_OK)
-        goto error;
-
-    /*
-     * Copy tuples into the newly created RDB_table
-     */
-
-    tmpqrp = RDB_expr_qresult(texp, ecp, txp);
-    if (tmpqrp == NULL)
-        goto error;
-
-    /*
-     * The duplicate elimination can produce a error message
-     * "Duplicate data items are not supported with sorted data"
-     * in the error log. This is expected behaviour.
-     */
-    RDB_init_obj(&tpl);
-    while ((ret = RDB_next_tuple(tmpqrp, &tpl, ecp, txp)) == RDB_OK) {
-        ret = RDB_insert(matp, &tpl, ecp, NULL);
-        if (ret != RDB_OK) {
-            if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_ELEMENT_EXISTS_ERROR) {
-                RDB_destroy_obj(&tpl, ecp);
-                goto error;
-            }
-            RDB_clear_err(ecp);
-        }
-    }
-    RDB_destroy_obj(&tpl, ecp);
-    if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR) {
-        goto error;
-    }
-    RDB_clear_err(ecp);
-
-    ret = RDB_del_qresult(tmpqrp, ecp, txp);
-    if (ret != RDB_OK)
-        goto error;
-
-    ret = RDB_init_stored_qresult(qrp, matp, NULL, ecp, txp);
-    if (ret != RDB_OK)
-        goto error;
-    qrp->matp = matp;
-
-    RDB_free(key.strv);
-    RDB_free(cmpv);
-
-    *qrpp = qrp;
-    return RDB_OK;
-
-error:
-    if (key.strv != NULL)
-        RDB_free(key.strv);
-    if (cmpv != NULL)
-        RDB_free(cmpv);
-    if (matp != NULL)
-        RDB_drop_table(matp, ecp, NULL);
-    RDB_free(qrp);
+    RDB_qresult *qrp = RDB_expr_qresult(texp, ecp, txp);
+    if (qrp == NULL)
+        return NULL;
 
-    return RDB_ERROR;
+    /* Add duplicate remover, if necessary */
+    if (RDB_duprem(qrp, ecp, txp) != RDB_OK) {
+        RDB_del_qresult(qrp, ecp, txp);
+        return NULL;
+    }
+    qrp->opt_exp = NULL;
+    return qrp;
 }
 
 static int
@@ -1454,8 +2117,9 @@ next_ungroup_tuple(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
         RDB_transaction *txp)
 {
     int ret;
+    int i;
+    int attrc;
     RDB_object *attrtbp;
-    RDB_hashtable_iter hiter;
     char *attrname = RDB_obj_string(&qrp->exp->def.op.args.firstp->nextp->def.obj);
 
     /* If no tuple has been read, read first tuple */
@@ -1511,18 +2175,16 @@ next_ungroup_tuple(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
     }
 
     /* Merge tuples, skipping the relation-valued attribute */
-    RDB_init_hashtable_iter(&hiter,
-            (RDB_hashtable *) &qrp->val.children.tpl.val.tpl_tab);
-    for (;;) {
-        /* Get next attribute */
-        tuple_entry *entryp = RDB_hashtable_next(&hiter);
-        if (entryp == NULL)
-            break;
+    attrc = RDB_tuple_size(&qrp->val.children.tpl);
+    for (i = 0; i < attrc; i++) {
+        const char *tplattrname = RDB_tuple_slot_name(&qrp->val.children.tpl, i);
 
-        if (strcmp(entryp->key, attrname) != 0)
-            RDB_tuple_set(tplp, entryp->key, &entryp->obj, ecp);
+        if (strcmp(tplattrname, attrname) != 0) {
+            if (RDB_tuple_set(tplp, tplattrname,
+                    RDB_tuple_slot(&qrp->val.children.tpl, i), ecp) != RDB_OK)
+                return RDB_ERROR;
+        }
     }
-    RDB_destroy_hashtable_iter(&hiter);
 
     return RDB_OK;
 }
@@ -1545,9 +2207,9 @@ next_unwrap(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
         RDB_transaction *txp)
 {
     int ret;
+    int i;
+    int attrc;
     RDB_object tpl;
-    RDB_hashtable_iter it;
-    tuple_entry *entryp;
     RDB_expression *argp;
     RDB_expression *exp = qrp->exp;
 
@@ -1583,31 +2245,47 @@ next_unwrap(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
     }
     
     /* Copy remaining attributes */
-    RDB_init_hashtable_iter(&it, (RDB_hashtable *)&tpl.val.tpl_tab);
-    while ((entryp = RDB_hashtable_next(&it)) != NULL) {
+    attrc = RDB_tuple_size(&tpl);
+    for (i = 0; i < attrc; i++) {
+        const char *attrname = RDB_tuple_slot_name(&tpl, i);
+
         /* Copy attribute if it does not appear in attrv */
-        if (find_str_exp(exp->def.op.args.firstp->nextp, entryp->key) == -1) {
-            ret = RDB_tuple_set(tplp, entryp->key, &entryp->obj, ecp);
+        if (find_str_exp(exp->def.op.args.firstp->nextp, attrname) == -1) {
+            ret = RDB_tuple_set(tplp, attrname, RDB_tuple_slot(&tpl, i), ecp);
             if (ret != RDB_OK) {
-                RDB_destroy_hashtable_iter(&it);
                 RDB_destroy_obj(&tpl, ecp);
                 return RDB_ERROR;
             }
         }
     }
-    RDB_destroy_hashtable_iter(&it);
 
     RDB_destroy_obj(&tpl, ecp);
     return RDB_OK;
 }
 
+/*
+ * Allocate temporary memory from *arenap, raising no_memory_error on failure
+ */
+static void *
+scratch_alloc(RDB_arena *arenap, size_t size, RDB_exec_context *ecp)
+{
+    void *datap = RDB_arena_alloc(arenap, size);
+    if (datap == NULL)
+        RDB_raise_no_memory(ecp);
+    return datap;
+}
+
 int
 RDB_seek_index_qresult(RDB_qresult *qrp, struct RDB_tbindex *indexp,
         const RDB_object *tplp, RDB_exec_context *ecp, RDB_transaction *txp)
 {
     int i;
     int ret;
-    RDB_field *fv = RDB_alloc(sizeof (RDB_field) * indexp->attrc, ecp);
+    RDB_field *fv;
+    RDB_arena_mark mark;
+
+    RDB_arena_get_mark(&qrp->arena, &mark);
+    fv = scratch_alloc(&qrp->arena, sizeof (RDB_field) * indexp->attrc, ecp);
     if (fv == NULL) {
         return RDB_ERROR;
     }
@@ -1634,70 +2312,31 @@ RDB_seek_index_qresult(RDB_qresult *qrp, struct RDB_tbindex *indexp,
     }
 
 cleanup:
-    RDB_free(fv);
+    RDB_arena_release(&qrp->arena, &mark);
 
     return ret;
 }
 
 /*
- * Read a tuple from a table using the unique index given by indexp,
- * using the values given by objpv as a key.
- * Read only the attributes in tpltyp.
+ * Set the field numbers of the non-key attributes in tpltyp,
+ * which are read from the table *tbp using the unique index *indexp.
  */
-int
-RDB_get_by_uindex(RDB_object *tbp, RDB_object *objpv[], RDB_tbindex *indexp,
-        RDB_type *tpltyp, RDB_exec_context *ecp, RDB_transaction *txp,
-        RDB_object *tplp)
+static void
+uindex_result_fields(RDB_object *tbp, RDB_tbindex *indexp, RDB_type *tpltyp,
+        RDB_field resfv[])
 {
-    RDB_field *fv;
-    RDB_field *resfv = NULL;
     int i;
-    int ret;
+    int rfi = 0;
     int keylen = indexp->attrc;
-    int resfc = tpltyp->def.tuple.attrc - keylen;
-
-    if (resfc > 0) {
-        resfv = RDB_alloc(sizeof (RDB_field) * resfc, ecp);
-        if (resfv == NULL) {
-            ret = RDB_ERROR;
-            goto cleanup;
-        }
-    }
-    fv = RDB_alloc(sizeof (RDB_field) * keylen, ecp);
-    if (fv == NULL) {
-        ret = RDB_ERROR;
-        goto cleanup;
-    }
-
-    /*
-     * Convert data to fields
-     */
-    for (i = 0; i < keylen; i++) {
-        ret = RDB_obj_to_field(&fv[i], objpv[i], ecp);
-        if (ret != RDB_OK)
-            goto cleanup;
-    }
-
-    /*
-     * Set 'no' fields of resfv and Read fields
-     */
-    if (indexp->idxp == NULL) {
-        int rfi = 0;
 
-        for (i = 0; i < tpltyp->def.tuple.attrc; i++) {
-            int fno = *RDB_field_no(tbp->val.tbp->stp, tpltyp->def.tuple.attrv[i].name);
+    for (i = 0; i < tpltyp->def.tuple.attrc; i++) {
+        int fno = *RDB_field_no(tbp->val.tbp->stp, tpltyp->def.tuple.attrv[i].name);
 
+        if (indexp->idxp == NULL) {
             if (fno >= keylen)
                 resfv[rfi++].no = fno;
-        }
-        ret = RDB_get_fields(tbp->val.tbp->stp->recmapp, fv, resfc,
-                             RDB_table_is_persistent(tbp) ? txp->tx : NULL, resfv, ecp);
-    } else {
-        int rfi = 0;
-
-        for (i = 0; i < tpltyp->def.tuple.attrc; i++) {
+        } else {
             int j;
-            int fno = *RDB_field_no(tbp->val.tbp->stp, tpltyp->def.tuple.attrv[i].name);
 
             /* Search field number in index */
             for (j = 0; j < keylen && indexp->idxp->fieldv[j] != fno; j++);
@@ -1706,15 +2345,21 @@ RDB_get_by_uindex(RDB_object *tbp, RDB_object *objpv[], RDB_tbindex *indexp,
             if (j >= keylen)
                 resfv[rfi++].no = fno;
         }
-        ret = RDB_index_get_fields(indexp->idxp, fv, resfc,
-                RDB_table_is_persistent(tbp) ? txp->tx : NULL, resfv, ecp);
     }
+}
 
-    if (ret != RDB_OK) {
-        RDB_handle_err(ecp, txp);
-        ret = RDB_ERROR;
-        goto cleanup;
-    }
+/*
+ * Store the key values given by objpv and the non-key values
+ * read from the table *tbp in *tplp.
+ */
+static int
+uindex_fields_to_tuple(RDB_object *tbp, RDB_object *objpv[],
+        RDB_tbindex *indexp, RDB_type *tpltyp, RDB_field resfv[],
+        RDB_object *tplp, RDB_exec_context *ecp)
+{
+    int i;
+    int ret;
+    int keylen = indexp->attrc;
 
     /*
      * Set key attributes
@@ -1750,29 +2395,246 @@ RDB_get_by_uindex(RDB_object *tbp, RDB_object *objpv[], RDB_tbindex *indexp,
                     resfv[rfi].datap, resfv[rfi].len, ecp);
             if (ret != RDB_OK) {
                 RDB_destroy_obj(&val, ecp);
-                goto cleanup;
+                return RDB_ERROR;
             }
             ret = RDB_tuple_set(tplp, attrname, &val, ecp);
             RDB_destroy_obj(&val, ecp);
+            if (ret != RDB_OK)
+                return RDB_ERROR;
+        }
+    }
+    return RDB_OK;
+}
+
+/*
+ * Read a tuple from a table using the unique index given by indexp,
+ * using the values given by objpv as a key.
+ * Read only the attributes in tpltyp.
+ * The field arrays are allocated from *arenap and released before
+ * the function returns. If arenap is NULL, a temporary arena is used.
+ */
+int
+RDB_get_by_uindex(RDB_object *tbp, RDB_object *objpv[], RDB_tbindex *indexp,
+        RDB_type *tpltyp, RDB_arena *arenap, RDB_exec_context *ecp,
+        RDB_transaction *txp, RDB_object *tplp)
+{
+    RDB_field *fv;
+    RDB_field *resfv = NULL;
+    int i;
+    int ret;
+    int keylen = indexp->attrc;
+    int resfc = tpltyp->def.tuple.attrc - keylen;
+    RDB_arena tmparena;
+    RDB_arena_mark mark;
+
+    if (arenap == NULL) {
+        RDB_init_arena(&tmparena);
+        arenap = &tmparena;
+    }
+    RDB_arena_get_mark(arenap, &mark);
+
+    if (resfc > 0) {
+        resfv = scratch_alloc(arenap, sizeof (RDB_field) * resfc, ecp);
+        if (resfv == NULL) {
+            ret = RDB_ERROR;
+            goto cleanup;
+        }
+    }
+    fv = scratch_alloc(arenap, sizeof (RDB_field) * keylen, ecp);
+    if (fv == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+
+    /*
+     * Convert data to fields
+     */
+    for (i = 0; i < keylen; i++) {
+        ret = RDB_obj_to_field(&fv[i], objpv[i], ecp);
+        if (ret != RDB_OK)
+            goto cleanup;
+    }
+
+    /*
+     * Set 'no' fields of resfv and Read fields
+     */
+    uindex_result_fields(tbp, indexp, tpltyp, resfv);
+    if (indexp->idxp == NULL) {
+        ret = RDB_get_fields(tbp->val.tbp->stp->recmapp, fv, resfc,
+                             RDB_table_is_persistent(tbp) ? txp->tx : NULL, resfv, ecp);
+    } else {
+        ret = RDB_index_get_fields(indexp->idxp, fv, resfc,
+                RDB_table_is_persistent(tbp) ? txp->tx : NULL, resfv, ecp);
+    }
+
+    if (ret != RDB_OK) {
+        RDB_handle_err(ecp, txp);
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+
+    ret = uindex_fields_to_tuple(tbp, objpv, indexp, tpltyp, resfv, tplp, ecp);
+
+cleanup:
+    if (arenap == &tmparena)
+        RDB_destroy_arena(&tmparena);
+    else
+        RDB_arena_release(arenap, &mark);
+    return ret;
+}
+
+/*
+ * Check if RDB_get_by_uindex_multi() can be used for reading tuples
+ * from the table *tbp using the unique index *indexp.
+ */
+RDB_bool
+RDB_multi_get_supported(RDB_object *tbp, RDB_tbindex *indexp)
+{
+    if (!RDB_table_is_persistent(tbp) || tbp->val.tbp->stp == NULL)
+        return RDB_FALSE;
+    if (indexp->idxp == NULL)
+        return RDB_recmap_multi_get(tbp->val.tbp->stp->recmapp);
+    return RDB_index_multi_get(indexp->idxp);
+}
+
+/*
+ * Read the tuples of the table *tbp whose values of the attributes
+ * of the unique index *indexp are given by the tuples
+ * keytplv[0] .. keytplv[tplc - 1], using a single multi-get
+ * of the record layer.
+ * If the tuple matching keytplv[i] is found, it is stored in tplv[i]
+ * and foundv[i] is set to RDB_TRUE, otherwise foundv[i] is set to RDB_FALSE.
+ * Read only the attributes in tpltyp.
+ * The field arrays are allocated from *arenap and released before
+ * the function returns.
+ * Must only be called if RDB_multi_get_supported() returns RDB_TRUE.
+ */
+int
+RDB_get_by_uindex_multi(RDB_object *tbp, int tplc, RDB_object keytplv[],
+        RDB_tbindex *indexp, RDB_type *tpltyp, RDB_arena *arenap,
+        RDB_exec_context *ecp, RDB_transaction *txp, RDB_object tplv[],
+        RDB_bool foundv[])
+{
+    int i, j;
+    int ret;
+    int keylen = indexp->attrc;
+    int resfc = tpltyp->def.tuple.attrc - keylen;
+    RDB_type *tbtpltyp = tbp->typ->def.basetyp;
+    RDB_field *fv;
+    RDB_field *resfv = NULL;
+    RDB_field **fvv = NULL;
+    RDB_field **resfvv = NULL;
+    RDB_object **objpv = NULL;
+    RDB_arena_mark mark;
+
+    RDB_arena_get_mark(arenap, &mark);
+    fv = scratch_alloc(arenap, sizeof(RDB_field) * keylen * tplc, ecp);
+    if (fv == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    if (resfc > 0) {
+        resfv = scratch_alloc(arenap, sizeof(RDB_field) * resfc * tplc, ecp);
+        if (resfv == NULL) {
+            ret = RDB_ERROR;
+            goto cleanup;
+        }
+    }
+    fvv = scratch_alloc(arenap, sizeof(RDB_field *) * tplc, ecp);
+    if (fvv == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    resfvv = scratch_alloc(arenap, sizeof(RDB_field *) * tplc, ecp);
+    if (resfvv == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+    objpv = scratch_alloc(arenap, sizeof(RDB_object *) * keylen, ecp);
+    if (objpv == NULL) {
+        ret = RDB_ERROR;
+        goto cleanup;
+    }
+
+    /*
+     * Convert key values to fields
+     */
+    for (i = 0; i < tplc; i++) {
+        fvv[i] = fv + i * keylen;
+        resfvv[i] = resfc > 0 ? resfv + i * resfc : NULL;
+        for (j = 0; j < keylen; j++) {
+            RDB_object *valp = RDB_tuple_get(&keytplv[i],
+                    indexp->attrv[j].attrname);
+            if (valp == NULL) {
+                RDB_raise_invalid_argument("key attribute not found", ecp);
+                ret = RDB_ERROR;
+                goto cleanup;
+            }
+            valp->store_typ = RDB_type_attr_type(tbtpltyp,
+                    indexp->attrv[j].attrname);
+            ret = RDB_obj_to_field(&fvv[i][j], valp, ecp);
             if (ret != RDB_OK)
                 goto cleanup;
         }
+        if (resfc > 0)
+            uindex_result_fields(tbp, indexp, tpltyp, resfvv[i]);
+    }
+
+    if (indexp->idxp == NULL) {
+        ret = RDB_get_fields_multi(tbp->val.tbp->stp->recmapp, tplc, fvv,
+                resfc, txp->tx, resfvv, foundv, ecp);
+    } else {
+        ret = RDB_index_get_fields_multi(indexp->idxp, tplc, fvv,
+                resfc, txp->tx, resfvv, foundv, ecp);
+    }
+    if (ret != RDB_OK) {
+        RDB_handle_err(ecp, txp);
+        goto cleanup;
+    }
+
+    for (i = 0; i < tplc; i++) {
+        if (!foundv[i])
+            continue;
+        for (j = 0; j < keylen; j++) {
+            objpv[j] = RDB_tuple_get(&keytplv[i], indexp->attrv[j].attrname);
+        }
+        ret = uindex_fields_to_tuple(tbp, objpv, indexp, tpltyp, resfvv[i],
+                &tplv[i], ecp);
+        if (ret != RDB_OK)
+            goto cleanup;
     }
     ret = RDB_OK;
 
 cleanup:
-    RDB_free(fv);
-    RDB_free(resfv);
+    RDB_arena_release(arenap, &mark);
     return ret;
 }
 
+/*
+ * Copy the attributes of the project qresult *qrp from *srctplp to *dsttplp
+ */
+static int
+project_tuple(RDB_qresult *qrp, RDB_object *srctplp, RDB_object *dsttplp,
+        RDB_exec_context *ecp)
+{
+    RDB_expression *argp = qrp->exp->def.op.args.firstp->nextp;
+
+    while (argp != NULL) {
+        char *attrname = RDB_obj_string(&argp->def.obj);
+
+        if (RDB_tuple_set(dsttplp, attrname, RDB_tuple_get(srctplp, attrname),
+                ecp) != RDB_OK)
+            return RDB_ERROR;
+        argp = argp->nextp;
+    }
+    return RDB_OK;
+}
+
 static int
 next_project(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
         RDB_transaction *txp)
 {
     int ret;
-    RDB_object *valp;
-    RDB_expression *argp;
 
     /* Get tuple */
     if (!qrp->nested) {
@@ -1800,14 +2662,9 @@ next_project(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
         }
 
         if (tplp != NULL) {
-            /* Copy attributes into new tuple */
-            argp = qrp->exp->def.op.args.firstp->nextp;
-            while (argp != NULL) {
-                char *attrname = RDB_obj_string(&argp->def.obj);
-
-                valp = RDB_tuple_get(&tpl, attrname);
-                RDB_tuple_set(tplp, attrname, valp, ecp);
-                argp = argp->nextp;
+            if (project_tuple(qrp, &tpl, tplp, ecp) != RDB_OK) {
+                RDB_destroy_obj(&tpl, ecp);
+                return RDB_ERROR;
             }
         }
 
@@ -1816,6 +2673,45 @@ next_project(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
     return RDB_OK;
 }
 
+/*
+ * Read tuples from the child of the nested project qresult *qrp
+ * in a single batch and store the projected tuples in tplv.
+ * Returns the number of tuples read or RDB_ERROR.
+ */
+static int
+next_project_tuples(RDB_qresult *qrp, RDB_object tplv[], int n,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int i;
+    int tplc;
+
+    if (qrp->val.children.batchv == NULL) {
+        qrp->val.children.batchv = RDB_alloc(
+                sizeof(RDB_object) * RDB_TUPLE_BATCH_SIZE, ecp);
+        if (qrp->val.children.batchv == NULL)
+            return RDB_ERROR;
+        for (i = 0; i < RDB_TUPLE_BATCH_SIZE; i++) {
+            RDB_init_obj(&qrp->val.children.batchv[i]);
+        }
+    }
+
+    if (n > RDB_TUPLE_BATCH_SIZE)
+        n = RDB_TUPLE_BATCH_SIZE;
+    tplc = RDB_next_tuples(qrp->val.children.qrp, qrp->val.children.batchv,
+            n, ecp, txp);
+    if (tplc == RDB_ERROR)
+        return RDB_ERROR;
+    if (tplc < n)
+        qrp->endreached = RDB_TRUE;
+
+    for (i = 0; i < tplc; i++) {
+        if (project_tuple(qrp, &qrp->val.children.batchv[i], &tplv[i], ecp)
+                != RDB_OK)
+            return RDB_ERROR;
+    }
+    return tplc;
+}
+
 static int
 next_where_index(RDB_qresult *qrp, RDB_object *tplp,
         RDB_exec_context *ecp, RDB_transaction *txp)
@@ -1842,7 +2738,7 @@ next_where_index(RDB_qresult *qrp, RDB_object *tplp,
     if (qrp->val.stored.curp == NULL) {
         ret = RDB_get_by_uindex(qrp->val.stored.tbp,
                 qrp->exp->def.op.optinfo.objpv, indexp,
-                tpltyp, ecp, txp, tplp);
+                tpltyp, &qrp->arena, ecp, txp, tplp);
         if (ret != RDB_OK) {
             goto error;
         }
@@ -1920,9 +2816,8 @@ wrap_tuple(const RDB_object *tplp, RDB_expression *exp,
     int i, j;
     int ret;
     RDB_object tpl;
+    int attrc;
     RDB_object *objp;
-    RDB_hashtable_iter it;
-    tuple_entry *entryp;
     RDB_expression *argp;
     int wrapc = (RDB_expr_list_length(&exp->def.op.args) - 1) / 2;
 
@@ -1972,16 +2867,16 @@ wrap_tuple(const RDB_object *tplp, RDB_expression *exp,
     RDB_destroy_obj(&tpl, ecp);
 
     /* Copy attributes which have not been wrapped */
-    RDB_init_hashtable_iter(&it, (RDB_hashtable *)&tplp->val.tpl_tab);
-    while ((entryp = RDB_hashtable_next(&it)) != NULL) {
-        int i;
+    attrc = RDB_tuple_size(tplp);
+    for (j = 0; j < attrc; j++) {
+        const char *tplattrname = RDB_tuple_slot_name(tplp, j);
         /* char *attrname = RDB_obj_string(&exp->def.op.argv[2 + 2 * i]->var.obj); */
 
         i = 0;
         ret = RDB_INT_MAX;
         argp = exp->def.op.args.firstp->nextp;
         while (i < wrapc && ret == RDB_INT_MAX) {
-            ret = find_str(&argp->def.obj, entryp->key,
+            ret = find_str(&argp->def.obj, tplattrname,
                     ecp);
             if (ret == RDB_ERROR) {
                 RDB_destroy_obj(&tpl, ecp);
@@ -1992,14 +2887,11 @@ wrap_tuple(const RDB_object *tplp, RDB_expression *exp,
         }
         if (i == wrapc) {
             /* Attribute not found, copy */
-            ret = RDB_tuple_set(restplp, entryp->key, &entryp->obj, ecp);
-            if (ret != RDB_OK) {
-                RDB_destroy_hashtable_iter(&it);
+            ret = RDB_tuple_set(restplp, tplattrname, RDB_tuple_slot(tplp, j), ecp);
+            if (ret != RDB_OK)
                 return RDB_ERROR;
-            }
         }
     }
-    RDB_destroy_hashtable_iter(&it);
 
     return RDB_OK;
 }
@@ -2017,9 +2909,32 @@ next_wrap(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
         RDB_destroy_obj(&tpl, ecp);
         return RDB_ERROR;
     }
-    ret = wrap_tuple(&tpl, qrp->exp, ecp, tplp);
-    RDB_destroy_obj(&tpl, ecp);
-    return ret;
+    ret = wrap_tuple(&tpl, qrp->exp, ecp, tplp);
+    RDB_destroy_obj(&tpl, ecp);
+    return ret;
+}
+
+static void
+del_cexprs(RDB_qresult *qrp, RDB_exec_context *ecp)
+{
+    int i;
+
+    for (i = 0; i < qrp->val.children.cexpc; i++) {
+        if (qrp->val.children.cexpv[i] != NULL)
+            RDB_del_cexpr(qrp->val.children.cexpv[i], ecp);
+    }
+    RDB_free(qrp->val.children.cexpv);
+}
+
+static void
+del_tuple_batch(RDB_object *tplv, RDB_exec_context *ecp)
+{
+    int i;
+
+    for (i = 0; i < RDB_TUPLE_BATCH_SIZE; i++) {
+        RDB_destroy_obj(&tplv[i], ecp);
+    }
+    RDB_free(tplv);
 }
 
 static int
@@ -2041,6 +2956,22 @@ destroy_qresult(RDB_qresult *qrp, RDB_exec_context *ecp, RDB_transaction *txp)
         }
         if (qrp->val.children.tpl_valid)
             RDB_destroy_obj(&qrp->val.children.tpl, ecp);
+        if (RDB_expr_is_op(qrp->exp, "join") && qrp->val.children.hjp != NULL)
+            RDB_del_join_hashtab(qrp->val.children.hjp, ecp);
+        if (RDB_expr_is_op(qrp->exp, "join") && qrp->val.children.mjp != NULL)
+            RDB_del_join_merge(qrp->val.children.mjp, ecp);
+        if (RDB_expr_is_op(qrp->exp, "join") && qrp->val.children.uixp != NULL)
+            RDB_del_join_uix(qrp->val.children.uixp, ecp);
+        if ((RDB_expr_is_op(qrp->exp, "where") || RDB_expr_is_op(qrp->exp, "extend"))
+                && qrp->val.children.cexpv != NULL)
+            del_cexprs(qrp, ecp);
+        if (RDB_expr_is_op(qrp->exp, "project")
+                && qrp->val.children.batchv != NULL)
+            del_tuple_batch(qrp->val.children.batchv, ecp);
+    } else if (qrp->exp == NULL && qrp->val.stored.tbp == NULL) {
+        /* Sorter */
+        RDB_del_sort(qrp->val.stored.sortp, ecp);
+        ret = RDB_OK;
     } else if (qrp->val.stored.curp != NULL) {
         ret = RDB_destroy_cursor(qrp->val.stored.curp, ecp);
         if (ret != RDB_OK) {
@@ -2053,6 +2984,9 @@ destroy_qresult(RDB_qresult *qrp, RDB_exec_context *ecp, RDB_transaction *txp)
 
     if (qrp->matp != NULL)
         RDB_drop_table(qrp->matp, ecp, txp);
+    if (qrp->dupsetp != NULL)
+        RDB_del_tupleset(qrp->dupsetp, ecp);
+    RDB_destroy_arena(&qrp->arena);
     return ret;
 }
 
@@ -2186,19 +3120,77 @@ next_sdivide(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
     return RDB_OK;
 }
 
+/*
+ * Compile the WHERE condition or the EXTEND attribute expressions of qrp->exp
+ * so operators and attributes are not looked up by name for each tuple.
+ * If tracing is enabled, the expressions are not compiled so evaluating them
+ * is traced.
+ */
+static int
+compile_tuple_exprs(RDB_qresult *qrp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    int i;
+    RDB_expression *argp;
+    RDB_type *reltyp;
+    int expc = RDB_expr_list_length(&qrp->exp->def.op.args) - 1;
+
+    if (qrp->exp->def.op.code == RDB_OP_EXTEND)
+        expc /= 2;
+
+    qrp->val.children.cexpv = RDB_alloc(sizeof(RDB_cexpr *) * expc, ecp);
+    if (qrp->val.children.cexpv == NULL)
+        return RDB_ERROR;
+    for (i = 0; i < expc; i++) {
+        qrp->val.children.cexpv[i] = NULL;
+    }
+    qrp->val.children.cexpc = expc;
+
+    if (txp != NULL && RDB_env_trace(txp->envp) > 0)
+        return RDB_OK;
+
+    reltyp = RDB_expr_type(qrp->exp->def.op.args.firstp, NULL, NULL, NULL,
+            ecp, txp);
+    if (reltyp == NULL)
+        return RDB_ERROR;
+
+    argp = qrp->exp->def.op.args.firstp->nextp;
+    for (i = 0; i < expc; i++) {
+        qrp->val.children.cexpv[i] = RDB_compile_expr(argp, reltyp->def.basetyp,
+                NULL, ecp, txp);
+        if (qrp->val.children.cexpv[i] == NULL)
+            return RDB_ERROR;
+        argp = argp->nextp;
+        if (qrp->exp->def.op.code == RDB_OP_EXTEND)
+            argp = argp->nextp;
+    }
+    return RDB_OK;
+}
+
 static int
 next_where_tuple(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
         RDB_transaction *txp)
 {
     int ret;
     RDB_bool expres;
+    RDB_cexpr *cxp;
+
+    if (qrp->val.children.cexpv == NULL) {
+        if (compile_tuple_exprs(qrp, ecp, txp) != RDB_OK)
+            return RDB_ERROR;
+    }
+    cxp = qrp->val.children.cexpv[0];
 
     do {
         ret = RDB_next_tuple(qrp->val.children.qrp, tplp, ecp, txp);
         if (ret != RDB_OK)
             break;
-        ret = RDB_evaluate_bool(qrp->exp->def.op.args.firstp->nextp,
-                &RDB_tpl_get, tplp, NULL, ecp, txp, &expres);
+        if (cxp != NULL) {
+            ret = RDB_cexpr_evaluate_bool(cxp, tplp, ecp, txp, &expres);
+        } else {
+            ret = RDB_evaluate_bool(qrp->exp->def.op.args.firstp->nextp,
+                    &RDB_tpl_get, tplp, NULL, ecp, txp, &expres);
+        }
         if (ret != RDB_OK)
             break;
     } while (!expres);
@@ -2206,6 +3198,62 @@ next_where_tuple(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
     return ret;
 }
 
+static void
+swap_objs(RDB_object *obj1p, RDB_object *obj2p)
+{
+    RDB_object obj = *obj1p;
+
+    *obj1p = *obj2p;
+    *obj2p = obj;
+}
+
+/*
+ * Read tuples from the child of the nested WHERE qresult *qrp
+ * in a single batch and move the tuples which satisfy the condition
+ * to the beginning of tplv.
+ * Returns the number of these tuples or RDB_ERROR.
+ */
+static int
+next_where_tuples(RDB_qresult *qrp, RDB_object tplv[], int n,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int i;
+    int tplc;
+    int resc = 0;
+    RDB_bool expres;
+    RDB_cexpr *cxp;
+
+    if (qrp->val.children.cexpv == NULL) {
+        if (compile_tuple_exprs(qrp, ecp, txp) != RDB_OK)
+            return RDB_ERROR;
+    }
+    cxp = qrp->val.children.cexpv[0];
+
+    tplc = RDB_next_tuples(qrp->val.children.qrp, tplv, n, ecp, txp);
+    if (tplc == RDB_ERROR)
+        return RDB_ERROR;
+    if (tplc < n)
+        qrp->endreached = RDB_TRUE;
+
+    for (i = 0; i < tplc; i++) {
+        if (cxp != NULL) {
+            if (RDB_cexpr_evaluate_bool(cxp, &tplv[i], ecp, txp, &expres)
+                    != RDB_OK)
+                return RDB_ERROR;
+        } else {
+            if (RDB_evaluate_bool(qrp->exp->def.op.args.firstp->nextp,
+                    &RDB_tpl_get, &tplv[i], NULL, ecp, txp, &expres) != RDB_OK)
+                return RDB_ERROR;
+        }
+        if (expres) {
+            if (i != resc)
+                swap_objs(&tplv[resc], &tplv[i]);
+            resc++;
+        }
+    }
+    return resc;
+}
+
 static int
 next_rename(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
         RDB_transaction *txp)
@@ -2326,20 +3374,31 @@ next_semijoin(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
     return RDB_OK;
 }
 
+/*
+ * Add the attributes of the EXTEND qresult *qrp to *tplp
+ */
 static int
-next_extend(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
+extend_tuple(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
         RDB_transaction *txp)
 {
+    int i;
     int ret;
     RDB_object obj;
+    RDB_object *valp;
     RDB_expression *argp;
-    
-    ret = RDB_next_tuple(qrp->val.children.qrp, tplp, ecp, txp);
-    if (ret != RDB_OK)
-        return RDB_ERROR;
 
     argp = qrp->exp->def.op.args.firstp->nextp;
-    while (argp != NULL) {
+    for (i = 0; argp != NULL; i++) {
+        if (qrp->val.children.cexpv[i] != NULL) {
+            if (RDB_cexpr_evaluate(qrp->val.children.cexpv[i], tplp, ecp, txp,
+                    &valp) != RDB_OK)
+                return RDB_ERROR;
+            if (RDB_tuple_set(tplp, RDB_obj_string(&argp->nextp->def.obj),
+                    valp, ecp) != RDB_OK)
+                return RDB_ERROR;
+            argp = argp->nextp->nextp;
+            continue;
+        }
         RDB_init_obj(&obj);
         if (RDB_evaluate(argp, &RDB_tpl_get, tplp, NULL, ecp,
                 txp, &obj) != RDB_OK) {
@@ -2357,6 +3416,54 @@ next_extend(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
     return RDB_OK;
 }
 
+static int
+next_extend(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    int ret;
+
+    if (qrp->val.children.cexpv == NULL) {
+        if (compile_tuple_exprs(qrp, ecp, txp) != RDB_OK)
+            return RDB_ERROR;
+    }
+
+    ret = RDB_next_tuple(qrp->val.children.qrp, tplp, ecp, txp);
+    if (ret != RDB_OK)
+        return RDB_ERROR;
+
+    return extend_tuple(qrp, tplp, ecp, txp);
+}
+
+/*
+ * Read tuples from the child of the EXTEND qresult *qrp
+ * in a single batch and add the attributes.
+ * Returns the number of tuples read or RDB_ERROR.
+ */
+static int
+next_extend_tuples(RDB_qresult *qrp, RDB_object tplv[], int n,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int i;
+    int tplc;
+
+    if (qrp->val.children.cexpv == NULL) {
+        if (compile_tuple_exprs(qrp, ecp, txp) != RDB_OK)
+            return RDB_ERROR;
+    }
+
+    tplc = RDB_next_tuples(qrp->val.children.qrp, tplv, n, ecp, txp);
+    if (tplc == RDB_ERROR)
+        return RDB_ERROR;
+    if (tplc < n)
+        qrp->endreached = RDB_TRUE;
+
+    for (i = 0; i < tplc; i++) {
+        if (extend_tuple(qrp, &tplv[i], ecp, txp) != RDB_OK)
+            return RDB_ERROR;
+    }
+    return tplc;
+}
+
 static int
 next_relation(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
         RDB_transaction *txp)
@@ -2387,17 +3494,12 @@ RDB_next_tuple(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
     }
 
     if (qrp->exp == NULL) {
-        RDB_type *tpltyp;
         if (qrp->val.stored.tbp == NULL) {
             /* It's a sorter */
-           return RDB_next_stored_tuple(qrp, qrp->matp, tplp, RDB_TRUE, RDB_FALSE,
-                    qrp->matp->typ->def.basetyp, ecp, txp);
-	    }
-        tpltyp = qrp->val.stored.tbp->typ->kind == RDB_TP_RELATION ?
-                qrp->val.stored.tbp->typ->def.basetyp
-                : RDB_obj_impl_type(qrp->val.stored.tbp)->def.scalar.arep->def.basetyp;
+            return RDB_next_sorted_tuple(qrp, tplp, ecp, txp);
+        }
         return RDB_next_stored_tuple(qrp, qrp->val.stored.tbp, tplp, RDB_TRUE,
-                RDB_FALSE, tpltyp, ecp, txp);
+                RDB_FALSE, stored_tuple_type(qrp->val.stored.tbp), ecp, txp);
     }
 
     if (!qrp->nested && qrp->val.stored.tbp == NULL && qrp->val.stored.curp != NULL) {
@@ -2415,89 +3517,330 @@ RDB_next_tuple(RDB_qresult *qrp, RDB_object *tplp, RDB_exec_context *ecp,
     	return RDB_ERROR;
     }
 
-    do {
-        /* ELEMENT_EXISTS can be active */
-        RDB_clear_err(ecp);
+    for (;;) {
+        RDB_bool inserted;
 
         if (qrp->endreached) {
             RDB_raise_not_found("", ecp);
             return RDB_ERROR;
         }
 
-        if (strcmp(qrp->exp->def.op.name, "where") == 0) {
+        switch (qrp->exp->def.op.code) {
+        case RDB_OP_WHERE:
             if (qrp->nested) {
-                if (next_where_tuple(qrp, tplp, ecp, txp) != RDB_OK)
-                    return RDB_ERROR;
+                ret = next_where_tuple(qrp, tplp, ecp, txp);
             } else {
-                if (next_where_index(qrp, tplp, ecp, txp) != RDB_OK)
-                    return RDB_ERROR;
-            }                
-        } else if (strcmp(qrp->exp->def.op.name, "project") == 0) {
-            if (next_project(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else if (strcmp(qrp->exp->def.op.name, "rename") == 0) {
-            if (next_rename(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else if (strcmp(qrp->exp->def.op.name, "join") == 0) {
-            if (RDB_next_join(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else if ((strcmp(qrp->exp->def.op.name, "minus") == 0)
-                || (strcmp(qrp->exp->def.op.name, "semiminus") == 0)) {
-            if (next_semiminus_tuple(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else if (strcmp(qrp->exp->def.op.name, "union") == 0) {
-            if (next_union(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else if (strcmp(qrp->exp->def.op.name, "d_union") == 0) {
-            if (next_d_union(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else if ((strcmp(qrp->exp->def.op.name, "intersect") == 0)
-                || (strcmp(qrp->exp->def.op.name, "semijoin") == 0)) {
-            if (next_semijoin(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else if (strcmp(qrp->exp->def.op.name, "extend") == 0) {
-            if (next_extend(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else if (strcmp(qrp->exp->def.op.name, "wrap") == 0) {
-            if (next_wrap(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else if (strcmp(qrp->exp->def.op.name, "unwrap") == 0) {
-            if (next_unwrap(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else if (strcmp(qrp->exp->def.op.name, "divide") == 0) {
-            if (next_sdivide(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else if (strcmp(qrp->exp->def.op.name, "tclose") == 0) {
-            if (RDB_next_tclose_tuple(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else if (strcmp(qrp->exp->def.op.name, "ungroup") == 0) {
-            if (next_ungroup_tuple(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else if (strcmp(qrp->exp->def.op.name, "relation") == 0) {
-            if (next_relation(qrp, tplp, ecp, txp) != RDB_OK)
-                return RDB_ERROR;
-        } else {
+                ret = next_where_index(qrp, tplp, ecp, txp);
+            }
+            break;
+        case RDB_OP_PROJECT:
+            ret = next_project(qrp, tplp, ecp, txp);
+            break;
+        case RDB_OP_RENAME:
+            ret = next_rename(qrp, tplp, ecp, txp);
+            break;
+        case RDB_OP_JOIN:
+            ret = RDB_next_join(qrp, tplp, ecp, txp);
+            break;
+        case RDB_OP_MINUS:
+        case RDB_OP_SEMIMINUS:
+            ret = next_semiminus_tuple(qrp, tplp, ecp, txp);
+            break;
+        case RDB_OP_UNION:
+            ret = next_union(qrp, tplp, ecp, txp);
+            break;
+        case RDB_OP_D_UNION:
+            ret = next_d_union(qrp, tplp, ecp, txp);
+            break;
+        case RDB_OP_INTERSECT:
+        case RDB_OP_SEMIJOIN:
+            ret = next_semijoin(qrp, tplp, ecp, txp);
+            break;
+        case RDB_OP_EXTEND:
+            ret = next_extend(qrp, tplp, ecp, txp);
+            break;
+        case RDB_OP_WRAP:
+            ret = next_wrap(qrp, tplp, ecp, txp);
+            break;
+        case RDB_OP_UNWRAP:
+            ret = next_unwrap(qrp, tplp, ecp, txp);
+            break;
+        case RDB_OP_DIVIDE:
+            ret = next_sdivide(qrp, tplp, ecp, txp);
+            break;
+        case RDB_OP_TCLOSE:
+            ret = RDB_next_tclose_tuple(qrp, tplp, ecp, txp);
+            break;
+        case RDB_OP_UNGROUP:
+            ret = next_ungroup_tuple(qrp, tplp, ecp, txp);
+            break;
+        case RDB_OP_RELATION:
+            ret = next_relation(qrp, tplp, ecp, txp);
+            break;
+        default:
             RDB_raise_internal(qrp->exp->def.op.name, ecp);
             return RDB_ERROR;
         }
+        if (ret != RDB_OK)
+            return RDB_ERROR;
 
         /* Check for duplicate, if necessary */
-        if (qrp->matp != NULL && strcmp(qrp->exp->def.op.name, "tclose") != 0) {
-            ret = RDB_insert_nonvirtual(qrp->matp, tplp, ecp, txp);
-            if (ret != RDB_OK) {
-                if (RDB_obj_type(RDB_get_err(ecp))
-                        != &RDB_ELEMENT_EXISTS_ERROR) {
+        if (qrp->dupsetp == NULL)
+            return RDB_OK;
+        if (RDB_tupleset_insert(qrp->dupsetp, tplp, ecp, &inserted) != RDB_OK)
+            return RDB_ERROR;
+        if (inserted)
+            return RDB_OK;
+    }
+}
+
+typedef int next_tuple_func(RDB_qresult *, RDB_object *, RDB_exec_context *,
+        RDB_transaction *);
+
+/*
+ * Return the function which reads the next tuple of *qrp
+ * if it can be called repeatedly by RDB_next_tuples(), otherwise NULL.
+ */
+static next_tuple_func *
+batch_next_fn(const RDB_qresult *qrp)
+{
+    /* Materialized results must be read by RDB_next_tuple() */
+    if (qrp->matp != NULL || qrp->exp->kind != RDB_EX_RO_OP)
+        return NULL;
+
+    switch (qrp->exp->def.op.code) {
+    case RDB_OP_WHERE:
+        return qrp->nested ? &next_where_tuple : &next_where_index;
+    case RDB_OP_PROJECT:
+        return &next_project;
+    case RDB_OP_EXTEND:
+        return &next_extend;
+    case RDB_OP_JOIN:
+        return &RDB_next_join;
+    default:
+        return NULL;
+    }
+}
+
+typedef int next_tuples_func(RDB_qresult *, RDB_object[], int,
+        RDB_exec_context *, RDB_transaction *);
+
+/*
+ * Return the function which reads a batch of tuples from the child
+ * of the nested qresult *qrp, or NULL if there is none.
+ */
+static next_tuples_func *
+batch_read_fn(const RDB_qresult *qrp)
+{
+    if (qrp->matp != NULL || qrp->exp->kind != RDB_EX_RO_OP || !qrp->nested)
+        return NULL;
+
+    switch (qrp->exp->def.op.code) {
+    case RDB_OP_WHERE:
+        return &next_where_tuples;
+    case RDB_OP_PROJECT:
+        return &next_project_tuples;
+    case RDB_OP_EXTEND:
+        return &next_extend_tuples;
+    default:
+        return NULL;
+    }
+}
+
+/*
+ * Remove the tuples from tplv[0] .. tplv[tplc - 1] which have already
+ * been returned by *qrp, moving the remaining tuples to the beginning.
+ * Returns the number of remaining tuples or RDB_ERROR.
+ */
+static int
+remove_dup_tuples(RDB_qresult *qrp, RDB_object tplv[], int tplc,
+        RDB_exec_context *ecp)
+{
+    int i;
+    int resc = 0;
+    RDB_bool inserted;
+
+    for (i = 0; i < tplc; i++) {
+        if (RDB_tupleset_insert(qrp->dupsetp, &tplv[i], ecp, &inserted)
+                != RDB_OK)
+            return RDB_ERROR;
+        if (inserted) {
+            if (i != resc)
+                swap_objs(&tplv[resc], &tplv[i]);
+            resc++;
+        }
+    }
+    return resc;
+}
+
+/**
+ * Read up to n tuples from the qresult *qrp and store them in
+<var>tplv</var>[0] .. <var>tplv</var>[<var>n</var> - 1].
+The elements of <var>tplv</var> must have been initialized
+using RDB_init_obj().
+
+Stored tables, sorters and WHERE, project, EXTEND and JOIN are read
+without dispatching on the operator and checking for errors for each tuple.
+WHERE, project and EXTEND over other operators read the tuples of their
+argument in batches using RDB_next_tuples().
+
+@returns
+
+The number of tuples read, which is less than <var>n</var> only
+if the end of the qresult has been reached, or RDB_ERROR if an error occurred.
+ */
+int
+RDB_next_tuples(RDB_qresult *qrp, RDB_object tplv[], int n,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int i = 0;
+    RDB_object *tbp = NULL;
+    RDB_type *tpltyp = NULL;
+    next_tuple_func *nextfp = NULL;
+    next_tuples_func *readfp = NULL;
+
+    RDB_clear_err(ecp);
+    if (qrp->endreached)
+        return 0;
+
+    if (qrp->exp == NULL && qrp->val.stored.tbp == NULL) {
+        /* It's a sorter */
+        nextfp = &RDB_next_sorted_tuple;
+    } else if (qrp->exp == NULL) {
+        /* Tuples of a stored table are read directly using the cursor */
+        tbp = qrp->val.stored.tbp;
+        tpltyp = stored_tuple_type(tbp);
+    } else if (!qrp->nested && qrp->val.stored.tbp == NULL
+            && qrp->val.stored.curp != NULL) {
+        RDB_type *tbtyp = RDB_expr_type(qrp->exp, NULL, NULL, NULL, ecp, txp);
+        if (tbtyp == NULL)
+            return RDB_ERROR;
+        tpltyp = RDB_base_type(tbtyp);
+    } else {
+        readfp = batch_read_fn(qrp);
+        if (readfp == NULL)
+            nextfp = batch_next_fn(qrp);
+    }
+
+    if (readfp != NULL) {
+        while (i < n && !qrp->endreached) {
+            int tplc = (*readfp)(qrp, tplv + i, n - i, ecp, txp);
+            if (tplc == RDB_ERROR)
+                return RDB_ERROR;
+            if (qrp->dupsetp != NULL) {
+                tplc = remove_dup_tuples(qrp, tplv + i, tplc, ecp);
+                if (tplc == RDB_ERROR)
                     return RDB_ERROR;
-                }
             }
-        } else {
-            ret = RDB_OK;
+            i += tplc;
+        }
+        return i;
+    }
+
+    if (tpltyp != NULL) {
+        for (i = 0; i < n; i++) {
+            if (RDB_next_stored_tuple(qrp, tbp, &tplv[i], RDB_TRUE,
+                    RDB_FALSE, tpltyp, ecp, txp) != RDB_OK)
+                break;
+        }
+    } else if (nextfp != NULL) {
+        while (i < n && !qrp->endreached) {
+            if ((*nextfp)(qrp, &tplv[i], ecp, txp) != RDB_OK)
+                break;
+            if (qrp->dupsetp != NULL) {
+                RDB_bool inserted;
+
+                if (RDB_tupleset_insert(qrp->dupsetp, &tplv[i], ecp,
+                        &inserted) != RDB_OK)
+                    break;
+                if (!inserted)
+                    continue;
+            }
+            i++;
+        }
+        if (i < n && qrp->endreached && RDB_get_err(ecp) == NULL)
+            return i;
+    } else {
+        for (i = 0; i < n; i++) {
+            if (RDB_next_tuple(qrp, &tplv[i], ecp, txp) != RDB_OK)
+                break;
         }
-    } while (ret == RDB_ERROR && RDB_obj_type(RDB_get_err(ecp))
-            == &RDB_ELEMENT_EXISTS_ERROR);
+    }
+
+    if (i < n) {
+        if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR)
+            return RDB_ERROR;
+        RDB_clear_err(ecp);
+    }
+    return i;
+}
+
+/*
+ * Initialize *batchp for reading tuples from *qrp.
+ * If an error occurs, batchp->tplv is set to NULL, so
+ * RDB_destroy_tuple_batch() can still be called.
+ */
+int
+RDB_init_tuple_batch(RDB_tuple_batch *batchp, RDB_qresult *qrp,
+        RDB_exec_context *ecp)
+{
+    int i;
+
+    batchp->tplv = RDB_alloc(sizeof(RDB_object) * RDB_TUPLE_BATCH_SIZE, ecp);
+    if (batchp->tplv == NULL)
+        return RDB_ERROR;
+    for (i = 0; i < RDB_TUPLE_BATCH_SIZE; i++) {
+        RDB_init_obj(&batchp->tplv[i]);
+    }
+    batchp->qrp = qrp;
+    batchp->tplc = 0;
+    batchp->pos = 0;
     return RDB_OK;
 }
 
+/*
+ * Return the next tuple from the batch, reading the next batch
+ * if necessary.
+ * Returns NULL if the end of the qresult has been reached
+ * or an error occurred. In the latter case, an error is left in *ecp.
+ * The tuple is valid until the next call.
+ */
+RDB_object *
+RDB_batch_next_tuple(RDB_tuple_batch *batchp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    if (batchp->pos >= batchp->tplc) {
+        /* A short batch means the end has been reached */
+        if (batchp->tplc > 0 && batchp->tplc < RDB_TUPLE_BATCH_SIZE)
+            return NULL;
+        batchp->tplc = RDB_next_tuples(batchp->qrp, batchp->tplv,
+                RDB_TUPLE_BATCH_SIZE, ecp, txp);
+        batchp->pos = 0;
+        if (batchp->tplc <= 0) {
+            batchp->tplc = 0;
+            return NULL;
+        }
+    }
+    return &batchp->tplv[batchp->pos++];
+}
+
+int
+RDB_destroy_tuple_batch(RDB_tuple_batch *batchp, RDB_exec_context *ecp)
+{
+    int i;
+    int ret = RDB_OK;
+
+    if (batchp->tplv == NULL)
+        return RDB_OK;
+    for (i = 0; i < RDB_TUPLE_BATCH_SIZE; i++) {
+        if (RDB_destroy_obj(&batchp->tplv[i], ecp) != RDB_OK)
+            ret = RDB_ERROR;
+    }
+    RDB_free(batchp->tplv);
+    batchp->tplv = NULL;
+    return ret;
+}
+
 int
 RDB_reset_qresult(RDB_qresult *qrp, RDB_exec_context *ecp, RDB_transaction *txp)
 {
@@ -2507,7 +3850,7 @@ RDB_reset_qresult(RDB_qresult *qrp, RDB_exec_context *ecp, RDB_transaction *txp)
      * If it is a qresult over a RELATION expression, we don't have to do anything
      */
     if (qrp->exp != NULL && qrp->exp->kind == RDB_EX_RO_OP
-            && strcmp(qrp->exp->def.op.name, "relation") == 0) {
+            && qrp->exp->def.op.code == RDB_OP_RELATION) {
         return RDB_OK;
     }
 
@@ -2524,6 +3867,14 @@ RDB_reset_qresult(RDB_qresult *qrp, RDB_exec_context *ecp, RDB_transaction *txp)
             RDB_destroy_obj(&qrp->val.children.tpl, ecp);
             qrp->val.children.tpl_valid = RDB_FALSE;
         }
+        if (RDB_expr_is_op(qrp->exp, "join") && qrp->val.children.uixp != NULL)
+            RDB_reset_join_uix(qrp->val.children.uixp);
+        qrp->endreached = RDB_FALSE;
+    } else if (qrp->exp == NULL && qrp->val.stored.tbp == NULL) {
+        /* Sorter */
+        if (RDB_reset_sort(qrp->val.stored.sortp, ecp) != RDB_OK)
+            return RDB_ERROR;
+        qrp->endreached = RDB_FALSE;
     } else {
         if (qrp->val.stored.curp != NULL) {
             /* Reset cursor */
@@ -2543,6 +3894,8 @@ RDB_reset_qresult(RDB_qresult *qrp, RDB_exec_context *ecp, RDB_transaction *txp)
             qrp->endreached = RDB_FALSE;
         }
     }
+    if (qrp->dupsetp != NULL)
+        RDB_clear_tupleset(qrp->dupsetp);
     if (qrp->exp != NULL && qrp->matp != NULL) {
         /* Clear materialized result */
         if (RDB_delete_nonvirtual(qrp->matp, NULL, NULL, NULL, ecp, txp)
@@ -2569,6 +3922,7 @@ RDB_del_table_iterator(RDB_qresult *qrp, RDB_exec_context *ecp,
 {
     RDB_expression *texp = qrp->opt_exp;
     int ret = RDB_del_qresult(qrp, ecp, txp);
-    RDB_del_expr(texp, ecp);
+    if (texp != NULL)
+        RDB_del_expr(texp, ecp);
     return ret;
 }
@@ -10,8 +10,14 @@
 
 #include "rdb.h"
 #include <rec/cursor.h>
+#include <gen/arena.h>
 
 struct RDB_tbindex;
+struct RDB_join_hashtab;
+struct RDB_join_merge;
+struct RDB_join_uix;
+struct RDB_sort;
+struct RDB_tupleset;
 
 typedef struct RDB_qresult {
     /* May be NULL */
@@ -25,6 +31,17 @@ typedef struct RDB_qresult {
 
             /* NULL if a unique index is used */
             RDB_cursor *curp;
+
+            /* only used for sorter */
+            struct RDB_sort *sortp;
+
+            /*
+             * Indexes of the tuple attributes which are read from the cursor,
+             * NULL if all attributes are read.
+             * Set by RDB_set_needed_attrs().
+             */
+            int *attrv;
+            int attrc;
         } stored;
         /* nested */
         struct {
@@ -36,6 +53,31 @@ typedef struct RDB_qresult {
             /* only used for join and ungroup */
             RDB_object tpl;
             RDB_bool tpl_valid;
+
+            /* only used for hash join */
+            struct RDB_join_hashtab *hjp;
+
+            /* only used for merge join */
+            struct RDB_join_merge *mjp;
+
+            /*
+             * only used for nested loop join over a unique index
+             * if the tuples are read in batches
+             */
+            struct RDB_join_uix *uixp;
+
+            /*
+             * only used for WHERE and EXTEND: the compiled condition
+             * or attribute expressions, NULL if not compiled yet
+             */
+            struct RDB_cexpr **cexpv;
+            int cexpc;
+
+            /*
+             * only used for project: tuples read from the child
+             * by RDB_next_tuples(), NULL if not allocated yet
+             */
+            RDB_object *batchv;
         } children;
         /* Used when iterating over operator arguments */
         RDB_expression *next_exp;
@@ -49,6 +91,22 @@ typedef struct RDB_qresult {
      */
     RDB_object *matp;
 
+    /*
+     * Memory for data which is only needed while iterating,
+     * like the entries of a hash join.
+     * Freed in bulk when the qresult is destroyed.
+     * Temporary data needed for reading a single tuple, like field arrays
+     * and key value pointers, is also allocated from it and released
+     * using a mark when the tuple has been read.
+     */
+    RDB_arena arena;
+
+    /*
+     * Tuples which have been returned, used for removing duplicates.
+     * NULL if the qresult cannot return duplicates.
+     */
+    struct RDB_tupleset *dupsetp;
+
     /*
      * Otimized expression created by RDB_table_iterator().
      */
@@ -77,11 +135,11 @@ RDB_seek_index_qresult(RDB_qresult *, struct RDB_tbindex *,
         const RDB_object *, RDB_exec_context *, RDB_transaction *);
 
 int
-RDB_sorter(RDB_expression *, RDB_qresult **qrespp, RDB_exec_context *,
-        RDB_transaction *, int seqitc, const RDB_seq_item seqitv[]);
+RDB_duprem(RDB_qresult *, RDB_exec_context *, RDB_transaction *);
 
 int
-RDB_duprem(RDB_qresult *, RDB_exec_context *, RDB_transaction *);
+RDB_set_needed_attrs(RDB_qresult *, int attrc, char *attrv[],
+        RDB_exec_context *, RDB_transaction *);
 
 int
 RDB_get_by_cursor(RDB_object *, RDB_cursor *, RDB_type *, RDB_object *,
@@ -89,12 +147,49 @@ RDB_get_by_cursor(RDB_object *, RDB_cursor *, RDB_type *, RDB_object *,
 
 int
 RDB_get_by_uindex(RDB_object *tbp, RDB_object *objpv[],
-        struct RDB_tbindex *indexp, RDB_type *, RDB_exec_context *,
-        RDB_transaction *, RDB_object *tplp);
+        struct RDB_tbindex *indexp, RDB_type *, RDB_arena *,
+        RDB_exec_context *, RDB_transaction *, RDB_object *tplp);
+
+RDB_bool
+RDB_multi_get_supported(RDB_object *, struct RDB_tbindex *);
+
+int
+RDB_get_by_uindex_multi(RDB_object *tbp, int tplc, RDB_object keytplv[],
+        struct RDB_tbindex *indexp, RDB_type *, RDB_arena *,
+        RDB_exec_context *, RDB_transaction *, RDB_object tplv[],
+        RDB_bool foundv[]);
 
 int
 RDB_reset_qresult(RDB_qresult *, RDB_exec_context *, RDB_transaction *);
 
+enum {
+    RDB_TUPLE_BATCH_SIZE = 256
+};
+
+/*
+ * Buffer for reading the tuples of a qresult in batches
+ * using RDB_next_tuples()
+ */
+typedef struct RDB_tuple_batch {
+    RDB_qresult *qrp;
+    RDB_object *tplv;
+
+    /* Number of tuples in tplv */
+    int tplc;
+
+    /* Index of the tuple to be returned next */
+    int pos;
+} RDB_tuple_batch;
+
+int
+RDB_init_tuple_batch(RDB_tuple_batch *, RDB_qresult *, RDB_exec_context *);
+
+RDB_object *
+RDB_batch_next_tuple(RDB_tuple_batch *, RDB_exec_context *, RDB_transaction *);
+
+int
+RDB_destroy_tuple_batch(RDB_tuple_batch *, RDB_exec_context *);
+
 int
 RDB_sdivide_preserves(RDB_expression *, const RDB_object *tplp, RDB_qresult *qr3p,
         RDB_exec_context *, RDB_transaction *, RDB_bool *);
@@ -83,6 +83,8 @@ typedef struct RDB_transaction {
     struct RDB_transaction *parentp;
     struct RDB_rmlink *delrmp;
     struct RDB_ixlink *delixp;
+    RDB_durability durability;
+    RDB_bool cat_modified;
 } RDB_transaction;
 
 #endif
@@ -203,6 +205,9 @@ RDB_drop_db(RDB_database *, RDB_exec_context *);
 int
 RDB_get_dbs(RDB_environment *, RDB_object *, RDB_exec_context *);
 
+unsigned long
+RDB_catalog_version(RDB_environment *);
+
 RDB_object *
 RDB_create_table(const char *,
         int, const RDB_attr[],
@@ -387,6 +392,9 @@ RDB_create_table_index(const char *name, RDB_object *tbp, int idxcompc,
 int
 RDB_drop_table_index(const char *name, RDB_exec_context *, RDB_transaction *);
 
+int
+RDB_analyze_table(RDB_object *, RDB_exec_context *, RDB_transaction *);
+
 int
 RDB_infer_keys(RDB_expression *, RDB_getobjfn *, void *,
         RDB_environment *, RDB_exec_context *, RDB_transaction *,
@@ -423,6 +431,9 @@ RDB_tx_db(RDB_transaction *);
 RDB_bool
 RDB_tx_is_running(RDB_transaction *);
 
+void
+RDB_tx_set_durability(RDB_transaction *, RDB_durability);
+
 int
 RDB_begin_tx(RDB_exec_context *, RDB_transaction *, RDB_database *dbp,
         RDB_transaction *parent);
@@ -481,6 +492,13 @@ RDB_qresult *
 RDB_table_iterator(RDB_object *, int, const RDB_seq_item[],
                    RDB_exec_context *, RDB_transaction *);
 
+RDB_expression *
+RDB_optimize_table(RDB_object *, RDB_exec_context *, RDB_transaction *);
+
+RDB_qresult *
+RDB_optimized_table_iterator(RDB_expression *, RDB_exec_context *,
+        RDB_transaction *);
+
 int
 RDB_del_table_iterator(RDB_qresult *, RDB_exec_context *, RDB_transaction *);
 
@@ -488,6 +506,22 @@ int
 RDB_next_tuple(RDB_qresult *, RDB_object *, RDB_exec_context *,
         RDB_transaction *);
 
+int
+RDB_next_tuples(RDB_qresult *, RDB_object[], int, RDB_exec_context *,
+        RDB_transaction *);
+
+void
+RDB_set_hash_mem(size_t);
+
+size_t
+RDB_hash_mem(void);
+
+void
+RDB_set_sort_mem(size_t);
+
+size_t
+RDB_sort_mem(void);
+
 int
 RDB_obj_property(const RDB_object *, const char *compname,
                    RDB_object *comp, RDB_environment *,
@@ -525,6 +525,7 @@ RDB_deserialize_type(const RDB_object *valp, int *posp, RDB_exec_context *ecp,
         }
         typ->name = NULL;
         typ->kind = RDB_TP_TUPLE;
+        typ->def.tuple.headingp = NULL;
         typ->ireplen = RDB_VARIABLE_LEN;
         typ->cleanup_fp = NULL;
 
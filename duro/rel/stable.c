@@ -51,6 +51,8 @@ free_stored_table(RDB_stored_table *stp)
         }
         RDB_free(stp->indexv);
     }
+    RDB_free(stp->fnov);
+    RDB_free(stp->est_distinctv);
     RDB_free(stp);
 }
 
@@ -93,6 +95,21 @@ RDB_field_no(RDB_stored_table *stp, const char *attrname)
     return entryp != NULL ? &entryp->fno : NULL;
 }
 
+/*
+ * Return the estimated number of distinct values of attribute attrname
+ * of the stored table, or 0 if it is not known.
+ */
+unsigned
+RDB_est_distinct(RDB_stored_table *stp, const char *attrname)
+{
+    RDB_int *fnop;
+
+    if (stp->est_distinctv == NULL)
+        return 0;
+    fnop = RDB_field_no(stp, attrname);
+    return fnop != NULL ? stp->est_distinctv[*fnop] : 0;
+}
+
 static int
 RDB_put_field_no(RDB_stored_table *stp, const char *attrname,
         RDB_int fno, RDB_exec_context *ecp)
@@ -119,7 +136,7 @@ RDB_put_field_no(RDB_stored_table *stp, const char *attrname,
     return ret;
 }
 
-RDB_exec_context *RDB_cmp_ecp;
+RDB_THREAD_LOCAL RDB_exec_context *RDB_cmp_ecp;
 
 static int
 compare_field(const void *data1p, size_t len1, const void *data2p, size_t len2,
@@ -563,6 +580,8 @@ RDB_create_stored_table(RDB_object *tbp, RDB_environment *envp,
         &str_equals);
 
     tbp->val.tbp->stp->est_cardinality = 0;
+    tbp->val.tbp->stp->est_distinctv = NULL;
+    tbp->val.tbp->stp->fnov = NULL;
 
     if (RDB_table_is_persistent(tbp) && RDB_table_is_user(tbp)) {
         /* Get indexes from catalog */
@@ -742,6 +761,8 @@ RDB_open_stored_table(RDB_object *tbp, RDB_environment *envp,
 
     RDB_init_hashtable(&tbp->val.tbp->stp->attrmap, RDB_DFL_MAP_CAPACITY, &hash_str,
             &str_equals);
+    tbp->val.tbp->stp->fnov = NULL;
+    tbp->val.tbp->stp->est_distinctv = NULL;
 
     ret = table_field_infos(tbp, &finfov, ecp);
     if (ret != RDB_OK)
@@ -768,6 +789,22 @@ RDB_open_stored_table(RDB_object *tbp, RDB_environment *envp,
         RDB_handle_err(ecp, txp);
         goto error;
     }
+
+    if (RDB_table_is_persistent(tbp) && RDB_table_is_user(tbp)) {
+        RDB_int card;
+
+        /* Get statistics from catalog */
+        if (RDB_cat_get_table_stats(tbp, &card, ecp, txp) != RDB_OK)
+            goto error;
+
+        /*
+         * The cardinality from the statistics may be outdated,
+         * so it is only used if the record layer does not provide
+         * an estimate
+         */
+        if (tbp->val.tbp->stp->est_cardinality == 0 && card > 0)
+            tbp->val.tbp->stp->est_cardinality = (unsigned) card;
+    }
     if (tbp->val.tbp->stp->est_cardinality == 0) {
         /*
          * Assume that the size has never been calculated
@@ -811,6 +848,7 @@ error:
     RDB_destroy_hashtable_iter(&hiter);
 
     RDB_destroy_hashtable(&tbp->val.tbp->stp->attrmap);
+    RDB_free(tbp->val.tbp->stp->est_distinctv);
     RDB_free(tbp->val.tbp->stp);
     tbp->val.tbp->stp = NULL;
 
@@ -18,6 +18,18 @@ typedef struct RDB_stored_table {
     int indexc;
     struct RDB_tbindex *indexv;
     unsigned est_cardinality; /* estimated cardinality (from statistics) */
+
+    /*
+     * Estimated numbers of distinct attribute values by field number,
+     * 0 if unknown. NULL if the table has not been analyzed.
+     */
+    unsigned *est_distinctv;
+
+    /*
+     * Field numbers in the order of the attributes of the table's
+     * tuple type, created on demand by RDB_get_by_cursor()
+     */
+    RDB_int *fnov;
 } RDB_stored_table;
 
 void
@@ -44,6 +56,9 @@ RDB_delete_stored_table(RDB_stored_table *, RDB_exec_context *, RDB_transaction
 RDB_int *
 RDB_field_no(RDB_stored_table *, const char *attrname);
 
+unsigned
+RDB_est_distinct(RDB_stored_table *, const char *attrname);
+
 int
 RDB_create_tbindex(RDB_object *, RDB_tbindex *, RDB_environment *,
         RDB_exec_context *, RDB_transaction *);
@@ -18,6 +18,7 @@
 #include <obj/objinternal.h>
 #include <gen/hashmapit.h>
 #include <gen/strfns.h>
+#include <gen/hll.h>
 #include <rec/sequence.h>
 
 #include <string.h>
@@ -257,6 +258,56 @@ RDB_table_ilen(const RDB_object *tbp, size_t *lenp, RDB_exec_context *ecp)
     return RDB_del_qresult(qrp, ecp, NULL);
 }
 
+enum {
+    /* Number of tuples inserted using a single bulk operation */
+    MOVE_BATCH_SIZE = 1024
+};
+
+/*
+ * Insert a tuple into the real table *dstp. If the table already contains
+ * the tuple, this is only an error if RDB_DISTINCT is set in flags.
+ */
+static int
+move_tuple(RDB_object *dstp, RDB_object *tplp, int flags,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    if (RDB_insert_nonvirtual(dstp, tplp, ecp,
+            RDB_table_is_persistent(dstp) ? txp : NULL) != RDB_OK) {
+        if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_ELEMENT_EXISTS_ERROR
+                || (flags & RDB_DISTINCT) != 0) {
+            return RDB_ERROR;
+        }
+        RDB_clear_err(ecp);
+    }
+    return RDB_OK;
+}
+
+/*
+ * Insert the tuples tplv[0] .. tplv[tplc - 1] into the real table *dstp
+ * using a bulk operation.
+ * If this fails because of a key violation, the tuples are inserted
+ * one by one, so tuples which are already in the table are handled like
+ * in move_tuple() and the error reported is the same.
+ */
+static int
+move_tuples_bulk(RDB_object *dstp, int tplc, RDB_object tplv[], int flags,
+        RDB_exec_context *ecp, RDB_transaction *txp)
+{
+    int i;
+
+    if (RDB_insert_nonvirtual_bulk(dstp, tplc, tplv, ecp, txp) == RDB_OK)
+        return RDB_OK;
+    if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_KEY_VIOLATION_ERROR)
+        return RDB_ERROR;
+    RDB_clear_err(ecp);
+
+    for (i = 0; i < tplc; i++) {
+        if (move_tuple(dstp, &tplv[i], flags, ecp, txp) != RDB_OK)
+            return RDB_ERROR;
+    }
+    return RDB_OK;
+}
+
 /** @addtogroup table
  * @{
  */
@@ -265,15 +316,21 @@ RDB_table_ilen(const RDB_object *tbp, size_t *lenp, RDB_exec_context *ecp)
  * Copy all tuples from source table into the destination table.
  * The destination table must be a real table.
  *
+ * If the record layer supports it, the tuples are inserted in batches
+ * using bulk operations.
+ *
  * @returns the number of tuples copied on success, RDB_ERROR on failure
  */
 RDB_int
 RDB_move_tuples(RDB_object *dstp, RDB_object *srcp, int flags, RDB_exec_context *ecp,
         RDB_transaction *txp)
 {
+    int i;
     RDB_object tpl;
     int ret;
     int count = 0;
+    int tplc = 0;
+    RDB_object *tplv = NULL;
     RDB_qresult *qrp = NULL;
     RDB_expression *texp = RDB_optimize(srcp, 0, NULL, ecp, txp);
     if (texp == NULL)
@@ -293,25 +350,51 @@ RDB_move_tuples(RDB_object *dstp, RDB_object *srcp, int flags, RDB_exec_context
         goto cleanup;
     }
 
-    while ((ret = RDB_next_tuple(qrp, &tpl, ecp, txp)) == RDB_OK) {
-        if (!RDB_table_is_persistent(dstp))
-            ret = RDB_insert_nonvirtual(dstp, &tpl, ecp, NULL);
-        else
-            ret = RDB_insert_nonvirtual(dstp, &tpl, ecp, txp);
-        if (ret != RDB_OK) {
-            if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_ELEMENT_EXISTS_ERROR
-                    || (flags & RDB_DISTINCT) != 0) {
-                goto cleanup;
+    while ((ret = RDB_next_tuple(qrp, tplv != NULL ? &tplv[tplc] : &tpl,
+            ecp, txp)) == RDB_OK) {
+        count++;
+        if (tplv != NULL) {
+            if (++tplc < MOVE_BATCH_SIZE)
+                continue;
+            ret = move_tuples_bulk(dstp, tplc, tplv, flags, ecp, txp);
+            tplc = 0;
+        } else {
+            ret = move_tuple(dstp, &tpl, flags, ecp, txp);
+
+            /*
+             * Check for bulk insertion after the first tuple has been
+             * inserted, because this may have created the stored table
+             */
+            if (ret == RDB_OK && count == 1 && RDB_bulk_insert_supported(dstp)) {
+                tplv = RDB_alloc(sizeof(RDB_object) * MOVE_BATCH_SIZE, ecp);
+                if (tplv == NULL) {
+                    ret = RDB_ERROR;
+                    goto cleanup;
+                }
+                for (i = 0; i < MOVE_BATCH_SIZE; i++) {
+                    RDB_init_obj(&tplv[i]);
+                }
             }
         }
-        count++;
+        if (ret != RDB_OK)
+            goto cleanup;
     }
     if (RDB_obj_type(RDB_get_err(ecp)) == &RDB_NOT_FOUND_ERROR) {
         RDB_clear_err(ecp);
-        ret = count;
+        ret = RDB_OK;
+        if (tplc > 0)
+            ret = move_tuples_bulk(dstp, tplc, tplv, flags, ecp, txp);
+        if (ret == RDB_OK)
+            ret = count;
     }
 
 cleanup:
+    if (tplv != NULL) {
+        for (i = 0; i < MOVE_BATCH_SIZE; i++) {
+            RDB_destroy_obj(&tplv[i], ecp);
+        }
+        RDB_free(tplv);
+    }
     if (qrp != NULL)
         RDB_del_qresult(qrp, ecp, txp);
     RDB_del_expr(texp, ecp);
@@ -1247,6 +1330,135 @@ error:
     return RDB_ERROR;
 }
 
+/**
+ * RDB_analyze_table reads all tuples of the persistent real table *<var>tbp</var>
+and stores the number of tuples and the estimated number of distinct values
+of each attribute in the catalog.
+The optimizer uses these statistics to choose indexes and to
+order joins.
+
+@returns
+
+RDB_OK on success, RDB_ERROR if an error occurred.
+
+@par Errors:
+
+<dl>
+<dt>no_running_tx_error
+<dd><var>txp</var> does not point to a running transaction.
+<dt>invalid_argument_error
+<dd>*<var>tbp</var> is not a persistent real table.
+</dl>
+
+The call may also fail for a @ref system-errors "system error",
+in which case the transaction may be implicitly rolled back.
+ */
+int
+RDB_analyze_table(RDB_object *tbp, RDB_exec_context *ecp,
+        RDB_transaction *txp)
+{
+    int i;
+    int ret;
+    RDB_stored_table *stp;
+    RDB_cursor *curp;
+    void *datap;
+    size_t len;
+    unsigned count;
+    unsigned *distinctv;
+    RDB_hll *hllv;
+    int attrc;
+
+    if (txp == NULL || !RDB_tx_is_running(txp)) {
+        RDB_raise_no_running_tx(ecp);
+        return RDB_ERROR;
+    }
+
+    if (!RDB_table_is_persistent(tbp) || !RDB_table_is_real(tbp)) {
+        RDB_raise_invalid_argument("table must be a persistent real table",
+                ecp);
+        return RDB_ERROR;
+    }
+
+    if (tbp->val.tbp->stp == NULL) {
+        if (RDB_provide_stored_table(tbp, RDB_TRUE, ecp, txp) != RDB_OK)
+            return RDB_ERROR;
+    }
+    stp = tbp->val.tbp->stp;
+    attrc = tbp->typ->def.basetyp->def.tuple.attrc;
+
+    /* One counter per field */
+    hllv = RDB_alloc(sizeof(RDB_hll) * attrc, ecp);
+    if (hllv == NULL)
+        return RDB_ERROR;
+    for (i = 0; i < attrc; i++) {
+        RDB_init_hll(&hllv[i]);
+    }
+
+    curp = RDB_recmap_cursor(stp->recmapp, RDB_FALSE, txp->tx, ecp);
+    if (curp == NULL) {
+        RDB_handle_err(ecp, txp);
+        RDB_free(hllv);
+        return RDB_ERROR;
+    }
+
+    /*
+     * Scan the table, counting the records and feeding the field values,
+     * which are in internal representation, into the counters
+     */
+    count = 0;
+    ret = RDB_cursor_first(curp, ecp);
+    while (ret == RDB_OK) {
+        for (i = 0; i < attrc; i++) {
+            ret = RDB_cursor_get(curp, i, &datap, &len, ecp);
+            if (ret != RDB_OK) {
+                RDB_handle_err(ecp, txp);
+                goto error;
+            }
+            RDB_hll_add(&hllv[i], datap, len);
+        }
+        count++;
+        ret = RDB_cursor_next(curp, 0, ecp);
+    }
+    if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR) {
+        RDB_handle_err(ecp, txp);
+        goto error;
+    }
+    RDB_clear_err(ecp);
+
+    ret = RDB_destroy_cursor(curp, ecp);
+    curp = NULL;
+    if (ret != RDB_OK) {
+        RDB_handle_err(ecp, txp);
+        goto error;
+    }
+
+    distinctv = RDB_alloc(sizeof(unsigned) * attrc, ecp);
+    if (distinctv == NULL)
+        goto error;
+    for (i = 0; i < attrc; i++) {
+        distinctv[i] = RDB_hll_estimate(&hllv[i]);
+
+        /* The estimate can be a bit off, so keep it in the valid range */
+        if (distinctv[i] > count)
+            distinctv[i] = count;
+        if (distinctv[i] == 0 && count > 0)
+            distinctv[i] = 1;
+    }
+    RDB_free(hllv);
+
+    RDB_free(stp->est_distinctv);
+    stp->est_distinctv = distinctv;
+    stp->est_cardinality = count;
+
+    return RDB_cat_put_table_stats(tbp, ecp, txp);
+
+error:
+    if (curp != NULL)
+        RDB_destroy_cursor(curp, ecp);
+    RDB_free(hllv);
+    return RDB_ERROR;
+}
+
 RDB_bool
 RDB_expr_is_serial(const RDB_expression *exp)
 {
@@ -8,7 +8,6 @@
 #include "tostr.h"
 #include "internal.h"
 #include "stable.h"
-#include <gen/hashtabit.h>
 #include <obj/objinternal.h>
 
 #include <string.h>
@@ -26,59 +25,32 @@ static int
 append_tuple(RDB_object *objp, const RDB_object *tplp, RDB_environment *envp,
         RDB_exec_context *ecp, RDB_transaction *txp)
 {
-    int ret;
-    RDB_hashtable_iter hiter;
-    tuple_entry *entryp;
-    RDB_bool start = RDB_TRUE;
+    int i;
+    int attrc = RDB_tuple_size(tplp);
 
     if (RDB_append_string(objp, "TUPLE {", ecp) != RDB_OK) {
         return RDB_ERROR;
     }
 
     /* Tuple can be empty */
-    if (tplp->kind != RDB_OB_INITIAL) {
-        RDB_init_hashtable_iter(&hiter, (RDB_hashtable *) &tplp->val.tpl_tab);
-        for (;;) {
-            /* Get next attribute */
-            entryp = RDB_hashtable_next(&hiter);
-            if (entryp == NULL)
-                break;
-    
-            if (start) {
-                start = RDB_FALSE;
-            } else {
-                ret = RDB_append_string(objp, ", ", ecp);
-                if (ret != RDB_OK) {
-                    goto error;
-                }
-            }
-    
-            ret = RDB_append_string(objp, entryp->key, ecp);
-            if (ret != RDB_OK) {
-                goto error;
-            }
-    
-            ret = RDB_append_string(objp, " ", ecp);
-            if (ret != RDB_OK) {
-                goto error;
-            }
-
-            ret = append_obj(objp, &entryp->obj, envp, ecp, txp);
-            if (ret != RDB_OK)
-                goto error;
+    for (i = 0; i < attrc; i++) {
+        if (i > 0) {
+            if (RDB_append_string(objp, ", ", ecp) != RDB_OK)
+                return RDB_ERROR;
         }
-    }
-    ret = RDB_append_string(objp, "}", ecp);
-    if (ret != RDB_OK)
-        return RDB_ERROR;
 
-    RDB_destroy_hashtable_iter(&hiter);
-    return RDB_OK;
+        if (RDB_append_string(objp, RDB_tuple_slot_name(tplp, i), ecp)
+                != RDB_OK)
+            return RDB_ERROR;
 
-error:
-    if (objp->kind != RDB_OB_INITIAL)
-        RDB_destroy_hashtable_iter(&hiter);
-    return RDB_ERROR;
+        if (RDB_append_string(objp, " ", ecp) != RDB_OK)
+            return RDB_ERROR;
+
+        if (append_obj(objp, RDB_tuple_slot(tplp, i), envp, ecp, txp)
+                != RDB_OK)
+            return RDB_ERROR;
+    }
+    return RDB_append_string(objp, "}", ecp);
 }
 
 static int
@@ -411,6 +383,16 @@ append_infix_binary_ex(RDB_object *objp, const RDB_expression *exp,
                 return RDB_ERROR;
         }
     }
+
+    if ((RDB_SHOW_INDEX & options) && strcmp(exp->def.op.name, "join") == 0) {
+        if (exp->def.op.optinfo.join_method == RDB_JOIN_HASH) {
+            if (RDB_append_string(objp, " HASH", ecp) != RDB_OK)
+                return RDB_ERROR;
+        } else if (exp->def.op.optinfo.join_method == RDB_JOIN_MERGE) {
+            if (RDB_append_string(objp, " MERGE", ecp) != RDB_OK)
+                return RDB_ERROR;
+        }
+    }
     return RDB_OK;
 }
 
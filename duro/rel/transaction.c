@@ -46,6 +46,8 @@ RDB_begin_tx_env(RDB_exec_context *ecp, RDB_transaction *txp, RDB_environment *e
     }
     txp->delrmp = NULL;
     txp->delixp = NULL;
+    txp->durability = RDB_DURABILITY_DEFAULT;
+    txp->cat_modified = RDB_FALSE;
     return RDB_OK;
 }
 
@@ -161,6 +163,12 @@ RDB_OK on success, RDB_ERROR if an error occurred.
 </dl>
 
 The call may also fail for a @ref system-errors "system error".
+Unless the error is retryable, the transaction is no longer running
+after a failed commit.
+If group commit is enabled for a Berkeley DB environment
+and the log could not be flushed, a system_error is raised although
+the transaction has been committed. In this case the transaction
+is not durable.
  */
 int
 RDB_commit(RDB_exec_context *ecp, RDB_transaction *txp)
@@ -172,12 +180,31 @@ RDB_commit(RDB_exec_context *ecp, RDB_transaction *txp)
         return RDB_ERROR;
     }
 
-    ret = RDB_commit_rec_tx(txp->tx, txp->envp, ecp);
+    ret = RDB_commit_rec_tx(txp->tx, txp->envp, txp->durability, ecp);
     if (ret == RDB_ERROR) {
         RDB_handle_err(ecp, txp);
+
+        /*
+         * Unless the error is retryable, the storage engine
+         * has terminated the transaction
+         */
+        if (!RDB_err_retryable(ecp))
+            txp->tx = NULL;
         return RDB_ERROR;
     }
 
+    /*
+     * Catalog modifications become visible to other environment handles
+     * when the top-level transaction has been committed
+     */
+    if (txp->cat_modified) {
+        if (txp->parentp != NULL) {
+            txp->parentp->cat_modified = RDB_TRUE;
+        } else {
+            RDB_catalog_modified();
+        }
+    }
+
     /* Delete recmaps and indexes scheduled for deletion */
     ret = del_storage(txp, ecp);
     if (ret != 0) {
@@ -285,6 +312,22 @@ RDB_tx_db(RDB_transaction *txp)
     return txp->dbp;
 }
 
+/**
+ * Sets the durability of the transaction pointed to by <var>txp</var>,
+which is applied when the transaction is committed.
+By default, the durability setting of the environment is used.
+Only has an effect on top-level transactions.
+
+With RDB_DURABILITY_WRITE_NOSYNC or RDB_DURABILITY_NOSYNC,
+the transaction may be lost if the system or the application crashes
+after the commit.
+ */
+void
+RDB_tx_set_durability(RDB_transaction *txp, RDB_durability durability)
+{
+    txp->durability = durability;
+}
+
 /*@}*/
 
 int
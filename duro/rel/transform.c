@@ -94,6 +94,7 @@ transform_union(RDB_expression *exp, RDB_gettypefn *getfnp, void *arg,
                 RDB_free(exp->def.op.name);
                 pexp = exp->def.op.args.firstp;
                 exp->def.op.name = pexp->def.op.name;
+                RDB_expr_resolve_op(exp);
 
                 exp->def.op.args.firstp = wex1p->def.op.args.firstp;
                 exp->def.op.args.lastp = pexp->def.op.args.lastp;
@@ -133,6 +134,7 @@ transform_union(RDB_expression *exp, RDB_gettypefn *getfnp, void *arg,
                 }
                 strcpy(name, "rename");
                 exp->def.op.name = name;
+                RDB_expr_resolve_op(exp);
                 RDB_del_expr(exp->def.op.args.firstp->nextp, ecp);
                 RDB_del_expr(exp->def.op.args.firstp->def.op.args.firstp->nextp, ecp);
                 exp->def.op.args.firstp->def.op.args.firstp = NULL;
@@ -176,6 +178,7 @@ normalize_comparisons(RDB_expression *exp)
                 strcpy(exp->def.op.name, "<=");
             else if (strcmp(exp->def.op.name, ">") == 0)
                 strcpy(exp->def.op.name, "<");
+            RDB_expr_resolve_op(exp);
 
             /* Swap arguments */
             hexp = exp->def.op.args.firstp;
@@ -242,6 +245,8 @@ transform_where(RDB_expression *exp, RDB_gettypefn *getfnp, void *arg,
             hname = exp->def.op.name;
             exp->def.op.name = chexp->def.op.name;
             chexp->def.op.name = hname;
+            RDB_expr_resolve_op(exp);
+            RDB_expr_resolve_op(chexp);
 
             hexp = chexp->def.op.args.firstp->nextp;
             chexp->def.op.args.firstp->nextp = exp->def.op.args.firstp->nextp;
@@ -273,6 +278,8 @@ transform_where(RDB_expression *exp, RDB_gettypefn *getfnp, void *arg,
             hname = chexp->def.op.name;
             chexp->def.op.name = exp->def.op.name;
             exp->def.op.name = hname;
+            RDB_expr_resolve_op(chexp);
+            RDB_expr_resolve_op(exp);
 
             chexp->def.op.args.firstp->nextp = exp->def.op.args.firstp->nextp;
             exp->def.op.args.firstp->nextp = wexp;
@@ -300,6 +307,8 @@ transform_where(RDB_expression *exp, RDB_gettypefn *getfnp, void *arg,
             hname = chexp->def.op.name;
             chexp->def.op.name = exp->def.op.name;
             exp->def.op.name = hname;
+            RDB_expr_resolve_op(chexp);
+            RDB_expr_resolve_op(exp);
 
             hexp = exp->def.op.args.firstp->nextp;
             exp->def.op.args.firstp->nextp = chexp->def.op.args.firstp->nextp;
@@ -342,6 +351,8 @@ transform_where(RDB_expression *exp, RDB_gettypefn *getfnp, void *arg,
             hname = chexp->def.op.name;
             chexp->def.op.name = exp->def.op.name;
             exp->def.op.name = hname;
+            RDB_expr_resolve_op(chexp);
+            RDB_expr_resolve_op(exp);
             
             hexp = exp->def.op.args.firstp->nextp;
             exp->def.op.args.firstp->nextp = chexp->def.op.args.firstp->nextp;
@@ -411,6 +422,8 @@ swap_project_union(RDB_expression *exp,
     hname = exp->def.op.name;
     exp->def.op.name = chexp->def.op.name;
     chexp->def.op.name = hname;
+    RDB_expr_resolve_op(exp);
+    RDB_expr_resolve_op(chexp);
 
     chexp->def.op.args.firstp->nextp = exp->def.op.args.firstp->nextp;
 
@@ -512,6 +525,8 @@ swap_project_rename(RDB_expression *texp, RDB_gettypefn *getfnp, void *arg,
     opname = texp->def.op.name;
     texp->def.op.name = chtexp->def.op.name;
     chtexp->def.op.name = opname;
+    RDB_expr_resolve_op(texp);
+    RDB_expr_resolve_op(chtexp);
 
     hexp = texp->def.op.args.firstp->nextp;
     texp->def.op.args.firstp->nextp = chtexp->def.op.args.firstp->nextp;
@@ -669,6 +684,8 @@ swap_project_where(RDB_expression *exp, RDB_expression *chexp,
         hname = exp->def.op.name;
         exp->def.op.name = chexp->def.op.name;
         chexp->def.op.name = hname;
+        RDB_expr_resolve_op(exp);
+        RDB_expr_resolve_op(chexp);
 
         hexp = exp->def.op.args.firstp->nextp;
         exp->def.op.args.firstp->nextp = chexp->def.op.args.firstp->nextp;
@@ -849,6 +866,7 @@ RDB_remove_to_project(RDB_expression *exp, RDB_gettypefn *getfnp, void *arg,
     }
     strcpy(opname, "project");
     exp->def.op.name = opname;
+    RDB_expr_resolve_op(exp);
 
     RDB_destroy_expr_list(&oargs, ecp);
     exp->def.op.args.firstp = nargp;
@@ -898,6 +916,7 @@ RDB_convert_update(RDB_expression *exp, RDB_gettypefn *getfnp, void *arg,
     RDB_expression *argp = exp->def.op.args.firstp->nextp;
 
     strcpy(exp->def.op.name, "rename");
+    RDB_expr_resolve_op(exp);
 
     pexp = RDB_ro_op("remove", ecp);
     if (pexp == NULL)
@@ -0,0 +1,157 @@
+/*
+ * Set of tuples, used for removing duplicates.
+ *
+ * The tuples are stored in their internal representation,
+ * so two tuples are considered equal if their internal representations
+ * are equal.
+ *
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include "tupleset.h"
+#include "internal.h"
+#include <obj/object.h>
+#include <obj/type.h>
+#include <obj/excontext.h>
+#include <gen/hashtable.h>
+#include <gen/arena.h>
+#include <gen/strfns.h>
+
+#include <string.h>
+
+enum {
+    TUPLESET_CAPACITY = 256
+};
+
+/*
+ * An entry is followed by the internal representation of the tuple.
+ */
+typedef struct {
+    unsigned hash;
+    size_t len;
+} tupleset_entry;
+
+#define ENTRY_DATA(entryp) ((char *) (entryp) + sizeof(tupleset_entry))
+
+struct RDB_tupleset {
+    /* The tuple type, owned by the tupleset */
+    RDB_type *tpltyp;
+
+    RDB_hashtable tab;
+
+    /* The entries are allocated from this arena */
+    RDB_arena arena;
+
+    /* Buffer for the entry of the tuple being looked up */
+    tupleset_entry *bufp;
+    size_t bufsize;
+};
+
+static unsigned
+hash_entry(const void *entryp, void *arg)
+{
+    return ((const tupleset_entry *) entryp)->hash;
+}
+
+static RDB_bool
+entry_equals(const void *e1p, const void *e2p, void *arg)
+{
+    const tupleset_entry *entry1p = e1p;
+    const tupleset_entry *entry2p = e2p;
+
+    return (RDB_bool) (entry1p->hash == entry2p->hash
+            && entry1p->len == entry2p->len
+            && memcmp(ENTRY_DATA(entry1p), ENTRY_DATA(entry2p),
+                    entry1p->len) == 0);
+}
+
+/*
+ * Create an empty set of tuples of type *tpltyp.
+ */
+RDB_tupleset *
+RDB_new_tupleset(RDB_type *tpltyp, RDB_exec_context *ecp)
+{
+    RDB_tupleset *tsp = RDB_alloc(sizeof(RDB_tupleset), ecp);
+    if (tsp == NULL)
+        return NULL;
+
+    tsp->tpltyp = RDB_dup_nonscalar_type(tpltyp, ecp);
+    if (tsp->tpltyp == NULL) {
+        RDB_free(tsp);
+        return NULL;
+    }
+    RDB_init_hashtable(&tsp->tab, TUPLESET_CAPACITY, &hash_entry,
+            &entry_equals);
+    RDB_init_arena(&tsp->arena);
+    tsp->bufp = NULL;
+    tsp->bufsize = 0;
+    return tsp;
+}
+
+void
+RDB_del_tupleset(RDB_tupleset *tsp, RDB_exec_context *ecp)
+{
+    RDB_destroy_hashtable(&tsp->tab);
+    RDB_destroy_arena(&tsp->arena);
+    RDB_free(tsp->bufp);
+    RDB_del_nonscalar_type(tsp->tpltyp, ecp);
+    RDB_free(tsp);
+}
+
+/*
+ * Insert *tplp into the set. If the set already contains the tuple,
+ * *insertedp is set to RDB_FALSE, otherwise to RDB_TRUE.
+ */
+int
+RDB_tupleset_insert(RDB_tupleset *tsp, RDB_object *tplp,
+        RDB_exec_context *ecp, RDB_bool *insertedp)
+{
+    size_t len;
+    size_t size;
+    tupleset_entry *entryp;
+
+    tplp->store_typ = tsp->tpltyp;
+    if (RDB_obj_ilen(tplp, &len, ecp) != RDB_OK)
+        return RDB_ERROR;
+
+    size = sizeof(tupleset_entry) + len;
+    if (size > tsp->bufsize) {
+        tupleset_entry *bufp = RDB_realloc(tsp->bufp, size, ecp);
+        if (bufp == NULL)
+            return RDB_ERROR;
+        tsp->bufp = bufp;
+        tsp->bufsize = size;
+    }
+    RDB_obj_to_irep(ENTRY_DATA(tsp->bufp), tplp, len);
+    tsp->bufp->len = len;
+    tsp->bufp->hash = RDB_hash_bytes(ENTRY_DATA(tsp->bufp), len);
+
+    if (RDB_hashtable_get(&tsp->tab, tsp->bufp, NULL) != NULL) {
+        *insertedp = RDB_FALSE;
+        return RDB_OK;
+    }
+
+    entryp = RDB_arena_alloc(&tsp->arena, size);
+    if (entryp == NULL) {
+        RDB_raise_no_memory(ecp);
+        return RDB_ERROR;
+    }
+    memcpy(entryp, tsp->bufp, size);
+    if (RDB_hashtable_put(&tsp->tab, entryp, NULL) != RDB_OK) {
+        RDB_raise_no_memory(ecp);
+        return RDB_ERROR;
+    }
+    *insertedp = RDB_TRUE;
+    return RDB_OK;
+}
+
+/*
+ * Remove all tuples from the set.
+ */
+void
+RDB_clear_tupleset(RDB_tupleset *tsp)
+{
+    RDB_clear_hashtable(&tsp->tab);
+    RDB_clear_arena(&tsp->arena);
+}
@@ -0,0 +1,31 @@
+/*
+ * tupleset.h
+ *
+ *  Created on: 16.10.2018
+ *      Author: Rene Hartmann
+ */
+
+#ifndef TUPLESET_H_
+#define TUPLESET_H_
+
+#include <gen/types.h>
+
+typedef struct RDB_object RDB_object;
+typedef struct RDB_exec_context RDB_exec_context;
+typedef struct RDB_type RDB_type;
+typedef struct RDB_tupleset RDB_tupleset;
+
+RDB_tupleset *
+RDB_new_tupleset(RDB_type *, RDB_exec_context *);
+
+void
+RDB_del_tupleset(RDB_tupleset *, RDB_exec_context *);
+
+int
+RDB_tupleset_insert(RDB_tupleset *, RDB_object *, RDB_exec_context *,
+        RDB_bool *);
+
+void
+RDB_clear_tupleset(RDB_tupleset *);
+
+#endif /* TUPLESET_H_ */
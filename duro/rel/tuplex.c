@@ -7,7 +7,6 @@
 
 #include "rdb.h"
 #include "internal.h"
-#include <gen/hashtabit.h>
 #include <gen/strfns.h>
 #include <obj/tuple.h>
 #include <obj/expression.h>
@@ -31,52 +30,45 @@ RDB_add_tuple(RDB_object *tpl1p, const RDB_object *tpl2p,
         RDB_exec_context *ecp, RDB_transaction *txp)
 {
     int ret;
-    RDB_hashtable_iter hiter;
+    int i;
+    int attrc = RDB_tuple_size(tpl2p);
 
-    RDB_init_hashtable_iter(&hiter, (RDB_hashtable *) &tpl2p->val.tpl_tab);
-    for (;;) {
-        /* Get next attribute */
+    for (i = 0; i < attrc; i++) {
         RDB_object *dstattrp;
-        tuple_entry *entryp = (tuple_entry *) RDB_hashtable_next(&hiter);
-        if (entryp == NULL)
-            break;
+        const char *attrname = RDB_tuple_slot_name(tpl2p, i);
+        RDB_object *srcattrp = RDB_tuple_slot(tpl2p, i);
 
         /* Get corresponding attribute from tuple #1 */
-        dstattrp = RDB_tuple_get(tpl1p, entryp->key);
+        dstattrp = RDB_tuple_get(tpl1p, attrname);
         if (dstattrp != NULL) {
              RDB_bool b;
              RDB_type *typ = RDB_obj_type(dstattrp);
 
              /* Check attribute types for equality */
              if (typ != NULL && !RDB_type_equals(typ,
-                     RDB_obj_type(&entryp->obj))) {
-                 RDB_destroy_hashtable_iter(&hiter);
+                     RDB_obj_type(srcattrp))) {
                  RDB_raise_type_mismatch("JOIN attribute types must be equal",
                          ecp);
                  return RDB_ERROR;
              }
 
              /* Check attribute values for equality */
-             ret = RDB_obj_equals(dstattrp, &entryp->obj, ecp, txp, &b);
+             ret = RDB_obj_equals(dstattrp, srcattrp, ecp, txp, &b);
              if (ret != RDB_OK) {
-                 RDB_destroy_hashtable_iter(&hiter);
                  return ret;
              }
              if (!b) {
-                 RDB_destroy_hashtable_iter(&hiter);
                  RDB_raise_invalid_argument("tuples do not match", ecp);
                  return RDB_ERROR;
              }
         } else {
-             ret = RDB_tuple_set(tpl1p, entryp->key, &entryp->obj, ecp);
+             ret = RDB_tuple_set(tpl1p, attrname, srcattrp, ecp);
              if (ret != RDB_OK)
              {
-                 RDB_destroy_hashtable_iter(&hiter);
                  return RDB_ERROR;
              }
         }
     }
-    RDB_destroy_hashtable_iter(&hiter);
     return RDB_OK;
 }
 
@@ -185,27 +177,26 @@ RDB_rename_tuple_ex(RDB_object *dtplp, const RDB_object *stplp,
         const RDB_expression *exp, RDB_exec_context *ecp)
 {
     int ret;
-    RDB_hashtable_iter it;
-    tuple_entry *entryp;
+    int i;
+    int attrc = RDB_tuple_size(stplp);
+
+    for (i = 0; i < attrc; i++) {
+        const char *attrname = RDB_tuple_slot_name(stplp, i);
+        RDB_object *attrp = RDB_tuple_slot(stplp, i);
 
-    RDB_init_hashtable_iter(&it, (RDB_hashtable *) &stplp->val.tpl_tab);
-    while ((entryp = RDB_hashtable_next(&it)) != NULL) {
         /* Search for attribute in rename arguments */
-        char *nattrname = RDB_rename_attr(entryp->key, exp);
+        char *nattrname = RDB_rename_attr(attrname, exp);
 
         if (nattrname != NULL) {
             /* Found - copy and rename attribute */
-            ret = RDB_tuple_set(dtplp, nattrname, &entryp->obj, ecp);
+            ret = RDB_tuple_set(dtplp, nattrname, attrp, ecp);
         } else {
             /* Not found - copy only */
-            ret = RDB_tuple_set(dtplp, entryp->key, &entryp->obj, ecp);
+            ret = RDB_tuple_set(dtplp, attrname, attrp, ecp);
         }
-        if (ret != RDB_OK) {
-            RDB_destroy_hashtable_iter(&it);
+        if (ret != RDB_OK)
             return RDB_ERROR;
-        }
     }
-    RDB_destroy_hashtable_iter(&it);
     return RDB_OK;
 }
 
@@ -249,8 +240,7 @@ RDB_wrap_tuple(const RDB_object *tplp, int wrapc, const RDB_wrapping wrapv[],
     int i, j;
     int ret;
     RDB_object tpl;
-    RDB_hashtable_iter it;
-    tuple_entry *entryp;
+    int attrc;
 
     /* Wrap attributes */
     for (i = 0; i < wrapc; i++) {
@@ -279,23 +269,21 @@ RDB_wrap_tuple(const RDB_object *tplp, int wrapc, const RDB_wrapping wrapv[],
     }
 
     /* Copy attributes which have not been wrapped */
-    RDB_init_hashtable_iter(&it, (RDB_hashtable *)&tplp->val.tpl_tab);
-    while ((entryp = RDB_hashtable_next(&it)) != NULL) {
-        int i;
+    attrc = RDB_tuple_size(tplp);
+    for (j = 0; j < attrc; j++) {
+        const char *attrname = RDB_tuple_slot_name(tplp, j);
 
         for (i = 0; i < wrapc
-                && RDB_find_str(wrapv[i].attrc, wrapv[i].attrv, entryp->key) == -1;
+                && RDB_find_str(wrapv[i].attrc, wrapv[i].attrv, attrname) == -1;
                 i++);
         if (i == wrapc) {
             /* Attribute not found, copy */
-            ret = RDB_tuple_set(restplp, entryp->key, &entryp->obj, ecp);
-            if (ret != RDB_OK) {
-                RDB_destroy_hashtable_iter(&it);
+            ret = RDB_tuple_set(restplp, attrname, RDB_tuple_slot(tplp, j),
+                    ecp);
+            if (ret != RDB_OK)
                 return RDB_ERROR;
-            }
         }
     }
-    RDB_destroy_hashtable_iter(&it);
 
     return RDB_OK;
 }
@@ -326,8 +314,7 @@ RDB_unwrap_tuple(const RDB_object *tplp, int attrc, char *attrv[],
 {
     int i;
     int ret;
-    RDB_hashtable_iter it;
-    tuple_entry *entryp;
+    int tplattrc;
 
     for (i = 0; i < attrc; i++) {
         RDB_object *wtplp = RDB_tuple_get(tplp, attrv[i]);
@@ -347,18 +334,18 @@ RDB_unwrap_tuple(const RDB_object *tplp, int attrc, char *attrv[],
     }
 
     /* Copy remaining attributes */
-    RDB_init_hashtable_iter(&it, (RDB_hashtable *)&tplp->val.tpl_tab);
-    while ((entryp = RDB_hashtable_next(&it)) != NULL) {
+    tplattrc = RDB_tuple_size(tplp);
+    for (i = 0; i < tplattrc; i++) {
+        const char *attrname = RDB_tuple_slot_name(tplp, i);
+
         /* Copy attribute if it does not appear in attrv */
-        if (RDB_find_str(attrc, attrv, entryp->key) == -1) {
-            ret = RDB_tuple_set(restplp, entryp->key, &entryp->obj, ecp);
-            if (ret != RDB_OK) {
-                RDB_destroy_hashtable_iter(&it);
+        if (RDB_find_str(attrc, attrv, attrname) == -1) {
+            ret = RDB_tuple_set(restplp, attrname, RDB_tuple_slot(tplp, i),
+                    ecp);
+            if (ret != RDB_OK)
                 return ret;
-            }
         }
     }
-    RDB_destroy_hashtable_iter(&it);
 
     return RDB_OK;
 }
@@ -369,8 +356,8 @@ int
 RDB_invrename_tuple_ex(const RDB_object *tup, const RDB_expression *exp,
                  RDB_exec_context *ecp, RDB_object *restup)
 {
-    RDB_hashtable_iter it;
-    tuple_entry *entryp;
+    int i;
+    int attrc;
 
     if (tup->kind != RDB_OB_TUPLE) {
         RDB_raise_invalid_argument("not a tuple", ecp);
@@ -378,25 +365,23 @@ RDB_invrename_tuple_ex(const RDB_object *tup, const RDB_expression *exp,
     }
 
     /* Copy attributes to tup */
-    RDB_init_hashtable_iter(&it, (RDB_hashtable *)&tup->val.tpl_tab);
-    while ((entryp = RDB_hashtable_next(&it)) != NULL) {
+    attrc = RDB_tuple_size(tup);
+    for (i = 0; i < attrc; i++) {
         int ret;
-        RDB_expression *argp = find_rename_to(exp, entryp->key);
+        const char *attrname = RDB_tuple_slot_name(tup, i);
+        RDB_object *attrp = RDB_tuple_slot(tup, i);
+        RDB_expression *argp = find_rename_to(exp, attrname);
 
         if (argp != NULL) {
             ret = RDB_tuple_set(restup, RDB_obj_string(&argp->def.obj),
-                    &entryp->obj, ecp);
+                    attrp, ecp);
         } else {
-            ret = RDB_tuple_set(restup, entryp->key, &entryp->obj, ecp);
+            ret = RDB_tuple_set(restup, attrname, attrp, ecp);
         }
-        if (ret != RDB_OK) {
-            RDB_destroy_hashtable_iter(&it);
+        if (ret != RDB_OK)
             return RDB_ERROR;
-        }
     }
 
-    RDB_destroy_hashtable_iter(&it);
-
     return RDB_OK;
 }
 
@@ -494,25 +479,33 @@ int
 RDB_tuple_equals(const RDB_object *tpl1p, const RDB_object *tpl2p,
         RDB_exec_context *ecp, RDB_transaction *txp, RDB_bool *resp)
 {
-    RDB_hashtable_iter hiter;
-    tuple_entry *entryp;
+    int i;
+    int attrc = RDB_tuple_size(tpl1p);
     RDB_bool b;
 
-    RDB_init_hashtable_iter(&hiter, (RDB_hashtable *) &tpl1p->val.tpl_tab);
-    while ((entryp = RDB_hashtable_next(&hiter)) != NULL) {
-        RDB_object *objp = RDB_tuple_get(tpl2p, entryp->key);
+    for (i = 0; i < attrc; i++) {
+        const char *attrname = RDB_tuple_slot_name(tpl1p, i);
+        RDB_object *attrp = RDB_tuple_slot(tpl1p, i);
+        RDB_object *objp;
+
+        /* If both tuples have the same heading, no lookup is needed */
+        if (tpl2p->kind == RDB_OB_TUPLE
+                && tpl2p->val.tpl.hdp == tpl1p->val.tpl.hdp) {
+            objp = RDB_tuple_slot(tpl2p, i);
+        } else {
+            objp = RDB_tuple_get(tpl2p, attrname);
+        }
         if (objp == NULL) {
-            RDB_destroy_hashtable_iter(&it);
             *resp = RDB_FALSE;
             return RDB_OK;
         }
-        if (RDB_obj_type(&entryp->obj) == NULL) {
+        if (RDB_obj_type(attrp) == NULL) {
             if (RDB_obj_type(tpl1p) == NULL) {
                 RDB_raise_invalid_argument("cannot obtain tuple attribute type", ecp);
                 return RDB_ERROR;
             }
-            if (set_tuple_attr_type(&entryp->obj, RDB_obj_type(tpl1p),
-                    entryp->key, ecp) != RDB_OK) {
+            if (set_tuple_attr_type(attrp, RDB_obj_type(tpl1p),
+                    attrname, ecp) != RDB_OK) {
                 return RDB_ERROR;
             }
         }
@@ -522,22 +515,18 @@ RDB_tuple_equals(const RDB_object *tpl1p, const RDB_object *tpl2p,
                 return RDB_ERROR;
             }
             if (set_tuple_attr_type(objp, RDB_obj_type(tpl2p),
-                    entryp->key, ecp) != RDB_OK) {
+                    attrname, ecp) != RDB_OK) {
                 return RDB_ERROR;
             }
         }
 
-        if (RDB_obj_equals(&entryp->obj, objp, ecp, txp, &b) != RDB_OK) {
-            RDB_destroy_hashtable_iter(&it);
+        if (RDB_obj_equals(attrp, objp, ecp, txp, &b) != RDB_OK)
             return RDB_ERROR;
-        }
         if (!b) {
-            RDB_destroy_hashtable_iter(&it);
             *resp = RDB_FALSE;
             return RDB_OK;
         }
     }
-    RDB_destroy_hashtable_iter(&it);
     *resp = RDB_TRUE;
     return RDB_OK;
 }
@@ -549,13 +538,12 @@ RDB_type *
 RDB_tuple_type(const RDB_object *tplp, RDB_exec_context *ecp)
 {
     int i;
-    tuple_entry *entryp;
-    RDB_hashtable_iter hiter;
     RDB_type *typ = RDB_alloc(sizeof (RDB_type), ecp);
     if (typ == NULL)
         return NULL;
 
     typ->kind = RDB_TP_TUPLE;
+    typ->def.tuple.headingp = NULL;
     typ->name = NULL;
     typ->cleanup_fp = NULL;
     typ->ireplen = RDB_VARIABLE_LEN;
@@ -568,23 +556,17 @@ RDB_tuple_type(const RDB_object *tplp, RDB_exec_context *ecp)
         for (i = 0; i < typ->def.tuple.attrc; i++)
             typ->def.tuple.attrv[i].name = NULL;
 
-        RDB_init_hashtable_iter(&hiter, (RDB_hashtable *) &tplp->val.tpl_tab);
-        i = 0;
-        while ((entryp = RDB_hashtable_next(&hiter)) != NULL) {
-            typ->def.tuple.attrv[i].typ = RDB_new_nonscalar_obj_type(&entryp->obj, ecp);
-            if (typ->def.tuple.attrv[i].typ == NULL) {
-                RDB_destroy_hashtable_iter(&it);
+        for (i = 0; i < typ->def.tuple.attrc; i++) {
+            typ->def.tuple.attrv[i].typ = RDB_new_nonscalar_obj_type(
+                    RDB_tuple_slot(tplp, i), ecp);
+            if (typ->def.tuple.attrv[i].typ == NULL)
                 goto error;
-            }
-            typ->def.tuple.attrv[i].name = RDB_dup_str(entryp->key);
-            if (typ->def.tuple.attrv[i].name == NULL) {
-                RDB_destroy_hashtable_iter(&it);
+            typ->def.tuple.attrv[i].name = RDB_dup_str(
+                    RDB_tuple_slot_name(tplp, i));
+            if (typ->def.tuple.attrv[i].name == NULL)
                 goto error;
-            }
             typ->def.tuple.attrv[i].defaultp = NULL;
-            i++;
         }
-        RDB_destroy_hashtable_iter(&it);
     }
     return typ;
 
@@ -609,8 +591,8 @@ int
 RDB_tuple_matches(const RDB_object *tpl1p, const RDB_object *tpl2p,
         RDB_exec_context *ecp, RDB_transaction *txp, RDB_bool *resp)
 {
-    RDB_hashtable_iter hiter;
-    tuple_entry *entryp;
+    int i;
+    int attrc;
     RDB_bool b;
 
     /* If one of the tuples is the empty tuple, the tuples match */
@@ -619,22 +601,19 @@ RDB_tuple_matches(const RDB_object *tpl1p, const RDB_object *tpl2p,
         return RDB_OK;
     }
 
-    RDB_init_hashtable_iter(&hiter, (RDB_hashtable *) &tpl1p->val.tpl_tab);
-    while ((entryp = RDB_hashtable_next(&hiter)) != NULL) {
-        RDB_object *attrp = RDB_tuple_get(tpl2p, entryp->key);
+    attrc = RDB_tuple_size(tpl1p);
+    for (i = 0; i < attrc; i++) {
+        RDB_object *attrp = RDB_tuple_get(tpl2p, RDB_tuple_slot_name(tpl1p, i));
         if (attrp != NULL) {
-            if (RDB_obj_equals(&entryp->obj, attrp, ecp, txp, &b) != RDB_OK) {
-                RDB_destroy_hashtable_iter(&it);
+            if (RDB_obj_equals(RDB_tuple_slot(tpl1p, i), attrp, ecp, txp, &b)
+                    != RDB_OK)
                 return RDB_ERROR;
-            }
             if (!b) {
-                RDB_destroy_hashtable_iter(&it);
                 *resp = RDB_FALSE;
                 return RDB_OK;
             }
         }
     }
-    RDB_destroy_hashtable_iter(&it);
     *resp = RDB_TRUE;
     return RDB_OK;
 }
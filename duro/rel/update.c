@@ -508,7 +508,7 @@ update_where_uindex(RDB_expression *texp, RDB_expression *condp,
     RDB_init_obj(&tpl);
     ret = RDB_get_by_uindex(refexp->def.tbref.tbp,
             texp->def.op.optinfo.objpv, refexp->def.tbref.indexp,
-            refexp->def.tbref.tbp->typ->def.basetyp, ecp, txp, &tpl);
+            refexp->def.tbref.tbp->typ->def.basetyp, NULL, ecp, txp, &tpl);
     if (ret != RDB_OK) {
         if (RDB_obj_type(RDB_get_err(ecp)) == &RDB_NOT_FOUND_ERROR) {
             RDB_clear_err(ecp);
@@ -1320,6 +1320,8 @@ RDB_update_nonvirtual(RDB_object *tbp, RDB_expression *condp,
     if (updc == 0)
         return (RDB_int) 0;
 
+    RDB_catalog_write(tbp, txp);
+
     if (tbp->val.tbp->stp == NULL) {
         if (RDB_provide_stored_table(tbp, RDB_FALSE, ecp, txp) != RDB_OK) {
             return RDB_ERROR;
@@ -1403,6 +1405,8 @@ RDB_update_where_index(RDB_expression *texp, RDB_expression *condp,
         /* child is projection */
         refexp = texp->def.op.args.firstp->def.op.args.firstp;
     }
+
+    RDB_catalog_write(refexp->def.tbref.tbp, txp);
     
     if (refexp->def.tbref.tbp->val.tbp->stp == NULL) {
         if (RDB_provide_stored_table(refexp->def.tbref.tbp,
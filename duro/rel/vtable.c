@@ -188,10 +188,13 @@ infer_join_keys(RDB_expression *exp, RDB_exec_context *ecp,
             &keyv1, &free1);
     if (keyc1 < 0)
         return keyc1;
-    keyc2 = RDB_infer_keys(exp->def.op.args.firstp, NULL, NULL, NULL, ecp, NULL,
-            &keyv2, &free2);
-    if (keyc2 < 0)
+    keyc2 = RDB_infer_keys(exp->def.op.args.firstp->nextp, NULL, NULL, NULL,
+            ecp, NULL, &keyv2, &free2);
+    if (keyc2 < 0) {
+        if (free1)
+            RDB_free_keys(keyc1, keyv1);
         return keyc2;
+    }
 
     newkeyc = keyc1 * keyc2;
     newkeyv = RDB_alloc(sizeof (RDB_string_vec) * newkeyc, ecp);
@@ -9,16 +9,124 @@
 #include <rel/rdb.h>
 #include <dli/iinterp.h>
 #include <sys/types.h>
+#include <unistd.h>
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
 #include <rel/json.h>
 #include <signal.h>
+#include <pthread.h>
+#include <dli/qcache.h>
 
 #define DEFAULT_PORT 8888
+#define DEFAULT_WORKERS 4
 
-RDB_exec_context ec;
-Duro_interp interp;
+/* Default number of seconds after which an inactive connection is closed */
+#define DEFAULT_TIMEOUT 30
+
+/* Default maximum number of cached queries per worker */
+#define DEFAULT_QCACHE_SIZE 256
+
+/* Size of the blocks in which tables are sent */
+#define STREAM_BLOCK_SIZE (32 * 1024)
+
+/*
+ * Tables whose JSON representation is smaller than this are read completely
+ * before the response is sent, so the worker is not kept while sending it
+ */
+#define MATERIALIZE_SIZE (64 * 1024)
+
+/*
+ * A worker has its own interpreter and execution context
+ * and its own handle of the database environment,
+ * so requests can be processed in parallel.
+ * The catalog version is shared by all handles, so catalog modifications
+ * made by one worker invalidate the query caches of all workers.
+ */
+typedef struct durod_worker {
+    RDB_environment *envp;
+    RDB_exec_context ec;
+    Duro_interp interp;
+    RDB_bool interp_initialized;
+
+    /* Parsed and optimized queries */
+    Duro_qcache qcache;
+
+    /* Next idle worker */
+    struct durod_worker *nextp;
+} durod_worker;
+
+static durod_worker *workerv;
+static int workerc;
+
+/* List of idle workers */
+static durod_worker *idle_workerp;
+
+static pthread_mutex_t worker_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t worker_cond = PTHREAD_COND_INITIALIZER;
+
+static int
+init_worker(durod_worker *wp, const char *envname, RDB_bool recover,
+        int qcachesize)
+{
+    RDB_init_exec_context(&wp->ec);
+    wp->interp_initialized = RDB_FALSE;
+    Duro_init_qcache(&wp->qcache, qcachesize);
+
+    wp->envp = RDB_open_env(envname, 0, &wp->ec);
+    if (wp->envp == NULL && recover) {
+        wp->envp = RDB_open_env(envname, RDB_RECOVER, &wp->ec);
+    }
+    if (wp->envp == NULL)
+        return RDB_ERROR;
+
+    if (Duro_init_interp(&wp->interp, &wp->ec, wp->envp, NULL) != RDB_OK)
+        return RDB_ERROR;
+    wp->interp_initialized = RDB_TRUE;
+    return RDB_OK;
+}
+
+static void
+destroy_worker(durod_worker *wp)
+{
+    Duro_destroy_qcache(&wp->qcache, &wp->ec);
+    if (wp->interp_initialized)
+        Duro_destroy_interp(&wp->interp);
+    if (wp->envp != NULL) {
+        if (RDB_close_env(wp->envp, &wp->ec) != RDB_OK) {
+            Duro_println_error(RDB_get_err(&wp->ec));
+        }
+    }
+    RDB_destroy_exec_context(&wp->ec);
+}
+
+/*
+ * Take an idle worker, waiting until one is available.
+ */
+static durod_worker *
+acquire_worker(void)
+{
+    durod_worker *wp;
+
+    pthread_mutex_lock(&worker_mutex);
+    while (idle_workerp == NULL) {
+        pthread_cond_wait(&worker_cond, &worker_mutex);
+    }
+    wp = idle_workerp;
+    idle_workerp = wp->nextp;
+    pthread_mutex_unlock(&worker_mutex);
+    return wp;
+}
+
+static void
+release_worker(durod_worker *wp)
+{
+    pthread_mutex_lock(&worker_mutex);
+    wp->nextp = idle_workerp;
+    idle_workerp = wp;
+    pthread_cond_signal(&worker_cond);
+    pthread_mutex_unlock(&worker_mutex);
+}
 
 static const char *
 split_get(const char *path, char **exp)
@@ -75,86 +183,303 @@ respond_not_found(struct MHD_Connection *connection)
     return ret;
 }
 
-static int
-query_to_json(const char *dbname, const char *expstr, RDB_object *json)
+/*
+ * Parse the query given by expstr and create a query cache entry for it.
+ * If the query is relation-valued, the resulting table is optimized.
+ */
+static Duro_qentry *
+prepare_query(durod_worker *wp, const char *key, const char *expstr)
 {
-    RDB_object *dbobjp;
-    RDB_object result;
     RDB_expression *exp;
     const char *varname;
+    Duro_qentry *entryp = Duro_new_qentry(key, wp->envp, &wp->ec);
+    if (entryp == NULL)
+        return NULL;
 
-    RDB_init_obj(&result);
-    dbobjp = Duro_lookup_var("current_db", &interp, &ec);
-    if (dbobjp == NULL) {
-        goto error;
-    }
-
-    if (RDB_string_to_obj(dbobjp, dbname, &ec) != RDB_OK) {
-        goto error;
-    }
-
-    exp = Duro_dt_parse_expr_str(expstr, &interp, &ec);
+    exp = Duro_dt_parse_expr_str(expstr, &wp->interp, &wp->ec);
     if (exp == NULL) {
         goto error;
     }
 
-    if (Duro_begin_tx(&interp, &ec) != RDB_OK)
-        goto error;
-
     varname = RDB_expr_var_name(exp);
     if (varname != NULL) {
-        RDB_object *tbp = RDB_get_table(varname, &ec, Duro_dt_tx(&interp));
-        if (tbp == NULL)
+        entryp->tbp = RDB_get_table(varname, &wp->ec,
+                Duro_dt_tx(&wp->interp));
+        RDB_del_expr(exp, &wp->ec);
+        if (entryp->tbp == NULL)
             goto error;
-        if (RDB_table_to_array(&result, tbp, 0, NULL, 0, &ec,
-                Duro_dt_tx(&interp)) != RDB_OK) {
-            goto error;
-        }
     } else {
-        RDB_type *typ = RDB_expr_type(exp, NULL, NULL, NULL, &ec, Duro_dt_tx(&interp));
+        RDB_type *typ = RDB_expr_type(exp, NULL, NULL, NULL, &wp->ec,
+                Duro_dt_tx(&wp->interp));
         if (typ != NULL && RDB_type_is_relation(typ)) {
-            RDB_object *tbp = RDB_expr_to_vtable(exp, &ec, Duro_dt_tx(&interp));
-            if (tbp == NULL) {
-                RDB_drop_table(tbp, &ec, Duro_dt_tx(&interp));
+            /* The expression is now owned by the table */
+            entryp->tbp = RDB_expr_to_vtable(exp, &wp->ec,
+                    Duro_dt_tx(&wp->interp));
+            if (entryp->tbp == NULL) {
                 goto error;
             }
-            exp = NULL;
-            if (RDB_table_to_array(&result, tbp, 0, NULL, 0, &ec,
-                    Duro_dt_tx(&interp)) != RDB_OK) {
-                RDB_drop_table(tbp, &ec, Duro_dt_tx(&interp));
-                goto error;
-            }
-            RDB_drop_table(tbp, &ec, Duro_dt_tx(&interp));
+            entryp->drop = RDB_TRUE;
         } else {
-            if (Duro_evaluate(exp, &interp, &ec, &result) != RDB_OK) {
-                goto error;
-            }
+            entryp->exp = exp;
         }
     }
 
-    if (RDB_obj_to_json(json, &result, &ec, Duro_dt_tx(&interp)) != RDB_OK) {
+    if (entryp->tbp != NULL) {
+        entryp->texp = RDB_optimize_table(entryp->tbp, &wp->ec,
+                Duro_dt_tx(&wp->interp));
+        if (entryp->texp == NULL)
+            goto error;
+    }
+
+    return entryp;
+
+error:
+    Duro_del_qentry(entryp, &wp->ec);
+    return NULL;
+}
+
+/*
+ * Start processing the query given by expstr.
+ * key identifies the query in the query cache.
+ * If the result is a table, *entrypp is set to the cache entry
+ * and the transaction remains active so the table can be read.
+ * The entry must then be returned to the cache using Duro_qcache_put()
+ * after the table has been read.
+ * Otherwise *entrypp is set to NULL and the JSON representation of the result
+ * is stored in *json.
+ */
+static int
+start_query(durod_worker *wp, const char *dbname, const char *expstr,
+        const char *key, RDB_object *json, Duro_qentry **entrypp)
+{
+    RDB_object *dbobjp;
+    RDB_object result;
+    Duro_qentry *entryp = NULL;
+
+    *entrypp = NULL;
+
+    RDB_init_obj(&result);
+    dbobjp = Duro_lookup_var("current_db", &wp->interp, &wp->ec);
+    if (dbobjp == NULL) {
+        goto error;
+    }
+
+    if (RDB_string_to_obj(dbobjp, dbname, &wp->ec) != RDB_OK) {
+        goto error;
+    }
+
+    if (Duro_begin_tx(&wp->interp, &wp->ec) != RDB_OK)
+        goto error;
+
+    /* If the query is not in the cache, parse and optimize it */
+    entryp = Duro_qcache_get(&wp->qcache, key, wp->envp, &wp->ec);
+    if (entryp == NULL) {
+        entryp = prepare_query(wp, key, expstr);
+        if (entryp == NULL)
+            goto error;
+    }
+
+    if (entryp->tbp != NULL) {
+        *entrypp = entryp;
+        RDB_destroy_obj(&result, &wp->ec);
+        return RDB_OK;
+    }
+
+    if (Duro_evaluate(entryp->exp, &wp->interp, &wp->ec, &result) != RDB_OK) {
+        goto error;
+    }
+
+    if (RDB_obj_to_json(json, &result, &wp->ec, Duro_dt_tx(&wp->interp)) != RDB_OK) {
         goto error;
     }
 
-    if (Duro_commit(&interp, &ec) != RDB_OK)
+    if (Duro_commit(&wp->interp, &wp->ec) != RDB_OK)
         goto error;
 
-    if (exp != NULL)
-        RDB_del_expr(exp, &ec);
-    RDB_destroy_obj(&result, &ec);
+    RDB_destroy_obj(&result, &wp->ec);
+
+    /* The result is available even if the query cannot be cached */
+    if (Duro_qcache_put(&wp->qcache, entryp, wp->envp, &wp->ec) != RDB_OK)
+        RDB_clear_err(&wp->ec);
     return RDB_OK;
 
 error:
-    if (interp.txnp != NULL) {
-        Duro_rollback(&interp, &ec);
+    if (wp->interp.txnp != NULL) {
+        Duro_rollback(&wp->interp, &wp->ec);
     }
+    if (entryp != NULL)
+        Duro_del_qentry(entryp, &wp->ec);
 
-    if (exp != NULL)
-        RDB_del_expr(exp, &ec);
-    RDB_destroy_obj(&result, &ec);
+    RDB_destroy_obj(&result, &wp->ec);
     return RDB_ERROR;
 }
 
+/*
+ * A table which is converted to JSON while the response is sent,
+ * so the table does not have to be held in memory.
+ * The worker is kept until the response has been sent.
+ */
+typedef struct {
+    durod_worker *wp;
+
+    /* Query cache entry, returned to the cache when the stream is freed */
+    Duro_qentry *entryp;
+
+    RDB_qresult *qrp;
+    RDB_object tpl;
+
+    /* JSON data which has not been passed to MHD */
+    RDB_object buf;
+    size_t buflen;
+    size_t bufpos;
+
+    RDB_bool first;
+    RDB_bool endreached;
+    RDB_bool failed;
+} json_stream;
+
+/*
+ * Delete the table iterator and finish the transaction.
+ * Return RDB_OK if the transaction has been committed.
+ */
+static int
+close_json_stream(json_stream *jsp)
+{
+    int ret = RDB_ERROR;
+    durod_worker *wp = jsp->wp;
+
+    if (RDB_del_table_iterator(jsp->qrp, &wp->ec,
+            Duro_dt_tx(&wp->interp)) != RDB_OK) {
+        jsp->failed = RDB_TRUE;
+    }
+    RDB_destroy_obj(&jsp->tpl, &wp->ec);
+    RDB_destroy_obj(&jsp->buf, &wp->ec);
+
+    /* Roll back if the response has not been sent completely */
+    if (jsp->failed || !jsp->endreached) {
+        Duro_rollback(&wp->interp, &wp->ec);
+    } else if (Duro_commit(&wp->interp, &wp->ec) != RDB_OK) {
+        Duro_println_error(RDB_get_err(&wp->ec));
+        if (wp->interp.txnp != NULL)
+            Duro_rollback(&wp->interp, &wp->ec);
+    } else {
+        ret = RDB_OK;
+    }
+
+    /*
+     * A rollback changes the catalog version,
+     * so the entry is then deleted instead of being cached
+     */
+    if (Duro_qcache_put(&wp->qcache, jsp->entryp, wp->envp, &wp->ec)
+            != RDB_OK) {
+        RDB_clear_err(&wp->ec);
+    }
+    return ret;
+}
+
+static void
+free_json_stream(void *cls)
+{
+    json_stream *jsp = cls;
+    durod_worker *wp = jsp->wp;
+
+    close_json_stream(jsp);
+    free(jsp);
+    release_worker(wp);
+}
+
+static json_stream *
+new_json_stream(durod_worker *wp, Duro_qentry *entryp)
+{
+    json_stream *jsp = malloc(sizeof(json_stream));
+    if (jsp == NULL) {
+        RDB_raise_no_memory(&wp->ec);
+        return NULL;
+    }
+
+    jsp->qrp = RDB_optimized_table_iterator(entryp->texp, &wp->ec,
+            Duro_dt_tx(&wp->interp));
+    if (jsp->qrp == NULL) {
+        free(jsp);
+        return NULL;
+    }
+    jsp->wp = wp;
+    jsp->entryp = entryp;
+    jsp->buflen = 0;
+    jsp->bufpos = 0;
+    jsp->first = RDB_TRUE;
+    jsp->endreached = RDB_FALSE;
+    jsp->failed = RDB_FALSE;
+    RDB_init_obj(&jsp->tpl);
+    RDB_init_obj(&jsp->buf);
+    return jsp;
+}
+
+/*
+ * Convert tuples to JSON until at least minlen bytes
+ * are in the buffer or the end of the table has been reached.
+ */
+static int
+fill_json_stream(json_stream *jsp, size_t minlen)
+{
+    durod_worker *wp = jsp->wp;
+
+    if (RDB_string_to_obj(&jsp->buf, jsp->first ? "[" : "", &wp->ec) != RDB_OK)
+        return RDB_ERROR;
+    jsp->buflen = jsp->first ? 1 : 0;
+    jsp->bufpos = 0;
+
+    while (jsp->buflen < minlen) {
+        if (RDB_next_tuple(jsp->qrp, &jsp->tpl, &wp->ec,
+                Duro_dt_tx(&wp->interp)) != RDB_OK) {
+            if (RDB_obj_type(RDB_get_err(&wp->ec)) != &RDB_NOT_FOUND_ERROR)
+                return RDB_ERROR;
+            RDB_clear_err(&wp->ec);
+            if (RDB_append_char(&jsp->buf, ']', &wp->ec) != RDB_OK)
+                return RDB_ERROR;
+            jsp->buflen = strlen(RDB_obj_string(&jsp->buf));
+            jsp->endreached = RDB_TRUE;
+            break;
+        }
+        if (!jsp->first) {
+            if (RDB_append_char(&jsp->buf, ',', &wp->ec) != RDB_OK)
+                return RDB_ERROR;
+        }
+        jsp->first = RDB_FALSE;
+        if (RDB_append_json(&jsp->buf, &jsp->tpl, &wp->ec,
+                Duro_dt_tx(&wp->interp)) != RDB_OK) {
+            return RDB_ERROR;
+        }
+        jsp->buflen = strlen(RDB_obj_string(&jsp->buf));
+    }
+    return RDB_OK;
+}
+
+static ssize_t
+read_json_stream(void *cls, uint64_t pos, char *buf, size_t max)
+{
+    json_stream *jsp = cls;
+    size_t len;
+
+    if (jsp->bufpos == jsp->buflen) {
+        if (jsp->endreached)
+            return MHD_CONTENT_READER_END_OF_STREAM;
+        if (fill_json_stream(jsp, max) != RDB_OK) {
+            /* The status has already been sent, so the response is truncated */
+            Duro_println_error(RDB_get_err(&jsp->wp->ec));
+            jsp->failed = RDB_TRUE;
+            return MHD_CONTENT_READER_END_WITH_ERROR;
+        }
+    }
+
+    len = jsp->buflen - jsp->bufpos;
+    if (len > max)
+        len = max;
+    memcpy(buf, RDB_obj_string(&jsp->buf) + jsp->bufpos, len);
+    jsp->bufpos += len;
+    return (ssize_t) len;
+}
+
 static int
 respond_invalid_query(struct MHD_Connection *connection)
 {
@@ -170,6 +495,32 @@ respond_invalid_query(struct MHD_Connection *connection)
     return ret;
 }
 
+/*
+ * Send the JSON data in *datap, which is freed by MHD
+ */
+static int
+respond_json(struct MHD_Connection *connection, char *datap, size_t len)
+{
+    struct MHD_Response *response;
+    int ret;
+
+    response = MHD_create_response_from_buffer(len, datap,
+            MHD_RESPMEM_MUST_FREE);
+    if (response == NULL) {
+        free(datap);
+        return MHD_NO;
+    }
+
+    ret = MHD_add_response_header (response, "Content-Type", "application/json");
+    if (ret == MHD_NO) {
+        MHD_destroy_response(response);
+        return MHD_NO;
+    }
+    ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
 static int
 respond(void *cls, struct MHD_Connection *connection,
        const char *url,
@@ -182,6 +533,11 @@ respond(void *cls, struct MHD_Connection *connection,
     char *expstr;
     struct MHD_Response *response;
     RDB_object json;
+    durod_worker *wp;
+    Duro_qentry *entryp;
+    json_stream *jsp;
+    char *datap;
+    size_t len;
     int ret;
 
     if (strcmp(method, MHD_HTTP_METHOD_GET) != 0) {
@@ -201,43 +557,101 @@ respond(void *cls, struct MHD_Connection *connection,
         return respond_not_found(connection);
     }
 
+    wp = acquire_worker();
+
     RDB_init_obj(&json);
-    if (query_to_json(dbname, expstr, &json) == RDB_ERROR) {
+    if (start_query(wp, dbname, expstr, url[0] == '/' ? url + 1 : url,
+            &json, &entryp) == RDB_ERROR) {
         free((void *) dbname);
-        Duro_println_error(RDB_get_err(&ec));
-        RDB_destroy_obj(&json, &ec);
+        Duro_println_error(RDB_get_err(&wp->ec));
+        RDB_destroy_obj(&json, &wp->ec);
+        release_worker(wp);
         return respond_invalid_query(connection);
     }
     free((void *) dbname);
 
-    response = MHD_create_response_from_buffer(strlen(json.val.bin.datap),
-            json.val.bin.datap, MHD_RESPMEM_MUST_FREE);
-    ret = MHD_add_response_header (response, "Content-Type", "application/json");
-    if (ret == MHD_NO) {
+    if (entryp != NULL) {
+        RDB_destroy_obj(&json, &wp->ec);
+        jsp = new_json_stream(wp, entryp);
+        if (jsp == NULL) {
+            Duro_println_error(RDB_get_err(&wp->ec));
+            Duro_rollback(&wp->interp, &wp->ec);
+            Duro_del_qentry(entryp, &wp->ec);
+            release_worker(wp);
+            return respond_invalid_query(connection);
+        }
+        if (fill_json_stream(jsp, MATERIALIZE_SIZE) != RDB_OK) {
+            Duro_println_error(RDB_get_err(&wp->ec));
+            jsp->failed = RDB_TRUE;
+            free_json_stream(jsp);
+            return respond_invalid_query(connection);
+        }
+
+        if (jsp->endreached) {
+            /*
+             * The table has been read completely, so finish the transaction
+             * and release the worker before the response is sent
+             */
+            datap = jsp->buf.val.bin.datap;
+            len = jsp->buflen;
+            jsp->buf.val.bin.datap = NULL;
+            jsp->buf.val.bin.len = 0;
+            ret = close_json_stream(jsp);
+            free(jsp);
+            release_worker(wp);
+            if (ret != RDB_OK) {
+                free(datap);
+                return respond_invalid_query(connection);
+            }
+            return respond_json(connection, datap, len);
+        }
+
+        /*
+         * Send the rest of the table while it is read, using chunked transfer
+         * encoding. free_json_stream() releases the worker.
+         * If the client stops reading, the connection timeout
+         * makes sure the worker is released.
+         */
+        response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN,
+                STREAM_BLOCK_SIZE, &read_json_stream, jsp, &free_json_stream);
+        if (response == NULL) {
+            free_json_stream(jsp);
+            return MHD_NO;
+        }
+        if (MHD_add_response_header(response, "Content-Type",
+                "application/json") == MHD_NO) {
+            MHD_destroy_response(response);
+            return MHD_NO;
+        }
+        ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
         MHD_destroy_response(response);
-        RDB_destroy_obj(&json, &ec);
-        return MHD_NO;
+        return ret;
     }
-    ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
-    MHD_destroy_response(response);
 
     /*
      * The data is freed by MHD so set the pointer to NULL
      * so that RDB_destroy_obj() doesn't free it
      */
+    datap = json.val.bin.datap;
+    len = strlen(datap);
     json.val.bin.datap = NULL;
     json.val.bin.len = 0;
-    RDB_destroy_obj(&json, &ec);
-    return ret;
+    RDB_destroy_obj(&json, &wp->ec);
+    release_worker(wp);
+    return respond_json(connection, datap, len);
 }
 
 static char *
-read_args(int argc, char *argv[], int *port)
+read_args(int argc, char *argv[], int *port, int *wcountp, int *qcsizep,
+        int *timeoutp)
 {
     char *envname = NULL;
     int i;
 
     *port = DEFAULT_PORT;
+    *wcountp = DEFAULT_WORKERS;
+    *qcsizep = DEFAULT_QCACHE_SIZE;
+    *timeoutp = DEFAULT_TIMEOUT;
 
     for (i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
@@ -246,6 +660,15 @@ read_args(int argc, char *argv[], int *port)
         if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
             *port = atoi(argv[++i]);
         }
+        if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            *wcountp = atoi(argv[++i]);
+        }
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            *qcsizep = atoi(argv[++i]);
+        }
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            *timeoutp = atoi(argv[++i]);
+        }
     }
     return envname;
 }
@@ -253,7 +676,8 @@ read_args(int argc, char *argv[], int *port)
 static void
 print_usage(void)
 {
-    fputs("Usage: durod -e envdir [-p port]\n", stderr);
+    fputs("Usage: durod -e envdir [-p port] [-w workers] [-c entries] [-t seconds]\n",
+            stderr);
 }
 
 static void
@@ -290,16 +714,35 @@ main(int argc, char *argv[])
 {
     struct MHD_Daemon *daemon;
     char *envname;
-    RDB_environment *envp = NULL;
     int port;
+    int wcount;
+    int qcsize;
+    int timeout;
+    int i;
+    RDB_exec_context ec;
     sigset_t oldmask, newmask;
 
-    envname = read_args(argc, argv, &port);
+    envname = read_args(argc, argv, &port, &wcount, &qcsize, &timeout);
     if (envname == NULL) {
         fputs("No database environment specified.\n", stderr);
         print_usage();
         return 1;
     }
+    if (wcount < 1) {
+        fputs("Invalid number of workers.\n", stderr);
+        print_usage();
+        return 1;
+    }
+    if (qcsize < 1) {
+        fputs("Invalid query cache size.\n", stderr);
+        print_usage();
+        return 1;
+    }
+    if (timeout < 1) {
+        fputs("Invalid timeout.\n", stderr);
+        print_usage();
+        return 1;
+    }
 
     handle_signals();
 
@@ -310,18 +753,25 @@ main(int argc, char *argv[])
         goto error;
     }
 
-    envp = RDB_open_env(envname, 0, &ec);
-    if (envp == NULL) {
-        envp = RDB_open_env(envname, RDB_RECOVER, &ec);
-        if (envp == NULL) {
-            Duro_println_error(RDB_get_err(&ec));
-            goto error;
-        }
+    workerv = malloc(sizeof(durod_worker) * wcount);
+    if (workerv == NULL) {
+        fputs("Out of memory.\n", stderr);
+        goto error;
     }
 
-    if (Duro_init_interp(&interp, &ec, envp, NULL) != RDB_OK) {
-        Duro_println_error(RDB_get_err(&ec));
-        goto error;
+    /*
+     * Only the first worker may run recovery because
+     * no other handles of the environment are open at that time
+     */
+    for (workerc = 0; workerc < wcount; workerc++) {
+        durod_worker *wp = &workerv[workerc];
+
+        if (init_worker(wp, envname, (RDB_bool) (workerc == 0), qcsize) != RDB_OK) {
+            Duro_println_error(RDB_get_err(&wp->ec));
+            destroy_worker(wp);
+            goto error;
+        }
+        release_worker(wp);
     }
 
     /* Block SIGINT and SIGTERM */
@@ -333,8 +783,19 @@ main(int argc, char *argv[])
         goto error;
     }
 
-    daemon = MHD_start_daemon(MHD_USE_SELECT_INTERNALLY, port, NULL, NULL,
-            &respond, NULL, MHD_OPTION_END);
+    /*
+     * Each connection is handled by its own thread which takes an idle worker
+     * for each request. A thread which waits for a worker does not block
+     * other connections, including those whose responses are being sent
+     * by a worker.
+     * A worker which sends a table is kept until the response has been sent,
+     * so inactive connections are closed after the timeout.
+     */
+    daemon = MHD_start_daemon(
+            MHD_USE_SELECT_INTERNALLY | MHD_USE_THREAD_PER_CONNECTION,
+            port, NULL, NULL, &respond, NULL,
+            MHD_OPTION_CONNECTION_TIMEOUT, (unsigned int) timeout,
+            MHD_OPTION_END);
     if (daemon == NULL) {
         fputs("Starting HTTP server failed.\n", stderr);
         goto error;
@@ -351,19 +812,19 @@ main(int argc, char *argv[])
 
     MHD_stop_daemon(daemon);
 
-    if (envp != NULL) {
-        if (RDB_close_env(envp, &ec) != RDB_OK) {
-            Duro_println_error(RDB_get_err(&ec));
-        }
+    for (i = 0; i < workerc; i++) {
+        destroy_worker(&workerv[i]);
     }
+    free(workerv);
 
     RDB_destroy_exec_context(&ec);
     return 0;
 
 error:
-    if (envp != NULL) {
-        RDB_close_env(envp, &ec);
+    for (i = 0; i < workerc; i++) {
+        destroy_worker(&workerv[i]);
     }
+    free(workerv);
 
     RDB_destroy_exec_context(&ec);
     return 1;
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include <rec/env.h>
+#include <obj/excontext.h>
+#include <obj/builtintypes.h>
+#include <obj/object.h>
+#include <stdio.h>
+
+int
+main(void)
+{
+    RDB_exec_context ec;
+    RDB_env_config config;
+
+    RDB_init_exec_context(&ec);
+    RDB_init_env_config(&config);
+
+    if (RDB_parse_env_config("cache_size=64M, log_buf_size=512k\n"
+            "max_locks=5000 max_txns=200 durability=write_nosync "
+            "hash_mem=4k sort_mem=1M fetch_rows=1000",
+            &config, &ec) != RDB_OK) {
+        fputs("parsing failed\n", stderr);
+        return 1;
+    }
+    if (config.cache_size != 64 * 1024 * 1024
+            || config.log_buf_size != 512 * 1024
+            || config.max_locks != 5000
+            || config.max_lockers != 0
+            || config.max_txns != 200
+            || config.durability != RDB_DURABILITY_WRITE_NOSYNC
+            || config.hash_mem != 4096
+            || config.sort_mem != 1024 * 1024
+            || config.fetch_rows != 1000) {
+        fputs("wrong settings\n", stderr);
+        return 1;
+    }
+
+    if (RDB_parse_env_config("cache_size=lots", &config, &ec) != RDB_ERROR
+            || RDB_obj_type(RDB_get_err(&ec)) != &RDB_INVALID_ARGUMENT_ERROR) {
+        fputs("invalid size accepted\n", stderr);
+        return 1;
+    }
+    RDB_clear_err(&ec);
+
+    if (RDB_parse_env_config("cache", &config, &ec) != RDB_ERROR) {
+        fputs("missing value accepted\n", stderr);
+        return 1;
+    }
+    RDB_clear_err(&ec);
+
+    if (RDB_parse_env_config("durability=sometimes", &config, &ec)
+            != RDB_ERROR) {
+        fputs("invalid durability accepted\n", stderr);
+        return 1;
+    }
+
+    RDB_destroy_exec_context(&ec);
+    return 0;
+}
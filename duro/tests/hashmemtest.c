@@ -0,0 +1,243 @@
+/*
+ * Test SUMMARIZE and GROUP with different hash table memory limits
+ *
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include <rel/rdb.h>
+#include <stdio.h>
+
+enum {
+    TUPLE_COUNT = 1000,
+    GROUP_COUNT = 100
+};
+
+/*
+ * Create a table with attributes N, G, and V where G is N modulo GROUP_COUNT
+ * and V is N converted to float
+ */
+static int
+create_table(RDB_object *tbp, RDB_exec_context *ecp)
+{
+    int i;
+    RDB_object tpl;
+    RDB_attr attrv[3];
+    char *keyattrv[] = { "N" };
+    RDB_string_vec key;
+
+    attrv[0].name = "N";
+    attrv[1].name = "G";
+    attrv[2].name = "V";
+    for (i = 0; i < 3; i++) {
+        attrv[i].typ = &RDB_INTEGER;
+        attrv[i].defaultp = NULL;
+        attrv[i].options = 0;
+    }
+    attrv[2].typ = &RDB_FLOAT;
+    key.strc = 1;
+    key.strv = keyattrv;
+
+    if (RDB_init_table(tbp, NULL, 3, attrv, 1, &key, ecp) != RDB_OK)
+        return RDB_ERROR;
+
+    RDB_init_obj(&tpl);
+    for (i = 0; i < TUPLE_COUNT; i++) {
+        if (RDB_tuple_set_int(&tpl, "N", (RDB_int) i, ecp) != RDB_OK)
+            goto error;
+        if (RDB_tuple_set_int(&tpl, "G", (RDB_int) (i % GROUP_COUNT), ecp)
+                != RDB_OK)
+            goto error;
+        if (RDB_tuple_set_float(&tpl, "V", (RDB_float) i, ecp) != RDB_OK)
+            goto error;
+        if (RDB_insert(tbp, &tpl, ecp, NULL) != RDB_OK)
+            goto error;
+    }
+    return RDB_destroy_obj(&tpl, ecp);
+
+error:
+    RDB_destroy_obj(&tpl, ecp);
+    return RDB_ERROR;
+}
+
+static RDB_expression *
+project_g(RDB_object *tbp, RDB_exec_context *ecp)
+{
+    RDB_expression *exp = RDB_ro_op("project", ecp);
+    if (exp == NULL)
+        return NULL;
+    RDB_add_arg(exp, RDB_table_ref(tbp, ecp));
+    RDB_add_arg(exp, RDB_string_to_expr("G", ecp));
+    return exp;
+}
+
+/*
+ * Evaluate tbp SUMMARIZE PER (tbp { G }) ADD (COUNT() AS C, SUM(V) AS S,
+ * AVG(V) AS A) and check the result
+ */
+static int
+test_summarize(RDB_object *tbp, RDB_exec_context *ecp)
+{
+    int i;
+    RDB_object res;
+    RDB_object array;
+    RDB_object *tplp;
+    RDB_expression *argp;
+    RDB_expression *exp = RDB_ro_op("summarize", ecp);
+    if (exp == NULL)
+        return RDB_ERROR;
+
+    RDB_add_arg(exp, RDB_table_ref(tbp, ecp));
+    RDB_add_arg(exp, project_g(tbp, ecp));
+    RDB_add_arg(exp, RDB_ro_op("count", ecp));
+    RDB_add_arg(exp, RDB_string_to_expr("C", ecp));
+    argp = RDB_ro_op("sum", ecp);
+    RDB_add_arg(argp, RDB_var_ref("V", ecp));
+    RDB_add_arg(exp, argp);
+    RDB_add_arg(exp, RDB_string_to_expr("S", ecp));
+    argp = RDB_ro_op("avg", ecp);
+    RDB_add_arg(argp, RDB_var_ref("V", ecp));
+    RDB_add_arg(exp, argp);
+    RDB_add_arg(exp, RDB_string_to_expr("A", ecp));
+
+    RDB_init_obj(&res);
+    RDB_init_obj(&array);
+    if (RDB_evaluate(exp, NULL, NULL, NULL, ecp, NULL, &res) != RDB_OK)
+        goto error;
+    if (RDB_table_to_array(&array, &res, 0, NULL, 0, ecp, NULL) != RDB_OK)
+        goto error;
+    if (RDB_array_length(&array, ecp) != GROUP_COUNT) {
+        fputs("wrong number of groups\n", stderr);
+        goto error;
+    }
+    for (i = 0; i < GROUP_COUNT; i++) {
+        RDB_int g;
+        RDB_int n = TUPLE_COUNT / GROUP_COUNT;
+
+        tplp = RDB_array_get(&array, (RDB_int) i, ecp);
+        if (tplp == NULL)
+            goto error;
+        g = RDB_tuple_get_int(tplp, "G");
+        if (RDB_tuple_get_int(tplp, "C") != n
+                || RDB_tuple_get_float(tplp, "S")
+                        != (RDB_float) (n * g + GROUP_COUNT * n * (n - 1) / 2)
+                || RDB_tuple_get_float(tplp, "A")
+                        != (RDB_float) g + GROUP_COUNT * (n - 1) / 2.0) {
+            fprintf(stderr, "wrong result for group %d\n", (int) g);
+            goto error;
+        }
+    }
+
+    RDB_destroy_obj(&array, ecp);
+    RDB_destroy_obj(&res, ecp);
+    return RDB_del_expr(exp, ecp);
+
+error:
+    RDB_destroy_obj(&array, ecp);
+    RDB_destroy_obj(&res, ecp);
+    RDB_del_expr(exp, ecp);
+    return RDB_ERROR;
+}
+
+/*
+ * Evaluate tbp GROUP { N, V } AS R and check the result
+ */
+static int
+test_group(RDB_object *tbp, RDB_exec_context *ecp)
+{
+    int i;
+    RDB_object res;
+    RDB_object array;
+    RDB_object *tplp;
+    RDB_expression *exp = RDB_ro_op("group", ecp);
+    if (exp == NULL)
+        return RDB_ERROR;
+
+    RDB_add_arg(exp, RDB_table_ref(tbp, ecp));
+    RDB_add_arg(exp, RDB_string_to_expr("N", ecp));
+    RDB_add_arg(exp, RDB_string_to_expr("V", ecp));
+    RDB_add_arg(exp, RDB_string_to_expr("R", ecp));
+
+    RDB_init_obj(&res);
+    RDB_init_obj(&array);
+    if (RDB_evaluate(exp, NULL, NULL, NULL, ecp, NULL, &res) != RDB_OK)
+        goto error;
+    if (RDB_table_to_array(&array, &res, 0, NULL, 0, ecp, NULL) != RDB_OK)
+        goto error;
+    if (RDB_array_length(&array, ecp) != GROUP_COUNT) {
+        fputs("wrong number of groups\n", stderr);
+        goto error;
+    }
+    for (i = 0; i < GROUP_COUNT; i++) {
+        tplp = RDB_array_get(&array, (RDB_int) i, ecp);
+        if (tplp == NULL)
+            goto error;
+        if (RDB_cardinality(RDB_tuple_get(tplp, "R"), ecp, NULL)
+                != TUPLE_COUNT / GROUP_COUNT) {
+            fprintf(stderr, "wrong result for group %d\n",
+                    (int) RDB_tuple_get_int(tplp, "G"));
+            goto error;
+        }
+    }
+
+    RDB_destroy_obj(&array, ecp);
+    RDB_destroy_obj(&res, ecp);
+    return RDB_del_expr(exp, ecp);
+
+error:
+    RDB_destroy_obj(&array, ecp);
+    RDB_destroy_obj(&res, ecp);
+    RDB_del_expr(exp, ecp);
+    return RDB_ERROR;
+}
+
+int
+main(void)
+{
+    int i;
+    RDB_exec_context ec;
+    RDB_object tb;
+
+    /*
+     * The default limit keeps all groups in memory, with 4K the hash table
+     * spills in the middle, and with 1 byte after the first group
+     */
+    static const size_t limitv[] = { 0, 4096, 1 };
+
+    RDB_init_exec_context(&ec);
+    if (RDB_init_builtin(&ec) != RDB_OK) {
+        fputs("error initializing built-in types\n", stderr);
+        return 2;
+    }
+
+    RDB_init_obj(&tb);
+    if (create_table(&tb, &ec) != RDB_OK)
+        goto error;
+
+    for (i = 0; i < (int) (sizeof(limitv) / sizeof(limitv[0])); i++) {
+        if (limitv[i] > 0)
+            RDB_set_hash_mem(limitv[i]);
+        if (test_summarize(&tb, &ec) != RDB_OK) {
+            fprintf(stderr, "SUMMARIZE failed with limit %d\n",
+                    (int) limitv[i]);
+            goto error;
+        }
+        if (test_group(&tb, &ec) != RDB_OK) {
+            fprintf(stderr, "GROUP failed with limit %d\n", (int) limitv[i]);
+            goto error;
+        }
+    }
+
+    RDB_destroy_obj(&tb, &ec);
+    RDB_destroy_exec_context(&ec);
+    return 0;
+
+error:
+    if (RDB_get_err(&ec) != NULL) {
+        fprintf(stderr, "Error: %s\n",
+                RDB_type_name(RDB_obj_type(RDB_get_err(&ec))));
+    }
+    RDB_destroy_obj(&tb, &ec);
+    RDB_destroy_exec_context(&ec);
+    return 1;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include <gen/hashtable.h>
+#include <stdio.h>
+
+/* Map all even and all odd numbers to the same slot to test collisions */
+static unsigned
+hash_int(const void *p, void *arg)
+{
+    return *(const int *) p % 2;
+}
+
+static RDB_bool
+int_equals(const void *p1, const void *p2, void *arg)
+{
+    return (RDB_bool) (*(const int *) p1 == *(const int *) p2);
+}
+
+int
+main(void)
+{
+    int n[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    int i;
+    RDB_hashtable tab;
+
+    RDB_init_hashtable(&tab, 4, &hash_int, &int_equals);
+
+    for (i = 0; i < 10; i++) {
+        if (RDB_hashtable_put(&tab, &n[i], NULL) != RDB_OK) {
+            fputs("RDB_hashtable_put() failed\n", stderr);
+            return 1;
+        }
+    }
+
+    /* Delete 0, 3, 6, 9 */
+    for (i = 0; i < 10; i += 3) {
+        if (RDB_hashtable_del(&tab, &n[i], NULL) != &n[i]) {
+            fprintf(stderr, "deleting %d failed\n", i);
+            return 1;
+        }
+    }
+    if (RDB_hashtable_del(&tab, &n[3], NULL) != NULL) {
+        fputs("deleted entry found\n", stderr);
+        return 1;
+    }
+
+    if (RDB_hashtable_size(&tab) != 6) {
+        fprintf(stderr, "wrong size %d\n", RDB_hashtable_size(&tab));
+        return 1;
+    }
+
+    for (i = 0; i < 10; i++) {
+        int *p = RDB_hashtable_get(&tab, &n[i], NULL);
+        if (i % 3 == 0) {
+            if (p != NULL) {
+                fprintf(stderr, "deleted entry %d found\n", i);
+                return 1;
+            }
+        } else if (p != &n[i]) {
+            fprintf(stderr, "entry %d not found\n", i);
+            return 1;
+        }
+    }
+
+    RDB_destroy_hashtable(&tab);
+
+    return 0;
+}
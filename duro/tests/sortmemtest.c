@@ -0,0 +1,225 @@
+/*
+ * Test sorting with different sort memory limits
+ *
+ * Copyright (C) 2018 Rene Hartmann.
+ * See the file COPYING for redistribution information.
+ */
+
+#include <rel/rdb.h>
+#include <stdio.h>
+
+enum {
+    TUPLE_COUNT = 1000,
+    GROUP_COUNT = 100,
+    LIMIT = 10
+};
+
+/*
+ * Create a table with attributes N, G, and S where G is N modulo GROUP_COUNT
+ * and S is a string derived from N
+ */
+static int
+create_table(RDB_object *tbp, RDB_exec_context *ecp)
+{
+    int i;
+    RDB_object tpl;
+    RDB_attr attrv[3];
+    char *keyattrv[] = { "N" };
+    RDB_string_vec key;
+    char buf[32];
+
+    attrv[0].name = "N";
+    attrv[1].name = "G";
+    attrv[2].name = "S";
+    for (i = 0; i < 3; i++) {
+        attrv[i].typ = &RDB_INTEGER;
+        attrv[i].defaultp = NULL;
+        attrv[i].options = 0;
+    }
+    attrv[2].typ = &RDB_STRING;
+    key.strc = 1;
+    key.strv = keyattrv;
+
+    if (RDB_init_table(tbp, NULL, 3, attrv, 1, &key, ecp) != RDB_OK)
+        return RDB_ERROR;
+
+    RDB_init_obj(&tpl);
+    for (i = 0; i < TUPLE_COUNT; i++) {
+        /* Insert in an order which differs from the sort order */
+        int n = (i * 7) % TUPLE_COUNT;
+
+        if (RDB_tuple_set_int(&tpl, "N", (RDB_int) n, ecp) != RDB_OK)
+            goto error;
+        if (RDB_tuple_set_int(&tpl, "G", (RDB_int) (n % GROUP_COUNT), ecp)
+                != RDB_OK)
+            goto error;
+        sprintf(buf, "string #%d", n);
+        if (RDB_tuple_set_string(&tpl, "S", buf, ecp) != RDB_OK)
+            goto error;
+        if (RDB_insert(tbp, &tpl, ecp, NULL) != RDB_OK)
+            goto error;
+    }
+    return RDB_destroy_obj(&tpl, ecp);
+
+error:
+    RDB_destroy_obj(&tpl, ecp);
+    return RDB_ERROR;
+}
+
+/*
+ * Sort the table by G ascending and N descending and check the result.
+ * If limit is not RDB_INT_MAX, only the first limit tuples are read.
+ */
+static int
+test_sort(RDB_object *tbp, RDB_int limit, RDB_exec_context *ecp)
+{
+    int i;
+    RDB_int len;
+    RDB_object array;
+    RDB_object *tplp;
+    RDB_seq_item seqitv[2];
+
+    seqitv[0].attrname = "G";
+    seqitv[0].asc = RDB_TRUE;
+    seqitv[1].attrname = "N";
+    seqitv[1].asc = RDB_FALSE;
+
+    RDB_init_obj(&array);
+    if (RDB_table_to_array_limit(&array, tbp, 2, seqitv, 0, limit, ecp, NULL)
+            != RDB_OK)
+        goto error;
+    len = RDB_array_length(&array, ecp);
+    if (len != (limit < TUPLE_COUNT ? limit : TUPLE_COUNT)) {
+        fputs("wrong number of tuples\n", stderr);
+        goto error;
+    }
+    for (i = 0; i < len; i++) {
+        RDB_int g = i / (TUPLE_COUNT / GROUP_COUNT);
+        RDB_int n = g + GROUP_COUNT
+                * (TUPLE_COUNT / GROUP_COUNT - 1 - i % (TUPLE_COUNT / GROUP_COUNT));
+
+        tplp = RDB_array_get(&array, (RDB_int) i, ecp);
+        if (tplp == NULL)
+            goto error;
+        if (RDB_tuple_get_int(tplp, "G") != g
+                || RDB_tuple_get_int(tplp, "N") != n) {
+            fprintf(stderr, "wrong tuple at position %d\n", i);
+            goto error;
+        }
+    }
+    return RDB_destroy_obj(&array, ecp);
+
+error:
+    RDB_destroy_obj(&array, ecp);
+    return RDB_ERROR;
+}
+
+/*
+ * Sort the projection of the table over G, which contains duplicates,
+ * and check the result
+ */
+static int
+test_sort_project(RDB_object *tbp, RDB_exec_context *ecp)
+{
+    int i;
+    RDB_object res;
+    RDB_object array;
+    RDB_object *tplp;
+    RDB_seq_item seqitem;
+    RDB_expression *exp = RDB_ro_op("project", ecp);
+    if (exp == NULL)
+        return RDB_ERROR;
+
+    RDB_add_arg(exp, RDB_table_ref(tbp, ecp));
+    RDB_add_arg(exp, RDB_string_to_expr("G", ecp));
+
+    seqitem.attrname = "G";
+    seqitem.asc = RDB_FALSE;
+
+    RDB_init_obj(&res);
+    RDB_init_obj(&array);
+    if (RDB_evaluate(exp, NULL, NULL, NULL, ecp, NULL, &res) != RDB_OK)
+        goto error;
+    if (RDB_table_to_array(&array, &res, 1, &seqitem, 0, ecp, NULL) != RDB_OK)
+        goto error;
+    if (RDB_array_length(&array, ecp) != GROUP_COUNT) {
+        fputs("wrong number of tuples in projection\n", stderr);
+        goto error;
+    }
+    for (i = 0; i < GROUP_COUNT; i++) {
+        tplp = RDB_array_get(&array, (RDB_int) i, ecp);
+        if (tplp == NULL)
+            goto error;
+        if (RDB_tuple_get_int(tplp, "G") != GROUP_COUNT - 1 - i) {
+            fprintf(stderr, "wrong tuple at position %d of projection\n", i);
+            goto error;
+        }
+    }
+
+    RDB_destroy_obj(&array, ecp);
+    RDB_destroy_obj(&res, ecp);
+    return RDB_del_expr(exp, ecp);
+
+error:
+    RDB_destroy_obj(&array, ecp);
+    RDB_destroy_obj(&res, ecp);
+    RDB_del_expr(exp, ecp);
+    return RDB_ERROR;
+}
+
+int
+main(void)
+{
+    int i;
+    RDB_exec_context ec;
+    RDB_object tb;
+
+    /*
+     * The default limit keeps all tuples in memory, with 4K several runs
+     * are written, and with 1 byte each tuple is written as a run of its own,
+     * so more runs than can be merged in one pass are created
+     */
+    static const size_t limitv[] = { 0, 4096, 1 };
+
+    RDB_init_exec_context(&ec);
+    if (RDB_init_builtin(&ec) != RDB_OK) {
+        fputs("error initializing built-in types\n", stderr);
+        return 2;
+    }
+
+    RDB_init_obj(&tb);
+    if (create_table(&tb, &ec) != RDB_OK)
+        goto error;
+
+    for (i = 0; i < (int) (sizeof(limitv) / sizeof(limitv[0])); i++) {
+        if (limitv[i] > 0)
+            RDB_set_sort_mem(limitv[i]);
+        if (test_sort(&tb, RDB_INT_MAX, &ec) != RDB_OK) {
+            fprintf(stderr, "sorting failed with limit %d\n", (int) limitv[i]);
+            goto error;
+        }
+        if (test_sort(&tb, LIMIT, &ec) != RDB_OK) {
+            fprintf(stderr, "sorting with LIMIT failed with limit %d\n",
+                    (int) limitv[i]);
+            goto error;
+        }
+        if (test_sort_project(&tb, &ec) != RDB_OK) {
+            fprintf(stderr, "sorting projection failed with limit %d\n",
+                    (int) limitv[i]);
+            goto error;
+        }
+    }
+
+    RDB_destroy_obj(&tb, &ec);
+    RDB_destroy_exec_context(&ec);
+    return 0;
+
+error:
+    if (RDB_get_err(&ec) != NULL) {
+        fprintf(stderr, "Error: %s\n",
+                RDB_type_name(RDB_obj_type(RDB_get_err(&ec))));
+    }
+    RDB_destroy_obj(&tb, &ec);
+    RDB_destroy_exec_context(&ec);
+    return 1;
+}
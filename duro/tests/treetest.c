@@ -0,0 +1,499 @@
+/* Test B+ tree functions */
+
+#include <treerec/tree.h>
+#include <rec/recmap.h>
+#include <rec/cursor.h>
+#include <rec/dbdefs.h>
+#include <obj/excontext.h>
+#include <obj/builtintypes.h>
+#include <obj/object.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEY_COUNT 2000
+
+static int
+insert_int(RDB_binary_tree *treep, int k, RDB_exec_context *ecp)
+{
+    int val = k * 2;
+
+    return RDB_tree_insert(treep, &k, sizeof(int), &val, sizeof(int), NULL,
+            ecp);
+}
+
+static int
+compare_int(const void *d1, size_t size1, const void *d2, size_t size2,
+        void *arg)
+{
+    int i1, i2;
+
+    memcpy(&i1, d1, sizeof(int));
+    memcpy(&i2, d2, sizeof(int));
+    return i1 < i2 ? -1 : (i1 > i2 ? 1 : 0);
+}
+
+/*
+ * Return the key of a record. Keys are not necessarily aligned.
+ */
+static int
+node_key(const RDB_tree_node *nodep)
+{
+    int k;
+
+    memcpy(&k, nodep->key, sizeof(int));
+    return k;
+}
+
+/*
+ * Fill buf with a value for key k whose length depends on k and round
+ * and return the length
+ */
+static size_t
+make_value(int k, int round, char *buf)
+{
+    size_t len = (size_t) ((k + round) % 50);
+
+    memset(buf, 'a' + k % 26, len);
+    return len;
+}
+
+static int
+check_value(const RDB_tree_node *nodep, int k, int round)
+{
+    char buf[64];
+    size_t len = make_value(k, round, buf);
+
+    return nodep->valuelen == len
+            && (len == 0 || memcmp(nodep->value, buf, len) == 0);
+}
+
+/*
+ * Check that the tree contains exactly the keys k with presentv[k] true,
+ * in ascending order when iterating forward and backward
+ */
+static int
+check_keys(RDB_binary_tree *treep, const RDB_bool *presentv, int round)
+{
+    int k;
+    RDB_tree_pos pos;
+    RDB_tree_node *nodep;
+
+    k = -1;
+    for (nodep = RDB_tree_first(treep, &pos); nodep != NULL;
+            nodep = RDB_tree_next(&pos)) {
+        int k2 = node_key(nodep);
+
+        while (++k < k2) {
+            if (presentv[k]) {
+                fprintf(stderr, "key %d missing\n", k);
+                return RDB_ERROR;
+            }
+        }
+        if (k != k2 || !presentv[k]) {
+            fprintf(stderr, "unexpected key %d\n", k2);
+            return RDB_ERROR;
+        }
+        if (!check_value(nodep, k, round)) {
+            fprintf(stderr, "wrong value for key %d\n", k);
+            return RDB_ERROR;
+        }
+        if (RDB_tree_find_pos(treep, &k, sizeof(int), &pos) == NULL) {
+            fprintf(stderr, "key %d not found\n", k);
+            return RDB_ERROR;
+        }
+    }
+    while (++k < KEY_COUNT) {
+        if (presentv[k]) {
+            fprintf(stderr, "key %d missing at end\n", k);
+            return RDB_ERROR;
+        }
+    }
+
+    /* Find the last key and iterate backwards */
+    for (k = KEY_COUNT - 1; k >= 0 && !presentv[k]; k--);
+    if (k < 0)
+        return RDB_tree_first(treep, &pos) == NULL ? RDB_OK : RDB_ERROR;
+    nodep = RDB_tree_find_pos(treep, &k, sizeof(int), &pos);
+    while (nodep != NULL) {
+        if (node_key(nodep) != k) {
+            fprintf(stderr, "wrong key %d iterating backwards, expected %d\n",
+                    node_key(nodep), k);
+            return RDB_ERROR;
+        }
+        while (--k >= 0 && !presentv[k]);
+        nodep = RDB_tree_prev(&pos);
+    }
+    if (k >= 0) {
+        fprintf(stderr, "backward iteration stopped before key %d\n", k);
+        return RDB_ERROR;
+    }
+    return RDB_OK;
+}
+
+/*
+ * Insert and delete many records with values of different lengths,
+ * so leaves are split and, when most records of a range are deleted,
+ * merged. Values are replaced by values of a different length.
+ */
+static int
+test_insert_delete(RDB_exec_context *ecp)
+{
+    int i;
+    int k;
+    int round;
+    size_t len;
+    char buf[64];
+    RDB_tree_pos pos;
+    RDB_tree_node *nodep;
+    RDB_bool presentv[KEY_COUNT];
+    RDB_binary_tree *treep = RDB_create_tree(&compare_int, NULL, ecp);
+
+    if (treep == NULL)
+        return RDB_ERROR;
+
+    for (k = 0; k < KEY_COUNT; k++)
+        presentv[k] = RDB_FALSE;
+
+    for (round = 0; round < 4; round++) {
+        /* Insert the missing keys in a scrambled order */
+        for (i = 0; i < KEY_COUNT; i++) {
+            k = (i * 7919) % KEY_COUNT;
+            if (presentv[k]) {
+                if (RDB_tree_find_pos(treep, &k, sizeof(int), &pos) == NULL)
+                    goto error;
+                len = make_value(k, round, buf);
+                if (RDB_tree_set_value(treep, &pos, buf, len, ecp) != RDB_OK)
+                    goto error;
+                if (!check_value(&pos.node, k, round)) {
+                    fprintf(stderr, "wrong value after update of key %d\n", k);
+                    goto error;
+                }
+            } else {
+                len = make_value(k, round, buf);
+                if (RDB_tree_insert(treep, &k, sizeof(int), buf, len, NULL,
+                        ecp) != RDB_OK)
+                    goto error;
+                presentv[k] = RDB_TRUE;
+            }
+        }
+        if (check_keys(treep, presentv, round) != RDB_OK)
+            goto error;
+
+        /*
+         * Delete 7 of 8 keys, in ranges which depend on the round,
+         * using positions for some keys and keys for the others
+         */
+        k = 0;
+        nodep = RDB_tree_first(treep, &pos);
+        while (nodep != NULL) {
+            k = node_key(nodep);
+            if ((k + round) % 8 != 0 && k % 3 == 0) {
+                if (RDB_tree_delete_pos(treep, &pos, ecp) != RDB_OK)
+                    goto error;
+                presentv[k] = RDB_FALSE;
+                nodep = RDB_tree_pos_node(&pos);
+                if (nodep != NULL && node_key(nodep) <= k) {
+                    fprintf(stderr, "wrong position after deleting key %d\n",
+                            k);
+                    goto error;
+                }
+            } else {
+                nodep = RDB_tree_next(&pos);
+            }
+        }
+        for (k = 0; k < KEY_COUNT; k++) {
+            if ((k + round) % 8 != 0 && presentv[k]) {
+                if (RDB_tree_delete_node(treep, &k, sizeof(int), ecp)
+                        != RDB_OK)
+                    goto error;
+                presentv[k] = RDB_FALSE;
+            }
+        }
+        if (check_keys(treep, presentv, round) != RDB_OK)
+            goto error;
+    }
+
+    /* Delete all remaining keys */
+    for (k = 0; k < KEY_COUNT; k++) {
+        if (presentv[k]) {
+            if (RDB_tree_delete_node(treep, &k, sizeof(int), ecp) != RDB_OK)
+                goto error;
+            presentv[k] = RDB_FALSE;
+        }
+    }
+    if (RDB_tree_first(treep, &pos) != NULL) {
+        fprintf(stderr, "tree not empty\n");
+        goto error;
+    }
+
+    RDB_drop_tree(treep);
+    return RDB_OK;
+
+error:
+    RDB_drop_tree(treep);
+    return RDB_ERROR;
+}
+
+/*
+ * Store k in big-endian byte order, so the records are ordered by k
+ */
+static void
+int_to_key(int k, unsigned char *keyp)
+{
+    keyp[0] = (unsigned char) (k >> 24);
+    keyp[1] = (unsigned char) (k >> 16);
+    keyp[2] = (unsigned char) (k >> 8);
+    keyp[3] = (unsigned char) k;
+}
+
+static int
+key_to_int(const unsigned char *keyp)
+{
+    return (keyp[0] << 24) | (keyp[1] << 16) | (keyp[2] << 8) | keyp[3];
+}
+
+static int
+insert_rec(RDB_recmap *rmp, int k, RDB_exec_context *ecp)
+{
+    unsigned char key[4];
+    RDB_field fieldv[2];
+
+    int_to_key(k, key);
+    fieldv[0].datap = key;
+    fieldv[0].len = sizeof(key);
+    fieldv[0].copyfp = &memcpy;
+    fieldv[1].datap = &k;
+    fieldv[1].len = sizeof(int);
+    fieldv[1].copyfp = &memcpy;
+    return RDB_insert_rec(rmp, fieldv, NULL, ecp);
+}
+
+static int
+delete_rec(RDB_recmap *rmp, int k, RDB_exec_context *ecp)
+{
+    unsigned char key[4];
+    RDB_field field;
+
+    int_to_key(k, key);
+    field.no = 0;
+    field.datap = key;
+    field.len = sizeof(key);
+    field.copyfp = &memcpy;
+    return RDB_delete_rec(rmp, 1, &field, NULL, ecp);
+}
+
+/*
+ * Insert and delete records while a cursor iterates over a recmap.
+ * The keys are 4 * i. When the cursor is on key 4 * i with i even,
+ * 4 * i - 2 (before the cursor) and 4 * i + 2 (after the cursor) are
+ * inserted, which splits the leaf, and 4 * i + 4 is deleted.
+ */
+static int
+test_cursor(RDB_exec_context *ecp)
+{
+    int i;
+    int k;
+    int expected;
+    int count;
+    void *datap;
+    size_t len;
+    RDB_cursor *curp = NULL;
+    RDB_recmap *rmp;
+    RDB_field_info fieldinfov[2] = {
+        { 4, NULL, 0 },
+        { sizeof(int), NULL, 0 }
+    };
+
+    rmp = RDB_create_recmap(NULL, NULL, 2, fieldinfov, 1, 0, NULL, RDB_UNIQUE,
+            0, NULL, NULL, ecp);
+    if (rmp == NULL)
+        return RDB_ERROR;
+
+    for (i = 0; i < KEY_COUNT; i++) {
+        if (insert_rec(rmp, 4 * i, ecp) != RDB_OK)
+            goto error;
+    }
+
+    curp = RDB_recmap_cursor(rmp, RDB_TRUE, NULL, ecp);
+    if (curp == NULL)
+        goto error;
+
+    count = 0;
+    expected = 0;
+    if (RDB_cursor_first(curp, ecp) != RDB_OK)
+        goto error;
+    do {
+        if (RDB_cursor_get(curp, 0, &datap, &len, ecp) != RDB_OK)
+            goto error;
+        k = key_to_int(datap);
+        if (k != expected) {
+            fprintf(stderr, "cursor at key %d, expected %d\n", k, expected);
+            goto error;
+        }
+        if (k % 4 == 0) {
+            if (k > 0 && insert_rec(rmp, k - 2, ecp) != RDB_OK)
+                goto error;
+            if (insert_rec(rmp, k + 2, ecp) != RDB_OK)
+                goto error;
+            if (k + 4 < 4 * KEY_COUNT && delete_rec(rmp, k + 4, ecp) != RDB_OK)
+                goto error;
+            expected = k + 2;
+        } else {
+            expected = k + 6;
+        }
+        count++;
+    } while (RDB_cursor_next(curp, 0, ecp) == RDB_OK);
+    if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR)
+        goto error;
+    RDB_clear_err(ecp);
+    if (count != KEY_COUNT) {
+        fprintf(stderr, "cursor visited %d records instead of %d\n",
+                count, KEY_COUNT);
+        goto error;
+    }
+
+    /*
+     * Move the cursor to the 3rd record, which has key 6,
+     * delete the record before it, and move back
+     */
+    if (RDB_cursor_first(curp, ecp) != RDB_OK)
+        goto error;
+    for (i = 0; i < 2; i++) {
+        if (RDB_cursor_next(curp, 0, ecp) != RDB_OK)
+            goto error;
+    }
+    if (delete_rec(rmp, 2, ecp) != RDB_OK)
+        goto error;
+    if (RDB_cursor_prev(curp, ecp) != RDB_OK)
+        goto error;
+    if (RDB_cursor_get(curp, 0, &datap, &len, ecp) != RDB_OK)
+        goto error;
+    k = key_to_int(datap);
+    if (k != 0) {
+        fprintf(stderr, "cursor at key %d after moving back\n", k);
+        goto error;
+    }
+
+    if (RDB_destroy_cursor(curp, ecp) != RDB_OK) {
+        curp = NULL;
+        goto error;
+    }
+    return RDB_delete_recmap(rmp, NULL, ecp);
+
+error:
+    if (curp != NULL)
+        RDB_destroy_cursor(curp, ecp);
+    RDB_delete_recmap(rmp, NULL, ecp);
+    return RDB_ERROR;
+}
+
+int
+main(void)
+{
+    int i;
+    int k;
+    RDB_tree_pos pos;
+    RDB_tree_node *nodep;
+    RDB_binary_tree *treep;
+    RDB_exec_context ec;
+
+    RDB_init_exec_context(&ec);
+
+    treep = RDB_create_tree(&compare_int, NULL, &ec);
+    if (treep == NULL) {
+        fprintf(stderr, "creating tree failed\n");
+        return 2;
+    }
+
+    /* Insert keys in a scrambled order */
+    for (i = 0; i < KEY_COUNT; i++) {
+        if (insert_int(treep, (i * 7919) % KEY_COUNT, &ec) != RDB_OK) {
+            fprintf(stderr, "insert failed\n");
+            return 1;
+        }
+    }
+
+    /* Inserting a duplicate key must fail */
+    if (insert_int(treep, 42, &ec) == RDB_OK) {
+        fprintf(stderr, "duplicate key inserted\n");
+        return 1;
+    }
+    RDB_clear_err(&ec);
+
+    for (i = 0; i < KEY_COUNT; i++) {
+        nodep = RDB_tree_find_pos(treep, &i, sizeof(int), &pos);
+        if (nodep == NULL || *(int *) nodep->value != i * 2) {
+            fprintf(stderr, "wrong value for key %d\n", i);
+            return 1;
+        }
+    }
+
+    /* Delete all odd keys using a position */
+    k = 0;
+    nodep = RDB_tree_first(treep, &pos);
+    while (nodep != NULL) {
+        if (node_key(nodep) != k) {
+            fprintf(stderr, "wrong order at key %d\n", k);
+            return 1;
+        }
+        if (k % 2 == 1) {
+            if (RDB_tree_delete_pos(treep, &pos, &ec) != RDB_OK) {
+                fprintf(stderr, "delete failed\n");
+                return 1;
+            }
+            nodep = RDB_tree_pos_node(&pos);
+        } else {
+            nodep = RDB_tree_next(&pos);
+        }
+        k++;
+    }
+    if (k != KEY_COUNT) {
+        fprintf(stderr, "%d keys found instead of %d\n", k, KEY_COUNT);
+        return 1;
+    }
+
+    /* Delete the even keys up to 1000 by key */
+    for (i = 0; i <= 1000; i += 2) {
+        if (RDB_tree_delete_node(treep, &i, sizeof(int), &ec) != RDB_OK) {
+            fprintf(stderr, "deleting key %d failed\n", i);
+            return 1;
+        }
+    }
+    i = 1;
+    if (RDB_tree_find_pos(treep, &i, sizeof(int), &pos) != NULL) {
+        fprintf(stderr, "deleted key %d found\n", i);
+        return 1;
+    }
+
+    /* Iterate backwards over the remaining keys */
+    i = KEY_COUNT - 2;
+    nodep = RDB_tree_find_pos(treep, &i, sizeof(int), &pos);
+    for (k = KEY_COUNT - 2; nodep != NULL; k -= 2) {
+        if (node_key(nodep) != k) {
+            fprintf(stderr, "wrong key %d, expected %d\n",
+                    node_key(nodep), k);
+            return 1;
+        }
+        nodep = RDB_tree_prev(&pos);
+    }
+    if (k != 1000) {
+        fprintf(stderr, "iteration stopped at key %d\n", k);
+        return 1;
+    }
+
+    RDB_drop_tree(treep);
+
+    if (test_insert_delete(&ec) != RDB_OK) {
+        fprintf(stderr, "insert/delete test failed\n");
+        return 1;
+    }
+
+    if (test_cursor(&ec) != RDB_OK) {
+        fprintf(stderr, "cursor test failed\n");
+        return 1;
+    }
+
+    RDB_destroy_exec_context(&ec);
+    return 0;
+}
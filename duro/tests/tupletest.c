@@ -3,6 +3,48 @@
 #include <rel/rdb.h>
 #include <stdio.h>
 
+/*
+ * Add more attributes than fit into the initial storage,
+ * then copy the tuple and modify the copy
+ */
+static int
+test_many_attrs(RDB_object *tplp, RDB_exec_context *ecp)
+{
+    int i;
+    char name[8];
+    RDB_object tpl2;
+    RDB_object *bp = RDB_tuple_get(tplp, "B");
+
+    for (i = 0; i < 40; i++) {
+        sprintf(name, "X%d", i);
+        if (RDB_tuple_set_int(tplp, name, (RDB_int) i, ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
+
+    /* Adding attributes must not move the values */
+    if (RDB_tuple_get(tplp, "B") != bp || RDB_tuple_get_int(tplp, "X33") != 33)
+        return RDB_ERROR;
+
+    RDB_init_obj(&tpl2);
+    if (RDB_copy_obj(&tpl2, tplp, ecp) != RDB_OK)
+        goto error;
+    if (RDB_tuple_set_int(&tpl2, "Y", (RDB_int) 1, ecp) != RDB_OK)
+        goto error;
+    if (RDB_tuple_set_int(&tpl2, "X0", (RDB_int) 100, ecp) != RDB_OK)
+        goto error;
+
+    printf("%d %d\n", (int) RDB_tuple_size(tplp), (int) RDB_tuple_size(&tpl2));
+    printf("X0 -> %d, %d\n", (int) RDB_tuple_get_int(tplp, "X0"),
+            (int) RDB_tuple_get_int(&tpl2, "X0"));
+    if (RDB_tuple_get(tplp, "Y") != NULL)
+        goto error;
+    return RDB_destroy_obj(&tpl2, ecp);
+
+error:
+    RDB_destroy_obj(&tpl2, ecp);
+    return RDB_ERROR;
+}
+
 int main(void)
 {
     const void *datap;
@@ -41,7 +83,13 @@ int main(void)
 
     i = RDB_tuple_get_int(&tpl, "B");
     printf("%s -> %d\n", "B", i);
-    
+
+    if (test_many_attrs(&tpl, &ec) != RDB_OK) {
+        RDB_destroy_obj(&tpl, &ec);
+        RDB_destroy_exec_context(&ec);
+        return 1;
+    }
+
     RDB_destroy_obj(&tpl, &ec);
 
     RDB_destroy_exec_context(&ec);
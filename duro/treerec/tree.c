@@ -1,7 +1,21 @@
 /*
- * Binary search tree
+ * B+ tree
  * Copyright (C) 2018 Rene Hartmann.
  * See the file COPYING for redistribution information.
+ *
+ * The records are stored in the leaves, which are linked
+ * so cursors can move from one leaf to the next.
+ * The keys and values of the records of a leaf are stored contiguously
+ * in a buffer owned by the leaf, and the separator keys of an inner node
+ * in a buffer owned by the node, so searching a node does not follow
+ * a pointer per key.
+ * A leaf which is less than a quarter full after a deletion is merged
+ * with a sibling if the records fit into one leaf.
+ * Inner nodes are not merged, they are only removed when they are empty.
+ *
+ * Splitting nodes is done in two steps: First all nodes and key buffers
+ * the split needs are allocated, then the records and children are moved.
+ * So the tree is not modified if an allocation fails.
  */
 
 #include <gen/types.h>
@@ -10,15 +24,57 @@
 #include <treerec/tree.h>
 
 #include <string.h>
+#include <stdint.h>
 
-static void
-del_node(RDB_tree_node *nodep) {
-    if (nodep->keylen > 0)
-        free(nodep->key);
-    if (nodep->valuelen > 0)
-        free(nodep->value);
-    RDB_free(nodep);
-}
+enum {
+    /* Maximum number of records in a leaf and of children of an inner node */
+    TREE_ORDER = 32,
+
+    /* A leaf with fewer records is merged with a sibling if possible */
+    TREE_LEAF_MIN = TREE_ORDER / 4,
+
+    TREE_KEYBUF_CAPACITY = 256
+};
+
+struct RDB_tree_inner;
+
+/* Fields common to leaves and inner nodes */
+typedef struct {
+    /* Number of records or children */
+    int count;
+
+    struct RDB_tree_inner *parentp;
+} tree_nodehdr;
+
+/*
+ * The records are stored in buf in key order. The key of record #i
+ * starts at offv[i] and is immediately followed by its value.
+ */
+typedef struct RDB_tree_leaf {
+    tree_nodehdr hdr;
+    struct RDB_tree_leaf *prevp;
+    struct RDB_tree_leaf *nextp;
+    size_t offv[TREE_ORDER];
+    size_t keylenv[TREE_ORDER];
+    size_t valuelenv[TREE_ORDER];
+    uint8_t *buf;
+    size_t bufcap;
+} RDB_tree_leaf;
+
+/*
+ * Key #i (i > 0) is the smallest key that may be stored below childv[i].
+ * Key #0 is not used. The keys are stored in keybuf in this order.
+ */
+typedef struct RDB_tree_inner {
+    tree_nodehdr hdr;
+    void *childv[TREE_ORDER];
+    size_t keyoffv[TREE_ORDER];
+    size_t keylenv[TREE_ORDER];
+    uint8_t *keybuf;
+    size_t keybufcap;
+} RDB_tree_inner;
+
+#define NODEHDR(p) ((tree_nodehdr *) (p))
 
 RDB_binary_tree *
 RDB_create_tree(RDB_comparison_func *cmpfp, void *arg, RDB_exec_context *ecp)
@@ -28,416 +84,937 @@ RDB_create_tree(RDB_comparison_func *cmpfp, void *arg, RDB_exec_context *ecp)
         return NULL;
 
     treep->root = NULL;
+    treep->height = 0;
+    treep->firstp = NULL;
+    treep->modcount = 0;
     treep->comparison_fp = cmpfp;
     treep->comparison_arg = arg;
     return treep;
 }
 
 static void
-delete_subtree(RDB_tree_node *nodep)
+del_inner(RDB_tree_inner *inp)
+{
+    RDB_free(inp->keybuf);
+    RDB_free(inp);
+}
+
+static void
+del_leaf(RDB_tree_leaf *leafp)
+{
+    RDB_free(leafp->buf);
+    RDB_free(leafp);
+}
+
+static void
+delete_subtree(void *nodep, int height)
 {
-    if (nodep->left != NULL)
-        delete_subtree(nodep->left);
-    if (nodep->right != NULL)
-        delete_subtree(nodep->right);
-    del_node(nodep);
+    int i;
+
+    if (height == 0) {
+        del_leaf(nodep);
+    } else {
+        RDB_tree_inner *inp = nodep;
+
+        for (i = 0; i < inp->hdr.count; i++)
+            delete_subtree(inp->childv[i], height - 1);
+        del_inner(inp);
+    }
 }
 
 void
 RDB_drop_tree(RDB_binary_tree *treep)
 {
     if (treep->root != NULL) {
-        delete_subtree(treep->root);
+        delete_subtree(treep->root, treep->height);
     }
     RDB_free(treep);
 }
 
 static int
-compare_key(const RDB_binary_tree *treep, const void *key, size_t keylen,
-        const RDB_tree_node *nodep)
+compare_key(const RDB_binary_tree *treep, const void *key1, size_t keylen1,
+        const void *key2, size_t keylen2)
 {
     int res;
 
-    if (keylen > 0 && nodep->keylen > 0) {
+    if (keylen1 > 0 && keylen2 > 0) {
         if (treep->comparison_fp != NULL) {
-            return (*treep->comparison_fp)(key, keylen,
-                    nodep->key, nodep->keylen, treep->comparison_arg);
+            return (*treep->comparison_fp)(key1, keylen1,
+                    key2, keylen2, treep->comparison_arg);
         }
-        res = memcmp(key, nodep->key, nodep->keylen <= keylen ?
-                nodep->keylen : keylen);
+        res = memcmp(key1, key2, keylen1 <= keylen2 ? keylen1 : keylen2);
         if (res != 0)
             return res;
     }
 
-    return abs(keylen - nodep->keylen);
+    if (keylen1 < keylen2)
+        return -1;
+    return keylen1 > keylen2 ? 1 : 0;
 }
 
-RDB_tree_node *
-RDB_tree_find(const RDB_binary_tree *treep, const void *key, size_t keylen)
-{
-    RDB_tree_node *nodep = treep->root;
-    while (nodep != NULL) {
-        int cmpres = compare_key(treep, key, keylen, nodep);
-        if (cmpres == 0)
-            return nodep;
-        if (cmpres < 0)
-            nodep = nodep->left;
+/*
+ * Return the index of the child of *inp below which the key is stored
+ */
+static int
+inner_child_idx(const RDB_binary_tree *treep, const RDB_tree_inner *inp,
+        const void *key, size_t keylen)
+{
+    int lo = 1;
+    int hi = inp->hdr.count - 1;
+    int idx = 0;
+
+    /* Search for the last separator key which is less than or equal to key */
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (compare_key(treep, key, keylen, inp->keybuf + inp->keyoffv[mid],
+                inp->keylenv[mid]) >= 0) {
+            idx = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return idx;
+}
+
+/*
+ * Return the index of the first record of the leaf whose key is greater than
+ * or equal to key. *foundp is set to RDB_TRUE if the keys are equal.
+ */
+static int
+leaf_search(const RDB_binary_tree *treep, const RDB_tree_leaf *leafp,
+        const void *key, size_t keylen, RDB_bool *foundp)
+{
+    int lo = 0;
+    int hi = leafp->hdr.count;
+
+    *foundp = RDB_FALSE;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        int res = compare_key(treep, key, keylen,
+                leafp->buf + leafp->offv[mid], leafp->keylenv[mid]);
+        if (res == 0) {
+            *foundp = RDB_TRUE;
+            return mid;
+        }
+        if (res < 0)
+            hi = mid;
         else
-            nodep = nodep->right;
+            lo = mid + 1;
     }
-    return NULL;
+    return lo;
 }
 
-static RDB_tree_node *
-create_node(RDB_tree_node *parentp, void *key, size_t keylen,
-        void *val, size_t vallen, RDB_exec_context *ecp)
+static RDB_tree_leaf *
+find_leaf(const RDB_binary_tree *treep, const void *key, size_t keylen)
 {
-    RDB_tree_node *nodep = RDB_alloc(sizeof(RDB_tree_node), ecp);
-    if (nodep == NULL) {
+    int h;
+    void *nodep = treep->root;
+
+    if (nodep == NULL)
         return NULL;
+    for (h = treep->height; h > 0; h--) {
+        RDB_tree_inner *inp = nodep;
+        nodep = inp->childv[inner_child_idx(treep, inp, key, keylen)];
     }
-    nodep->left = NULL;
-    nodep->right = NULL;
-    nodep->parent = parentp;
-    nodep->balance = 0;
-    nodep->keylen = keylen;
-    if (keylen > 0)
-        nodep->key = key;
-    nodep->valuelen = vallen;
-    if (vallen > 0)
-        nodep->value = val;
     return nodep;
 }
 
-static RDB_tree_node *
-avl_tree_insert(RDB_binary_tree *treep, RDB_tree_node **nodepp, RDB_tree_node *parentp,
-        void *key, size_t keylen, void *val, size_t vallen,
-        RDB_bool *hp, RDB_exec_context *ecp)
+/*
+ * Find the record with the given key and store its position in *posp.
+ * Returns NULL if there is no such record.
+ */
+RDB_tree_node *
+RDB_tree_find_pos(const RDB_binary_tree *treep, const void *key, size_t keylen,
+        RDB_tree_pos *posp)
 {
-    int cmpres;
-    RDB_tree_node *newnodep;
-    RDB_tree_node *nodep1, *nodep2;
+    RDB_bool found;
+    int idx;
+    RDB_tree_leaf *leafp = find_leaf(treep, key, keylen);
+    if (leafp == NULL)
+        return NULL;
 
-    if (*nodepp == NULL) {
-        *nodepp = create_node(parentp, key, keylen, val, vallen, ecp);
-        *hp = RDB_TRUE;
-        return *nodepp;
-    }
-    cmpres = compare_key(treep, key, keylen, *nodepp);
-    if (cmpres == 0) {
-        RDB_raise_key_violation("", ecp);
+    idx = leaf_search(treep, leafp, key, keylen, &found);
+    if (!found)
+        return NULL;
+    posp->leafp = leafp;
+    posp->idx = idx;
+    return RDB_tree_pos_node(posp);
+}
+
+/*
+ * Move *posp to the first record whose key is greater than or equal to key.
+ * *foundp is set to RDB_TRUE if the keys are equal.
+ * Returns NULL if there is no such record.
+ */
+RDB_tree_node *
+RDB_tree_seek(const RDB_binary_tree *treep, const void *key, size_t keylen,
+        RDB_tree_pos *posp, RDB_bool *foundp)
+{
+    RDB_tree_leaf *leafp = find_leaf(treep, key, keylen);
+
+    *foundp = RDB_FALSE;
+    if (leafp == NULL) {
+        posp->leafp = NULL;
+        posp->idx = 0;
         return NULL;
     }
-    if (cmpres < 0) {
-        newnodep = avl_tree_insert(treep, &(*nodepp)->left, *nodepp, key, keylen, val, vallen,
-                hp, ecp);
-        if (newnodep == NULL)
-            return NULL;
-        if (*hp) {
-            switch((*nodepp)->balance) {
-            case 1:
-                (*nodepp)->balance = 0;
-                *hp = RDB_FALSE;
-                break;
-            case 0:
-                (*nodepp)->balance = -1;
-                break;
-            case -1:
-                nodep1 = (*nodepp)->left;
-                if (nodep1->balance == -1) {
-                    (*nodepp)->left = nodep1->right;
-                    if (nodep1->right != NULL)
-                        nodep1->right->parent = *nodepp;
-                    nodep1->right = *nodepp;
-                    (*nodepp)->parent = nodep1;
-                    (*nodepp)->balance = 0;
-                    nodep1->parent = parentp;
-                    *nodepp = nodep1;
-                } else {
-                    nodep2 = nodep1->right;
-                    nodep1->right = nodep2->left;
-                    if (nodep2->left != NULL)
-                        nodep2->left->parent = nodep1;
-                    nodep2->left = nodep1;
-                    nodep1->parent = nodep2;
-                    (*nodepp)->left = nodep2->right;
-                    if (nodep2->right != NULL)
-                        nodep2->right->parent = *nodepp;
-                    nodep2->right = *nodepp;
-                    (*nodepp)->parent = nodep2;
-                    if (nodep2->balance == -1) {
-                        (*nodepp)->balance = 1;
-                    } else {
-                        (*nodepp)->balance = 0;
-                    }
-                    if (nodep2->balance == 1) {
-                        nodep1->balance = -1;
-                    } else {
-                        nodep1->balance = 0;
-                    }
-                    nodep2->parent = parentp;
-                    *nodepp = nodep2;
-                }
-                (*nodepp)->balance = 0;
-                *hp = RDB_FALSE;
-                break;
-            }
-        }
+    posp->idx = leaf_search(treep, leafp, key, keylen, foundp);
+    if (posp->idx < leafp->hdr.count) {
+        posp->leafp = leafp;
     } else {
-        newnodep = avl_tree_insert(treep, &(*nodepp)->right, *nodepp, key, keylen, val, vallen,
-                hp, ecp);
-        if (newnodep == NULL)
-            return NULL;
-        if (*hp) {
-            switch((*nodepp)->balance) {
-            case -1:
-                (*nodepp)->balance = 0;
-                *hp = RDB_FALSE;
-                break;
-            case 0:
-                (*nodepp)->balance = 1;
-                break;
-            case 1:
-                nodep1 = (*nodepp)->right;
-                if (nodep1->balance == 1) {
-                    (*nodepp)->right = nodep1->left;
-                    if (nodep1->left != NULL)
-                        nodep1->left->parent = *nodepp;
-                    nodep1->left = *nodepp;
-                    (*nodepp)->parent = nodep1;
-                    (*nodepp)->balance = 0;
-                    nodep1->parent = parentp;
-                    *nodepp = nodep1;
-                } else {
-                    nodep2 = nodep1->left;
-                    nodep1->left = nodep2->right;
-                    if (nodep2->right != NULL)
-                        nodep2->right->parent = nodep1;
-                    nodep2->right = nodep1;
-                    nodep1->parent = nodep2;
-                    (*nodepp)->right = nodep2->left;
-                    if (nodep2->left != NULL)
-                        nodep2->left->parent = *nodepp;
-                    nodep2->left = *nodepp;
-                    (*nodepp)->parent = nodep2;
-                    if (nodep2->balance == 1) {
-                        (*nodepp)->balance = -1;
-                    } else {
-                        (*nodepp)->balance = 0;
-                    }
-                    if (nodep2->balance == -1) {
-                        nodep1->balance = 1;
-                    } else {
-                        nodep1->balance = 0;
-                    }
-                    nodep2->parent = parentp;
-                    *nodepp = nodep2;
-                }
-                (*nodepp)->balance = 0;
-                *hp = RDB_FALSE;
-                break;
-            }
-        }
+        posp->leafp = leafp->nextp;
+        posp->idx = 0;
     }
-    return newnodep;
+    return RDB_tree_pos_node(posp);
 }
 
-RDB_tree_node *
-RDB_tree_insert(RDB_binary_tree *treep, void *key, size_t keylen,
-        void *val, size_t vallen, RDB_exec_context *ecp)
+static size_t
+inner_keys_len(const RDB_tree_inner *inp)
+{
+    if (inp->hdr.count <= 1)
+        return 0;
+    return inp->keyoffv[inp->hdr.count - 1] + inp->keylenv[inp->hdr.count - 1];
+}
+
+static RDB_tree_inner *
+new_inner(RDB_exec_context *ecp)
 {
-    RDB_bool h = RDB_FALSE;
-    return avl_tree_insert(treep, &treep->root, NULL, key, keylen, val, vallen, &h, ecp);
+    RDB_tree_inner *inp = RDB_alloc(sizeof(RDB_tree_inner), ecp);
+    if (inp == NULL)
+        return NULL;
+    inp->hdr.count = 0;
+    inp->hdr.parentp = NULL;
+    inp->keybuf = NULL;
+    inp->keybufcap = 0;
+    return inp;
 }
 
+/*
+ * Make sure a key of length keylen can be added to the key buffer
+ */
+static int
+inner_reserve(RDB_tree_inner *inp, size_t keylen, RDB_exec_context *ecp)
+{
+    size_t used = inner_keys_len(inp);
+
+    if (used + keylen > inp->keybufcap) {
+        size_t cap = inp->keybufcap > 0 ? inp->keybufcap * 2
+                : TREE_KEYBUF_CAPACITY;
+        uint8_t *bufp;
+
+        if (cap < used + keylen)
+            cap = used + keylen;
+        bufp = RDB_realloc(inp->keybuf, cap, ecp);
+        if (bufp == NULL)
+            return RDB_ERROR;
+        inp->keybuf = bufp;
+        inp->keybufcap = cap;
+    }
+    return RDB_OK;
+}
+
+/*
+ * Insert a child at position idx, key is the separator key of the child.
+ * If idx is 0, the key is ignored.
+ * The key buffer must be large enough to hold the key.
+ */
 static void
-avl_balance_l(RDB_tree_node **nodepp, RDB_bool *hp)
-{
-    RDB_tree_node *parentp;
-    RDB_tree_node *nodep1, *nodep2;
-    int bal;
-
-    switch((*nodepp)->balance) {
-    case -1:
-        (*nodepp)->balance = 0;
-        break;
-    case 0:
-        (*nodepp)->balance = 1;
-        *hp = RDB_FALSE;
-        break;
-    case 1:
-        parentp = (*nodepp)->parent;
-        nodep1 = (*nodepp)->right;
-        bal = nodep1->balance;
-        if (bal >= 0) {
-            (*nodepp)->right = nodep1->left;
-            if (nodep1->left != NULL)
-                nodep1->left->parent = *nodepp;
-            nodep1->left = *nodepp;
-            (*nodepp)->parent = nodep1;
-            if (bal == 0) {
-                (*nodepp)->balance = 1;
-                nodep1->balance = -1;
-                *hp = RDB_FALSE;
-            } else {
-                (*nodepp)->balance = 0;
-                nodep1->balance = 0;
-            }
-            *nodepp = nodep1;
-        } else {
-            nodep2 = nodep1->left;
-            bal = nodep2->balance;
-            nodep1->left = nodep2->right;
-            if (nodep2->right != NULL)
-                nodep2->right->parent = nodep1;
-            nodep2->right = nodep1;
-            nodep1->parent = nodep2;
-            (*nodepp)->right = nodep2->left;
-            if (nodep2->left != NULL)
-                nodep2->left->parent = *nodepp;
-            nodep2->left = *nodepp;
-            (*nodepp)->parent = nodep2;
-            (*nodepp)->balance = (bal == 1) ? -1 : 0;
-            nodep1->balance = (bal == -1) ? 1 : 0;
-            *nodepp = nodep2;
-            nodep2->balance = 0;
+inner_insert(RDB_tree_inner *inp, int idx, void *childp,
+        const void *key, size_t keylen)
+{
+    int i;
+    size_t off;
+    size_t used = inner_keys_len(inp);
+
+    /* Key #0 is not used */
+    if (idx == 0)
+        keylen = 0;
+
+    off = idx > 0 && idx < inp->hdr.count ? inp->keyoffv[idx] : used;
+    memmove(inp->keybuf + off + keylen, inp->keybuf + off, used - off);
+    for (i = inp->hdr.count - 1; i >= idx; i--) {
+        inp->childv[i + 1] = inp->childv[i];
+        inp->keyoffv[i + 1] = inp->keyoffv[i] + keylen;
+        inp->keylenv[i + 1] = inp->keylenv[i];
+    }
+    inp->childv[idx] = childp;
+    inp->keyoffv[idx] = off;
+    inp->keylenv[idx] = keylen;
+    if (keylen > 0)
+        memcpy(inp->keybuf + off, key, keylen);
+    inp->hdr.count++;
+    NODEHDR(childp)->parentp = inp;
+}
+
+/*
+ * Remove the child at position idx
+ */
+static void
+inner_remove(RDB_tree_inner *inp, int idx)
+{
+    int i;
+    size_t used = inner_keys_len(inp);
+
+    /* If the 1st child is removed, the 2nd child becomes the 1st one */
+    int keyidx = idx > 0 ? idx : 1;
+
+    if (keyidx < inp->hdr.count) {
+        size_t off = inp->keyoffv[keyidx];
+        size_t keylen = inp->keylenv[keyidx];
+
+        memmove(inp->keybuf + off, inp->keybuf + off + keylen,
+                used - off - keylen);
+        for (i = keyidx + 1; i < inp->hdr.count; i++)
+            inp->keyoffv[i] -= keylen;
+    }
+    for (i = idx; i < inp->hdr.count - 1; i++) {
+        inp->childv[i] = inp->childv[i + 1];
+        inp->keyoffv[i] = inp->keyoffv[i + 1];
+        inp->keylenv[i] = inp->keylenv[i + 1];
+    }
+    inp->hdr.count--;
+    inp->keyoffv[0] = 0;
+    inp->keylenv[0] = 0;
+}
+
+static int
+child_idx(const RDB_tree_inner *inp, const void *childp)
+{
+    int i;
+
+    for (i = 0; i < inp->hdr.count && inp->childv[i] != childp; i++);
+    return i;
+}
+
+/*
+ * The nodes and key buffers a split needs, allocated before the tree
+ * is modified
+ */
+typedef struct {
+    /* The new leaf */
+    RDB_tree_leaf *leafp;
+
+    /*
+     * Number of full inner nodes above the leaf which must be split,
+     * the new nodes and the new key buffers of the nodes which are split,
+     * from the bottom up
+     */
+    int innerc;
+    RDB_tree_inner **innerv;
+    uint8_t **bufv;
+
+    /* The new root, if the root is split */
+    RDB_tree_inner *rootp;
+} tree_split;
+
+static void
+insert_into_parent(RDB_binary_tree *, void *, const void *, size_t, void *,
+        tree_split *, int);
+
+static RDB_tree_leaf *
+new_leaf(RDB_exec_context *ecp)
+{
+    RDB_tree_leaf *leafp = RDB_alloc(sizeof(RDB_tree_leaf), ecp);
+    if (leafp == NULL)
+        return NULL;
+    leafp->hdr.count = 0;
+    leafp->hdr.parentp = NULL;
+    leafp->prevp = NULL;
+    leafp->nextp = NULL;
+    leafp->buf = NULL;
+    leafp->bufcap = 0;
+    return leafp;
+}
+
+/*
+ * Return the number of bytes the records #idx and following
+ * occupy in the buffer of the leaf
+ */
+static size_t
+leaf_recs_len(const RDB_tree_leaf *leafp, int idx)
+{
+    int last = leafp->hdr.count - 1;
+
+    if (idx > last)
+        return 0;
+    return leafp->offv[last] + leafp->keylenv[last] + leafp->valuelenv[last]
+            - leafp->offv[idx];
+}
+
+/*
+ * Make sure len bytes can be added to the buffer of the leaf
+ */
+static int
+leaf_reserve(RDB_tree_leaf *leafp, size_t len, RDB_exec_context *ecp)
+{
+    size_t used = leaf_recs_len(leafp, 0);
+
+    if (used + len > leafp->bufcap) {
+        size_t cap = leafp->bufcap > 0 ? leafp->bufcap * 2
+                : TREE_KEYBUF_CAPACITY;
+        uint8_t *bufp;
+
+        if (cap < used + len)
+            cap = used + len;
+        bufp = RDB_realloc(leafp->buf, cap, ecp);
+        if (bufp == NULL)
+            return RDB_ERROR;
+        leafp->buf = bufp;
+        leafp->bufcap = cap;
+    }
+    return RDB_OK;
+}
+
+/*
+ * Insert a record at position idx.
+ * The buffer must be large enough to hold key and value.
+ */
+static void
+leaf_insert(RDB_tree_leaf *leafp, int idx, const void *key, size_t keylen,
+        const void *val, size_t vallen)
+{
+    int i;
+    size_t len = keylen + vallen;
+    size_t off = idx < leafp->hdr.count ? leafp->offv[idx]
+            : leaf_recs_len(leafp, 0);
+
+    if (len > 0) {
+        memmove(leafp->buf + off + len, leafp->buf + off,
+                leaf_recs_len(leafp, idx));
+    }
+    for (i = leafp->hdr.count - 1; i >= idx; i--) {
+        leafp->offv[i + 1] = leafp->offv[i] + len;
+        leafp->keylenv[i + 1] = leafp->keylenv[i];
+        leafp->valuelenv[i + 1] = leafp->valuelenv[i];
+    }
+    leafp->offv[idx] = off;
+    leafp->keylenv[idx] = keylen;
+    leafp->valuelenv[idx] = vallen;
+    if (keylen > 0)
+        memcpy(leafp->buf + off, key, keylen);
+    if (vallen > 0)
+        memcpy(leafp->buf + off + keylen, val, vallen);
+    leafp->hdr.count++;
+}
+
+/*
+ * Remove the record at position idx
+ */
+static void
+leaf_remove(RDB_tree_leaf *leafp, int idx)
+{
+    int i;
+    size_t len = leafp->keylenv[idx] + leafp->valuelenv[idx];
+
+    if (len > 0) {
+        memmove(leafp->buf + leafp->offv[idx],
+                leafp->buf + leafp->offv[idx] + len,
+                leaf_recs_len(leafp, idx + 1));
+    }
+    for (i = idx; i < leafp->hdr.count - 1; i++) {
+        leafp->offv[i] = leafp->offv[i + 1] - len;
+        leafp->keylenv[i] = leafp->keylenv[i + 1];
+        leafp->valuelenv[i] = leafp->valuelenv[i + 1];
+    }
+    leafp->hdr.count--;
+}
+
+/*
+ * Append the records #idx and following of *srcp to *dstp.
+ * The buffer of *dstp must be large enough.
+ */
+static void
+leaf_append(RDB_tree_leaf *dstp, RDB_tree_leaf *srcp, int idx)
+{
+    int i;
+    size_t off = leaf_recs_len(dstp, 0);
+    size_t len = leaf_recs_len(srcp, idx);
+
+    if (len > 0)
+        memcpy(dstp->buf + off, srcp->buf + srcp->offv[idx], len);
+    for (i = idx; i < srcp->hdr.count; i++) {
+        dstp->offv[dstp->hdr.count] = srcp->offv[i] - srcp->offv[idx] + off;
+        dstp->keylenv[dstp->hdr.count] = srcp->keylenv[i];
+        dstp->valuelenv[dstp->hdr.count] = srcp->valuelenv[i];
+        dstp->hdr.count++;
+    }
+}
+
+/*
+ * Return the length of key #n1 after inserting a key of length keylen
+ * at position idx into a sequence of keys whose lengths are lenv
+ */
+static size_t
+split_key_len(int n1, int idx, size_t keylen, const size_t *lenv)
+{
+    if (n1 < idx)
+        return lenv[n1];
+    if (n1 == idx)
+        return keylen;
+    return lenv[n1 - 1];
+}
+
+static void
+free_split(tree_split *splitp)
+{
+    int i;
+
+    if (splitp->leafp != NULL)
+        del_leaf(splitp->leafp);
+    for (i = 0; i < splitp->innerc; i++) {
+        if (splitp->innerv[i] != NULL)
+            del_inner(splitp->innerv[i]);
+        RDB_free(splitp->bufv[i]);
+    }
+    RDB_free(splitp->innerv);
+    RDB_free(splitp->bufv);
+    if (splitp->rootp != NULL)
+        del_inner(splitp->rootp);
+}
+
+/*
+ * Allocate what is needed to split the full leaf *leafp
+ * when inserting a record with a key of length keylen and a value
+ * of length vallen at position idx
+ */
+static int
+reserve_split(RDB_tree_leaf *leafp, int idx, size_t keylen, size_t vallen,
+        tree_split *splitp, RDB_exec_context *ecp)
+{
+    size_t cap;
+    int i;
+    int n;
+    size_t pushlen;
+    void *childp = leafp;
+    RDB_tree_inner *parentp;
+    int n1 = (TREE_ORDER + 1) / 2;
+
+    splitp->innerc = 0;
+    splitp->innerv = NULL;
+    splitp->bufv = NULL;
+    splitp->rootp = NULL;
+    splitp->leafp = new_leaf(ecp);
+    if (splitp->leafp == NULL)
+        return RDB_ERROR;
+
+    /*
+     * The buffer of the new leaf must hold the upper half of the records,
+     * the buffer of the old leaf the new record if it goes there.
+     * Growing the buffer does not change the old leaf.
+     */
+    if (idx < n1) {
+        cap = leaf_recs_len(leafp, n1 - 1);
+        if (leaf_reserve(leafp, keylen + vallen, ecp) != RDB_OK)
+            goto error;
+    } else {
+        cap = leaf_recs_len(leafp, n1) + keylen + vallen;
+    }
+    if (cap > 0) {
+        splitp->leafp->buf = RDB_alloc(cap, ecp);
+        if (splitp->leafp->buf == NULL)
+            goto error;
+        splitp->leafp->bufcap = cap;
+    }
+
+    /* Length of the key of the first record of the new leaf */
+    if (idx < n1)
+        pushlen = leafp->keylenv[n1 - 1];
+    else if (idx == n1)
+        pushlen = keylen;
+    else
+        pushlen = leafp->keylenv[n1];
+
+    n = 0;
+    for (parentp = leafp->hdr.parentp;
+            parentp != NULL && parentp->hdr.count == TREE_ORDER;
+            parentp = parentp->hdr.parentp) {
+        n++;
+    }
+    if (n > 0) {
+        splitp->innerv = RDB_alloc(sizeof(RDB_tree_inner *) * n, ecp);
+        if (splitp->innerv == NULL)
+            goto error;
+        splitp->bufv = RDB_alloc(sizeof(uint8_t *) * n, ecp);
+        if (splitp->bufv == NULL)
+            goto error;
+    }
+
+    parentp = leafp->hdr.parentp;
+    for (i = 0; i < n; i++) {
+        int cidx = child_idx(parentp, childp) + 1;
+
+        /* Each half can hold all keys of the node and the new key */
+        size_t keycap = inner_keys_len(parentp) + pushlen;
+
+        splitp->innerv[i] = new_inner(ecp);
+        splitp->bufv[i] = NULL;
+        splitp->innerc++;
+        if (splitp->innerv[i] == NULL)
+            goto error;
+        if (keycap > 0) {
+            splitp->innerv[i]->keybuf = RDB_alloc(keycap, ecp);
+            if (splitp->innerv[i]->keybuf == NULL)
+                goto error;
+            splitp->innerv[i]->keybufcap = keycap;
+            splitp->bufv[i] = RDB_alloc(keycap, ecp);
+            if (splitp->bufv[i] == NULL)
+                goto error;
         }
-        (*nodepp)->parent = parentp;
+
+        /* The key which goes into the parent of this node */
+        pushlen = split_key_len(n1, cidx, pushlen, parentp->keylenv);
+
+        childp = parentp;
+        parentp = parentp->hdr.parentp;
+    }
+
+    if (parentp == NULL) {
+        splitp->rootp = new_inner(ecp);
+        if (splitp->rootp == NULL)
+            goto error;
+        parentp = splitp->rootp;
     }
+    /* Growing the key buffer does not change the node */
+    if (inner_reserve(parentp, pushlen, ecp) != RDB_OK)
+        goto error;
+    return RDB_OK;
+
+error:
+    free_split(splitp);
+    return RDB_ERROR;
 }
 
+/*
+ * Split the full inner node *inp at level while inserting childp
+ * at position idx
+ */
 static void
-avl_balance_r(RDB_tree_node **nodepp, RDB_bool *hp)
-{
-    RDB_tree_node *parentp;
-    RDB_tree_node *nodep1, *nodep2;
-    int bal;
-
-    switch((*nodepp)->balance) {
-    case 1:
-        (*nodepp)->balance = 0;
-        break;
-    case 0:
-        (*nodepp)->balance = -1;
-        *hp = RDB_FALSE;
-        break;
-    case -1:
-        parentp = (*nodepp)->parent;
-        nodep1 = (*nodepp)->left;
-        bal = nodep1->balance;
-        if (bal <= 0) {
-            (*nodepp)->left = nodep1->right;
-            if (nodep1->right != NULL)
-                nodep1->right->parent = *nodepp;
-            nodep1->right = *nodepp;
-            (*nodepp)->parent = nodep1;
-            if (bal == 0) {
-                (*nodepp)->balance = -1;
-                nodep1->balance = 1;
-                *hp = RDB_FALSE;
-            } else {
-                (*nodepp)->balance = 0;
-                nodep1->balance = 0;
-            }
-            *nodepp = nodep1;
+split_inner(RDB_binary_tree *treep, RDB_tree_inner *inp, int idx, void *childp,
+        const void *key, size_t keylen, tree_split *splitp, int level)
+{
+    int i;
+    void *childv[TREE_ORDER + 1];
+    const uint8_t *keyv[TREE_ORDER + 1];
+    size_t keylenv[TREE_ORDER + 1];
+    uint8_t *oldbuf;
+    int n1 = (TREE_ORDER + 1) / 2;
+    RDB_tree_inner *newp = splitp->innerv[level];
+
+    splitp->innerv[level] = NULL;
+
+    for (i = 0; i <= TREE_ORDER; i++) {
+        if (i < idx) {
+            childv[i] = inp->childv[i];
+            keyv[i] = inp->keybuf + inp->keyoffv[i];
+            keylenv[i] = inp->keylenv[i];
+        } else if (i == idx) {
+            childv[i] = childp;
+            keyv[i] = key;
+            keylenv[i] = keylen;
         } else {
-            nodep2 = nodep1->right;
-            bal = nodep2->balance;
-            nodep1->right = nodep2->left;
-            if (nodep2->left != NULL)
-                nodep2->left->parent = nodep1;
-            nodep2->left = nodep1;
-            nodep1->parent = nodep2;
-            (*nodepp)->left = nodep2->right;
-            if (nodep2->right != NULL)
-                nodep2->right->parent = *nodepp;
-            nodep2->right = *nodepp;
-            (*nodepp)->parent = nodep2;
-            (*nodepp)->balance = (bal == -1) ? 1 : 0;
-            nodep1->balance = (bal == 1) ? -1 : 0;
-            *nodepp = nodep2;
-            nodep2->balance = 0;
+            childv[i] = inp->childv[i - 1];
+            keyv[i] = inp->keybuf + inp->keyoffv[i - 1];
+            keylenv[i] = inp->keylenv[i - 1];
         }
-        (*nodepp)->parent = parentp;
     }
+
+    /* Rebuild both nodes, the old keys are kept until the parent is updated */
+    oldbuf = inp->keybuf;
+    inp->keybuf = splitp->bufv[level];
+    inp->keybufcap = newp->keybufcap;
+    splitp->bufv[level] = NULL;
+    inp->hdr.count = 0;
+    for (i = 0; i < n1; i++) {
+        inner_insert(inp, i, childv[i], keyv[i], keylenv[i]);
+    }
+    for (i = n1; i <= TREE_ORDER; i++) {
+        inner_insert(newp, i - n1, childv[i], keyv[i], keylenv[i]);
+    }
+
+    insert_into_parent(treep, inp, keyv[n1], keylenv[n1], newp, splitp,
+            level + 1);
+    RDB_free(oldbuf);
 }
 
+/*
+ * Insert rightp, which has been split off from leftp, into the parent of leftp.
+ * level is the number of inner nodes which have been split below the parent.
+ */
 static void
-del_rightmost(RDB_tree_node **rnodepp,
-        RDB_tree_node **delnodepp, RDB_bool *hp)
+insert_into_parent(RDB_binary_tree *treep, void *leftp,
+        const void *key, size_t keylen, void *rightp, tree_split *splitp,
+        int level)
 {
-    if ((*rnodepp)->right != NULL) {
-        del_rightmost(&(*rnodepp)->right, delnodepp, hp);
-        if (*hp) {
-            avl_balance_r(rnodepp, hp);
-        }
-    } else {
-        if ((*delnodepp)->keylen > 0)
-            free ((*delnodepp)->key);
-        if ((*delnodepp)->valuelen > 0)
-            free ((*delnodepp)->value);
-        (*delnodepp)->keylen = (*rnodepp)->keylen;
-        (*delnodepp)->key = (*rnodepp)->key;
-        (*delnodepp)->valuelen = (*rnodepp)->valuelen;
-        (*delnodepp)->value = (*rnodepp)->value;
-        (*rnodepp)->keylen = 0;
-        (*rnodepp)->key = NULL;
-        (*rnodepp)->valuelen = 0;
-        (*rnodepp)->value = NULL;
-        *delnodepp = *rnodepp;
-        if ((*rnodepp)->left != NULL)
-            (*rnodepp)->left->parent = (*rnodepp)->parent;
-        *rnodepp = (*rnodepp)->left;
-        *hp = RDB_TRUE;
+    RDB_tree_inner *parentp = NODEHDR(leftp)->parentp;
+
+    if (parentp == NULL) {
+        /* Create new root */
+        parentp = splitp->rootp;
+        splitp->rootp = NULL;
+        inner_insert(parentp, 0, leftp, NULL, 0);
+        inner_insert(parentp, 1, rightp, key, keylen);
+        treep->root = parentp;
+        treep->height++;
+        return;
+    }
+
+    if (parentp->hdr.count < TREE_ORDER) {
+        inner_insert(parentp, child_idx(parentp, leftp) + 1, rightp,
+                key, keylen);
+        return;
     }
+    split_inner(treep, parentp, child_idx(parentp, leftp) + 1, rightp,
+            key, keylen, splitp, level);
 }
 
+/*
+ * Split a full leaf while inserting a record at position idx.
+ * The position of the new record is stored in *posp.
+ */
 static int
-avl_delete_node(RDB_binary_tree *treep, RDB_tree_node **nodepp,
-        void *key, size_t keylen, RDB_bool *hp, RDB_exec_context *ecp)
+split_leaf(RDB_binary_tree *treep, RDB_tree_leaf *leafp, int idx,
+        const void *key, size_t keylen, const void *val, size_t vallen,
+        RDB_tree_pos *posp, RDB_exec_context *ecp)
 {
-    int cmpres;
-    int ret;
+    tree_split split;
+    RDB_tree_leaf *newp;
+    int n1 = (TREE_ORDER + 1) / 2;
 
-    if (*nodepp == NULL) {
-        RDB_raise_not_found("", ecp);
+    if (reserve_split(leafp, idx, keylen, vallen, &split, ecp) != RDB_OK)
         return RDB_ERROR;
+    newp = split.leafp;
+    split.leafp = NULL;
+
+    /* Move the upper half of the records to the new leaf */
+    if (idx < n1) {
+        leaf_append(newp, leafp, n1 - 1);
+        leafp->hdr.count = n1 - 1;
+        leaf_insert(leafp, idx, key, keylen, val, vallen);
+    } else {
+        leaf_append(newp, leafp, n1);
+        leafp->hdr.count = n1;
+        leaf_insert(newp, idx - n1, key, keylen, val, vallen);
     }
 
-    cmpres = compare_key(treep, key, keylen, *nodepp);
-    if (cmpres < 0) {
-        ret = avl_delete_node(treep, &(*nodepp)->left, key, keylen, hp, ecp);
-        if (ret != RDB_OK)
+    newp->prevp = leafp;
+    newp->nextp = leafp->nextp;
+    if (leafp->nextp != NULL)
+        leafp->nextp->prevp = newp;
+    leafp->nextp = newp;
+
+    insert_into_parent(treep, leafp, newp->buf + newp->offv[0],
+            newp->keylenv[0], newp, &split, 0);
+    free_split(&split);
+
+    if (idx < n1) {
+        posp->leafp = leafp;
+        posp->idx = idx;
+    } else {
+        posp->leafp = newp;
+        posp->idx = idx - n1;
+    }
+    return RDB_OK;
+}
+
+/*
+ * Insert a record. Key and value are copied into the tree.
+ * If posp is not NULL, the position of the new record is stored in *posp.
+ * If a record with the same key exists, RDB_KEY_VIOLATION_ERROR is raised.
+ */
+int
+RDB_tree_insert(RDB_binary_tree *treep, const void *key, size_t keylen,
+        const void *val, size_t vallen, RDB_tree_pos *posp,
+        RDB_exec_context *ecp)
+{
+    RDB_bool found;
+    int idx;
+    RDB_tree_leaf *leafp;
+    RDB_tree_pos pos;
+
+    if (treep->root == NULL) {
+        leafp = new_leaf(ecp);
+        if (leafp == NULL)
             return RDB_ERROR;
-        if (*hp) {
-            avl_balance_l(nodepp, hp);
-        }
-    } else if (cmpres > 0) {
-        ret = avl_delete_node(treep, &(*nodepp)->right, key, keylen, hp, ecp);
-        if (ret != RDB_OK)
+        treep->root = leafp;
+        treep->height = 0;
+        treep->firstp = leafp;
+    } else {
+        leafp = find_leaf(treep, key, keylen);
+    }
+
+    idx = leaf_search(treep, leafp, key, keylen, &found);
+    if (found) {
+        RDB_raise_key_violation("", ecp);
+        return RDB_ERROR;
+    }
+
+    if (posp == NULL)
+        posp = &pos;
+    if (leafp->hdr.count < TREE_ORDER) {
+        if (leaf_reserve(leafp, keylen + vallen, ecp) != RDB_OK)
             return RDB_ERROR;
-        if (*hp) {
-            avl_balance_r(nodepp, hp);
-        }
+        leaf_insert(leafp, idx, key, keylen, val, vallen);
+        posp->leafp = leafp;
+        posp->idx = idx;
     } else {
-        RDB_tree_node *delnodep = *nodepp;
-        if (delnodep->right == NULL) {
-            *nodepp = delnodep->left;
-            *hp = RDB_TRUE;
-        } else if (delnodep->left == NULL) {
-            *nodepp = delnodep->right;
-            *hp = RDB_TRUE;
-        } else {
-            del_rightmost(&delnodep->left, &delnodep, hp);
-            if (*hp) {
-                avl_balance_l(nodepp, hp);
-            }
+        if (split_leaf(treep, leafp, idx, key, keylen, val, vallen, posp, ecp)
+                != RDB_OK)
+            return RDB_ERROR;
+    }
+    treep->modcount++;
+    RDB_tree_pos_node(posp);
+    return RDB_OK;
+}
+
+/*
+ * Replace the value of the record at position *posp.
+ * The position remains valid, but the addresses of the keys and values
+ * of the records in the same leaf change.
+ */
+int
+RDB_tree_set_value(RDB_binary_tree *treep, RDB_tree_pos *posp,
+        const void *val, size_t vallen, RDB_exec_context *ecp)
+{
+    RDB_tree_leaf *leafp = posp->leafp;
+    int idx = posp->idx;
+    size_t oldlen = leafp->valuelenv[idx];
+    size_t valoff = leafp->offv[idx] + leafp->keylenv[idx];
+    int i;
+
+    if (vallen > oldlen) {
+        if (leaf_reserve(leafp, vallen - oldlen, ecp) != RDB_OK)
+            return RDB_ERROR;
+    }
+    if (vallen != oldlen) {
+        /* Move the following records */
+        memmove(leafp->buf + valoff + vallen, leafp->buf + valoff + oldlen,
+                leaf_recs_len(leafp, idx + 1));
+        for (i = idx + 1; i < leafp->hdr.count; i++)
+            leafp->offv[i] = leafp->offv[i] + vallen - oldlen;
+        leafp->valuelenv[idx] = vallen;
+    }
+    if (vallen > 0)
+        memcpy(leafp->buf + valoff, val, vallen);
+    RDB_tree_pos_node(posp);
+    return RDB_OK;
+}
+
+/*
+ * Remove an empty node from the tree and delete it
+ */
+static void
+remove_node(RDB_binary_tree *treep, void *nodep, RDB_bool leaf)
+{
+    RDB_tree_inner *parentp = NODEHDR(nodep)->parentp;
+
+    if (parentp != NULL)
+        inner_remove(parentp, child_idx(parentp, nodep));
+    if (leaf)
+        del_leaf(nodep);
+    else
+        del_inner(nodep);
+
+    if (parentp == NULL) {
+        treep->root = NULL;
+        treep->height = 0;
+        return;
+    }
+
+    if (parentp->hdr.count == 0) {
+        remove_node(treep, parentp, RDB_FALSE);
+        return;
+    }
+
+    /* Shrink the tree if the root has only one child */
+    while (treep->height > 0
+            && ((RDB_tree_inner *) treep->root)->hdr.count == 1) {
+        RDB_tree_inner *rootp = treep->root;
+
+        treep->root = rootp->childv[0];
+        NODEHDR(treep->root)->parentp = NULL;
+        treep->height--;
+        del_inner(rootp);
+    }
+}
+
+static void
+unlink_leaf(RDB_binary_tree *treep, RDB_tree_leaf *leafp)
+{
+    if (leafp->prevp != NULL)
+        leafp->prevp->nextp = leafp->nextp;
+    else
+        treep->firstp = leafp->nextp;
+    if (leafp->nextp != NULL)
+        leafp->nextp->prevp = leafp->prevp;
+}
+
+/*
+ * Move the records of *rightp to its left sibling *leftp
+ * and remove *rightp. If *posp is in *rightp, it is moved to *leftp.
+ * If the buffer of *leftp cannot be grown, the leaves are not merged.
+ */
+static void
+merge_leaves(RDB_binary_tree *treep, RDB_tree_leaf *leftp,
+        RDB_tree_leaf *rightp, RDB_tree_pos *posp)
+{
+    RDB_exec_context ec;
+    int ret;
+
+    /* Merging is optional, so a failed allocation is not an error */
+    RDB_init_exec_context(&ec);
+    ret = leaf_reserve(leftp, leaf_recs_len(rightp, 0), &ec);
+    RDB_destroy_exec_context(&ec);
+    if (ret != RDB_OK)
+        return;
+
+    if (posp->leafp == rightp) {
+        posp->leafp = leftp;
+        posp->idx += leftp->hdr.count;
+    }
+    leaf_append(leftp, rightp, 0);
+    rightp->hdr.count = 0;
+    unlink_leaf(treep, rightp);
+    remove_node(treep, rightp, RDB_TRUE);
+}
+
+/*
+ * Delete the record at position *posp.
+ * Afterwards *posp is the position of the following record.
+ */
+int
+RDB_tree_delete_pos(RDB_binary_tree *treep, RDB_tree_pos *posp,
+        RDB_exec_context *ecp)
+{
+    RDB_tree_leaf *leafp = posp->leafp;
+
+    leaf_remove(leafp, posp->idx);
+    treep->modcount++;
+
+    if (posp->idx == leafp->hdr.count) {
+        posp->leafp = leafp->nextp;
+        posp->idx = 0;
+    }
+
+    if (leafp->hdr.count == 0) {
+        /* Unlink and remove the empty leaf */
+        unlink_leaf(treep, leafp);
+        remove_node(treep, leafp, RDB_TRUE);
+        return RDB_OK;
+    }
+
+    /* Merge the leaf with a sibling which has the same parent */
+    if (leafp->hdr.count < TREE_LEAF_MIN && leafp->hdr.parentp != NULL) {
+        RDB_tree_leaf *nextp = leafp->nextp;
+        RDB_tree_leaf *prevp = leafp->prevp;
+
+        if (nextp != NULL && nextp->hdr.parentp == leafp->hdr.parentp
+                && leafp->hdr.count + nextp->hdr.count <= TREE_ORDER) {
+            merge_leaves(treep, leafp, nextp, posp);
+        } else if (prevp != NULL && prevp->hdr.parentp == leafp->hdr.parentp
+                && prevp->hdr.count + leafp->hdr.count <= TREE_ORDER) {
+            merge_leaves(treep, prevp, leafp, posp);
         }
-        if (delnodep->left != NULL)
-            delnodep->left->parent = delnodep->parent;
-        if (delnodep->right != NULL)
-            delnodep->right->parent = delnodep->parent;
-        del_node(delnodep);
     }
     return RDB_OK;
 }
@@ -446,6 +1023,77 @@ int
 RDB_tree_delete_node(RDB_binary_tree *treep, void *key, size_t keylen,
         RDB_exec_context *ecp)
 {
-    RDB_bool h = RDB_FALSE;
-    return avl_delete_node(treep, &treep->root, key, keylen, &h, ecp);
+    RDB_tree_pos pos;
+
+    if (RDB_tree_find_pos(treep, key, keylen, &pos) == NULL) {
+        RDB_raise_not_found("", ecp);
+        return RDB_ERROR;
+    }
+    return RDB_tree_delete_pos(treep, &pos, ecp);
+}
+
+/*
+ * Get the first record. Returns NULL if the tree is empty.
+ */
+RDB_tree_node *
+RDB_tree_first(const RDB_binary_tree *treep, RDB_tree_pos *posp)
+{
+    posp->leafp = treep->firstp;
+    posp->idx = 0;
+    return RDB_tree_pos_node(posp);
+}
+
+/*
+ * Return the record at position *posp, NULL if there is none.
+ * The record is stored in posp->node.
+ */
+RDB_tree_node *
+RDB_tree_pos_node(RDB_tree_pos *posp)
+{
+    RDB_tree_leaf *leafp = posp->leafp;
+    int idx = posp->idx;
+
+    if (leafp == NULL || idx >= leafp->hdr.count)
+        return NULL;
+    posp->node.keylen = leafp->keylenv[idx];
+    posp->node.key = posp->node.keylen > 0
+            ? leafp->buf + leafp->offv[idx] : NULL;
+    posp->node.valuelen = leafp->valuelenv[idx];
+    posp->node.value = posp->node.valuelen > 0
+            ? leafp->buf + leafp->offv[idx] + leafp->keylenv[idx] : NULL;
+    return &posp->node;
+}
+
+/*
+ * Move to the next record. Returns NULL if there is no next record.
+ */
+RDB_tree_node *
+RDB_tree_next(RDB_tree_pos *posp)
+{
+    if (posp->leafp == NULL)
+        return NULL;
+    if (++posp->idx >= posp->leafp->hdr.count) {
+        posp->leafp = posp->leafp->nextp;
+        posp->idx = 0;
+    }
+    return RDB_tree_pos_node(posp);
+}
+
+/*
+ * Move to the previous record. Returns NULL if there is no previous record.
+ */
+RDB_tree_node *
+RDB_tree_prev(RDB_tree_pos *posp)
+{
+    if (posp->leafp == NULL)
+        return NULL;
+    if (posp->idx > 0) {
+        posp->idx--;
+    } else {
+        posp->leafp = posp->leafp->prevp;
+        if (posp->leafp == NULL)
+            return NULL;
+        posp->idx = posp->leafp->hdr.count - 1;
+    }
+    return RDB_tree_pos_node(posp);
 }
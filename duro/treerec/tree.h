@@ -1,5 +1,5 @@
 /*
- * AVL Tree
+ * B+ tree
  *
  * Copyright (C) 2018 Rene Hartmann.
  * See the file COPYING for redistribution information.
@@ -8,6 +8,7 @@
 #ifndef TREEREC_TREE_H_
 #define TREEREC_TREE_H_
 
+#include <gen/types.h>
 #include <stdlib.h>
 
 typedef struct RDB_exec_context RDB_exec_context;
@@ -16,23 +17,51 @@ typedef struct RDB_index RDB_index;
 typedef int RDB_comparison_func (const void *d1, size_t size1,
         const void *d2, size_t size2, void *comparison_arg);
 
+/*
+ * A record stored in a leaf of the tree.
+ * The key and the value point into the buffer of the leaf
+ * and are only valid until the tree is modified.
+ */
 typedef struct RDB_tree_node {
-    struct RDB_tree_node *left;
-    struct RDB_tree_node *right;
-    struct RDB_tree_node *parent;
-    int balance;
     size_t keylen;
     size_t valuelen;
     void *key;
     void *value;
 } RDB_tree_node;
 
+struct RDB_tree_leaf;
+
 typedef struct {
-    RDB_tree_node *root;
+    /* A leaf if height is 0, otherwise an inner node. NULL if the tree is empty */
+    void *root;
+    int height;
+
+    /* The leftmost leaf */
+    struct RDB_tree_leaf *firstp;
+
+    /*
+     * Incremented when a record is inserted or deleted,
+     * which invalidates positions
+     */
+    unsigned long modcount;
+
     RDB_comparison_func *comparison_fp;
     void *comparison_arg;
 } RDB_binary_tree;
 
+/*
+ * Position of a record, used for iterating over a tree.
+ * leafp is NULL if the position is behind the last record.
+ * A position is only valid until the tree is modified.
+ */
+typedef struct {
+    struct RDB_tree_leaf *leafp;
+    int idx;
+
+    /* The record at the position, filled in by the functions returning it */
+    RDB_tree_node node;
+} RDB_tree_pos;
+
 RDB_binary_tree *
 RDB_create_tree(RDB_comparison_func *, void *, RDB_exec_context *);
 
@@ -40,14 +69,38 @@ void
 RDB_drop_tree(RDB_binary_tree *);
 
 RDB_tree_node *
-RDB_tree_find(const RDB_binary_tree *, const void *, size_t);
+RDB_tree_find_pos(const RDB_binary_tree *, const void *, size_t,
+        RDB_tree_pos *);
 
 RDB_tree_node *
-RDB_tree_insert(RDB_binary_tree *, void *, size_t,
-        void *, size_t, RDB_exec_context *);
+RDB_tree_seek(const RDB_binary_tree *, const void *, size_t,
+        RDB_tree_pos *, RDB_bool *);
+
+int
+RDB_tree_insert(RDB_binary_tree *, const void *, size_t,
+        const void *, size_t, RDB_tree_pos *, RDB_exec_context *);
+
+int
+RDB_tree_set_value(RDB_binary_tree *, RDB_tree_pos *, const void *, size_t,
+        RDB_exec_context *);
 
 int
 RDB_tree_delete_node(RDB_binary_tree *, void *key, size_t keylen,
         RDB_exec_context *);
 
+int
+RDB_tree_delete_pos(RDB_binary_tree *, RDB_tree_pos *, RDB_exec_context *);
+
+RDB_tree_node *
+RDB_tree_first(const RDB_binary_tree *, RDB_tree_pos *);
+
+RDB_tree_node *
+RDB_tree_pos_node(RDB_tree_pos *);
+
+RDB_tree_node *
+RDB_tree_next(RDB_tree_pos *);
+
+RDB_tree_node *
+RDB_tree_prev(RDB_tree_pos *);
+
 #endif /* TREEREC_TREE_H_ */
@@ -26,7 +26,14 @@ new_tree_cursor(RDB_recmap *rmp, RDB_binary_tree *treep, RDB_exec_context *ecp)
 
     curp->recmapp = rmp;
     curp->cur.tree.treep = treep;
-    curp->cur.tree.nodep = NULL;
+    curp->cur.tree.pos.leafp = NULL;
+    curp->cur.tree.pos.idx = 0;
+    curp->cur.tree.deleted = RDB_FALSE;
+    curp->cur.tree.modcount = treep->modcount;
+    curp->cur.tree.haskey = RDB_FALSE;
+    curp->cur.tree.key = NULL;
+    curp->cur.tree.keylen = 0;
+    curp->cur.tree.keycap = 0;
 
     curp->destroy_fn = &RDB_destroy_tree_cursor;
     curp->get_fn = &RDB_tree_cursor_get;
@@ -58,30 +65,91 @@ RDB_tree_recmap_cursor(RDB_recmap *rmp, RDB_bool wr,
 int
 RDB_destroy_tree_cursor(RDB_cursor *curp, RDB_exec_context *ecp)
 {
+    RDB_free(curp->cur.tree.key);
     RDB_free(curp);
     return RDB_OK;
 }
 
+/*
+ * Remember the key of the record at the cursor position,
+ * so the position can be found again after the tree has been modified
+ */
+static int
+save_pos(RDB_cursor *curp, RDB_exec_context *ecp)
+{
+    RDB_tree_node *nodep = RDB_tree_pos_node(&curp->cur.tree.pos);
+
+    curp->cur.tree.modcount = curp->cur.tree.treep->modcount;
+    if (nodep == NULL) {
+        curp->cur.tree.haskey = RDB_FALSE;
+        return RDB_OK;
+    }
+    if (nodep->keylen > curp->cur.tree.keycap) {
+        void *keyp = RDB_realloc(curp->cur.tree.key, nodep->keylen, ecp);
+        if (keyp == NULL) {
+            curp->cur.tree.haskey = RDB_FALSE;
+            return RDB_ERROR;
+        }
+        curp->cur.tree.key = keyp;
+        curp->cur.tree.keycap = nodep->keylen;
+    }
+    if (nodep->keylen > 0)
+        memcpy(curp->cur.tree.key, nodep->key, nodep->keylen);
+    curp->cur.tree.keylen = nodep->keylen;
+    curp->cur.tree.haskey = RDB_TRUE;
+    return RDB_OK;
+}
+
+/*
+ * If the tree has been modified since the cursor position was obtained,
+ * the position may be invalid, so look up the record by its key.
+ * If the record has been deleted, the cursor is moved to the following
+ * record, like after RDB_tree_cursor_delete().
+ */
+static void
+revalidate_pos(RDB_cursor *curp)
+{
+    RDB_bool found;
+
+    if (curp->cur.tree.modcount == curp->cur.tree.treep->modcount)
+        return;
+    curp->cur.tree.modcount = curp->cur.tree.treep->modcount;
+    if (!curp->cur.tree.haskey) {
+        curp->cur.tree.pos.leafp = NULL;
+        curp->cur.tree.pos.idx = 0;
+        return;
+    }
+    RDB_tree_seek(curp->cur.tree.treep, curp->cur.tree.key,
+            curp->cur.tree.keylen, &curp->cur.tree.pos, &found);
+    if (!found)
+        curp->cur.tree.deleted = RDB_TRUE;
+}
+
 int
 RDB_tree_cursor_get(RDB_cursor *curp, int fno, void **datapp, size_t *lenp,
         RDB_exec_context *ecp)
 {
     uint8_t *databp;
     int offs;
+    RDB_tree_node *nodep;
+
+    revalidate_pos(curp);
+    nodep = curp->cur.tree.deleted ? NULL
+            : RDB_tree_pos_node(&curp->cur.tree.pos);
 
-    if (curp->cur.tree.nodep == NULL) {
+    if (nodep == NULL) {
         RDB_raise_not_found("invalid cursor", ecp);
         return RDB_ERROR;
     }
 
     if (fno < curp->recmapp->keyfieldcount) {
-        databp = curp->cur.tree.nodep->key;
+        databp = nodep->key;
         offs = RDB_get_field(curp->recmapp, fno,
-                databp, curp->cur.tree.nodep->keylen, lenp, NULL);
+                databp, nodep->keylen, lenp, NULL);
     } else {
-        databp = curp->cur.tree.nodep->value;
+        databp = nodep->value;
         offs = RDB_get_field(curp->recmapp, fno,
-                databp, curp->cur.tree.nodep->valuelen, lenp, NULL);
+                databp, nodep->valuelen, lenp, NULL);
     }
     if (offs < 0) {
         RDB_errcode_to_error(offs, ecp);
@@ -95,10 +163,13 @@ int
 RDB_tree_cursor_set(RDB_cursor *curp, int fieldc, RDB_field fields[],
         RDB_exec_context *ecp)
 {
-    int i;
-    int ret;
+    RDB_tree_node *nodep;
 
-    if (curp->cur.tree.nodep == NULL) {
+    revalidate_pos(curp);
+    nodep = curp->cur.tree.deleted ? NULL
+            : RDB_tree_pos_node(&curp->cur.tree.pos);
+
+    if (nodep == NULL) {
         RDB_raise_not_found("invalid cursor", ecp);
         return RDB_ERROR;
     }
@@ -112,31 +183,37 @@ RDB_tree_cursor_set(RDB_cursor *curp, int fieldc, RDB_field fields[],
         return RDB_ERROR;
     }
 
-    for (i = 0; i < fieldc; i++) {
-        ret = RDB_set_field_mem(curp->recmapp, &curp->cur.tree.nodep->value,
-                &curp->cur.tree.nodep->valuelen, &fields[i],
-                curp->recmapp->vardatafieldcount);
-        if (ret != RDB_OK) {
-            RDB_errcode_to_error(ret, ecp);
-            return RDB_ERROR;
-        }
-    }
-
-    return RDB_OK;
+    return RDB_set_tree_value_fields(curp->recmapp, curp->cur.tree.treep,
+            &curp->cur.tree.pos, fieldc, fields, ecp);
 }
 
+/*
+ * Delete the record at the cursor position.
+ * A subsequent call to RDB_tree_cursor_next() moves the cursor
+ * to the record following the deleted one.
+ */
 int
 RDB_tree_cursor_delete(RDB_cursor *curp, RDB_exec_context *ecp)
 {
-    RDB_tree_node *nodep = curp->cur.tree.nodep;
-    int ret = RDB_tree_cursor_next(curp, 0, ecp);
-    if (ret != RDB_OK) {
-        if (RDB_obj_type(RDB_get_err(ecp)) != &RDB_NOT_FOUND_ERROR)
-            return RDB_ERROR;
+    RDB_tree_node *nodep;
+
+    revalidate_pos(curp);
+    nodep = curp->cur.tree.deleted ? NULL
+            : RDB_tree_pos_node(&curp->cur.tree.pos);
+    if (nodep == NULL) {
+        RDB_raise_not_found("invalid cursor", ecp);
+        return RDB_ERROR;
     }
     if (RDB_delete_from_tree_indexes(curp->recmapp, nodep, ecp) != RDB_OK)
         return RDB_ERROR;
-    return RDB_tree_delete_node(curp->cur.tree.treep, nodep->key, nodep->keylen, ecp);
+    if (RDB_tree_delete_pos(curp->cur.tree.treep, &curp->cur.tree.pos, ecp)
+            != RDB_OK)
+        return RDB_ERROR;
+    curp->cur.tree.deleted = RDB_TRUE;
+
+    /* The position is valid, the key is that of the deleted record */
+    curp->cur.tree.modcount = curp->cur.tree.treep->modcount;
+    return RDB_OK;
 }
 
 /*
@@ -146,65 +223,47 @@ RDB_tree_cursor_delete(RDB_cursor *curp, RDB_exec_context *ecp)
 int
 RDB_tree_cursor_first(RDB_cursor *curp, RDB_exec_context *ecp)
 {
-    RDB_tree_node *nodep = curp->cur.tree.treep->root;
-    if (nodep == NULL) {
+    curp->cur.tree.deleted = RDB_FALSE;
+    if (RDB_tree_first(curp->cur.tree.treep, &curp->cur.tree.pos) == NULL) {
+        curp->cur.tree.haskey = RDB_FALSE;
         RDB_raise_not_found("", ecp);
         return RDB_ERROR;
     }
-    while (nodep->left != NULL)
-        nodep = nodep->left;
-    curp->cur.tree.nodep = nodep;
-    return RDB_OK;
+    return save_pos(curp, ecp);
 }
 
 int
 RDB_tree_cursor_next(RDB_cursor *curp, int flags, RDB_exec_context *ecp)
 {
-    RDB_tree_node *nodep = curp->cur.tree.nodep;
+    RDB_tree_node *nodep;
+
+    revalidate_pos(curp);
+    if (curp->cur.tree.deleted) {
+        /* The cursor is already positioned on the next record */
+        curp->cur.tree.deleted = RDB_FALSE;
+        nodep = RDB_tree_pos_node(&curp->cur.tree.pos);
+    } else {
+        nodep = RDB_tree_next(&curp->cur.tree.pos);
+    }
     if (nodep == NULL) {
+        curp->cur.tree.haskey = RDB_FALSE;
         RDB_raise_not_found("", ecp);
         return RDB_ERROR;
     }
-    if (nodep->right != NULL) {
-        nodep = nodep->right;
-        while (nodep->left != NULL)
-            nodep = nodep->left;
-        curp->cur.tree.nodep = nodep;
-        return RDB_OK;
-    }
-    while (nodep->parent != NULL && nodep != nodep->parent->left) {
-        nodep = nodep->parent;
-    }
-    curp->cur.tree.nodep = nodep->parent;
-    if (curp->cur.tree.nodep != NULL)
-        return RDB_OK;
-    RDB_raise_not_found("", ecp);
-    return RDB_ERROR;
+    return save_pos(curp, ecp);
 }
 
 int
 RDB_tree_cursor_prev(RDB_cursor *curp, RDB_exec_context *ecp)
 {
-    RDB_tree_node *nodep = curp->cur.tree.nodep;
-    if (nodep == NULL) {
+    revalidate_pos(curp);
+    curp->cur.tree.deleted = RDB_FALSE;
+    if (RDB_tree_prev(&curp->cur.tree.pos) == NULL) {
+        curp->cur.tree.haskey = RDB_FALSE;
         RDB_raise_not_found("", ecp);
         return RDB_ERROR;
     }
-    if (nodep->left != NULL) {
-        nodep = nodep->left;
-        while (nodep->right != NULL)
-            nodep = nodep->right;
-        curp->cur.tree.nodep = nodep;
-        return RDB_OK;
-    }
-    while (nodep->parent != NULL && nodep != nodep->parent->right) {
-        nodep = nodep->parent;
-    }
-    curp->cur.tree.nodep = nodep->parent;
-    if (curp->cur.tree.nodep != NULL)
-        return RDB_OK;
-    RDB_raise_not_found("", ecp);
-    return RDB_ERROR;
+    return save_pos(curp, ecp);
 }
 
 /*
@@ -218,6 +277,7 @@ RDB_tree_cursor_seek(RDB_cursor *curp, int fieldc, RDB_field keyv[], int flags,
     int i;
     void *key;
     size_t keylen;
+    RDB_tree_node *nodep;
 
     if (curp->idxp == NULL) {
         for (i = 0; i < curp->recmapp->keyfieldcount; i++)
@@ -238,12 +298,13 @@ RDB_tree_cursor_seek(RDB_cursor *curp, int fieldc, RDB_field keyv[], int flags,
         return RDB_ERROR;
     }
 
-    curp->cur.tree.nodep = RDB_tree_find(curp->cur.tree.treep,
-                key, keylen);
+    nodep = RDB_tree_find_pos(curp->cur.tree.treep, key, keylen,
+            &curp->cur.tree.pos);
     free(key);
-    if (curp->cur.tree.nodep == NULL) {
+    if (nodep == NULL) {
         RDB_raise_not_found("", ecp);
         return RDB_ERROR;
     }
-    return RDB_OK;
+    curp->cur.tree.deleted = RDB_FALSE;
+    return save_pos(curp, ecp);
 }
@@ -164,6 +164,7 @@ new_tree_index(RDB_recmap *rmp,
     ixp->delete_index_fn = &RDB_delete_tree_index;
     ixp->index_delete_rec_fn = &RDB_tree_index_delete_rec;
     ixp->index_get_fields_fn = &RDB_tree_index_get_fields;
+    ixp->index_get_fields_multi_fn = NULL;
     ixp->index_cursor_fn = NULL; /* Not needed because there are only unique indexes */
 
     return ixp;
@@ -257,6 +258,7 @@ RDB_tree_index_get_fields(RDB_index *ixp, RDB_field keyv[], int fieldc,
 {
     size_t keylen;
     void *key;
+    RDB_tree_pos pos, rmpos;
     RDB_tree_node *nodep, *rmnodep;
     int ret;
     int i;
@@ -274,14 +276,15 @@ RDB_tree_index_get_fields(RDB_index *ixp, RDB_field keyv[], int fieldc,
         return RDB_ERROR;
     }
 
-    nodep = RDB_tree_find(ixp->impl.tree.treep, key, keylen);
+    nodep = RDB_tree_find_pos(ixp->impl.tree.treep, key, keylen, &pos);
     free(key);
     if (nodep == NULL) {
         RDB_raise_not_found("", ecp);
         return RDB_ERROR;
     }
 
-    rmnodep = RDB_tree_find(ixp->rmp->impl.tree.treep, nodep->value, nodep->valuelen);
+    rmnodep = RDB_tree_find_pos(ixp->rmp->impl.tree.treep, nodep->value,
+            nodep->valuelen, &rmpos);
     if (rmnodep == NULL){
         RDB_raise_internal("index node not found", ecp);
         return RDB_ERROR;
@@ -315,6 +318,7 @@ RDB_tree_index_delete_rec(RDB_index *ixp, RDB_field keyv[], RDB_rec_transaction
 {
     size_t keylen;
     void *key;
+    RDB_tree_pos pos, rmpos;
     RDB_tree_node *pnodep, *rmnodep;
     int ret;
     int i;
@@ -332,21 +336,23 @@ RDB_tree_index_delete_rec(RDB_index *ixp, RDB_field keyv[], RDB_rec_transaction
         return RDB_ERROR;
     }
 
-    pnodep = RDB_tree_find(ixp->impl.tree.treep, key, keylen);
+    pnodep = RDB_tree_find_pos(ixp->impl.tree.treep, key, keylen, &pos);
     free(key);
     if (pnodep == NULL) {
         RDB_raise_not_found("", ecp);
         return RDB_ERROR;
     }
 
-    rmnodep = RDB_tree_find(ixp->rmp->impl.tree.treep, pnodep->value, pnodep->valuelen);
+    rmnodep = RDB_tree_find_pos(ixp->rmp->impl.tree.treep, pnodep->value,
+            pnodep->valuelen, &rmpos);
     if (rmnodep == NULL) {
         RDB_raise_not_found("", ecp);
         return RDB_ERROR;
     }
 
+    /* This deletes *pnodep, but not *rmnodep */
     if (RDB_delete_from_tree_indexes(ixp->rmp, rmnodep, ecp) != RDB_OK)
         return RDB_ERROR;
 
-    return RDB_tree_delete_node(ixp->rmp->impl.tree.treep, rmnodep->key, rmnodep->keylen, ecp);
+    return RDB_tree_delete_pos(ixp->rmp->impl.tree.treep, &rmpos, ecp);
 }
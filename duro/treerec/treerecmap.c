@@ -254,6 +254,7 @@ check_in_indexes(RDB_recmap *rmp, void *key, size_t keylen,
     void *skey = NULL;
     size_t skeylen;
     RDB_index *ixp;
+    RDB_tree_pos pos;
     int ret;
 
     for (ixp = rmp->indexes; ixp != NULL; ixp = ixp->nextp) {
@@ -262,7 +263,8 @@ check_in_indexes(RDB_recmap *rmp, void *key, size_t keylen,
         if (ret != RDB_OK) {
             return RDB_ERROR;
         }
-        if (RDB_tree_find(ixp->impl.tree.treep, skey, skeylen) != NULL) {
+        if (RDB_tree_find_pos(ixp->impl.tree.treep, skey, skeylen, &pos)
+                != NULL) {
             free(skey);
             RDB_raise_key_violation("", ecp);
             return RDB_ERROR;
@@ -281,25 +283,18 @@ insert_into_indexes(RDB_recmap *rmp, RDB_tree_node *nodep, RDB_exec_context *ecp
     int ret;
 
     for (ixp = rmp->indexes; ixp != NULL; ixp = ixp->nextp) {
-        void *key;
-
         ret = RDB_make_skey(ixp, nodep->key, nodep->keylen, nodep->value, nodep->valuelen,
         		&skey, &skeylen, RDB_FALSE, ecp);
         if (ret != RDB_OK) {
             return RDB_ERROR;
         }
 
-        key = RDB_alloc(nodep->keylen, ecp);
-        if (key == NULL)
-            return RDB_ERROR;
-        memcpy (key, nodep->key, nodep->keylen);
-
-        if (RDB_tree_insert(ixp->impl.tree.treep, skey, skeylen,
-                key, nodep->keylen, ecp) == NULL) {
-            free(skey);
-            RDB_free(key);
+        /* The index maps the secondary key to the primary key */
+        ret = RDB_tree_insert(ixp->impl.tree.treep, skey, skeylen,
+                nodep->key, nodep->keylen, NULL, ecp);
+        free(skey);
+        if (ret != RDB_OK)
             return RDB_ERROR;
-        }
     }
     return RDB_OK;
 }
@@ -309,7 +304,9 @@ delete_tree_rec_by_key(RDB_recmap *rmp, void *key, size_t keylen, RDB_exec_conte
 {
     if (rmp->indexes != NULL) {
         /* Delete entry from indexes */
-        RDB_tree_node *nodep = RDB_tree_find(rmp->impl.tree.treep, key, keylen);
+        RDB_tree_pos pos;
+        RDB_tree_node *nodep = RDB_tree_find_pos(rmp->impl.tree.treep,
+                key, keylen, &pos);
         if (nodep != NULL) {
             if (RDB_delete_from_tree_indexes(rmp, nodep, ecp) != RDB_OK) {
                 return RDB_ERROR;
@@ -319,22 +316,25 @@ delete_tree_rec_by_key(RDB_recmap *rmp, void *key, size_t keylen, RDB_exec_conte
     return RDB_tree_delete_node(rmp->impl.tree.treep, key, keylen, ecp);
 }
 
+/*
+ * Insert a record. Key and value are copied.
+ */
 static int
 insert_tree_rec_kv(RDB_recmap *rmp, void *key, size_t keylen,
         void *value, size_t valuelen, RDB_exec_context *ecp)
 {
-    RDB_tree_node *nodep;
+    RDB_tree_pos pos;
 
     if (check_in_indexes(rmp, key, keylen, value, valuelen, ecp) != RDB_OK) {
         return RDB_ERROR;
     }
 
-    nodep = RDB_tree_insert(rmp->impl.tree.treep, key, keylen, value, valuelen, ecp);
-    if (nodep == NULL) {
+    if (RDB_tree_insert(rmp->impl.tree.treep, key, keylen, value, valuelen,
+            &pos, ecp) != RDB_OK) {
         return RDB_ERROR;
     }
 
-    if (insert_into_indexes(rmp, nodep, ecp) != RDB_OK) {
+    if (insert_into_indexes(rmp, &pos.node, ecp) != RDB_OK) {
         delete_tree_rec_by_key(rmp, key, keylen, ecp);
         return RDB_ERROR;
     }
@@ -364,12 +364,9 @@ RDB_insert_tree_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rtxp
     }
 
     ret = insert_tree_rec_kv(rmp, key, keylen, value, valuelen, ecp);
-    if (ret != RDB_OK) {
-        free(key);
-        free(value);
-        return RDB_ERROR;
-    }
-    return RDB_OK;
+    free(key);
+    free(value);
+    return ret;
 }
 
 RDB_bool
@@ -407,6 +404,10 @@ delete_update_reinsert_tree_node(RDB_recmap *rmp, RDB_tree_node *nodep,
     void *value2 = NULL;
     size_t keylen2, valuelen2;
 
+    /*
+     * Copy the record, one copy is modified and the other one
+     * is inserted again if inserting the modified record fails
+     */
     keylen = nodep->keylen;
     valuelen = nodep->valuelen;
     if (keylen > 0) {
@@ -425,11 +426,6 @@ delete_update_reinsert_tree_node(RDB_recmap *rmp, RDB_tree_node *nodep,
         }
         memcpy(value, nodep->value, valuelen);
     }
-
-    if (delete_tree_rec_by_key(rmp, key, keylen, ecp) != RDB_OK) {
-        goto error;
-    }
-
     keylen2 = keylen;
     valuelen2 = valuelen;
     if (keylen2 > 0) {
@@ -445,6 +441,10 @@ delete_update_reinsert_tree_node(RDB_recmap *rmp, RDB_tree_node *nodep,
         memcpy(value2, value, valuelen2);
     }
 
+    if (delete_tree_rec_by_key(rmp, key, keylen, ecp) != RDB_OK) {
+        goto error;
+    }
+
     for (i = 0; i < fieldc; i++) {
         if (fieldv[i].no < rmp->keyfieldcount) {
             ret = RDB_set_field_mem(rmp, &key, &keylen, &fieldv[i],
@@ -462,55 +462,70 @@ delete_update_reinsert_tree_node(RDB_recmap *rmp, RDB_tree_node *nodep,
     if (ret != RDB_OK) {
         /* Insert unmodified record */
         if (RDB_obj_type(RDB_get_err(ecp)) == &RDB_KEY_VIOLATION_ERROR) {
-            if (insert_tree_rec_kv(rmp, key2, keylen2, value2, valuelen2, ecp) == RDB_OK) {
-                key2 = NULL;
-                value2 = NULL;
-            }
+            insert_tree_rec_kv(rmp, key2, keylen2, value2, valuelen2, ecp);
         }
         goto error;
     }
+    free(key);
+    free(value);
     RDB_free(key2);
     RDB_free(value2);
 
     return RDB_OK;
 
 error:
-    if (key != NULL) {
-        free(key);
-    }
-    if (value != NULL) {
-        free(value);
-    }
-    if (key2 != NULL) {
-        RDB_free(key2);
-    }
-    if (value2 != NULL) {
-        RDB_free(value2);
-    }
+    free(key);
+    free(value);
+    RDB_free(key2);
+    RDB_free(value2);
 
     return RDB_ERROR;
 }
 
-static int
-RDB_update_tree_node(RDB_recmap *rmp, RDB_tree_node *nodep,
-               int fieldc, const RDB_field fieldv[], RDB_exec_context *ecp)
+/*
+ * Set fields of the value of the record at position *posp
+ */
+int
+RDB_set_tree_value_fields(RDB_recmap *rmp, RDB_binary_tree *treep,
+        RDB_tree_pos *posp, int fieldc, const RDB_field fieldv[],
+        RDB_exec_context *ecp)
 {
     int i;
     int ret;
+    void *value = NULL;
+    size_t valuelen = posp->node.valuelen;
 
-    if (RDB_recmap_is_key_update(rmp, fieldc, fieldv)) {
-        return delete_update_reinsert_tree_node(rmp, nodep, fieldc, fieldv, ecp);
+    /* The value is modified in a copy because its length may change */
+    if (valuelen > 0) {
+        value = RDB_alloc(valuelen, ecp);
+        if (value == NULL)
+            return RDB_ERROR;
+        memcpy(value, posp->node.value, valuelen);
     }
-
     for (i = 0; i < fieldc; i++) {
-        ret = RDB_set_field_mem(rmp, &nodep->value, &nodep->valuelen,
+        ret = RDB_set_field_mem(rmp, &value, &valuelen,
                 &fieldv[i], rmp->vardatafieldcount);
         if (ret != RDB_OK) {
+            RDB_free(value);
             RDB_errcode_to_error(ret, ecp);
             return RDB_ERROR;
         }
     }
-    return RDB_OK;
+    ret = RDB_tree_set_value(treep, posp, value, valuelen, ecp);
+    RDB_free(value);
+    return ret;
+}
+
+static int
+RDB_update_tree_node(RDB_recmap *rmp, RDB_tree_pos *posp,
+               int fieldc, const RDB_field fieldv[], RDB_exec_context *ecp)
+{
+    if (RDB_recmap_is_key_update(rmp, fieldc, fieldv)) {
+        return delete_update_reinsert_tree_node(rmp, &posp->node, fieldc,
+                fieldv, ecp);
+    }
+    return RDB_set_tree_value_fields(rmp, rmp->impl.tree.treep, posp,
+            fieldc, fieldv, ecp);
 }
 
 int
@@ -521,6 +536,7 @@ RDB_update_tree_rec(RDB_recmap *rmp, RDB_field keyv[],
     size_t keylen;
     void *key;
     int ret;
+    RDB_tree_pos pos;
     RDB_tree_node *nodep;
 
     ret = key_to_mem(rmp, keyv, &key, &keylen);
@@ -529,7 +545,7 @@ RDB_update_tree_rec(RDB_recmap *rmp, RDB_field keyv[],
         return RDB_ERROR;
     }
 
-    nodep = RDB_tree_find(rmp->impl.tree.treep, key, keylen);
+    nodep = RDB_tree_find_pos(rmp->impl.tree.treep, key, keylen, &pos);
     if (keylen > 0)
         free(key);
     if (nodep == NULL) {
@@ -537,7 +553,7 @@ RDB_update_tree_rec(RDB_recmap *rmp, RDB_field keyv[],
         return RDB_ERROR;
     }
 
-    return RDB_update_tree_node(rmp, nodep, fieldc, fieldv, ecp);
+    return RDB_update_tree_node(rmp, &pos, fieldc, fieldv, ecp);
 }
 
 int
@@ -588,6 +604,7 @@ RDB_get_tree_fields(RDB_recmap *rmp, RDB_field keyv[], int fieldc,
 {
     size_t keylen;
     void *key;
+    RDB_tree_pos pos;
     RDB_tree_node *nodep;
     int ret;
 
@@ -597,7 +614,7 @@ RDB_get_tree_fields(RDB_recmap *rmp, RDB_field keyv[], int fieldc,
         return RDB_ERROR;
     }
 
-    nodep = RDB_tree_find(rmp->impl.tree.treep, key, keylen);
+    nodep = RDB_tree_find_pos(rmp->impl.tree.treep, key, keylen, &pos);
     if (nodep == NULL) {
         free(key);
         RDB_raise_not_found("", ecp);
@@ -619,6 +636,7 @@ RDB_contains_tree_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rt
 {
     size_t keylen;
     void *key;
+    RDB_tree_pos pos;
     RDB_tree_node *nodep;
     size_t value2len;
     void *value2;
@@ -630,7 +648,7 @@ RDB_contains_tree_rec(RDB_recmap *rmp, RDB_field flds[], RDB_rec_transaction *rt
         return RDB_ERROR;
     }
 
-    nodep = RDB_tree_find(rmp->impl.tree.treep, key, keylen);
+    nodep = RDB_tree_find_pos(rmp->impl.tree.treep, key, keylen, &pos);
     free(key);
     if (nodep == NULL) {
         RDB_raise_not_found("", ecp);
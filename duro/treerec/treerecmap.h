@@ -9,9 +9,9 @@
 #define TREEREC_AVLRECMAP_H_
 
 #include <rec/recmap.h>
+#include <treerec/tree.h>
 
 typedef struct RDB_exec_context RDB_exec_context;
-typedef struct RDB_tree_node RDB_tree_node;
 typedef struct RDB_index RDB_index;
 
 RDB_recmap *
@@ -49,6 +49,10 @@ RDB_tree_recmap_est_size(RDB_recmap *, RDB_rec_transaction *, unsigned *, RDB_ex
 int
 RDB_delete_from_tree_indexes(RDB_recmap *, RDB_tree_node *, RDB_exec_context *);
 
+int
+RDB_set_tree_value_fields(RDB_recmap *, RDB_binary_tree *, RDB_tree_pos *,
+        int, const RDB_field[], RDB_exec_context *);
+
 RDB_bool
 RDB_recmap_is_key_update(RDB_recmap *, int, const RDB_field[]);
 